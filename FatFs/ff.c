@@ -1925,6 +1925,7 @@ void get_fileinfo (                                                         /* N
         }
         fno->fattrib = dir[DIR_Attr];                                   /* Attribute */
         fno->fsize = LD_DWORD(dir + DIR_FileSize);                      /* Size */
+        fno->fclust = LD_CLUST(dir);                                    /* Start cluster */
         fno->fdate = LD_WORD(dir + DIR_WrtDate);                        /* Date */
         fno->ftime = LD_WORD(dir + DIR_WrtTime);                        /* Time */
     }
@@ -2488,6 +2489,49 @@ FRESULT f_open (
     LEAVE_FF(dj.fs, res);
 }
 
+/*
+ *-----------------------------------------------------------------------
+ * Open a File by its Start Cluster (Read Only)
+ *
+ * The cluster and size are the fclust and fsize fields returned by
+ * f_readdir, this avoids following the path again to re-open a file.
+ *-----------------------------------------------------------------------
+ */
+
+FRESULT f_open_clust (
+    FIL *fp,                                                                /* Pointer to the blank file object */
+    FATFS *fs,                                                              /* Pointer to the file system object */
+    DWORD clust,                                                            /* File start cluster */
+    DWORD size                                                              /* File size */
+    )
+{
+    FRESULT res;
+
+
+    fp->fs = 0;                                                             /* Clear file object */
+
+    res = validate(fs, fs ? fs->id : 0);                                    /* Check the volume is still mounted */
+    if (res != FR_OK){
+        return (res);
+    }
+
+    if (size ? (clust < 2 || clust >= fs->n_fatent) : (clust != 0)){
+        res = FR_INVALID_OBJECT;                                            /* Not a valid start cluster */
+    } else {
+        fp->flag = FA_READ;                                                 /* File access mode */
+        fp->org_clust = clust;                                              /* File start cluster */
+        fp->fsize = size;                                                   /* File size */
+        fp->fptr = 0;                                                       /* File pointer */
+        fp->dsect = 0;
+#if _USE_FASTSEEK
+        fp->cltbl = 0;                                                      /* No cluster link map table */
+#endif
+        fp->fs = fs; fp->id = fs->id;                                       /* Validate file object */
+    }
+
+    LEAVE_FF(fs, res);
+}
+
 /*
  *-----------------------------------------------------------------------
  * Read File
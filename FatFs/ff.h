@@ -619,6 +619,7 @@ typedef struct {
 
 typedef struct {
     DWORD fsize;                                                    /* File size */
+    DWORD fclust;                                                   /* File start cluster (0 when fsize==0) */
     WORD fdate;                                                     /* Last modified date */
     WORD ftime;                                                     /* Last modified time */
     BYTE fattrib;                                                   /* Attribute */
@@ -672,6 +673,7 @@ FRESULT f_lseek(FIL *, DWORD);                                      /* Move file
 FRESULT f_close (FIL*);                                             /* Close an open file object */
 FRESULT f_opendir (DIR*, const TCHAR*);                             /* Open an existing directory */
 FRESULT f_readdir (DIR*, FILINFO*);                                 /* Read a directory item */
+FRESULT f_open_clust (FIL*, FATFS*, DWORD, DWORD);                  /* Open a file by its start cluster (read only) */
 FRESULT f_stat (const TCHAR*, FILINFO*);                            /* Get file status */
 
 #if !_FS_READONLY
@@ -34,6 +34,8 @@ static const char SLIDES_PATH[] = "img/slides.txt";
 
 int app_stop = 0;
 
+static int bench_selected(struct pl_platform *plat);
+
 int app_demo(struct pl_platform *plat)
 {
 	int stat;
@@ -41,10 +43,14 @@ int app_demo(struct pl_platform *plat)
 	if (app_clear(plat))
 		return -1;
 
-	if (CONFIG_DEMO_POWERMODES)
+	if (CONFIG_DEMO_BENCH || bench_selected(plat))
+		stat = app_bench(plat, "img");
+	else if (CONFIG_DEMO_POWERMODES)
 		stat = app_power(plat, "img");
 	else if (CONFIG_DEMO_PATTERN)
 		stat = app_pattern(plat);
+	else if (CONFIG_DEMO_STREAM)
+		stat = app_stream(plat);
 	else if (is_file_present(SLIDES_PATH))
 		stat = app_sequencer(plat, SLIDES_PATH);
 	else
@@ -53,6 +59,18 @@ int app_demo(struct pl_platform *plat)
 	return stat;
 }
 
+/* The selection switches pull their input low when they are on */
+static int bench_selected(struct pl_platform *plat)
+{
+#if CONFIG_DEMO_BENCH_SEL
+	const unsigned sel = plat->sys_gpio->sel[CONFIG_DEMO_BENCH_SEL - 1];
+
+	return !pl_gpio_get(&plat->gpio, sel);
+#else
+	return 0;
+#endif
+}
+
 #include <pl/endian.h>
 
 int app_clear(struct pl_platform *plat)
@@ -37,5 +37,7 @@ extern int app_power(struct pl_platform *plat, const char *path);
 extern int app_slideshow(struct pl_platform *plat, const char *path);
 extern int app_sequencer(struct pl_platform *plat, const char *path);
 extern int app_pattern(struct pl_platform *plat);
+extern int app_stream(struct pl_platform *plat);
+extern int app_bench(struct pl_platform *plat, const char *path);
 
 #endif /* INCLUDE_APP_H */
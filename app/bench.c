@@ -0,0 +1,425 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * app/bench.c -- Throughput benchmark app
+ */
+
+#include <app/app.h>
+#include <app/playlist.h>
+#include <pl/platform.h>
+#include <pl/epdc.h>
+#include <pl/epdpsu.h>
+#include <pl/types.h>
+#include <pl/wflib.h>
+#include <string.h>
+#include "assert.h"
+
+#define LOG_TAG "bench"
+#include "utils.h"
+
+/* Registers which are the same on all the supported Epson controllers */
+#define BENCH_REG_READ  0x0002 /* REV_CODE */
+#define BENCH_REG_WRITE 0x001A /* I2C_CLOCK, written with its own value */
+
+/* Number of register accesses timed together */
+#define BENCH_REG_OPS 100
+
+/* Maximum number of images from the directory to load */
+#define BENCH_MAX_IMAGES 4
+
+struct bench_stat {
+	uint32_t total;
+	uint32_t min;
+	uint32_t max;
+	uint16_t n;
+};
+
+/* Same paths as the waveform library on the SD card in main.c */
+static const char * const wflib_paths[] = {
+	"display/waveform.bin", "display/waveform.wbf",
+};
+
+static int bench_regs(struct pl_epdc *epdc);
+static int bench_fill(struct pl_epdc *epdc);
+static int bench_images(struct pl_epdc *epdc, const char *path);
+static int bench_wflib(struct pl_epdc *epdc);
+static int bench_psu(struct pl_epdpsu *psu);
+static int bench_update(struct pl_epdc *epdc, struct pl_epdpsu *psu);
+static void stat_add(struct bench_stat *s, uint32_t start);
+static void stat_report(const char *name, const char *item,
+			const struct bench_stat *s, uint32_t bytes);
+static void centre_area(struct pl_area *area, unsigned width,
+			unsigned height);
+
+int app_bench(struct pl_platform *plat, const char *path)
+{
+	struct pl_epdc *epdc = &plat->epdc;
+	struct pl_epdpsu *psu = &plat->psu;
+
+	LOG("Running %d iterations of each test, times in us",
+	    CONFIG_DEMO_BENCH_ITERATIONS);
+	LOG("%-8s %-12s %5s %8s %8s %8s %6s", "test", "item", "n", "mean",
+	    "min", "max", "kB/s");
+
+	if (epdc->set_power(epdc, PL_EPDC_RUN))
+		return -1;
+
+	if (bench_regs(epdc) || bench_fill(epdc) ||
+	    bench_images(epdc, path) || bench_wflib(epdc) || bench_psu(psu) ||
+	    bench_update(epdc, psu))
+		return -1;
+
+	LOG("Done");
+
+	return 0;
+}
+
+static int bench_regs(struct pl_epdc *epdc)
+{
+	struct bench_stat rd, wr;
+	unsigned i, j;
+
+	if ((epdc->read_register == NULL) || (epdc->write_register == NULL)) {
+		LOG("Register access not supported, skipping");
+		return 0;
+	}
+
+	memset(&rd, 0, sizeof(rd));
+	memset(&wr, 0, sizeof(wr));
+
+	for (i = 0; i < CONFIG_DEMO_BENCH_ITERATIONS; ++i) {
+		const uint16_t val =
+			epdc->read_register(epdc, BENCH_REG_WRITE);
+		uint32_t start;
+
+		start = ticks_now();
+
+		for (j = 0; j < BENCH_REG_OPS; ++j)
+			epdc->read_register(epdc, BENCH_REG_READ);
+
+		stat_add(&rd, start);
+		start = ticks_now();
+
+		for (j = 0; j < BENCH_REG_OPS; ++j)
+			epdc->write_register(epdc, BENCH_REG_WRITE, val);
+
+		stat_add(&wr, start);
+	}
+
+	stat_report("reg", "read x100", &rd, 0);
+	stat_report("reg", "write x100", &wr, 0);
+
+	return 0;
+}
+
+static int bench_fill(struct pl_epdc *epdc)
+{
+	static const uint8_t greys[4] = {
+		0x00, 0x55, 0xAA, 0xFF };
+	struct bench_stat full, win, batch;
+	struct pl_area area;
+	struct pl_area quads[4];
+	unsigned i;
+
+	memset(&full, 0, sizeof(full));
+	memset(&win, 0, sizeof(win));
+	memset(&batch, 0, sizeof(batch));
+	centre_area(&area, epdc->xres, epdc->yres);
+
+	for (i = 0; i < ARRAY_SIZE(quads); ++i) {
+		quads[i].width = (epdc->xres / 2) & ~1;
+		quads[i].height = epdc->yres / 2;
+		quads[i].left = (i & 1) ? quads[i].width : 0;
+		quads[i].top = (i & 2) ? quads[i].height : 0;
+	}
+
+	for (i = 0; i < CONFIG_DEMO_BENCH_ITERATIONS; ++i) {
+		uint32_t start;
+
+		start = ticks_now();
+
+		if (epdc->fill(epdc, NULL, PL_WHITE))
+			return -1;
+
+		stat_add(&full, start);
+		start = ticks_now();
+
+		if (epdc->fill(epdc, &area, PL_BLACK))
+			return -1;
+
+		stat_add(&win, start);
+
+		if (epdc->fill_areas == NULL)
+			continue;
+
+		start = ticks_now();
+
+		if (epdc->fill_areas(epdc, quads, greys, ARRAY_SIZE(quads)))
+			return -1;
+
+		stat_add(&batch, start);
+	}
+
+	stat_report("fill", "full", &full, (uint32_t)epdc->xres * epdc->yres);
+	stat_report("fill", "window", &win, (uint32_t)area.width * area.height);
+	stat_report("fill", "areas x4", &batch,
+		    (uint32_t)quads[0].width * quads[0].height * 4);
+
+	return 0;
+}
+
+/* Full and windowed loads of the first images in the directory, each format
+ * (PGM, image container with its compression) is given by the files */
+static int bench_images(struct pl_epdc *epdc, const char *path)
+{
+	struct playlist_entry entries[BENCH_MAX_IMAGES];
+	struct playlist pl;
+	unsigned i, j;
+
+	if (playlist_init(&pl, path, entries, BENCH_MAX_IMAGES))
+		return -1;
+
+	if (!pl.n)
+		LOG("No image file found in %s, skipping", path);
+
+	if (CONFIG_IMAGE_CACHE_SLOTS)
+		LOG("Image cache enabled, min is a cache hit");
+
+	for (i = 0; i < pl.n; ++i) {
+		const struct playlist_entry *e = &entries[i];
+		struct bench_stat full, win;
+		struct pl_area area;
+
+		memset(&full, 0, sizeof(full));
+		memset(&win, 0, sizeof(win));
+		centre_area(&area, e->width, e->height);
+
+		for (j = 0; j < CONFIG_DEMO_BENCH_ITERATIONS; ++j) {
+			uint32_t start;
+
+			start = ticks_now();
+
+			if (playlist_load(&pl, i, epdc, NULL, 0, 0))
+				return -1;
+
+			stat_add(&full, start);
+			start = ticks_now();
+
+			if (playlist_load(&pl, i, epdc, &area, area.left,
+					  area.top))
+				return -1;
+
+			stat_add(&win, start);
+		}
+
+		LOG("%s: %ux%u, %s, %lu bytes", e->fname, e->width, e->height,
+		    (e->format == PLAYLIST_PGM) ? "pgm" : "plimg",
+		    (unsigned long)e->size);
+		stat_report("image", "full", &full,
+			    (uint32_t)e->width * e->height);
+		stat_report("image", "window", &win,
+			    (uint32_t)area.width * area.height);
+	}
+
+	return 0;
+}
+
+/* Load the waveform library from the configured source, and from the SD card
+ * when it is present, then leave the configured one loaded */
+static int bench_wflib(struct pl_epdc *epdc)
+{
+	const struct pl_wflib wflib = epdc->wflib;
+	struct bench_stat s;
+	unsigned i, j;
+	int stat = 0;
+
+	memset(&s, 0, sizeof(s));
+
+	for (i = 0; i < CONFIG_DEMO_BENCH_ITERATIONS; ++i) {
+		const uint32_t start = ticks_now();
+
+		if (pl_epdc_load_wflib(epdc))
+			return -1;
+
+		stat_add(&s, start);
+	}
+
+	stat_report("wflib", "config", &s, wflib.size);
+
+	for (i = 0; !stat && (i < ARRAY_SIZE(wflib_paths)); ++i) {
+		FIL f;
+
+		if (!is_file_present(wflib_paths[i]))
+			continue;
+
+		if (pl_wflib_init_fatfs(&epdc->wflib, &f, wflib_paths[i]))
+			return -1;
+
+		memset(&s, 0, sizeof(s));
+
+		for (j = 0; j < CONFIG_DEMO_BENCH_ITERATIONS; ++j) {
+			const uint32_t start = ticks_now();
+
+			stat = pl_epdc_load_wflib(epdc);
+
+			if (stat)
+				break;
+
+			stat_add(&s, start);
+		}
+
+		f_close(&f);
+		LOG("%s", wflib_paths[i]);
+		stat_report("wflib", "sd", &s, epdc->wflib.size);
+	}
+
+	epdc->wflib = wflib;
+
+	if (pl_epdc_load_wflib(epdc))
+		return -1;
+
+	return stat;
+}
+
+static int bench_psu(struct pl_epdpsu *psu)
+{
+	struct bench_stat on, off;
+	unsigned i;
+
+	memset(&on, 0, sizeof(on));
+	memset(&off, 0, sizeof(off));
+
+	for (i = 0; i < CONFIG_DEMO_BENCH_ITERATIONS; ++i) {
+		uint32_t start;
+
+		start = ticks_now();
+
+		if (psu->on(psu))
+			return -1;
+
+		stat_add(&on, start);
+		start = ticks_now();
+
+		if (psu->off(psu))
+			return -1;
+
+		stat_add(&off, start);
+	}
+
+	stat_report("psu", "on", &on, 0);
+	stat_report("psu", "off", &off, 0);
+
+	return 0;
+}
+
+/* Time from the update command until the end of the update, with the PSU
+ * already on and the temperature already measured */
+static int bench_update(struct pl_epdc *epdc, struct pl_epdpsu *psu)
+{
+	struct bench_stat full, win;
+	struct pl_area area;
+	unsigned i;
+	int wfid;
+
+	wfid = pl_epdc_get_wfid(epdc, 2);
+
+	if (wfid < 0)
+		return -1;
+
+	memset(&full, 0, sizeof(full));
+	memset(&win, 0, sizeof(win));
+	centre_area(&area, epdc->xres, epdc->yres);
+
+	if (epdc->fill(epdc, NULL, PL_WHITE) || pl_epdc_update_temp(epdc) ||
+	    psu->on(psu))
+		return -1;
+
+	for (i = 0; i < CONFIG_DEMO_BENCH_ITERATIONS; ++i) {
+		uint32_t start;
+
+		start = ticks_now();
+
+		if (epdc->update(epdc, wfid, UPDATE_FULL, NULL) ||
+		    epdc->wait_update_end(epdc))
+			break;
+
+		stat_add(&full, start);
+		start = ticks_now();
+
+		if (epdc->update(epdc, wfid, UPDATE_FULL_AREA, &area) ||
+		    epdc->wait_update_end(epdc))
+			break;
+
+		stat_add(&win, start);
+	}
+
+	if (psu->off(psu) || (i < CONFIG_DEMO_BENCH_ITERATIONS))
+		return -1;
+
+	stat_report("update", "full", &full, 0);
+	stat_report("update", "window", &win, 0);
+
+	return 0;
+}
+
+static void stat_add(struct bench_stat *s, uint32_t start)
+{
+	const uint32_t duration = ticks_now() - start;
+
+	if (!s->n || (duration < s->min))
+		s->min = duration;
+
+	if (duration > s->max)
+		s->max = duration;
+
+	s->total += duration;
+	s->n++;
+}
+
+/* Report the mean, min and max durations, and the mean throughput in kB/s
+ * when a number of bytes is given */
+static void stat_report(const char *name, const char *item,
+			const struct bench_stat *s, uint32_t bytes)
+{
+	uint32_t mean;
+	unsigned long rate = 0;
+
+	if (!s->n)
+		return;
+
+	mean = s->total / s->n;
+
+	if (bytes && mean)
+		rate = ((uint64_t)bytes * 1000) / mean;
+
+	LOG("%-8s %-12s %5u %8lu %8lu %8lu %6lu", name, item, s->n,
+	    (unsigned long)mean, (unsigned long)s->min,
+	    (unsigned long)s->max, rate);
+}
+
+/* Centre half of the given size, aligned on even coordinates as needed to
+ * load areas of image containers */
+static void centre_area(struct pl_area *area, unsigned width,
+			unsigned height)
+{
+	area->left = (width / 4) & ~1;
+	area->top = height / 4;
+	area->width = (width / 2) & ~1;
+	area->height = height / 2;
+}
@@ -0,0 +1,472 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * app/compose.c -- Composition of image and fill layers
+ */
+
+#include <app/compose.h>
+#include <pl/epdc.h>
+#include <pl/prof.h>
+#include <string.h>
+#include "assert.h"
+#include "config.h"
+#include "pnm-utils.h"
+
+#define LOG_TAG "compose"
+#include "utils.h"
+
+/* Set to 1 to enable verbose log messages */
+#define VERBOSE 0
+
+/* Each layer starts and ends a band at most */
+#define COMPOSE_MAX_BANDS (2 * COMPOSE_MAX_LAYERS)
+
+/* Pixels of a line from start to end, excluded */
+struct span {
+	int start;
+	int end;
+};
+
+static int add_layer(struct compose *c, const struct pl_area *area,
+		     struct compose_layer **layer);
+static int send_fills(struct compose *c, unsigned *first);
+static int send_layers(struct compose *c, unsigned first);
+static int open_images(struct compose *c, unsigned first);
+static void close_images(struct compose *c, unsigned first, unsigned last);
+static int find_bands(const struct compose *c, unsigned first,
+		      struct pl_area *bands);
+static unsigned add_boundary(int *ys, unsigned n, int y);
+static unsigned add_span(struct span *spans, unsigned n, int start, int end);
+static int send_band(struct compose *c, unsigned first,
+		     const struct pl_area *band, uint8_t *line);
+static int render_line(struct compose *c, unsigned first,
+		       const struct pl_area *band, int y, uint8_t *line);
+static int draw_span(struct compose_layer *l, int y, int start, int end,
+		     uint8_t *out);
+
+void compose_init(struct compose *c, struct pl_epdc *epdc)
+{
+	c->epdc = epdc;
+	c->n = 0;
+}
+
+int compose_add_image(struct compose *c, const char *path,
+		      const struct pl_area *area, int left, int top)
+{
+	struct compose_layer *l;
+
+	if (strlen(path) >= sizeof(l->path)) {
+		LOG("Path too long: %s", path);
+		return -1;
+	}
+
+	if (add_layer(c, area, &l))
+		return -1;
+
+	l->type = COMPOSE_IMAGE;
+	l->left_in = left;
+	l->top_in = top;
+	strcpy(l->path, path);
+
+	return 0;
+}
+
+int compose_add_fill(struct compose *c, const struct pl_area *area,
+		     uint8_t grey)
+{
+	struct compose_layer *l;
+
+	if (add_layer(c, area, &l))
+		return -1;
+
+	l->type = COMPOSE_FILL;
+	l->grey = grey;
+
+	return 0;
+}
+
+int compose_flush(struct compose *c)
+{
+	struct pl_area bands[COMPOSE_MAX_BANDS];
+	uint8_t *line;
+	unsigned first;
+	int n_bands;
+	int width;
+	int stat;
+	int i;
+
+	if (!c->n)
+		return 0;
+
+	/* Fills at the bottom are sent with the fill command, which needs no
+	 * pixel data, so only the layers above them are merged */
+	stat = send_fills(c, &first);
+
+	if (stat || (first == c->n))
+		goto exit_empty;
+
+	if (((c->n - first) < 2) || global_config.source_offset ||
+	    (c->epdc->load_area_begin == NULL))
+		n_bands = -1;
+	else
+		n_bands = find_bands(c, first, bands);
+
+	if ((n_bands < 0) || open_images(c, first)) {
+		stat = send_layers(c, first);
+		goto exit_empty;
+	}
+
+	for (i = 0, width = 0; i < n_bands; ++i)
+		width = max(width, bands[i].width);
+
+	line = malloc(width);
+
+	if (line == NULL) {
+		LOG("Not enough memory");
+		stat = -1;
+	} else {
+		for (i = 0, stat = 0; !stat && (i < n_bands); ++i)
+			stat = send_band(c, first, &bands[i], line);
+
+		free(line);
+	}
+
+	close_images(c, first, c->n);
+
+#if VERBOSE
+	LOG("%u layers sent in %d areas", (c->n - first), n_bands);
+#endif
+
+exit_empty:
+	c->n = 0;
+
+	return stat;
+}
+
+/* ----------------------------------------------------------------------------
+ * static functions
+ */
+
+static int add_layer(struct compose *c, const struct pl_area *area,
+		     struct compose_layer **layer)
+{
+	assert(area != NULL);
+
+	if ((area->width <= 0) || (area->height <= 0)) {
+		LOG("Invalid layer area");
+		return -1;
+	}
+
+	if ((c->n == COMPOSE_MAX_LAYERS) && compose_flush(c))
+		return -1;
+
+	*layer = &c->layers[c->n++];
+	(*layer)->area = *area;
+
+	return 0;
+}
+
+/* Send the fills at the bottom and set first to the index of the next
+ * layer */
+static int send_fills(struct compose *c, unsigned *first)
+{
+	struct pl_epdc *epdc = c->epdc;
+	struct pl_area areas[COMPOSE_MAX_LAYERS];
+	uint8_t greys[COMPOSE_MAX_LAYERS];
+	unsigned n;
+	int stat = 0;
+
+	for (n = 0; (n < c->n) && (c->layers[n].type == COMPOSE_FILL); ++n) {
+		areas[n] = c->layers[n].area;
+		greys[n] = c->layers[n].grey;
+	}
+
+	*first = n;
+
+	if ((n > 1) && (epdc->fill_areas != NULL)) {
+		stat = epdc->fill_areas(epdc, areas, greys, n);
+	} else {
+		unsigned i;
+
+		for (i = 0; !stat && (i < n); ++i)
+			stat = epdc->fill(epdc, &areas[i], greys[i]);
+	}
+
+	return stat;
+}
+
+/* Send the layers one by one as without composition */
+static int send_layers(struct compose *c, unsigned first)
+{
+	struct pl_epdc *epdc = c->epdc;
+	unsigned i;
+
+	for (i = first; i < c->n; ++i) {
+		struct compose_layer *l = &c->layers[i];
+		int stat;
+
+		if (l->type == COMPOSE_FILL)
+			stat = epdc->fill(epdc, &l->area, l->grey);
+		else
+			stat = epdc->load_image(epdc, l->path, &l->area,
+						l->left_in, l->top_in);
+
+		if (stat)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Open the image files, which can only be merged if they are 8-bit PGM files
+ * large enough for their area */
+static int open_images(struct compose *c, unsigned first)
+{
+	unsigned i;
+
+	for (i = first; i < c->n; ++i) {
+		struct compose_layer *l = &c->layers[i];
+		struct pnm_header hdr;
+
+		if (l->type != COMPOSE_IMAGE)
+			continue;
+
+		if (f_open(&l->f, l->path, FA_READ) != FR_OK)
+			break;
+
+		if (pnm_read_header(&l->f, &hdr) ||
+		    (hdr.type != PNM_GREYSCALE) || (hdr.max_gray > 255) ||
+		    (l->left_in < 0) || (l->top_in < 0) ||
+		    ((l->left_in + l->area.width) > hdr.width) ||
+		    ((l->top_in + l->area.height) > hdr.height)) {
+			f_close(&l->f);
+			break;
+		}
+
+		l->width = hdr.width;
+		l->data_offset = l->f.fptr;
+	}
+
+	if (i == c->n)
+		return 0;
+
+	close_images(c, first, i);
+
+	return -1;
+}
+
+static void close_images(struct compose *c, unsigned first, unsigned last)
+{
+	unsigned i;
+
+	for (i = first; i < last; ++i)
+		if (c->layers[i].type == COMPOSE_IMAGE)
+			f_close(&c->layers[i].f);
+}
+
+/* Split the union of the layers into bands of lines which are all covered
+ * by the same span, and return the number of bands or -1 if some lines have
+ * gaps between the layers */
+static int find_bands(const struct compose *c, unsigned first,
+		      struct pl_area *bands)
+{
+	int ys[2 * COMPOSE_MAX_LAYERS];
+	unsigned n_ys = 0;
+	unsigned n = 0;
+	unsigned i, j;
+
+	for (i = first; i < c->n; ++i) {
+		const struct pl_area *a = &c->layers[i].area;
+
+		n_ys = add_boundary(ys, n_ys, a->top);
+		n_ys = add_boundary(ys, n_ys, (a->top + a->height));
+	}
+
+	/* the same layers cover all the lines between two boundaries */
+	for (j = 1; j < n_ys; ++j) {
+		struct span spans[COMPOSE_MAX_LAYERS];
+		unsigned n_spans = 0;
+		struct pl_area *b = n ? &bands[n - 1] : NULL;
+
+		for (i = first; i < c->n; ++i) {
+			const struct pl_area *a = &c->layers[i].area;
+
+			if ((a->top <= ys[j - 1]) &&
+			    ((a->top + a->height) >= ys[j]))
+				n_spans = add_span(spans, n_spans, a->left,
+						   (a->left + a->width));
+		}
+
+		if (!n_spans)
+			continue;
+
+		/* the EPDC loads 2 pixels at a time */
+		if ((n_spans > 1) || (spans[0].start % 2) ||
+		    (spans[0].end % 2))
+			return -1;
+
+		if ((b != NULL) && (b->left == spans[0].start) &&
+		    (b->width == (spans[0].end - spans[0].start)) &&
+		    ((b->top + b->height) == ys[j - 1])) {
+			b->height += ys[j] - ys[j - 1];
+			continue;
+		}
+
+		b = &bands[n++];
+		b->left = spans[0].start;
+		b->top = ys[j - 1];
+		b->width = spans[0].end - spans[0].start;
+		b->height = ys[j] - ys[j - 1];
+	}
+
+	return n;
+}
+
+/* Add a value to a sorted list without duplicates */
+static unsigned add_boundary(int *ys, unsigned n, int y)
+{
+	unsigned i;
+
+	for (i = 0; (i < n) && (ys[i] < y); ++i);
+
+	if ((i < n) && (ys[i] == y))
+		return n;
+
+	memmove(&ys[i + 1], &ys[i], ((n - i) * sizeof(int)));
+	ys[i] = y;
+
+	return n + 1;
+}
+
+/* Add a span to a sorted list of disjoint spans, merge the ones which overlap
+ * or touch and return the new number of spans */
+static unsigned add_span(struct span *spans, unsigned n, int start, int end)
+{
+	unsigned i, j;
+
+	for (i = 0; (i < n) && (spans[i].end < start); ++i);
+
+	for (j = i; (j < n) && (spans[j].start <= end); ++j) {
+		start = min(start, spans[j].start);
+		end = max(end, spans[j].end);
+	}
+
+	memmove(&spans[i + 1], &spans[j], ((n - j) * sizeof(struct span)));
+	spans[i].start = start;
+	spans[i].end = end;
+
+	return n - (j - i) + 1;
+}
+
+static int send_band(struct compose *c, unsigned first,
+		     const struct pl_area *band, uint8_t *line)
+{
+	struct pl_epdc *epdc = c->epdc;
+	int stat;
+	int y;
+
+	if (epdc->load_area_begin(epdc, band))
+		return -1;
+
+	for (y = band->top, stat = 0;
+	     !stat && (y < (band->top + band->height)); ++y) {
+		stat = render_line(c, first, band, y, line);
+
+		if (!stat)
+			stat = epdc->load_area_data(epdc, line, band->width);
+	}
+
+	if (epdc->load_area_end(epdc))
+		stat = -1;
+
+	return stat;
+}
+
+/* Find the layers which are visible on a line, from the top one down, and
+ * then draw them from the bottom one up.  Each visible layer is drawn with a
+ * single span, so image lines are read with one f_read() each rather than
+ * one for each gap between the layers above. */
+static int render_line(struct compose *c, unsigned first,
+		       const struct pl_area *band, int y, uint8_t *line)
+{
+	struct span covered[COMPOSE_MAX_LAYERS];
+	struct span spans[COMPOSE_MAX_LAYERS];
+	unsigned n_covered = 0;
+	unsigned visible = 0;
+	unsigned i;
+
+	for (i = c->n; i > first; --i) {
+		struct compose_layer *l = &c->layers[i - 1];
+		const int start = max(l->area.left, band->left);
+		const int end = min((l->area.left + l->area.width),
+				    (band->left + band->width));
+		unsigned j;
+
+		if ((y < l->area.top) || (y >= (l->area.top + l->area.height))
+		    || (start >= end))
+			continue;
+
+		/* hidden when a single covered span contains it */
+		for (j = 0; (j < n_covered) && (covered[j].end < end); ++j);
+
+		if ((j == n_covered) || (covered[j].start > start)) {
+			visible |= 1 << (i - 1);
+			spans[i - 1].start = start;
+			spans[i - 1].end = end;
+		}
+
+		n_covered = add_span(covered, n_covered, start, end);
+	}
+
+	for (i = first; i < c->n; ++i) {
+		if ((visible & (1 << i)) &&
+		    draw_span(&c->layers[i], y, spans[i].start, spans[i].end,
+			      &line[spans[i].start - band->left]))
+			return -1;
+	}
+
+	return 0;
+}
+
+static int draw_span(struct compose_layer *l, int y, int start, int end,
+		     uint8_t *out)
+{
+	const UINT n = end - start;
+	DWORD pos;
+	FRESULT res;
+	UINT count;
+
+	if (l->type == COMPOSE_FILL) {
+		memset(out, l->grey, n);
+		return 0;
+	}
+
+	pos = l->data_offset + ((DWORD)(l->top_in + y - l->area.top) * l->width)
+		+ l->left_in + (start - l->area.left);
+
+	/* no need to seek when the layer is as wide as the image */
+	if ((l->f.fptr != pos) && (f_lseek(&l->f, pos) != FR_OK))
+		return -1;
+
+	PL_PROF_START(PL_PROF_SD_READ);
+	res = f_read(&l->f, out, n, &count);
+	PL_PROF_STOP(PL_PROF_SD_READ);
+
+	return ((res != FR_OK) || (count != n)) ? -1 : 0;
+}
@@ -0,0 +1,91 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * app/compose.h -- Composition of image and fill layers
+ */
+
+#ifndef INCLUDE_APP_COMPOSE_H
+#define INCLUDE_APP_COMPOSE_H 1
+
+/**
+   @file app/compose.h
+
+   Layers of images and solid fills are collected and then sent to the EPDC
+   together, the last layer added being on top.  The union of the layers is
+   generated one line at a time, reading one line from each image file which
+   is not entirely hidden by the layers above, and uploaded with a single
+   area load.  When the union has lines with gaps between the layers,
+   it is split into bands of lines which each get one area load.
+
+   Layers which can't be merged this way (image containers, images with a
+   source offset or areas with gaps on the same line) are sent one by one as
+   they would be without composition.
+*/
+
+#include <FatFs/ff.h>
+#include <pl/types.h>
+#include <stdint.h>
+
+struct pl_epdc;
+
+/** Maximum number of layers, adding one more sends the current ones */
+#define COMPOSE_MAX_LAYERS 8
+
+/** Maximum length of the image paths, same as MAX_PATH_LEN in utils.h */
+#define COMPOSE_PATH_LEN 64
+
+enum compose_layer_type {
+	COMPOSE_IMAGE,
+	COMPOSE_FILL,
+};
+
+struct compose_layer {
+	uint8_t type;           /* enum compose_layer_type */
+	uint8_t grey;           /* 8-bit grey level of a fill */
+	struct pl_area area;    /* area on the display */
+	int left_in;            /* image coordinates of the area */
+	int top_in;
+	char path[COMPOSE_PATH_LEN]; /* image file */
+	/* private */
+	FIL f;
+	int width;
+	DWORD data_offset;
+};
+
+struct compose {
+	struct pl_epdc *epdc;
+	uint8_t n;
+	struct compose_layer layers[COMPOSE_MAX_LAYERS];
+};
+
+/** Initialise an empty list of layers */
+extern void compose_init(struct compose *c, struct pl_epdc *epdc);
+
+/** Add an image layer, with the same arguments as epdc->load_image */
+extern int compose_add_image(struct compose *c, const char *path,
+			     const struct pl_area *area, int left, int top);
+
+/** Add a solid fill layer with an 8-bit grey level */
+extern int compose_add_fill(struct compose *c, const struct pl_area *area,
+			    uint8_t grey);
+
+/** Send all the layers to the EPDC and empty the list */
+extern int compose_flush(struct compose *c);
+
+#endif /* INCLUDE_APP_COMPOSE_H */
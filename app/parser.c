@@ -27,6 +27,7 @@
 #include <app/parser.h>
 #include <pl/types.h>
 #include <stdlib.h>
+#include <string.h>
 
 int parser_find_str(const char *str, const char *sep, int skip)
 {
@@ -120,7 +121,7 @@ int parser_read_area(const char *str, const char *sep, struct pl_area *a)
 
 int parser_read_file_line(FIL *f, char *buffer, int max_length)
 {
-	size_t count;
+	UINT count;
 	char *out;
 	int i;
 
@@ -50,7 +50,7 @@ int app_pattern(struct pl_platform *plat)
 	if (epdc->pattern_check(epdc, CONFIG_DEMO_PATTERN_SIZE))
 		return -1;
 
-	if (epdc->update_temp(epdc))
+	if (pl_epdc_update_temp(epdc))
 		return -1;
 
 	if (psu->on(psu))
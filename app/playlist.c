@@ -0,0 +1,241 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * app/playlist.c -- In-RAM index of the images in a directory
+ */
+
+#include <app/playlist.h>
+#include <pl/epdc.h>
+#include <FatFs/diskio.h>
+#include <string.h>
+#include "config.h"
+#include "plimg.h"
+#include "pnm-utils.h"
+#include "assert.h"
+
+#define LOG_TAG "playlist"
+#include "utils.h"
+
+static int build(struct playlist *pl);
+static int read_entry(struct playlist *pl, const FILINFO *f,
+		      struct playlist_entry *e);
+static void insert_entry(struct playlist *pl,
+			 const struct playlist_entry *e);
+
+int playlist_init(struct playlist *pl, const char *path,
+		  struct playlist_entry *entries, unsigned max)
+{
+	assert(pl != NULL);
+	assert(path != NULL);
+	assert(entries != NULL);
+	assert(max && (max <= 255));
+
+	pl->path = path;
+	pl->fs = NULL;
+	pl->fs_id = 0;
+	pl->max = max;
+	pl->n = 0;
+	pl->entries = entries;
+
+	return build(pl);
+}
+
+int playlist_refresh(struct playlist *pl)
+{
+	assert(pl != NULL);
+
+	if (!pl->stale && (pl->fs != NULL) && pl->fs->fs_type &&
+	    (pl->fs->id == pl->fs_id) &&
+	    !(disk_status(pl->fs->drv) & STA_NOINIT))
+		return 0;
+
+	LOG("Directory may have changed, building index again");
+
+	return build(pl);
+}
+
+int playlist_load(struct playlist *pl, unsigned i, struct pl_epdc *epdc,
+		  struct pl_area *area, int left, int top)
+{
+	const struct playlist_entry *e;
+	FIL f;
+	int stat;
+
+	assert(pl != NULL);
+	assert(epdc != NULL);
+	assert(i < pl->n);
+
+	e = &pl->entries[i];
+
+	if (epdc->load_image_file == NULL) {
+		char path[MAX_PATH_LEN];
+
+		if (join_path(path, sizeof(path), pl->path, e->fname))
+			return -1;
+
+		return epdc->load_image(epdc, path, area, left, top);
+	}
+
+	if (f_open_clust(&f, pl->fs, e->clust, e->size) != FR_OK) {
+		LOG("Failed to open %s", e->fname);
+		pl->stale = 1;
+		return -1;
+	}
+
+	/* full images are identified by their first cluster in the cache */
+	if ((area == NULL) && (epdc->load_image_cached != NULL))
+		stat = epdc->load_image_cached(epdc, &f, e->clust);
+	else
+		stat = epdc->load_image_file(epdc, &f, area, left, top);
+
+	f_close(&f);
+
+	return stat;
+}
+
+/* ----------------------------------------------------------------------------
+ * static functions
+ */
+
+static int build(struct playlist *pl)
+{
+	struct playlist_entry e;
+	DIR dir;
+	FILINFO f;
+	unsigned skipped = 0;
+
+	pl->n = 0;
+	pl->stale = 1;
+
+	if (f_opendir(&dir, pl->path) != FR_OK) {
+		LOG("Failed to open directory [%s]", pl->path);
+		return -1;
+	}
+
+	pl->fs = dir.fs;
+	pl->fs_id = dir.fs->id;
+
+	for (;;) {
+		if (f_readdir(&dir, &f) != FR_OK) {
+			LOG("Failed to read directory entry");
+			return -1;
+		}
+
+		/* end of the directory reached */
+		if (f.fname[0] == '\0')
+			break;
+
+		/* skip directories */
+		if ((f.fname[0] == '.') || (f.fattrib & AM_DIR))
+			continue;
+
+		/* only PGM files and image containers */
+		if (!strstr(f.fname, ".PGM") && !strstr(f.fname, ".PLI"))
+			continue;
+
+		/* when full, keep the first file names in the display order */
+		if ((pl->n == pl->max) &&
+		    (strcmp(f.fname, pl->entries[pl->n - 1].fname) > 0)) {
+			skipped++;
+			continue;
+		}
+
+		if (read_entry(pl, &f, &e)) {
+			LOG("Skipping %s", f.fname);
+			continue;
+		}
+
+		/* the last entry is dropped to make room */
+		if (pl->n == pl->max)
+			skipped++;
+
+		insert_entry(pl, &e);
+	}
+
+	pl->stale = 0;
+	LOG("%u images in %s", pl->n, pl->path);
+
+	if (skipped)
+		LOG("Playlist full, %u more image(s) skipped", skipped);
+
+	return 0;
+}
+
+static int read_entry(struct playlist *pl, const FILINFO *f,
+		      struct playlist_entry *e)
+{
+	struct plimg_header plimg_hdr;
+	struct pnm_header pnm_hdr;
+	FIL file;
+	UINT count;
+	int stat = -1;
+
+	if (f_open_clust(&file, pl->fs, f->fclust, f->fsize) != FR_OK)
+		return -1;
+
+	e->clust = f->fclust;
+	e->size = f->fsize;
+	strcpy(e->fname, f->fname);
+
+	if (f_read(&file, &plimg_hdr, sizeof(plimg_hdr), &count) != FR_OK)
+		goto exit_close;
+
+	if ((count == sizeof(plimg_hdr)) &&
+	    !memcmp(plimg_hdr.magic, PLIMG_MAGIC, sizeof(plimg_hdr.magic))) {
+		/* the rest of the header is checked when loading the image */
+		if (plimg_check_config(&plimg_hdr, &global_config))
+			goto exit_close;
+
+		e->format = PLAYLIST_PLIMG;
+		e->width = plimg_hdr.src_width;
+		e->height = plimg_hdr.src_height;
+	} else {
+		if ((f_lseek(&file, 0) != FR_OK) ||
+		    pnm_read_header(&file, &pnm_hdr))
+			goto exit_close;
+
+		e->format = PLAYLIST_PGM;
+		e->width = pnm_hdr.width;
+		e->height = pnm_hdr.height;
+	}
+
+	stat = 0;
+
+exit_close:
+	f_close(&file);
+
+	return stat;
+}
+
+/* Keep the entries sorted by file name, which is the display order.  When
+ * full, the new entry sorts before the last one which is dropped. */
+static void insert_entry(struct playlist *pl, const struct playlist_entry *e)
+{
+	unsigned i;
+
+	if (pl->n == pl->max)
+		pl->n--;
+
+	for (i = pl->n; i && (strcmp(pl->entries[i - 1].fname, e->fname) > 0);
+	     --i)
+		pl->entries[i] = pl->entries[i - 1];
+
+	pl->entries[i] = *e;
+	pl->n++;
+}
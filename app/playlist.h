@@ -0,0 +1,85 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * app/playlist.h -- In-RAM index of the images in a directory
+ */
+
+#ifndef INCLUDE_APP_PLAYLIST_H
+#define INCLUDE_APP_PLAYLIST_H 1
+
+/**
+   @file app/playlist.h
+
+   The directory is read once to build an array of entries with the start
+   cluster, size and header of each image file, sorted by file name which is
+   also the display order.  Images are then opened with f_open_clust()
+   without following their path again.  The index is only built again when
+   the SD card has been re-mounted or when an entry can't be opened any more,
+   for example when the card has been replaced.
+
+   The number of entries is fixed when the playlist is initialised, up to
+   255.  When there are more images, only the first ones by file name are
+   kept.  The slideshow uses CONFIG_PLAYLIST_ENTRIES entries.
+*/
+
+#include <FatFs/ff.h>
+#include <stdint.h>
+
+struct pl_epdc;
+struct pl_area;
+
+enum playlist_format {
+	PLAYLIST_PGM,
+	PLAYLIST_PLIMG,
+};
+
+struct playlist_entry {
+	DWORD clust;            /* start cluster */
+	DWORD size;             /* file size in bytes */
+	uint16_t width;         /* image width, before scrambling */
+	uint16_t height;        /* image height, before scrambling */
+	uint8_t format;         /* enum playlist_format */
+	char fname[13];         /* 8.3 file name, for logs and as fallback */
+};
+
+struct playlist {
+	const char *path;
+	FATFS *fs;
+	WORD fs_id;
+	uint8_t stale;
+	uint8_t max;
+	uint8_t n;
+	struct playlist_entry *entries;
+};
+
+/** Initialise a playlist with an array of max entries and build the index
+ * of the images in the given directory. */
+extern int playlist_init(struct playlist *pl, const char *path,
+			 struct playlist_entry *entries, unsigned max);
+
+/** Build the index again if the directory may have changed, this is cheap
+ * when nothing needs to be done. */
+extern int playlist_refresh(struct playlist *pl);
+
+/** Load image number i in the EPDC, same arguments as epdc->load_image */
+extern int playlist_load(struct playlist *pl, unsigned i,
+			 struct pl_epdc *epdc, struct pl_area *area,
+			 int left, int top);
+
+#endif /* INCLUDE_APP_PLAYLIST_H */
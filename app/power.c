@@ -26,46 +26,39 @@
  */
 
 #include <app/app.h>
+#include <app/playlist.h>
 #include <pl/platform.h>
 #include <pl/epdc.h>
-#include <string.h>
 
 #define LOG_TAG "power-demo"
 #include "utils.h"
 
+static int restore_image(struct playlist *pl, struct pl_epdc *epdc);
+
 int app_power(struct pl_platform *plat, const char *path)
 {
 	struct pl_epdc *epdc = &plat->epdc;
 	struct pl_epdpsu *psu = &plat->psu;
+	struct playlist_entry entry;
+	struct playlist pl;
 	int wfid;
-	char full_path[MAX_PATH_LEN];
-	DIR dir;
-	FILINFO f;
 
 	wfid = pl_epdc_get_wfid(epdc, 2);
 
 	if (wfid < 0)
 		return -1;
 
-	if (f_opendir(&dir, path) != FR_OK) {
-		LOG("Failed to open directory [%s]", path);
+	/* only keep the first image found in the directory */
+	if (playlist_init(&pl, path, &entry, 1))
 		return -1;
-	}
-
-	do {
-		if (f_readdir(&dir, &f) != FR_OK) {
-			LOG("Failed to read directory entry");
-			return -1;
-		} else if (f.fname[0] == '\0') {
-			LOG("No image file found");
-			return -1;
-		}
-	} while ((f.fname[0] == '.') || !strstr(f.fname, ".PGM"));
 
-	if (join_path(full_path, sizeof(full_path), path, f.fname))
+	if (!pl.n) {
+		LOG("No image file found");
 		return -1;
+	}
 
-	LOG("Running power sequence demo using image: %s", full_path);
+	LOG("Running power sequence demo using image: %s/%s", path,
+	    entry.fname);
 
 	while (!app_stop) {
 		/* --- RUN mode --- */
@@ -75,7 +68,8 @@ int app_power(struct pl_platform *plat, const char *path)
 		if (epdc->set_power(epdc, PL_EPDC_RUN))
 			return -1;
 
-		if (epdc->load_image(epdc, full_path, NULL, 0, 0))
+		if (playlist_refresh(&pl) || !pl.n ||
+		    playlist_load(&pl, 0, epdc, NULL, 0, 0))
 			return -1;
 
 		if (epdc->set_power(epdc, PL_EPDC_RUN))
@@ -108,7 +102,8 @@ int app_power(struct pl_platform *plat, const char *path)
 
 		LOG("RUN");
 
-		if (epdc->set_power(epdc, PL_EPDC_RUN))
+		if (epdc->set_power(epdc, PL_EPDC_RUN) ||
+		    restore_image(&pl, epdc))
 			return -1;
 
 		if (pl_epdc_single_update(epdc, psu, wfid, UPDATE_FULL, NULL))
@@ -125,14 +120,34 @@ int app_power(struct pl_platform *plat, const char *path)
 
 		LOG("Resuming now");
 
-		if (epdc->set_power(epdc, PL_EPDC_RUN))
+		if (epdc->set_power(epdc, PL_EPDC_RUN) ||
+		    restore_image(&pl, epdc))
 			return -1;
 
 		if (pl_epdc_single_update(epdc, psu, wfid, UPDATE_FULL, NULL))
 			return -1;
 
+		/* the resume after STANDBY is recorded as from SLEEP */
+		LOG("Resume time: sleep %lu us, off %lu us",
+		    (unsigned long)epdc->resume_us[PL_EPDC_SLEEP],
+		    (unsigned long)epdc->resume_us[PL_EPDC_OFF]);
+
 		msleep(1000);
 	}
 
 	return 0;
 }
+
+/* Load the image again if it was lost in the previous power state */
+static int restore_image(struct playlist *pl, struct pl_epdc *epdc)
+{
+	if (!epdc->image_lost)
+		return 0;
+
+	LOG("Image lost, loading it again");
+
+	if (playlist_refresh(pl) || !pl->n)
+		return -1;
+
+	return playlist_load(pl, 0, epdc, NULL, 0, 0);
+}
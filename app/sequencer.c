@@ -25,13 +25,18 @@
  */
 
 #include <app/app.h>
+#include <app/compose.h>
 #include <app/parser.h>
 #include <pl/platform.h>
 #include <pl/epdc.h>
+#include <pl/prof.h>
+#include <pl/trace.h>
 #include <pl/types.h>
 #include <stdlib.h>
 #include <string.h>
 #include "assert.h"
+#include "font.h"
+#include "pattern.h"
 
 #define LOG_TAG "sequencer"
 #include "utils.h"
@@ -49,16 +54,32 @@ struct sequencer_item {
 
 static const char SEP[] = ", ";
 
+/* Area of the last image, fill, pattern or text command, used by "update"
+ * with "last" instead of the area coordinates */
+static struct pl_area last_area;
+
+#if CONFIG_SEQUENCER_COMPOSE
+/* Image and fill layers waiting for the next command of another kind */
+static struct compose compose;
+#endif
+
 /* -- private functions -- */
 
 static int load_image(struct pl_epdc *epdc, const struct sequencer_item *item,
 		      const char *dir);
 static int parse_item(const char *line, struct sequencer_item *item);
+static int read_opt_ints(const char *opt, int len, int **list);
+static int flush_layers(int (*next)(struct pl_platform *plat,
+				    const char *line));
 static int cmd_sleep(struct pl_platform *plat, const char *line);
 static int cmd_image(struct pl_platform *plat, const char *line);
 static int cmd_fill(struct pl_platform *plat, const char *line);
+static int cmd_pattern(struct pl_platform *plat, const char *line);
+static int cmd_text(struct pl_platform *plat, const char *line);
 static int cmd_power(struct pl_platform *plat, const char *line);
 static int cmd_update(struct pl_platform *plat, const char *line);
+static int cmd_profile(struct pl_platform *plat, const char *line);
+static int cmd_trace(struct pl_platform *plat, const char *line);
 
 /* -- public entry point -- */
 
@@ -78,6 +99,10 @@ int app_sequencer(struct pl_platform *plat, const char *path)
 	stat = 0;
 	lno = 0;
 
+#if CONFIG_SEQUENCER_COMPOSE
+	compose_init(&compose, &plat->epdc);
+#endif
+
 	while (!stat) {
 		struct cmd {
 			const char *name;
@@ -87,8 +112,12 @@ int app_sequencer(struct pl_platform *plat, const char *path)
 			{ "update", cmd_update },
 			{ "power", cmd_power },
 			{ "fill", cmd_fill },
+			{ "pattern", cmd_pattern },
+			{ "text", cmd_text },
 			{ "image", cmd_image },
 			{ "sleep", cmd_sleep },
+			{ "profile", cmd_profile },
+			{ "trace", cmd_trace },
 			{ NULL, NULL }
 		};
 		const struct cmd *cmd;
@@ -125,7 +154,11 @@ int app_sequencer(struct pl_platform *plat, const char *path)
 
 		for (cmd = cmd_table; cmd->name != NULL; ++cmd) {
 			if (!strcmp(cmd->name, cmd_name)) {
-				stat = cmd->func(plat, (line + len));
+				stat = flush_layers(cmd->func);
+
+				if (!stat)
+					stat = cmd->func(plat, (line + len));
+
 				break;
 			}
 		}
@@ -160,8 +193,13 @@ static int load_image(struct pl_epdc *epdc, const struct sequencer_item *item,
 	    item->area.top, item->area.width, item->area.height);
 #endif
 
+#if CONFIG_SEQUENCER_COMPOSE
+	return compose_add_image(&compose, path, &item->area, item->left_in,
+				 item->top_in);
+#else
 	return epdc->load_image(epdc, path, (struct pl_area*) &item->area, item->left_in,
 				item->top_in);
+#endif
 }
 
 static int parse_item(const char *line, struct sequencer_item *item)
@@ -206,14 +244,43 @@ exit_now:
 	return -1;
 }
 
+/* Send the image and fill layers before running any other command */
+static int flush_layers(int (*next)(struct pl_platform *plat,
+				    const char *line))
+{
+#if CONFIG_SEQUENCER_COMPOSE
+	if ((next != cmd_image) && (next != cmd_fill))
+		return compose_flush(&compose);
+#endif
+
+	return 0;
+}
+
+/* Read the optional integers after the field of length len at opt, until
+ * the end of the line.  The length of the last field on the line does not
+ * include its last character, so a field only follows a separator. */
+static int read_opt_ints(const char *opt, int len, int **list)
+{
+	while ((*list != NULL) && (len > 0) && strchr(SEP, opt[len - 1])) {
+		opt += len;
+		len = parser_read_int(opt, SEP, *list++);
+
+		if (len < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
 static int cmd_update(struct pl_platform *plat, const char *line)
 {
-	// update structure: update, wfid, update_mode, area->left, area->top, area->width, area->height,delay_ms
+	// update structure: update, wfid, update_mode, area->left, area->top, area->width, area->height (or last),delay_ms
 	struct pl_epdc *epdc = &plat->epdc;
 	//char waveform[16];
 	//char update_mode[16];
 	enum pl_update_mode update_mode;
 	struct pl_area area;
+	char area_name[8];
 	int delay_ms;
 	const char *opt;
 	int len;
@@ -234,7 +301,18 @@ static int cmd_update(struct pl_platform *plat, const char *line)
 		return -1;
 
 	opt += len;
-	len = parser_read_area(opt, SEP, &area);
+	len = parser_read_str(opt, SEP, area_name, sizeof(area_name));
+
+	if ((len > 0) && !strcmp(area_name, "last")) {
+		if (!last_area.width) {
+			LOG("No area loaded yet");
+			return -1;
+		}
+
+		area = last_area;
+	} else {
+		len = parser_read_area(opt, SEP, &area);
+	}
 
 	if (len <= 0)
 		return -1;
@@ -271,7 +349,7 @@ static int cmd_power(struct pl_platform *plat, const char *line)
 		return -1;
 
 	if (!strcmp(on_off, "on")) {
-		if (epdc->update_temp(epdc))
+		if (pl_epdc_update_temp(epdc))
 			return -1;
 
 		if (psu->on(psu))
@@ -315,7 +393,264 @@ static int cmd_fill(struct pl_platform *plat, const char *line)
 		return -1;
 	}
 
-	return epdc->fill(epdc, &area, PL_GL16(gl));
+#if CONFIG_SEQUENCER_COMPOSE
+	if (compose_add_fill(&compose, &area, PL_GL16(gl)))
+#else
+	if (epdc->fill(epdc, &area, PL_GL16(gl)))
+#endif
+		return -1;
+
+	last_area = area;
+
+	return 0;
+}
+
+/* pattern, type, left, top, width, height[, size[, fg[, bg]]] */
+static int cmd_pattern(struct pl_platform *plat, const char *line)
+{
+	struct pl_epdc *epdc = &plat->epdc;
+	struct pattern pat;
+	struct pl_area area;
+	char name[16];
+	int size = 0, fg = 0, bg = 15;
+	int *opts[] = { &size, &fg, &bg, NULL };
+	uint8_t *buffer;
+	const char *opt;
+	uint16_t y;
+	int len;
+	int type;
+	int stat;
+
+	opt = line;
+	len = parser_read_str(opt, SEP, name, sizeof(name));
+
+	if (len <= 0)
+		return -1;
+
+	opt += len;
+	len = parser_read_area(opt, SEP, &area);
+
+	if ((len < 0) || read_opt_ints(opt, len, opts))
+		return -1;
+
+	type = pattern_find(name);
+
+	if (type < 0) {
+		LOG("Invalid pattern: %s", name);
+		return -1;
+	}
+
+	if ((fg < 0) || (fg > 15) || (bg < 0) || (bg > 15) || (size < 0)) {
+		LOG("Invalid pattern size or grey level");
+		return -1;
+	}
+
+	if ((area.width <= 0) || (area.height <= 0) || (area.width % 2) ||
+	    (area.left < 0) || (area.top < 0) ||
+	    ((area.left + area.width) > epdc->xres) ||
+	    ((area.top + area.height) > epdc->yres)) {
+		LOG("Invalid pattern area");
+		return -1;
+	}
+
+	if (epdc->load_area_begin == NULL) {
+		LOG("Loading areas from memory not supported");
+		return -1;
+	}
+
+	pat.type = type;
+	pat.width = area.width;
+	pat.height = area.height;
+	pat.size = size;
+	pat.fg = PL_GL16(fg);
+	pat.bg = PL_GL16(bg);
+	pat.bpp = 8;
+
+	/* two line templates, enough for all the patterns */
+	buffer = malloc(2 * PATTERN_LINE_SIZE(pat.width, pat.bpp));
+
+	if (buffer == NULL) {
+		LOG("Not enough memory");
+		return -1;
+	}
+
+	stat = pattern_init(&pat, buffer,
+			    2 * PATTERN_LINE_SIZE(pat.width, pat.bpp));
+
+	if (!stat)
+		stat = epdc->load_area_begin(epdc, &area);
+
+	if (!stat) {
+		for (y = 0; !stat && (y < pat.height); ++y)
+			stat = epdc->load_area_data(epdc,
+						    pattern_line(&pat, y),
+						    pat.line_size);
+
+		if (epdc->load_area_end(epdc))
+			stat = -1;
+	}
+
+	free(buffer);
+
+	if (!stat)
+		last_area = area;
+
+	return stat;
+}
+
+/* text, font, left, top, width, height, fg, bg, scale, string
+ * The font is either 5x9 for the built-in font or a file in the font
+ * directory, and a width or height of 0 makes the area fit the text. */
+static int cmd_text(struct pl_platform *plat, const char *line)
+{
+	struct pl_epdc *epdc = &plat->epdc;
+	struct font file_font;
+	struct font_text text;
+	struct pl_area area;
+	char name[16];
+	char path[MAX_PATH_LEN];
+	int fg, bg, scale;
+	int *opts[] = { &area.left, &area.top, &area.width, &area.height,
+			&fg, &bg, &scale, NULL };
+	const struct font *font;
+	uint8_t *buffer;
+	size_t row_size;
+	size_t line_size;
+	const char *opt;
+	FIL f;
+	uint16_t x, y;
+	int len;
+	int stat;
+
+	opt = line;
+	len = parser_read_str(opt, SEP, name, sizeof(name));
+
+	if (len <= 0)
+		return -1;
+
+	opt += len;
+	len = parser_read_int_list(opt, SEP, opts);
+
+	if (len <= 0) {
+		if (!len)
+			LOG("Not enough arguments");
+
+		return -1;
+	}
+
+	if ((fg < 0) || (fg > 15) || (bg < 0) || (bg > 15) || (scale < 1) ||
+	    (scale > 255)) {
+		LOG("Invalid text scale or grey level");
+		return -1;
+	}
+
+	if (epdc->load_area_begin == NULL) {
+		LOG("Loading areas from memory not supported");
+		return -1;
+	}
+
+	if (!strcmp(name, "5x9")) {
+		font = &font_5x9;
+	} else {
+		if (join_path(path, sizeof(path), "font", name))
+			return -1;
+
+		if (f_open(&f, path, FA_READ) != FR_OK) {
+			LOG("Failed to open font file [%s]", path);
+			return -1;
+		}
+
+		if (font_open(&file_font, &f)) {
+			f_close(&f);
+			return -1;
+		}
+
+		font = &file_font;
+	}
+
+	text.font = font;
+	text.text = opt + len;
+	text.scale = scale;
+	text.fg = PL_GL16(fg);
+	text.bg = PL_GL16(bg);
+
+	if (!area.width)
+		area.width = ((font_text_width(font, text.text) * scale) + 1) &
+			~1;
+
+	if (!area.height)
+		area.height = font->height * scale;
+
+	buffer = NULL;
+	stat = -1;
+
+	if ((area.width <= 0) || (area.height <= 0) || (area.width % 2) ||
+	    (area.left < 0) || (area.top < 0) ||
+	    ((area.left + area.width) > epdc->xres) ||
+	    ((area.top + area.height) > epdc->yres)) {
+		LOG("Invalid text area");
+		goto exit_close;
+	}
+
+	/* one line of pixels and one strike line for fonts on the SD card */
+	row_size = (font->f != NULL) ? font->row_size : 0;
+	text.width = area.width;
+	buffer = malloc(area.width + row_size);
+
+	if (buffer == NULL) {
+		LOG("Not enough memory");
+		goto exit_close;
+	}
+
+	stat = font_text_init(&text, (row_size ? &buffer[area.width] : NULL),
+			      row_size);
+
+	/* text only has 16 grey levels, so send 2 pixels per byte when the
+	 * EPDC can take them to halve the data on the bus */
+	if ((epdc->load_area_begin_4bpp != NULL) && !(area.width % 4)) {
+		line_size = area.width / 2;
+
+		if (!stat)
+			stat = epdc->load_area_begin_4bpp(epdc, &area);
+	} else {
+		line_size = area.width;
+
+		if (!stat)
+			stat = epdc->load_area_begin(epdc, &area);
+	}
+
+	if (!stat) {
+		for (y = 0; !stat && (y < area.height); ++y) {
+			stat = font_text_line(&text, y, buffer);
+
+			/* pack in place, first pixel in the low nibble */
+			if (!stat && (line_size != area.width)) {
+				for (x = 0; x < line_size; ++x)
+					buffer[x] = (buffer[2 * x] >> 4) |
+						(buffer[(2 * x) + 1] & 0xF0);
+			}
+
+			if (!stat)
+				stat = epdc->load_area_data(epdc, buffer,
+							    line_size);
+		}
+
+		if (epdc->load_area_end(epdc))
+			stat = -1;
+	}
+
+	if (!stat)
+		last_area = area;
+
+exit_close:
+	free(buffer);
+
+	if (font == &file_font) {
+		font_close(&file_font);
+		f_close(&f);
+	}
+
+	return stat;
 }
 
 static int cmd_image(struct pl_platform *plat, const char *line)
@@ -328,6 +663,8 @@ static int cmd_image(struct pl_platform *plat, const char *line)
 	if (load_image(&plat->epdc, &item, "img"))
 		return -1;
 
+	last_area = item.area;
+
 	return 0;
 }
 
@@ -350,3 +687,51 @@ static int cmd_sleep(struct pl_platform *plat, const char *line)
 
 	return 0;
 }
+
+static int cmd_profile(struct pl_platform *plat, const char *line)
+{
+	char action[8];
+
+	if (parser_read_str(line, SEP, action, sizeof(action)) < 0)
+		return -1;
+
+	if (!strcmp(action, "report")) {
+		const struct pl_epdc_temp_cache *t = &plat->epdc.temp;
+
+		pl_prof_report();
+		LOG("temperature: %u samples, %u cached, %u waveform reloads",
+		    t->samples, t->cached, t->reloads);
+	} else if (!strcmp(action, "reset")) {
+		pl_prof_reset();
+	} else {
+		LOG("Invalid profile action: %s", action);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int cmd_trace(struct pl_platform *plat, const char *line)
+{
+	char action[8];
+
+	if (parser_read_str(line, SEP, action, sizeof(action)) < 0)
+		return -1;
+
+#if CONFIG_EPDC_TRACE
+	if (!strcmp(action, "start")) {
+		pl_trace_start(&pl_trace_ram_sink);
+	} else if (!strcmp(action, "stop")) {
+		pl_trace_stop();
+	} else if (!strcmp(action, "dump")) {
+		pl_trace_ram_dump();
+	} else {
+		LOG("Invalid trace action: %s", action);
+		return -1;
+	}
+#else
+	LOG("Trace not enabled, set CONFIG_EPDC_TRACE to 1");
+#endif
+
+	return 0;
+}
@@ -26,66 +26,62 @@
  */
 
 #include "app.h"
+#include <app/playlist.h>
 #include <pl/platform.h>
 #include <pl/epdc.h>
 #include <pl/epdpsu.h>
+#include <pl/prof.h>
 #include <stdio.h>
-#include <string.h>
 #include "assert.h"
+#include "config.h"
 
 #define LOG_TAG "slideshow"
 #include "utils.h"
 
 /* -- private functions -- */
 
-static int show_image(struct pl_platform *plat, const char *dir,
-		      const char *file);
+static int show_image(struct pl_platform *plat, struct playlist *pl,
+		      unsigned i);
 
 /* -- public entry point -- */
 
 int app_slideshow(struct pl_platform *plat, const char *path)
 {
-	DIR dir;
-	FILINFO f;
-	int dir_open = 0;
+	static struct playlist_entry entries[CONFIG_PLAYLIST_ENTRIES];
+	struct playlist pl;
+	unsigned i = 0;
 
 	assert(plat != NULL);
 	assert(path != NULL);
 
 	LOG("Running slideshow");
 
+	if (playlist_init(&pl, path, entries, ARRAY_SIZE(entries)))
+		return -1;
+
 	while (!app_stop) {
-		if (!dir_open) {
-			/* (re-)open the directory */
-			if (f_opendir(&dir, path) != FR_OK) {
-				LOG("Failed to open directory [%s]", path);
-				return -1;
-			}
-
-			dir_open = 1;
-		}
+		if (playlist_refresh(&pl))
+			return -1;
 
-		/* read next entry in the directory */
-		if (f_readdir(&dir, &f) != FR_OK) {
-			LOG("Failed to read directory entry");
+		if (!pl.n) {
+			LOG("No image file found");
 			return -1;
 		}
 
-		/* end of the directory reached */
-		if (f.fname[0] == '\0') {
-			dir_open = 0;
-			continue;
+		/* end of the playlist reached */
+		if (i >= pl.n) {
+			i = 0;
+#if CONFIG_PROFILE
+			pl_prof_report();
+			pl_prof_reset();
+#endif
 		}
 
-		/* skip directories */
-		if ((f.fname[0] == '.') || (f.fattrib & AM_DIR))
-			continue;
+		if (show_image(plat, &pl, i++)) {
+			/* the index will be built again on the next iteration */
+			if (pl.stale)
+				continue;
 
-		/* only show PGM files */
-		if (!strstr(f.fname, ".PGM"))
-			continue;
-
-		if (show_image(plat, path, f.fname)) {
 			LOG("Failed to show image");
 			return -1;
 		}
@@ -94,12 +90,11 @@ int app_slideshow(struct pl_platform *plat, const char *path)
 	return 0;
 }
 
-static int show_image(struct pl_platform *plat, const char *dir,
-		      const char *file)
+static int show_image(struct pl_platform *plat, struct playlist *pl,
+		      unsigned i)
 {
 	struct pl_epdc *epdc = &plat->epdc;
 	struct pl_epdpsu *psu = &plat->psu;
-	char path[MAX_PATH_LEN];
 	int wfid;
 
 	wfid = pl_epdc_get_wfid(epdc, 2);
@@ -107,13 +102,10 @@ static int show_image(struct pl_platform *plat, const char *dir,
 	if (wfid < 0)
 		return -1;
 
-	if (join_path(path, sizeof(path), dir, file))
-		return -1;
-
-	if (epdc->load_image(epdc, path, NULL, 0, 0))
+	if (playlist_load(pl, i, epdc, NULL, 0, 0))
 		return -1;
 
-	if (epdc->update_temp(epdc))
+	if (pl_epdc_update_temp(epdc))
 		return -1;
 
 	if (psu->on(psu))
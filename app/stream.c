@@ -0,0 +1,584 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * app/stream.c -- Serial image streaming app
+ */
+
+#include <app/app.h>
+#include <app/stream.h>
+#include <pl/platform.h>
+#include <pl/serial.h>
+#include <pl/epdc.h>
+#include <pl/types.h>
+#include <string.h>
+#include "crc16.h"
+#include "lzss.h"
+#include "assert.h"
+
+#define LOG_TAG "stream"
+#include "utils.h"
+
+/* Set to 1 to enable verbose log messages */
+#define VERBOSE 0
+
+/* Time to wait for the next command, then check app_stop */
+#define IDLE_TIMEOUT_MS 1000
+
+/* Time to wait for a command while the wflib is being loaded in chunks */
+#define WFLIB_POLL_MS 2
+
+/* Time to wait for the next DATA frame while loading an image */
+#define DATA_TIMEOUT_MS 2000
+
+/* Size of the buffer used to send pixels to the EPDC, must be even */
+#define OUT_BUFFER_SIZE 128
+
+struct stream {
+	struct pl_platform *plat;
+	struct pl_serial *serial;
+	uint32_t stats[STREAM_STAT_N];
+
+	/* current frame */
+	uint8_t frame[STREAM_MAX_FRAME];
+	uint8_t type;
+	uint8_t seq;
+	uint16_t len;
+	const uint8_t *payload;
+
+	/* current image load */
+	uint32_t data_left;     /* DATA payload bytes still to be received */
+	uint32_t pixels_left;   /* pixels still to be sent to the EPDC */
+	uint8_t data_seq;       /* sequence number of the next DATA frame */
+	uint16_t in_pos;        /* position in the current DATA payload */
+	uint16_t out_len;       /* number of bytes in out */
+	uint16_t out[OUT_BUFFER_SIZE / 2]; /* 16-bit aligned for the EPDC */
+	char lzss_buffer[LZSS_BUFFER_SIZE(STREAM_LZSS_EI)];
+};
+
+static struct stream g_stream;
+
+/* -- private functions -- */
+
+static int read_frame(struct stream *s, unsigned timeout_ms);
+static int send_reply(struct stream *s, uint8_t status, const uint8_t *data,
+		      uint16_t len);
+static int cmd_query_stats(struct stream *s);
+static int cmd_load_area(struct stream *s);
+static int cmd_fill(struct stream *s);
+static int cmd_update(struct stream *s);
+static int cmd_power(struct stream *s);
+static int read_area(const uint8_t *data, struct pl_area *area);
+static uint16_t get_le16(const uint8_t *data);
+static uint32_t get_le32(const uint8_t *data);
+static void put_le32(uint8_t *data, uint32_t value);
+
+/* -- public entry point -- */
+
+int app_stream(struct pl_platform *plat)
+{
+	struct stream *s = &g_stream;
+	int stat = 0;
+
+	assert(plat != NULL);
+
+	if (plat->serial == NULL) {
+		LOG("No serial port");
+		return -1;
+	}
+
+	memset(s, 0, sizeof(*s));
+	s->plat = plat;
+	s->serial = plat->serial;
+
+	LOG("Waiting for commands");
+
+	while (!app_stop && !stat) {
+		const int wflib_pending =
+			(plat->epdc.wflib_state == PL_EPDC_WFLIB_PENDING);
+		int ret = read_frame(s, (wflib_pending ? WFLIB_POLL_MS :
+					 IDLE_TIMEOUT_MS));
+
+		if (ret < 0) {
+			stat = send_reply(s, STREAM_ERR_CRC, NULL, 0);
+			continue;
+		}
+
+		/* load the waveform library while there is nothing to do */
+		if (!ret) {
+			if (wflib_pending)
+				pl_epdc_wflib_poll(&plat->epdc);
+			continue;
+		}
+
+#if VERBOSE
+		LOG("cmd 0x%02X, seq %u, len %u", s->type, s->seq, s->len);
+#endif
+
+		switch (s->type) {
+		case STREAM_CMD_QUERY_STATS:
+			stat = cmd_query_stats(s);
+			break;
+		case STREAM_CMD_LOAD_AREA:
+			stat = cmd_load_area(s);
+			break;
+		case STREAM_CMD_DATA:
+			/* not expected outside of a load */
+			stat = send_reply(s, STREAM_ERR_SEQ, NULL, 0);
+			break;
+		case STREAM_CMD_FILL:
+			stat = cmd_fill(s);
+			break;
+		case STREAM_CMD_UPDATE:
+			stat = cmd_update(s);
+			break;
+		case STREAM_CMD_POWER:
+			stat = cmd_power(s);
+			break;
+		default:
+			stat = send_reply(s, STREAM_ERR_CMD, NULL, 0);
+			break;
+		}
+	}
+
+	return stat;
+}
+
+/* ----------------------------------------------------------------------------
+ * private functions
+ */
+
+/* Return 1 if a valid frame was received, 0 if timeout and -1 if the frame
+ * was discarded because of an invalid CRC */
+static int read_frame(struct stream *s, unsigned timeout_ms)
+{
+	struct pl_serial *serial = s->serial;
+	uint8_t *hdr = s->frame;
+	uint16_t crc;
+
+	for (;;) {
+		if (serial->read(serial, hdr, 1, timeout_ms) != 1)
+			return 0;
+
+		if (hdr[0] != STREAM_SOF) {
+			s->stats[STREAM_STAT_JUNK]++;
+			continue;
+		}
+
+		if (serial->read(serial, &hdr[1], (STREAM_HEADER_SIZE - 1),
+				 timeout_ms) != (STREAM_HEADER_SIZE - 1))
+			return 0;
+
+		s->len = get_le16(&hdr[3]);
+
+		/* not a real frame, look for the next SOF */
+		if (s->len > STREAM_MAX_PAYLOAD) {
+			s->stats[STREAM_STAT_JUNK] += STREAM_HEADER_SIZE;
+			continue;
+		}
+
+		break;
+	}
+
+	s->type = hdr[1];
+	s->seq = hdr[2];
+	s->payload = &hdr[STREAM_HEADER_SIZE];
+
+	if (serial->read(serial, &hdr[STREAM_HEADER_SIZE],
+			 (s->len + STREAM_CRC_SIZE), timeout_ms)
+	    != (s->len + STREAM_CRC_SIZE))
+		return 0;
+
+	crc = crc16_run(crc16_init, &hdr[1], (STREAM_HEADER_SIZE - 1 + s->len));
+
+	if (crc != get_le16(&s->payload[s->len])) {
+		s->stats[STREAM_STAT_CRC_ERRORS]++;
+		return -1;
+	}
+
+	s->stats[STREAM_STAT_FRAMES]++;
+	s->stats[STREAM_STAT_BYTES] += s->len;
+
+	return 1;
+}
+
+static int send_reply(struct stream *s, uint8_t status, const uint8_t *data,
+		      uint16_t len)
+{
+	uint8_t hdr[STREAM_HEADER_SIZE + 1];
+	uint8_t crc_le[STREAM_CRC_SIZE];
+	uint16_t crc;
+
+	hdr[0] = STREAM_SOF;
+	hdr[1] = s->type | STREAM_REPLY;
+	hdr[2] = s->seq;
+	hdr[3] = (len + 1) & 0xFF;
+	hdr[4] = ((len + 1) >> 8) & 0xFF;
+	hdr[5] = status;
+
+	crc = crc16_run(crc16_init, &hdr[1], (sizeof(hdr) - 1));
+	crc = crc16_run(crc, data, len);
+	crc_le[0] = crc & 0xFF;
+	crc_le[1] = (crc >> 8) & 0xFF;
+
+	if (status != STREAM_OK)
+		LOG("Error %u on command 0x%02X, seq %u", status, s->type,
+		    s->seq);
+
+	if (s->serial->write(s->serial, hdr, sizeof(hdr)))
+		return -1;
+
+	if (len && s->serial->write(s->serial, data, len))
+		return -1;
+
+	return s->serial->write(s->serial, crc_le, sizeof(crc_le));
+}
+
+static int cmd_query_stats(struct stream *s)
+{
+	uint8_t data[STREAM_STAT_N * 4];
+	unsigned i;
+
+	if (s->serial->get_overruns != NULL)
+		s->stats[STREAM_STAT_RX_OVERRUNS] =
+			s->serial->get_overruns(s->serial);
+
+	for (i = 0; i < STREAM_STAT_N; ++i)
+		put_le32(&data[i * 4], s->stats[i]);
+
+	return send_reply(s, STREAM_OK, data, sizeof(data));
+}
+
+/* -- image loading -- */
+
+static int put_pixels(struct stream *s, const uint8_t *data, size_t n)
+{
+	struct pl_epdc *epdc = &s->plat->epdc;
+	uint8_t *out = (uint8_t *)s->out;
+
+	/* silently drop anything beyond the end of the area */
+	if (n > s->pixels_left)
+		n = s->pixels_left;
+
+	s->pixels_left -= n;
+	s->stats[STREAM_STAT_PIXELS] += n;
+
+	while (n) {
+		const size_t chunk = min(n, (OUT_BUFFER_SIZE - s->out_len));
+
+		memcpy(&out[s->out_len], data, chunk);
+		s->out_len += chunk;
+		data += chunk;
+		n -= chunk;
+
+		if ((s->out_len == OUT_BUFFER_SIZE) || (!n && !s->pixels_left)) {
+			if (epdc->load_area_data(epdc, out, s->out_len))
+				return -1;
+
+			s->out_len = 0;
+		}
+	}
+
+	return 0;
+}
+
+/* Get the next DATA frame of the current image, 0 on success otherwise a
+ * stream_status value.  When the expected frame has an invalid CRC, the host
+ * is asked to send it again along with the following ones, so any other DATA
+ * frame is discarded.  Frames lost without a reply are sent again by the
+ * host after a timeout.  */
+static int next_data_frame(struct stream *s)
+{
+	for (;;) {
+		const int ret = read_frame(s, DATA_TIMEOUT_MS);
+
+		if (ret && (s->seq != s->data_seq) &&
+		    ((ret < 0) || (s->type == STREAM_CMD_DATA))) {
+#if VERBOSE
+			LOG("DATA seq %u discarded, expected %u", s->seq,
+			    s->data_seq);
+#endif
+			continue;
+		}
+
+		if (ret > 0)
+			break;
+
+		/* errors are reported against the expected frame */
+		s->type = STREAM_CMD_DATA;
+		s->seq = s->data_seq;
+
+		if (!ret)
+			return STREAM_ERR_SEQ;
+
+		if (send_reply(s, STREAM_ERR_CRC, NULL, 0))
+			return STREAM_ERR_EPDC;
+	}
+
+	if ((s->type != STREAM_CMD_DATA) || (s->len > s->data_left) || !s->len)
+		return STREAM_ERR_SEQ;
+
+	s->data_left -= s->len;
+	s->data_seq++;
+	s->in_pos = 0;
+
+	return 0;
+}
+
+struct lzss_rd_ctx {
+	struct stream *s;
+	int status;
+};
+
+static int stream_lzss_rd(struct lzss_rd_ctx *ctx)
+{
+	struct stream *s = ctx->s;
+
+	if (s->in_pos == s->len) {
+		/* the last DATA frame is acknowledged at the end of the load */
+		if (!s->data_left)
+			return EOF;
+
+		if (send_reply(s, STREAM_OK, NULL, 0))
+			return LZSS_ERROR;
+
+		ctx->status = next_data_frame(s);
+
+		if (ctx->status)
+			return LZSS_ERROR;
+	}
+
+	return s->payload[s->in_pos++];
+}
+
+static int stream_lzss_wr(int c, struct stream *s)
+{
+	const uint8_t c8 = c;
+
+	if (put_pixels(s, &c8, 1))
+		return LZSS_ERROR;
+
+	return 0;
+}
+
+static int load_lzss(struct stream *s)
+{
+	struct lzss lzss;
+	struct lzss_io io;
+	struct lzss_rd_ctx rd_ctx;
+
+	if (lzss_init(&lzss, STREAM_LZSS_EI, STREAM_LZSS_EJ))
+		return STREAM_ERR_LZSS;
+
+	lzss.buffer = s->lzss_buffer;
+	rd_ctx.s = s;
+	rd_ctx.status = STREAM_OK;
+	io.rd = (lzss_rd_t)stream_lzss_rd;
+	io.i = &rd_ctx;
+	io.wr = (lzss_wr_t)stream_lzss_wr;
+	io.o = s;
+
+	if (lzss_decode(&lzss, &io))
+		return (rd_ctx.status != STREAM_OK) ?
+			rd_ctx.status : STREAM_ERR_LZSS;
+
+	return STREAM_OK;
+}
+
+static int load_raw(struct stream *s)
+{
+	for (;;) {
+		int status;
+
+		if (put_pixels(s, s->payload, s->len))
+			return STREAM_ERR_EPDC;
+
+		/* the last DATA frame is acknowledged at the end of the load */
+		if (!s->data_left)
+			break;
+
+		if (send_reply(s, STREAM_OK, NULL, 0))
+			return STREAM_ERR_EPDC;
+
+		status = next_data_frame(s);
+
+		if (status)
+			return status;
+	}
+
+	return STREAM_OK;
+}
+
+static int cmd_load_area(struct stream *s)
+{
+	struct pl_epdc *epdc = &s->plat->epdc;
+	struct pl_area area;
+	const struct pl_area *parea;
+	uint32_t start;
+	uint8_t flags;
+	int status;
+	int ret;
+
+	if (s->len != 13)
+		return send_reply(s, STREAM_ERR_ARG, NULL, 0);
+
+	flags = s->payload[0];
+	parea = read_area(&s->payload[1], &area) ? NULL : &area;
+	s->data_left = get_le32(&s->payload[9]);
+
+	if (parea != NULL)
+		s->pixels_left = (uint32_t)area.width * area.height;
+	else
+		s->pixels_left = (uint32_t)epdc->xres * epdc->yres;
+
+	/* only 16-bit transfers */
+	if (!s->data_left || (s->pixels_left & 1))
+		return send_reply(s, STREAM_ERR_ARG, NULL, 0);
+
+#if VERBOSE
+	LOG("load %lu pixels from %lu bytes%s", s->pixels_left, s->data_left,
+	    (flags & STREAM_LOAD_LZSS) ? " (LZSS)" : "");
+#endif
+
+	start = ticks_now();
+
+	if (epdc->load_area_begin(epdc, parea))
+		return send_reply(s, STREAM_ERR_EPDC, NULL, 0);
+
+	if (send_reply(s, STREAM_OK, NULL, 0))
+		return -1;
+
+	s->out_len = 0;
+	s->data_seq = s->seq + 1;
+	status = next_data_frame(s);
+
+	if (!status) {
+		if (flags & STREAM_LOAD_LZSS)
+			status = load_lzss(s);
+		else
+			status = load_raw(s);
+	}
+
+	ret = epdc->load_area_end(epdc);
+
+	if (!status && ret)
+		status = STREAM_ERR_EPDC;
+
+	if (!status && s->pixels_left)
+		status = STREAM_ERR_SEQ;
+
+	if (!status) {
+		s->stats[STREAM_STAT_LOADS]++;
+		s->stats[STREAM_STAT_LOAD_US] = ticks_now() - start;
+	}
+
+	/* reply to the last DATA frame or the one which failed */
+	return send_reply(s, status, NULL, 0);
+}
+
+/* -- other commands -- */
+
+static int cmd_fill(struct stream *s)
+{
+	struct pl_epdc *epdc = &s->plat->epdc;
+	struct pl_area area;
+	const struct pl_area *parea;
+
+	if (s->len != 9)
+		return send_reply(s, STREAM_ERR_ARG, NULL, 0);
+
+	parea = read_area(&s->payload[1], &area) ? NULL : &area;
+
+	if (epdc->fill(epdc, parea, s->payload[0]))
+		return send_reply(s, STREAM_ERR_EPDC, NULL, 0);
+
+	return send_reply(s, STREAM_OK, NULL, 0);
+}
+
+static int cmd_update(struct stream *s)
+{
+	struct pl_epdc *epdc = &s->plat->epdc;
+	struct pl_area area;
+	const struct pl_area *parea;
+	int wfid;
+
+	if (s->len != 10)
+		return send_reply(s, STREAM_ERR_ARG, NULL, 0);
+
+	wfid = pl_epdc_get_wfid(epdc, s->payload[0]);
+
+	if ((wfid < 0) || (s->payload[1] > UPDATE_PARTIAL_AREA))
+		return send_reply(s, STREAM_ERR_ARG, NULL, 0);
+
+	parea = read_area(&s->payload[2], &area) ? NULL : &area;
+
+	if (epdc->update(epdc, wfid, s->payload[1], parea))
+		return send_reply(s, STREAM_ERR_EPDC, NULL, 0);
+
+	s->stats[STREAM_STAT_UPDATES]++;
+
+	return send_reply(s, STREAM_OK, NULL, 0);
+}
+
+static int cmd_power(struct stream *s)
+{
+	struct pl_epdc *epdc = &s->plat->epdc;
+	struct pl_epdpsu *psu = &s->plat->psu;
+	int stat;
+
+	if (s->len != 1)
+		return send_reply(s, STREAM_ERR_ARG, NULL, 0);
+
+	if (s->payload[0])
+		stat = pl_epdc_update_temp(epdc) || psu->on(psu);
+	else
+		stat = epdc->wait_update_end(epdc) || psu->off(psu);
+
+	return send_reply(s, (stat ? STREAM_ERR_EPDC : STREAM_OK), NULL, 0);
+}
+
+/* -- utilities -- */
+
+/* Return 1 if the area has a width of 0, meaning the whole screen */
+static int read_area(const uint8_t *data, struct pl_area *area)
+{
+	area->left = get_le16(&data[0]);
+	area->top = get_le16(&data[2]);
+	area->width = get_le16(&data[4]);
+	area->height = get_le16(&data[6]);
+
+	return !area->width;
+}
+
+static uint16_t get_le16(const uint8_t *data)
+{
+	return data[0] | ((uint16_t)data[1] << 8);
+}
+
+static uint32_t get_le32(const uint8_t *data)
+{
+	return get_le16(data) | ((uint32_t)get_le16(&data[2]) << 16);
+}
+
+static void put_le32(uint8_t *data, uint32_t value)
+{
+	data[0] = value & 0xFF;
+	data[1] = (value >> 8) & 0xFF;
+	data[2] = (value >> 16) & 0xFF;
+	data[3] = (value >> 24) & 0xFF;
+}
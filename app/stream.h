@@ -0,0 +1,132 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * app/stream.h -- Serial image streaming protocol
+ */
+
+#ifndef INCLUDE_APP_STREAM_H
+#define INCLUDE_APP_STREAM_H 1
+
+/**
+   @file app/stream.h
+
+   Binary protocol to push images and commands over a serial port.
+
+   Every message is sent in a frame:
+
+     SOF | type | seq | length (16-bit) | payload | CRC16 (16-bit)
+
+   All multi-byte values are little-endian.  The CRC16 is computed with
+   crc16_run() over the type, seq, length and payload fields.  Any byte
+   received outside a valid frame is ignored, so text log messages can share
+   the same serial port.
+
+   The board replies to each command frame with a frame of type
+   (command | STREAM_REPLY) with the same sequence number, and a payload made
+   of a status byte (enum stream_status) optionally followed by some data.
+
+   The host can send up to STREAM_WINDOW frames without waiting for their
+   replies, so the next chunks of image data are being received while the
+   current one is decoded and sent to the EPDC.  Each DATA frame is
+   acknowledged once it has been consumed, except the last one of an image
+   which is acknowledged once the image has been fully loaded.
+
+   DATA frames carry consecutive sequence numbers following the one of the
+   STREAM_CMD_LOAD_AREA frame.  When the DATA frame the board expects has an
+   invalid CRC, it replies with STREAM_ERR_CRC and that sequence number, then
+   discards any other DATA frame until it gets that one.  The host then sends
+   again all the frames which have not been acknowledged, which it also does
+   if a reply does not come in time.
+*/
+
+/** Start of frame marker */
+#define STREAM_SOF               0xA5
+
+/** Size of the header: SOF, type, seq, 16-bit length */
+#define STREAM_HEADER_SIZE       5
+
+/** Size of the CRC16 at the end of each frame */
+#define STREAM_CRC_SIZE          2
+
+/** Maximum payload size */
+#define STREAM_MAX_PAYLOAD       240
+
+/** Maximum size of a whole frame */
+#define STREAM_MAX_FRAME \
+	(STREAM_HEADER_SIZE + STREAM_MAX_PAYLOAD + STREAM_CRC_SIZE)
+
+/** Maximum number of frames the host can send ahead of the replies */
+#define STREAM_WINDOW            4
+
+/** Bit set in the type of reply frames */
+#define STREAM_REPLY             0x80
+
+/** LZSS parameters used for compressed image data */
+#define STREAM_LZSS_EI           8
+#define STREAM_LZSS_EJ           4
+
+/** Command frame types */
+enum stream_cmd {
+	/* no payload, reply with the stream_stat values (32-bit each) */
+	STREAM_CMD_QUERY_STATS = 0x01,
+	/* flags (8-bit), left, top, width, height (16-bit), data size (32-bit)
+	 * followed by DATA frames with a total payload of data size bytes.
+	 * With a width of 0, the whole screen is loaded.  */
+	STREAM_CMD_LOAD_AREA   = 0x02,
+	/* image data with 8-bit pixels, or LZSS compressed pixels */
+	STREAM_CMD_DATA        = 0x03,
+	/* grey level (8-bit), left, top, width, height (16-bit) */
+	STREAM_CMD_FILL        = 0x04,
+	/* waveform (8-bit), update mode (8-bit), left, top, width, height */
+	STREAM_CMD_UPDATE      = 0x05,
+	/* 1 to turn the EPD power on, 0 to turn it off (8-bit) */
+	STREAM_CMD_POWER       = 0x06,
+};
+
+/** STREAM_CMD_LOAD_AREA flags */
+enum stream_load_flags {
+	STREAM_LOAD_LZSS       = 1 << 0, /**< data is LZSS compressed */
+};
+
+/** Status byte at the start of each reply payload */
+enum stream_status {
+	STREAM_OK = 0,
+	STREAM_ERR_CRC,        /**< invalid CRC, the frame was discarded */
+	STREAM_ERR_CMD,        /**< unknown command */
+	STREAM_ERR_ARG,        /**< invalid payload */
+	STREAM_ERR_SEQ,        /**< unexpected DATA frame or missing data */
+	STREAM_ERR_EPDC,       /**< failed to perform EPDC operation */
+	STREAM_ERR_LZSS,       /**< failed to decode LZSS data */
+};
+
+/** Statistics returned by STREAM_CMD_QUERY_STATS */
+enum stream_stat {
+	STREAM_STAT_FRAMES = 0,    /**< valid frames received */
+	STREAM_STAT_BYTES,         /**< payload bytes received */
+	STREAM_STAT_CRC_ERRORS,    /**< frames discarded due to bad CRC */
+	STREAM_STAT_JUNK,          /**< bytes received outside any frame */
+	STREAM_STAT_LOADS,         /**< images successfully loaded */
+	STREAM_STAT_PIXELS,        /**< pixels sent to the EPDC */
+	STREAM_STAT_UPDATES,       /**< display updates */
+	STREAM_STAT_LOAD_US,       /**< duration of the last image load */
+	STREAM_STAT_RX_OVERRUNS,   /**< bytes lost by the serial port */
+	STREAM_STAT_N
+};
+
+#endif /* INCLUDE_APP_STREAM_H */
@@ -90,9 +90,102 @@ enum config_interface_type {
 #define CONFIG_DEMO_PATTERN           0  /** Not intended for Type19 displays  */
 #define CONFIG_DEMO_PATTERN_SIZE      16 /** Size of checker-board */
 
+/** Set to 1 to receive images and commands over the serial port using the
+ * protocol defined in app/stream.h rather than running the slideshow */
+#define CONFIG_DEMO_STREAM		0
+
+/** Set to 1 to run the throughput benchmark (see app/bench.c) and report
+ * the results on the serial port rather than running the slideshow */
+#define CONFIG_DEMO_BENCH		0
+
+/** Selection switch (1 to 4) which also runs the benchmark when it is on, or
+ * 0 to ignore the switches */
+#define CONFIG_DEMO_BENCH_SEL		0
+
+/** Number of times each benchmark test is run */
+#define CONFIG_DEMO_BENCH_ITERATIONS	10
+
 /** Set to 1 to have stdout, stderr sent to serial port */
 #define CONFIG_UART_PRINTF		0
 
+/** Size in bytes of the interrupt-driven UART transmit ring buffer, must be a
+ * power of 2.  Set to 0 to send each character synchronously instead.  When
+ * the buffer is full, whole messages are dropped rather than stalling the
+ * caller and their number is sent as soon as there is room again.  Text on
+ * stdout is line-buffered so each line is one message. */
+#define CONFIG_UART_TX_BUFFER		512
+
+/** Size in bytes of the interrupt-driven UART receive ring buffer, must be a
+ * power of 2.  The stream protocol needs room for a full window of frames. */
+#if CONFIG_DEMO_STREAM
+#define CONFIG_UART_RX_BUFFER		1024
+#else
+#define CONFIG_UART_RX_BUFFER		32
+#endif
+
+/** Set to 1 to send dlog() messages as compact binary records to be decoded
+ * on the host with tools/dlog-decode.py rather than formatting them on the
+ * target (requires CONFIG_UART_PRINTF) */
+#define CONFIG_LOG_DEFERRED		0
+
+/** Set to 1 to enable the hot-path timing profiler (see pl/prof.h) */
+#define CONFIG_PROFILE			0
+
+/** Set to 1 to log the duration of each boot stage up to the application */
+#define CONFIG_BOOT_TIMING		0
+
+/** Set to 1 to defer loading the waveform library until it is needed by an
+ * update, loading it in chunks when pl_epdc_wflib_poll() is called.  The
+ * EPDC can't load it in the middle of an image, so it only overlaps with the
+ * last boot stages and idle time.  All the demos start with app_clear() which
+ * needs the waveforms, so in practice they still wait for them at boot. */
+#define CONFIG_WFLIB_DEFERRED		0
+
+/** Time in ms during which a temperature measurement is reused by
+ * pl_epdc_update_temp(), set to 0 to measure before each update */
+#define CONFIG_TEMP_TTL_MS		30000
+
+/** Change in degrees C needed to reload the waveforms after the EPDC has
+ * reported a temperature band change, set to 0 to reload immediately */
+#define CONFIG_TEMP_HYSTERESIS		2
+
+/** Maximum number of images shown by the slideshow, up to 255.  Each one
+ * takes 26 bytes of RAM in the index of the directory (see app/playlist.h).
+ * When there are more images, only the first ones by file name are shown. */
+#define CONFIG_PLAYLIST_ENTRIES		64
+
+/** Set to 1 to check the CRC of each strip of pixel data when loading an
+ * image container (see plimg.h), the header CRC is always checked */
+#define CONFIG_PLIMG_CRC		0
+
+/** Number of 512-byte sectors in each of the two buffers used to read PGM
+ * files with aligned multi-block reads (see readahead.h) */
+#define CONFIG_READAHEAD_SECTORS	2
+
+/** Set to 1 to send data to the EPDC over SPI with DMA, so the next chunk
+ * can be prepared while the current one is being sent */
+#define CONFIG_SPI_DMA			0
+
+/** Number of full-frame image slots kept in the EPDC memory to show images
+ * again without reading them from the SD card, including the main image
+ * buffer (S1D13524 only).  Set to 0 to disable the image cache. */
+#define CONFIG_IMAGE_CACHE_SLOTS	0
+
+/** Set to 1 to keep a copy of the EPDC configuration registers which are
+ * only changed by the MCU, to avoid reading them back */
+#define CONFIG_REG_SHADOW		0
+
+/** Set to 1 to be able to record a trace of the EPDC commands in RAM (see
+ * pl/trace.h and the sequencer trace command) */
+#define CONFIG_EPDC_TRACE		0
+
+/** Number of 8-byte records kept in RAM by the EPDC command trace */
+#define CONFIG_EPDC_TRACE_SIZE		256
+
+/** Set to 1 to merge consecutive sequencer image and fill commands into a
+ * single area load before the next command (see app/compose.h) */
+#define CONFIG_SEQUENCER_COMPOSE	0
+
 struct config {
 	enum config_interface_type interface_type;
 	enum endianess endianess; // most likely always little endian
@@ -0,0 +1,35 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2013 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * dlog-msgs.h -- Table of deferred log messages
+ */
+
+/* This file is included several times with different definitions of the
+ * DLOG_MSG(id, tag, nargs, fmt) macro, so it has no include guard.  It is
+ * also parsed by tools/dlog-decode.py: keep one entry per line.  Arguments
+ * are all sent as 16-bit integers, so only use %d, %u, %x or %X with them.
+ * Only add new messages at the end to keep old logs decodable.  */
+
+DLOG_MSG(DLOG_DROPPED, "dlog", 1, "%u message(s) dropped")
+DLOG_MSG(DLOG_HRDY_TIMEOUT, "s1d135xx", 0, "HRDY timeout")
+DLOG_MSG(DLOG_S1D135XX_UPDATE, "s1d135xx", 1, "update %d")
+DLOG_MSG(DLOG_S1D135XX_UPDATE_AREA, "s1d135xx", 5, "update area %d (%d, %d) %dx%d")
+DLOG_MSG(DLOG_S1D135XX_EPD_POWER, "s1d135xx", 1, "EPD power %d")
+DLOG_MSG(DLOG_EPDPSU_POK_TIMEOUT, "epdpsu", 0, "POK timeout")
+DLOG_MSG(DLOG_S1D135XX_REG_TIMEOUT, "s1d135xx", 2, "timeout waiting for reg 0x%04X mask 0x%04X")
@@ -0,0 +1,122 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2013 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * dlog.c -- Deferred logging
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "dlog.h"
+#include "assert.h"
+
+#if CONFIG_LOG_DEFERRED
+
+#if !CONFIG_UART_PRINTF
+#error CONFIG_LOG_DEFERRED requires CONFIG_UART_PRINTF
+#endif
+
+#include "msp430/msp430-uart.h"
+
+static const uint8_t dlog_nargs[DLOG_N_MSGS] = {
+#define DLOG_MSG(_id, _tag, _nargs, _fmt) _nargs,
+#include "dlog-msgs.h"
+#undef DLOG_MSG
+};
+
+static uint16_t dlog_dropped;
+
+static int dlog_send(uint8_t id, const unsigned *args, uint8_t nargs)
+{
+	uint8_t record[2 + (DLOG_MAX_ARGS * 2)];
+	uint8_t *it = record;
+
+	*it++ = DLOG_SYNC;
+	*it++ = id;
+
+	while (nargs--) {
+		*it++ = *args & 0xFF;
+		*it++ = (*args++ >> 8) & 0xFF;
+	}
+
+	return msp430_uart_write_frame(record, (it - record));
+}
+
+void dlog(enum dlog_id id, ...)
+{
+	unsigned args[DLOG_MAX_ARGS];
+	uint8_t nargs;
+	va_list ap;
+	uint8_t i;
+
+	assert(id < DLOG_N_MSGS);
+
+	nargs = dlog_nargs[id];
+	assert(nargs <= DLOG_MAX_ARGS);
+
+	va_start(ap, id);
+
+	for (i = 0; i < nargs; ++i)
+		args[i] = va_arg(ap, unsigned);
+
+	va_end(ap);
+
+	if (dlog_dropped) {
+		const unsigned dropped = dlog_dropped;
+
+		if (dlog_send(DLOG_DROPPED, &dropped, 1)) {
+			if (dlog_dropped != 0xFFFF)
+				dlog_dropped++;
+			return;
+		}
+
+		dlog_dropped = 0;
+	}
+
+	if (dlog_send(id, args, nargs) && (dlog_dropped != 0xFFFF))
+		dlog_dropped++;
+}
+
+#else /* !CONFIG_LOG_DEFERRED */
+
+static const char * const dlog_tags[DLOG_N_MSGS] = {
+#define DLOG_MSG(_id, _tag, _nargs, _fmt) _tag,
+#include "dlog-msgs.h"
+#undef DLOG_MSG
+};
+
+static const char * const dlog_fmts[DLOG_N_MSGS] = {
+#define DLOG_MSG(_id, _tag, _nargs, _fmt) _fmt,
+#include "dlog-msgs.h"
+#undef DLOG_MSG
+};
+
+void dlog(enum dlog_id id, ...)
+{
+	va_list ap;
+
+	assert(id < DLOG_N_MSGS);
+
+	va_start(ap, id);
+	printf("%-16s ", dlog_tags[id]);
+	vprintf(dlog_fmts[id], ap);
+	printf("\n");
+	va_end(ap);
+}
+
+#endif /* CONFIG_LOG_DEFERRED */
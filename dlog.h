@@ -0,0 +1,62 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2013 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * dlog.h -- Deferred logging
+ */
+
+#ifndef INCLUDE_DLOG_H
+#define INCLUDE_DLOG_H 1
+
+#include <stdint.h>
+#include "config.h"
+
+/**
+   @file dlog.h
+
+   Log messages which can be sent either as text or as compact binary records.
+
+   All the messages are listed in dlog-msgs.h.  When CONFIG_LOG_DEFERRED is
+   set, only the message identifier and its arguments are sent to the UART
+   so no formatting is done on the target and the format strings are not
+   even built into the firmware.  The records are then decoded on the host
+   with tools/dlog-decode.py, and can be interleaved with normal text output.
+
+   Each record is made of DLOG_SYNC, the message identifier and then each
+   argument as a 16-bit little-endian integer.  Records which do not fit in
+   the UART transmit buffer are dropped and counted, and the number of
+   dropped records is sent with DLOG_DROPPED as soon as there is room again.
+*/
+
+/** First byte of a binary record, never found in text output */
+#define DLOG_SYNC 0x1E
+
+/** Maximum number of arguments of a message */
+#define DLOG_MAX_ARGS 5
+
+enum dlog_id {
+#define DLOG_MSG(_id, _tag, _nargs, _fmt) _id,
+#include "dlog-msgs.h"
+#undef DLOG_MSG
+	DLOG_N_MSGS
+};
+
+/** Log a message with its integer arguments as listed in dlog-msgs.h */
+extern void dlog(enum dlog_id id, ...);
+
+#endif /* INCLUDE_DLOG_H */
@@ -31,14 +31,25 @@
 #include <pl/gpio.h>
 #include <stdlib.h>
 #include "assert.h"
+#include "config.h"
 
 #define LOG_TAG "epson-epdc"
 #include "utils.h"
 
+static enum epson_epdc_ref g_ref;
+
+static int epson_epdc_init_ref(struct pl_epdc *epdc);
+static int epson_epdc_init_wflib(struct pl_epdc *epdc);
+static int epson_epdc_resume(struct pl_epdc *epdc);
+static int resume_state(struct pl_epdc *epdc);
+
 static int epson_epdc_clear_init(struct pl_epdc *epdc)
 {
 	struct s1d135xx *p = epdc->data;
 
+	if (pl_epdc_wflib_wait(epdc))
+		return -1;
+
 	return s1d135xx_clear_init(p);
 }
 
@@ -48,6 +59,9 @@ static int epson_epdc_update(struct pl_epdc *epdc, int wfid,
 {
 	struct s1d135xx *p = epdc->data;
 
+	if (pl_epdc_wflib_wait(epdc))
+		return -1;
+
 	return s1d135xx_update(p, wfid, mode, area);
 }
 
@@ -63,11 +77,24 @@ static int epson_epdc_set_power(struct pl_epdc *epdc,
 {
 	struct s1d135xx *p = epdc->data;
 
+	/* the init code sets the RUN state again while resuming */
+	if ((state == PL_EPDC_RUN) && (epdc->power_state != PL_EPDC_RUN) &&
+	    !p->flags.resuming)
+		return epson_epdc_resume(epdc);
+
 	if (s1d135xx_set_power_state(p, state))
 		return -1;
 
+	/* going from SLEEP to STANDBY still needs a resume from SLEEP */
+	if ((epdc->power_state == PL_EPDC_RUN) || (state > epdc->resume_from))
+		epdc->resume_from = state;
+
 	epdc->power_state = state;
 
+	if (((state == PL_EPDC_SLEEP) || (state == PL_EPDC_OFF)) &&
+	    (epdc->power_lost_hook != NULL))
+		epdc->power_lost_hook(epdc->power_hook_ctx);
+
 	return 0;
 }
 
@@ -78,11 +105,24 @@ static int epson_epdc_set_epd_power(struct pl_epdc *epdc, int on)
 	return s1d135xx_set_epd_power(p, on);
 }
 
+static uint16_t epson_epdc_read_register(struct pl_epdc *epdc, uint16_t reg)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_read_reg(p, reg);
+}
+
+static void epson_epdc_write_register(struct pl_epdc *epdc, uint16_t reg,
+				      uint16_t val)
+{
+	struct s1d135xx *p = epdc->data;
+
+	s1d135xx_write_reg(p, reg, val);
+}
+
 int epson_epdc_init(struct pl_epdc *epdc, const struct pl_dispinfo *dispinfo,
 		    enum epson_epdc_ref ref, struct s1d135xx *s1d135xx)
 {
-	int stat;
-
 	assert(epdc != NULL);
 	assert(dispinfo != NULL);
 	assert(s1d135xx != NULL);
@@ -101,26 +141,17 @@ int epson_epdc_init(struct pl_epdc *epdc, const struct pl_dispinfo *dispinfo,
 	epdc->wait_update_end = epson_epdc_wait_update_end;
 	epdc->set_power = epson_epdc_set_power;
 	epdc->set_epd_power = epson_epdc_set_epd_power;
+	epdc->read_register = epson_epdc_read_register;
+	epdc->write_register = epson_epdc_write_register;
 	epdc->data = s1d135xx;
 	epdc->dispinfo = dispinfo;
 
-	switch (ref) {
-	case EPSON_EPDC_S1D13524:
-		stat = epson_epdc_init_s1d13524(epdc);
-		break;
-	case EPSON_EPDC_S1D13541:
-		stat = epson_epdc_init_s1d13541(epdc);
-		break;
-	default:
-		assert_fail("Invalid Epson ref");
-	}
+	g_ref = ref;
 
-	if (stat)
+	if (epson_epdc_init_ref(epdc))
 		return -1;
 
-	LOG("Loading wflib");
-
-	if (epdc->load_wflib(epdc))
+	if (epson_epdc_init_wflib(epdc))
 		return -1;
 
 	s1d135xx->xres = epdc->xres;
@@ -148,3 +179,105 @@ int epson_epdc_early_init(struct s1d135xx *p, enum epson_epdc_ref ref)
 
 	return stat;
 }
+
+/* ----------------------------------------------------------------------------
+ * private functions
+ */
+
+static int epson_epdc_init_ref(struct pl_epdc *epdc)
+{
+	int stat;
+
+	switch (g_ref) {
+	case EPSON_EPDC_S1D13524:
+		stat = epson_epdc_init_s1d13524(epdc);
+		break;
+	case EPSON_EPDC_S1D13541:
+		stat = epson_epdc_init_s1d13541(epdc);
+		break;
+	default:
+		assert_fail("Invalid Epson ref");
+	}
+
+	return stat;
+}
+
+static int epson_epdc_init_wflib(struct pl_epdc *epdc)
+{
+#if CONFIG_WFLIB_DEFERRED
+	LOG("Deferring wflib loading");
+	pl_epdc_wflib_defer(epdc);
+#else
+	LOG("Loading wflib");
+
+	if (pl_epdc_load_wflib(epdc))
+		return -1;
+#endif
+
+	return 0;
+}
+
+/* Go back to RUN and only restore what was lost in the previous power state,
+ * the caller needs to load an image again if image_lost is set */
+static int epson_epdc_resume(struct pl_epdc *epdc)
+{
+	struct s1d135xx *p = epdc->data;
+	const enum pl_epdc_power_state from = epdc->resume_from;
+	const enum pl_epdc_power_state prev = epdc->power_state;
+	const uint32_t start = ticks_now();
+	int stat;
+
+	epdc->image_lost = (p->state & S1D135XX_STATE_IMAGE) ? 0 : 1;
+
+	p->flags.resuming = 1;
+	stat = resume_state(epdc);
+	p->flags.resuming = 0;
+
+	/* try again on the next set_power(RUN) if anything failed */
+	if (stat) {
+		epdc->power_state = prev;
+		return -1;
+	}
+
+	epdc->power_state = PL_EPDC_RUN;
+	epdc->resume_us[from] = ticks_now() - start;
+	LOG("Resumed from state %d in %lu us", from,
+	    (unsigned long)epdc->resume_us[from]);
+
+	return 0;
+}
+
+static int resume_state(struct pl_epdc *epdc)
+{
+	struct s1d135xx *p = epdc->data;
+
+	if (!(p->state & S1D135XX_STATE_INIT_CODE)) {
+		LOG("Resume: reloading init code");
+		p->flags.early_init_done = 0;
+		s1d135xx_power_on(p);
+		/* the controller has lost its temperature settings */
+		pl_epdc_invalidate_temp(epdc);
+
+		if (epson_epdc_init_ref(epdc))
+			return -1;
+	} else if (s1d135xx_set_power_state(p, PL_EPDC_RUN)) {
+		return -1;
+	}
+
+	if (!(p->state & S1D135XX_STATE_OVERRIDES)) {
+		LOG("Resume: reloading register overrides");
+
+		if (s1d135xx_load_register_overrides(p))
+			return -1;
+	}
+
+	if (!(p->state & S1D135XX_STATE_WFLIB) && epson_epdc_init_wflib(epdc))
+		return -1;
+
+	if ((epdc->resume_from >= PL_EPDC_SLEEP) &&
+	    (epdc->power_restored_hook != NULL) &&
+	    epdc->power_restored_hook(epdc->power_hook_ctx))
+		return -1;
+
+	return 0;
+}
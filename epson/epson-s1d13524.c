@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include "assert.h"
+#include "config.h"
 
 #define LOG_TAG "s1d13524"
 #include "utils.h"
@@ -52,11 +53,16 @@
 #define S1D13524_CTLR_PROCESSED_SINGLE  0x0000
 #define S1D13524_CTLR_PROCESSED_DOUBLE  0x0001
 #define S1D13524_CTLR_PROCESSED_TRIPLE  0x0002
+#define S1D13524_CACHE_ADDR             0x00800000L /* spare SDRAM */
+#define S1D13524_CACHE_PIXEL_SIZE       2 /* worst case in the image buffer */
+#define S1D13524_CACHE_ALIGN            0x10000L
 
 enum s1d13524_reg {
 	S1D13524_REG_POWER_SAVE_MODE    = 0x0006,
 	S1D13524_REG_FRAME_DATA_LENGTH  = 0x0300,
 	S1D13524_REG_LINE_DATA_LENGTH   = 0x0306,
+	S1D13524_REG_IMG_BUF_ADDR_0     = 0x0310,
+	S1D13524_REG_IMG_BUF_ADDR_1     = 0x0312,
 	S1D13524_REG_TEMP_AUTO_RETRIEVE = 0x0320,
 	S1D13524_REG_TEMP               = 0x0322,
 	S1D13541_REG_WF_ADDR_0          = 0x0390,
@@ -78,11 +84,32 @@ static const struct pl_wfid epson_epdc_wf_table_s1d13524[] = {
 	{ -1,	 -1 }
 };
 #endif
+#if CONFIG_REG_SHADOW
+/* Registers only changed by the init code or the MCU */
+static const uint16_t s1d13524_shadow_regs[] = {
+	S1D13524_REG_FRAME_DATA_LENGTH,
+	S1D13524_REG_LINE_DATA_LENGTH,
+	S1D13524_REG_IMG_BUF_ADDR_0,
+	S1D13524_REG_IMG_BUF_ADDR_1,
+	S1D13541_REG_WF_ADDR_0,
+	S1D13541_REG_WF_ADDR_1,
+};
+#endif
+
+#if CONFIG_IMAGE_CACHE_SLOTS
+static struct s1d135xx_cache s1d13524_cache;
+static struct s1d135xx_cache_slot s1d13524_cache_slots[
+	CONFIG_IMAGE_CACHE_SLOTS];
+#endif
+
 /* -- private functions -- */
 
 static int s1d13524_check_rev(struct s1d135xx *p);
 static int s1d13524_init_clocks(struct s1d135xx *p);
 static int s1d13524_init_ctlr_mode(struct s1d135xx *p);
+#if CONFIG_IMAGE_CACHE_SLOTS
+static int s1d13524_init_cache(struct pl_epdc *epdc);
+#endif
 
 /* -- pl_epdc interface -- */
 
@@ -208,6 +235,15 @@ static int s1d13524_fill(struct pl_epdc *epdc, const struct pl_area *area,
 	return s1d135xx_fill(p, S1D13524_LD_IMG_4BPP, 4, area, grey);
 }
 
+static int s1d13524_fill_areas(struct pl_epdc *epdc,
+			       const struct pl_area *areas,
+			       const uint8_t *greys, unsigned n)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_fill_areas(p, S1D13524_LD_IMG_4BPP, 4, areas, greys, n);
+}
+
 static int s1d13524_pattern_check(struct pl_epdc *epdc, uint16_t size)
 {
 	struct s1d135xx *p = epdc->data;
@@ -224,6 +260,58 @@ static int s1d13524_load_image(struct pl_epdc *epdc, const char *path,
 				   left, top);
 }
 
+static int s1d13524_load_image_file(struct pl_epdc *epdc, FIL *f,
+				    struct pl_area *area, int left, int top)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_load_image_file(p, f, S1D13524_LD_IMG_8BPP, 8, area,
+					left, top);
+}
+
+#if CONFIG_IMAGE_CACHE_SLOTS
+static int s1d13524_load_image_cached(struct pl_epdc *epdc, FIL *f,
+				      uint32_t key)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_load_image_cached(p, f, key, S1D13524_LD_IMG_8BPP, 8);
+}
+#endif
+
+static int s1d13524_load_area_begin(struct pl_epdc *epdc,
+				     const struct pl_area *area)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_load_area_begin(p, S1D13524_LD_IMG_8BPP, area);
+}
+
+static int s1d13524_load_area_begin_4bpp(struct pl_epdc *epdc,
+					 const struct pl_area *area)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_load_area_begin(p, S1D13524_LD_IMG_4BPP, area);
+}
+
+static int s1d13524_load_area_data(struct pl_epdc *epdc, const uint8_t *data,
+				    size_t n)
+{
+	struct s1d135xx *p = epdc->data;
+
+	s1d135xx_load_area_data(p, data, n);
+
+	return 0;
+}
+
+static int s1d13524_load_area_end(struct pl_epdc *epdc)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_load_area_end(p);
+}
+
 /* -- initialisation -- */
 
 int epson_epdc_early_init_s1d13524(struct s1d135xx *p)
@@ -231,6 +319,14 @@ int epson_epdc_early_init_s1d13524(struct s1d135xx *p)
 	p->hrdy_mask = S1D13524_STATUS_HRDY;
 	p->hrdy_result = 0;
 	p->measured_temp = -127;
+#if CONFIG_REG_SHADOW
+	s1d135xx_set_shadow(p, s1d13524_shadow_regs,
+			    ARRAY_SIZE(s1d13524_shadow_regs));
+#endif
+	/* the SDRAM is not refreshed while the clock is stopped in sleep */
+	p->sleep_state = (S1D135XX_STATE_INIT_CODE |
+			  S1D135XX_STATE_OVERRIDES);
+	p->state = 0;
 	s1d135xx_hard_reset(p->gpio, p->data);
 
 	if (s1d135xx_soft_reset(p))
@@ -244,14 +340,20 @@ int epson_epdc_early_init_s1d13524(struct s1d135xx *p)
 	if (s1d13524_init_clocks(p))
 		return -1;
 
-	return s1d135xx_set_power_state(p, PL_EPDC_RUN);
+	if (s1d135xx_set_power_state(p, PL_EPDC_RUN))
+		return -1;
+
+	p->flags.early_init_done = 1;
+
+	return 0;
 }
 
 int epson_epdc_init_s1d13524(struct pl_epdc *epdc)
 {
 	struct s1d135xx *p = epdc->data;
 
-	if (epson_epdc_early_init_s1d13524(p))
+	/* skip the reset if already done to use the I2C master */
+	if (!p->flags.early_init_done && epson_epdc_early_init_s1d13524(p))
 		return -1;
 
 	if (s1d135xx_load_init_code(p)) {
@@ -285,12 +387,23 @@ int epson_epdc_init_s1d13524(struct pl_epdc *epdc)
 	epdc->set_temp_mode = s1d13524_set_temp_mode;
 	epdc->update_temp = s1d13524_update_temp;
 	epdc->fill = s1d13524_fill;
+	epdc->fill_areas = s1d13524_fill_areas;
 	epdc->pattern_check = s1d13524_pattern_check;
 	epdc->load_image = s1d13524_load_image;
+	epdc->load_image_file = s1d13524_load_image_file;
+	epdc->load_area_begin = s1d13524_load_area_begin;
+	epdc->load_area_data = s1d13524_load_area_data;
+	epdc->load_area_end = s1d13524_load_area_end;
+	epdc->load_area_begin_4bpp = s1d13524_load_area_begin_4bpp;
 	epdc->wf_table = epson_epdc_wf_table_s1d13524;
 	epdc->xres = s1d135xx_read_reg(p, S1D13524_REG_LINE_DATA_LENGTH);
 	epdc->yres = s1d135xx_read_reg(p, S1D13524_REG_FRAME_DATA_LENGTH);
 
+#if CONFIG_IMAGE_CACHE_SLOTS
+	if (s1d13524_init_cache(epdc))
+		return -1;
+#endif
+
 	return epdc->set_temp_mode(epdc, PL_EPDC_TEMP_EXTERNAL);
 }
 
@@ -349,3 +462,41 @@ static int s1d13524_init_ctlr_mode(struct s1d135xx *p)
 
 	return s1d135xx_wait_idle(p);
 }
+
+#if CONFIG_IMAGE_CACHE_SLOTS
+static int s1d13524_init_cache(struct pl_epdc *epdc)
+{
+	struct s1d135xx *p = epdc->data;
+	const uint32_t end_mask = S1D13524_CACHE_ALIGN - 1;
+	uint32_t slot_size;
+	uint32_t cache_end;
+	uint32_t wf_addr;
+	uint32_t wf_end;
+
+	slot_size = (uint32_t)epdc->xres * epdc->yres *
+		S1D13524_CACHE_PIXEL_SIZE;
+	slot_size = (slot_size + end_mask) & ~end_mask;
+	cache_end = S1D13524_CACHE_ADDR +
+		(slot_size * (CONFIG_IMAGE_CACHE_SLOTS - 1));
+	wf_addr = s1d135xx_read_reg(p, S1D13541_REG_WF_ADDR_1);
+	wf_addr <<= 16;
+	wf_addr |= s1d135xx_read_reg(p, S1D13541_REG_WF_ADDR_0);
+	wf_end = wf_addr + epdc->wflib.size;
+
+	if ((wf_addr < cache_end) && (wf_end > S1D13524_CACHE_ADDR)) {
+		LOG("Image cache overlaps waveform at 0x%08lX, disabled",
+		    (unsigned long)wf_addr);
+		return 0;
+	}
+
+	if (s1d135xx_cache_init(p, &s1d13524_cache, s1d13524_cache_slots,
+				CONFIG_IMAGE_CACHE_SLOTS,
+				S1D13524_REG_IMG_BUF_ADDR_0,
+				S1D13524_CACHE_ADDR, slot_size))
+		return -1;
+
+	epdc->load_image_cached = s1d13524_load_image_cached;
+
+	return 0;
+}
+#endif
@@ -112,9 +112,20 @@ static const struct pl_wfid s1d13541_wf_table_new[] = {
 
 #endif
 
+#if CONFIG_REG_SHADOW
+/* Registers only changed by the init code or the MCU */
+static const uint16_t s1d13541_shadow_regs[] = {
+	S1D135XX_REG_PERIPH_CONFIG,
+	S1D13541_REG_WF_DECODER_BYPASS,
+	S1D13541_REG_FRAME_DATA_LENGTH,
+	S1D13541_REG_LINE_DATA_LENGTH,
+};
+#endif
+
 /* -- private functions -- */
 
 static int s1d13541_init_clocks(struct s1d135xx *p);
+static void wflib_loaded(struct s1d135xx *p);
 static void update_temp(struct s1d135xx *p, uint16_t reg);
 static int update_temp_manual(struct s1d135xx *p, int manual_temp);
 static int update_temp_auto(struct s1d135xx *p, uint16_t temp_reg);
@@ -126,7 +137,27 @@ static int s1d13541_load_wflib(struct pl_epdc *epdc)
 {
 	struct s1d135xx *p = epdc->data;
 
-	return s1d135xx_load_wflib(p, &epdc->wflib, S1D13541_WF_ADDR);
+	if (s1d135xx_load_wflib(p, &epdc->wflib, S1D13541_WF_ADDR))
+		return -1;
+
+	wflib_loaded(p);
+
+	return 0;
+}
+
+static int s1d13541_load_wflib_part(struct pl_epdc *epdc, uint32_t offset,
+				    uint32_t n)
+{
+	struct s1d135xx *p = epdc->data;
+
+	if (s1d135xx_load_wflib_part(p, &epdc->wflib, S1D13541_WF_ADDR,
+				     offset, n))
+		return -1;
+
+	if ((offset + n) == epdc->wflib.size)
+		wflib_loaded(p);
+
+	return 0;
 }
 
 static int s1d13541_set_temp_mode(struct pl_epdc *epdc,
@@ -138,6 +169,7 @@ static int s1d13541_set_temp_mode(struct pl_epdc *epdc,
 	if (mode == epdc->temp_mode)
 		return 0;
 
+	pl_epdc_invalidate_temp(epdc);
 	reg = s1d135xx_read_reg(p, S1D135XX_REG_PERIPH_CONFIG);
 	/* ToDo: when do we set this bit back? */
 	reg &= S1D13541_TEMP_SENSOR_CONTROL;
@@ -161,7 +193,7 @@ static int s1d13541_set_temp_mode(struct pl_epdc *epdc,
 	 * after each temperature measurement.  */
 	reg = s1d135xx_read_reg(p, S1D13541_REG_WF_DECODER_BYPASS);
 	reg |= S1D13541_AUTO_TEMP_JUDGE_EN;
-	s1d135xx_write_reg(p, reg, S1D13541_REG_WF_DECODER_BYPASS);
+	s1d135xx_write_reg(p, S1D13541_REG_WF_DECODER_BYPASS, reg);
 
 	epdc->temp_mode = mode;
 
@@ -188,13 +220,35 @@ static int s1d13541_update_temp(struct pl_epdc *epdc)
 	if (stat)
 		return -1;
 
-	if (p->flags.needs_update) {
+	/* Waveforms loaded before the first measurement are taken as loaded at
+	 * this temperature, so the band reported by the first measurement
+	 * doesn't cause a reload. */
+	if (p->wf_temp == -127) {
+		p->wf_temp = p->measured_temp;
+		p->flags.needs_update = 0;
+	}
+
+	/* The controller reports each temperature band change, but only reload
+	 * the waveforms once the temperature has moved far enough from the one
+	 * they were loaded at to avoid reloading them at a band boundary. */
+	if (p->flags.needs_update)
+		p->flags.wf_update_pending = 1;
+
+	if (p->flags.wf_update_pending &&
+	    (abs(p->measured_temp - p->wf_temp) >= CONFIG_TEMP_HYSTERESIS)) {
 #if VERBOSE_TEMPERATURE
 		LOG("Updating waveform table");
 #endif
 
-		if (s1d13541_load_wflib(epdc))
+		/* a deferred load is simply restarted */
+		if (epdc->wflib_state == PL_EPDC_WFLIB_PENDING)
+			pl_epdc_wflib_defer(epdc);
+		else if (s1d13541_load_wflib(epdc))
 			return -1;
+
+		p->flags.wf_update_pending = 0;
+		p->wf_temp = p->measured_temp;
+		epdc->temp.reloads++;
 	}
 
 	return 0;
@@ -208,6 +262,15 @@ static int s1d13541_fill(struct pl_epdc *epdc, const struct pl_area *area,
 	return s1d135xx_fill(p, S1D13541_LD_IMG_8BPP, 8, area, grey);
 }
 
+static int s1d13541_fill_areas(struct pl_epdc *epdc,
+			       const struct pl_area *areas,
+			       const uint8_t *greys, unsigned n)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_fill_areas(p, S1D13541_LD_IMG_8BPP, 8, areas, greys, n);
+}
+
 static int s1d13541_pattern_check(struct pl_epdc *epdc, uint16_t size)
 {
 	struct s1d135xx *p = epdc->data;
@@ -225,6 +288,48 @@ static int s1d13541_load_image(struct pl_epdc *epdc, const char *path,
 				   left, top);
 }
 
+static int s1d13541_load_image_file(struct pl_epdc *epdc, FIL *f,
+				    struct pl_area *area, int left, int top)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_load_image_file(p, f, S1D13541_LD_IMG_8BPP, 8, area,
+					left, top);
+}
+
+static int s1d13541_load_area_begin(struct pl_epdc *epdc,
+				     const struct pl_area *area)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_load_area_begin(p, S1D13541_LD_IMG_8BPP, area);
+}
+
+static int s1d13541_load_area_begin_4bpp(struct pl_epdc *epdc,
+					 const struct pl_area *area)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_load_area_begin(p, S1D13541_LD_IMG_4BPP, area);
+}
+
+static int s1d13541_load_area_data(struct pl_epdc *epdc, const uint8_t *data,
+				    size_t n)
+{
+	struct s1d135xx *p = epdc->data;
+
+	s1d135xx_load_area_data(p, data, n);
+
+	return 0;
+}
+
+static int s1d13541_load_area_end(struct pl_epdc *epdc)
+{
+	struct s1d135xx *p = epdc->data;
+
+	return s1d135xx_load_area_end(p);
+}
+
 
 /* -- initialisation -- */
 
@@ -233,6 +338,14 @@ int epson_epdc_early_init_s1d13541(struct s1d135xx *p)
 	p->hrdy_mask = S1D13541_STATUS_HRDY;
 	p->hrdy_result = S1D13541_STATUS_HRDY;
 	p->measured_temp = -127;
+	p->wf_temp = -127;
+#if CONFIG_REG_SHADOW
+	s1d135xx_set_shadow(p, s1d13541_shadow_regs,
+			    ARRAY_SIZE(s1d13541_shadow_regs));
+#endif
+	/* VCC stays on in sleep so the internal memory is retained */
+	p->sleep_state = S1D135XX_STATE_ALL;
+	p->state = 0;
 	s1d135xx_hard_reset(p->gpio, p->data);
 
 	if (s1d135xx_soft_reset(p))
@@ -241,14 +354,20 @@ int epson_epdc_early_init_s1d13541(struct s1d135xx *p)
 	if (s1d135xx_check_prod_code(p, S1D13541_PROD_CODE))
 		return -1;
 
-	return s1d13541_init_clocks(p);
+	if (s1d13541_init_clocks(p))
+		return -1;
+
+	p->flags.early_init_done = 1;
+
+	return 0;
 }
 
 int epson_epdc_init_s1d13541(struct pl_epdc *epdc)
 {
 	struct s1d135xx *p = epdc->data;
 
-	if (epson_epdc_early_init_s1d13541(p))
+	/* skip the reset if already done to use the I2C master */
+	if (!p->flags.early_init_done && epson_epdc_early_init_s1d13541(p))
 		return -1;
 
 	if (s1d135xx_load_init_code(p)) {
@@ -280,11 +399,18 @@ int epson_epdc_init_s1d13541(struct pl_epdc *epdc)
 		return -1;
 
 	epdc->load_wflib = s1d13541_load_wflib;
+	epdc->load_wflib_part = s1d13541_load_wflib_part;
 	epdc->set_temp_mode = s1d13541_set_temp_mode;
 	epdc->update_temp = s1d13541_update_temp;
 	epdc->fill = s1d13541_fill;
+	epdc->fill_areas = s1d13541_fill_areas;
 	epdc->pattern_check = s1d13541_pattern_check;
 	epdc->load_image = s1d13541_load_image;
+	epdc->load_image_file = s1d13541_load_image_file;
+	epdc->load_area_begin = s1d13541_load_area_begin;
+	epdc->load_area_data = s1d13541_load_area_data;
+	epdc->load_area_end = s1d13541_load_area_end;
+	epdc->load_area_begin_4bpp = s1d13541_load_area_begin_4bpp;
 	if(global_config.waveform_version == 0){
 		epdc->wf_table = s1d13541_wf_table_old;
 	}else{
@@ -310,6 +436,14 @@ static int s1d13541_init_clocks(struct s1d135xx *p)
 	return s1d135xx_wait_idle(p);
 }
 
+/* Record the temperature the waveforms were loaded at, unknown until the
+ * first measurement */
+static void wflib_loaded(struct s1d135xx *p)
+{
+	p->wf_temp = p->measured_temp;
+	p->flags.wf_update_pending = 0;
+}
+
 static void update_temp(struct s1d135xx *p, uint16_t reg)
 {
 	uint16_t regval;
@@ -32,10 +32,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pl/interface.h>
+#include <pl/prof.h>
+#include <pl/trace.h>
 #include "assert.h"
+#include "dlog.h"
 
 /* until the i/o operations are abstracted */
 #include "pnm-utils.h"
+#include "plimg.h"
+#include "readahead.h"
+#include "crc16.h"
 
 #define LOG_TAG "s1d135xx"
 #include "utils.h"
@@ -46,6 +52,7 @@
 #define VERBOSE 0
 
 #define DATA_BUFFER_LENGTH              2048 // must be above maximum xres value for any supported display
+#define XFER_ASYNC_LENGTH               128  // each of the two buffers used with asynchronous interfaces
 
 #define S1D135XX_WF_MODE(_wf)           (((_wf) << 8) & 0x0F00)
 #define S1D135XX_XMASK                  0x0FFF
@@ -55,6 +62,10 @@
 #define S1D135XX_PWR_CTRL_DOWN          0x8002
 #define S1D135XX_PWR_CTRL_BUSY          0x0080
 #define S1D135XX_PWR_CTRL_CHECK_ON      0x2200
+#define S1D135XX_RESET_PULSE_MS         4
+#define S1D135XX_RESET_READY_US         10000UL
+#define S1D135XX_CMD_SETTLE_US          20
+#define S1D135XX_INIT_TIMEOUT_MS        500
 
 enum s1d135xx_cmd {
 	S1D135XX_CMD_INIT_SET         	 = 0x00, /* to load init code */
@@ -81,7 +92,14 @@ enum s1d135xx_cmd {
 	S1D135XX_CMD_EPD_GDRV_CLR     	 = 0x37,
 };
 
+static void init_gpio_handles(struct s1d135xx *p);
+static int shadow_index(struct s1d135xx *p, uint16_t reg);
+static uint16_t read_reg(struct s1d135xx *p, uint16_t reg);
+static void cache_set_slot(struct s1d135xx *p, unsigned i);
+static void cache_invalidate(struct s1d135xx *p, int all);
 static int get_hrdy(struct s1d135xx *p);
+static int fill_word(const struct pl_area *area, unsigned bpp, uint8_t g,
+		     uint16_t *val16, uint32_t *words);
 static int do_fill(struct s1d135xx *p, const struct pl_area *area,
 		   unsigned bpp, uint8_t g);
 static int wflib_wr(void *ctx, const uint8_t *data, size_t n);
@@ -90,14 +108,39 @@ static int transfer_file_scrambled(struct s1d135xx *p, FIL *file, int xres);
 static int transfer_image(struct s1d135xx *p, FIL *f, const struct pl_area *area, int left,
 			  int top, int width, int xres, uint16_t scramble, uint16_t source_offset);
 static void transfer_data(struct s1d135xx *p, const uint8_t *data, size_t n);
+static int load_plimg(struct s1d135xx *p, struct plimg *img, uint16_t mode,
+		      unsigned bpp, const struct pl_area *area, int left,
+		      int top);
+static int plimg_crop_sink(const uint8_t *data, size_t n, void *ctx);
+static void transfer_raw(struct s1d135xx *p, const uint8_t *data, size_t n);
+static void transfer_async(struct s1d135xx *p, const uint8_t *data, size_t n,
+			   int swap);
+static void transfer_wait(struct s1d135xx *p);
 static void send_cmd_area(struct s1d135xx *p, uint16_t cmd, uint16_t mode,
 			  const struct pl_area *area);
 static void send_cmd_cs(struct s1d135xx *p, uint16_t cmd);
 static void send_cmd(struct s1d135xx *p, uint16_t cmd);
 static void send_params(struct s1d135xx *p, const uint16_t *params, size_t n);
 static void send_param(struct s1d135xx *p, uint16_t param);
+static void send_repeat(struct s1d135xx *p, const uint16_t *pattern,
+			uint8_t len, uint32_t n);
+static void send_checker_line(struct s1d135xx *p, uint16_t k,
+			      uint16_t checker_size, uint16_t words);
 static void set_cs(struct s1d135xx *p, int state);
 static void set_hdc(struct s1d135xx *p, int state);
+static void wait_reset_end(void);
+static int wait_ready_ms(struct s1d135xx *p, unsigned timeout_ms,
+			 uint16_t reg, uint16_t mask);
+
+/* Time when the controller was last released from reset, so the wait for it
+ * to be ready can overlap with other initialisation steps */
+static uint32_t g_reset_release;
+static int g_reset_pending;
+
+/* With an asynchronous interface, each chunk is copied to one of these
+ * buffers while the previous one is being sent */
+static uint16_t g_xfer_bufs[2][XFER_ASYNC_LENGTH / 2];
+static uint8_t g_xfer_buf;
 
 /* ----------------------------------------------------------------------------
  * public functions
@@ -118,13 +161,17 @@ void s1d135xx_hard_reset(struct pl_gpio *gpio,
 	}
 
 	pl_gpio_set(gpio, data->reset, 0);
-	mdelay(4);
+	mdelay(S1D135XX_RESET_PULSE_MS);
 	pl_gpio_set(gpio, data->reset, 1);
-	mdelay(10);
+	g_reset_release = ticks_now();
+	g_reset_pending = 1;
 }
 
 int s1d135xx_soft_reset(struct s1d135xx *p)
 {
+	/* also needed after a hard reset, which is always followed by this */
+	p->shadow_valid = 0;
+	wait_reset_end();
 	s1d135xx_write_reg(p, S1D135XX_REG_SOFTWARE_RESET, 0xFF);
 
 	return s1d135xx_wait_idle(p);
@@ -183,18 +230,21 @@ int s1d135xx_load_init_code(struct s1d135xx *p)
 	send_cmd(p, S1D135XX_CMD_INIT_STBY);
 	send_param(p, 0x0500);
 	set_cs(p, 1);
-	mdelay(100);
 
-	if (s1d135xx_wait_idle(p))
-		return -1;
-
-	checksum = s1d135xx_read_reg(p, S1D135XX_REG_SEQ_AUTOBOOT_CMD);
-
-	if (!(checksum & (uint16_t)S1D135XX_INIT_CODE_CHECKSUM_OK)) {
-		LOG("Init code checksum error");
+	/* poll until the init code has been checked rather than sleeping */
+	if (wait_ready_ms(p, S1D135XX_INIT_TIMEOUT_MS,
+			  S1D135XX_REG_SEQ_AUTOBOOT_CMD,
+			  S1D135XX_INIT_CODE_CHECKSUM_OK)) {
+		checksum = s1d135xx_read_reg(p, S1D135XX_REG_SEQ_AUTOBOOT_CMD);
+		LOG("Init code checksum error (0x%04X)", checksum);
 		return -1;
 	}
 
+	/* the registers have been set up again by the init code */
+	p->shadow_valid = 0;
+	p->state &= ~S1D135XX_STATE_OVERRIDES;
+	p->state |= S1D135XX_STATE_INIT_CODE;
+
 	return 0;
 }
 
@@ -223,7 +273,54 @@ int s1d135xx_load_wflib(struct s1d135xx *p, struct pl_wflib *wflib,
 
 	send_cmd_cs(p, S1D135XX_CMD_BST_END_SDR);
 
-	return s1d135xx_wait_idle(p);
+	if (s1d135xx_wait_idle(p))
+		return -1;
+
+	p->state |= S1D135XX_STATE_WFLIB;
+
+	return 0;
+}
+
+int s1d135xx_load_wflib_part(struct s1d135xx *p, struct pl_wflib *wflib,
+			     uint32_t addr, uint32_t offset, uint32_t n)
+{
+	uint16_t params[4];
+	uint32_t n2 = n / 2;
+
+	assert(wflib->xfer_part != NULL);
+	assert(!(offset & 1));
+
+	if (s1d135xx_wait_idle(p))
+		return -1;
+
+	addr += offset;
+	params[0] = addr & 0xFFFF;
+	params[1] = (addr >> 16) & 0xFFFF;
+	params[2] = n2 & 0xFFFF;
+	params[3] = (n2 >> 16) & 0xFFFF;
+	set_cs(p, 0);
+	send_cmd(p, S1D135XX_CMD_BST_WR_SDR);
+	send_params(p, params, ARRAY_SIZE(params));
+	set_cs(p, 1);
+
+	if (offset == 0)
+		p->state &= ~S1D135XX_STATE_WFLIB;
+
+	if (wflib->xfer_part(wflib, offset, n, wflib_wr, p))
+		return -1;
+
+	if (s1d135xx_wait_idle(p))
+		return -1;
+
+	send_cmd_cs(p, S1D135XX_CMD_BST_END_SDR);
+
+	if (s1d135xx_wait_idle(p))
+		return -1;
+
+	if ((offset + n) == wflib->size)
+		p->state |= S1D135XX_STATE_WFLIB;
+
+	return 0;
 }
 
 int s1d135xx_init_gate_drv(struct s1d135xx *p)
@@ -276,10 +373,83 @@ int s1d135xx_fill(struct s1d135xx *p, uint16_t mode, unsigned bpp,
 	return do_fill(p, fill_area, bpp, grey);
 }
 
+static void send_checker_line(struct s1d135xx *p, uint16_t k,
+			      uint16_t checker_size, uint16_t words)
+{
+	uint16_t w = 0;
+
+	while (w < words) {
+		const uint16_t square = (w * 2) / checker_size;
+		const uint16_t val = (k + square) % 2 ? 0xFFFF : 0x0;
+		uint16_t run = 1;
+
+		while (((w + run) < words) &&
+		       (((w + run) * 2) / checker_size) == square)
+			run++;
+
+		send_repeat(p, &val, 1, run);
+		w += run;
+	}
+}
+
+/* Fill several areas, in a single chip select frame when the HDC and HRDY
+ * signals are available as no register then needs to be polled in between */
+int s1d135xx_fill_areas(struct s1d135xx *p, uint16_t mode, unsigned bpp,
+			const struct pl_area *areas, const uint8_t *greys,
+			unsigned n)
+{
+	unsigned i;
+
+	if ((p->data->hdc == PL_GPIO_NONE) || (p->data->hrdy == PL_GPIO_NONE)) {
+		for (i = 0; i < n; ++i)
+			if (s1d135xx_fill(p, mode, bpp, &areas[i], greys[i]))
+				return -1;
+
+		return 0;
+	}
+
+	set_cs(p, 0);
+
+	for (i = 0; i < n; ++i) {
+		uint16_t val16;
+		uint32_t words;
+
+		if (fill_word(&areas[i], bpp, greys[i], &val16, &words))
+			break;
+
+		send_cmd_area(p, S1D135XX_CMD_LD_IMG_AREA, mode, &areas[i]);
+
+		if (s1d135xx_wait_idle(p))
+			break;
+
+		send_cmd(p, S1D135XX_CMD_WRITE_REG);
+		send_param(p, S1D135XX_REG_HOST_MEM_PORT);
+		send_repeat(p, &val16, 1, words);
+
+		if (s1d135xx_wait_idle(p))
+			break;
+
+		send_cmd(p, S1D135XX_CMD_LD_IMG_END);
+
+		if (s1d135xx_wait_idle(p))
+			break;
+	}
+
+	set_cs(p, 1);
+
+	return (i == n) ? 0 : -1;
+}
+
+/* Each line is a cycle of checker_size words, so all the lines of a row of
+ * squares can be sent in one go when they are a whole number of cycles.
+ * Larger squares are sent as runs of the same word. */
 int s1d135xx_pattern_check(struct s1d135xx *p, uint16_t height, uint16_t width, uint16_t checker_size, uint16_t mode)
 {
-	uint16_t i = 0, j = 0, k = 0;
-	uint16_t val = 0;
+	uint16_t cycle[S1D135XX_REPEAT_MAX];
+	const uint16_t words = (width + 1) / 2;
+	uint16_t i, j;
+
+	assert(checker_size);
 
 	set_cs(p, 0);
 	send_cmd(p, S1D135XX_CMD_LD_IMG);
@@ -293,12 +463,29 @@ int s1d135xx_pattern_check(struct s1d135xx *p, uint16_t height, uint16_t width,
 	send_cmd(p, S1D135XX_CMD_WRITE_REG);
 	send_param(p, S1D135XX_REG_HOST_MEM_PORT);
 
-	for (i = 0; i < height; i++) {
-		k = i / checker_size;
-		for (j = 0; j < width; j += 2) {
-			val = (k + (j / checker_size)) % 2 ? 0xFFFF : 0x0;
-			send_param(p, val);
+	for (i = 0; i < height;) {
+		const uint16_t k = i / checker_size;
+		uint16_t lines;
+
+		for (j = 0; j < checker_size && j < S1D135XX_REPEAT_MAX; j++)
+			cycle[j] = (k + ((j * 2) / checker_size)) % 2 ?
+				0xFFFF : 0x0;
+
+		lines = min((uint16_t)(checker_size - (i % checker_size)),
+			    (uint16_t)(height - i));
+
+		if (checker_size > S1D135XX_REPEAT_MAX) {
+			for (j = 0; j < lines; j++)
+				send_checker_line(p, k, checker_size, words);
+		} else if (words % checker_size) {
+			for (j = 0; j < lines; j++)
+				send_repeat(p, cycle, checker_size, words);
+		} else {
+			send_repeat(p, cycle, checker_size,
+				    (uint32_t)words * lines);
 		}
+
+		i += lines;
 	}
 
 	set_cs(p, 1);
@@ -315,14 +502,35 @@ int s1d135xx_load_image(struct s1d135xx *p, const char *path, uint16_t mode,
 			unsigned bpp, struct pl_area *area, int left,
 			int top)
 {
-	struct pnm_header hdr;
 	FIL img_file;
 	int stat;
 
 	if (f_open(&img_file, path, FA_READ) != FR_OK)
 		return -1;
 
-	if (pnm_read_header(&img_file, &hdr))
+	stat = s1d135xx_load_image_file(p, &img_file, mode, bpp, area, left,
+					top);
+	f_close(&img_file);
+
+	return stat;
+}
+
+int s1d135xx_load_image_file(struct s1d135xx *p, FIL *img_file,
+			     uint16_t mode, unsigned bpp,
+			     struct pl_area *area, int left, int top)
+{
+	struct pnm_header hdr;
+	struct plimg plimg;
+	struct pl_area full_area;
+	int stat;
+
+	stat = plimg_open(&plimg, img_file);
+
+	if (stat <= 0)
+		return stat ? -1 : load_plimg(p, &plimg, mode, bpp, area, left,
+					      top);
+
+	if (pnm_read_header(img_file, &hdr))
 		return -1;
 
 	set_cs(p, 0);
@@ -340,7 +548,7 @@ int s1d135xx_load_image(struct s1d135xx *p, const char *path, uint16_t mode,
 			send_cmd(p, S1D135XX_CMD_LD_IMG);
 			send_param(p, mode);
 		}else{
-			area = (struct pl_area*) malloc(sizeof(struct pl_area));
+			area = &full_area;
 			area->top = 0;
 			area->left = 0;
 			area->width = p->xres;
@@ -362,16 +570,12 @@ int s1d135xx_load_image(struct s1d135xx *p, const char *path, uint16_t mode,
 	send_param(p, S1D135XX_REG_HOST_MEM_PORT);
 
 	if (area == NULL || p->source_offset){
-		stat = transfer_file_scrambled(p, &img_file, hdr.width);
+		stat = transfer_file_scrambled(p, img_file, hdr.width);
 	}else{
-		stat = transfer_image(p, &img_file, area, left, top, hdr.width, hdr.width, p->scrambling, p->source_offset);
-	}
-	if(area){
-		free(area);
+		stat = transfer_image(p, img_file, area, left, top, hdr.width, hdr.width, p->scrambling, p->source_offset);
 	}
 
 	set_cs(p, 1);
-	f_close(&img_file);
 
 	if (stat)
 		return -1;
@@ -384,15 +588,149 @@ int s1d135xx_load_image(struct s1d135xx *p, const char *path, uint16_t mode,
 	return s1d135xx_wait_idle(p);
 }
 
+/* The image buffer start address register is followed by the high word.
+ * Slot 0 is the image buffer set up by the init code, and the other slots
+ * are n_slots - 1 consecutive frames of slot_size bytes from base. */
+int s1d135xx_cache_init(struct s1d135xx *p, struct s1d135xx_cache *cache,
+			struct s1d135xx_cache_slot *slots, unsigned n_slots,
+			uint16_t img_buf_reg, uint32_t base,
+			uint32_t slot_size)
+{
+	assert(n_slots > 0);
+
+	if (s1d135xx_wait_idle(p))
+		return -1;
+
+	cache->img_buf = s1d135xx_read_reg(p, img_buf_reg + 2);
+	cache->img_buf <<= 16;
+	cache->img_buf |= s1d135xx_read_reg(p, img_buf_reg);
+	cache->base = base;
+	cache->slot_size = slot_size;
+	cache->img_buf_reg = img_buf_reg;
+	cache->clock = 0;
+	cache->n_slots = n_slots;
+	cache->current = 0;
+	cache->loading = 0;
+	cache->slots = slots;
+	memset(slots, 0, n_slots * sizeof(struct s1d135xx_cache_slot));
+	p->cache = cache;
+
+	return 0;
+}
+
+/* Load a full image unless it's already in a cache slot, the key and file
+ * size identify the image.  The least recently used slot gets replaced. */
+int s1d135xx_load_image_cached(struct s1d135xx *p, FIL *img_file,
+			       uint32_t key, uint16_t mode, unsigned bpp)
+{
+	struct s1d135xx_cache *c = p->cache;
+	struct s1d135xx_cache_slot *s;
+	unsigned lru = 0;
+	unsigned i;
+	int stat;
+
+	if (c == NULL)
+		return s1d135xx_load_image_file(p, img_file, mode, bpp, NULL,
+						0, 0);
+
+	for (i = 0; i < c->n_slots; ++i) {
+		s = &c->slots[i];
+
+		if (s->valid && (s->key == key) &&
+		    (s->size == img_file->fsize)) {
+			if (s1d135xx_wait_update_end(p))
+				return -1;
+
+			cache_set_slot(p, i);
+			s->used = ++c->clock;
+
+			return 0;
+		}
+
+		if (!c->slots[lru].valid)
+			continue;
+
+		if (!s->valid || ((uint16_t)(c->clock - s->used) >
+				  (uint16_t)(c->clock - c->slots[lru].used)))
+			lru = i;
+	}
+
+	if (s1d135xx_wait_update_end(p))
+		return -1;
+
+	s = &c->slots[lru];
+	s->valid = 0;
+	cache_set_slot(p, lru);
+	c->loading = 1;
+	stat = s1d135xx_load_image_file(p, img_file, mode, bpp, NULL, 0, 0);
+	c->loading = 0;
+
+	if (stat)
+		return -1;
+
+	s->key = key;
+	s->size = img_file->fsize;
+	s->used = ++c->clock;
+	s->valid = 1;
+
+	return 0;
+}
+
+int s1d135xx_load_area_begin(struct s1d135xx *p, uint16_t mode,
+			     const struct pl_area *area)
+{
+	if (s1d135xx_wait_idle(p))
+		return -1;
+
+	set_cs(p, 0);
+
+	if (area != NULL) {
+		send_cmd_area(p, S1D135XX_CMD_LD_IMG_AREA, mode, area);
+	} else {
+		send_cmd(p, S1D135XX_CMD_LD_IMG);
+		send_param(p, mode);
+	}
+
+	set_cs(p, 1);
+
+	if (s1d135xx_wait_idle(p))
+		return -1;
+
+	/* CS stays asserted until s1d135xx_load_area_end */
+	set_cs(p, 0);
+	send_cmd(p, S1D135XX_CMD_WRITE_REG);
+	send_param(p, S1D135XX_REG_HOST_MEM_PORT);
+
+	return 0;
+}
+
+void s1d135xx_load_area_data(struct s1d135xx *p, const uint8_t *data,
+			     size_t n)
+{
+	transfer_data(p, data, n);
+}
+
+int s1d135xx_load_area_end(struct s1d135xx *p)
+{
+	set_cs(p, 1);
+
+	if (s1d135xx_wait_idle(p))
+		return -1;
+
+	send_cmd_cs(p, S1D135XX_CMD_LD_IMG_END);
+
+	return s1d135xx_wait_idle(p);
+}
+
 int s1d135xx_update(struct s1d135xx *p, int wfid, enum pl_update_mode mode,  const struct pl_area *area)
 {
 	struct pl_area area_scrambled;
 #if VERBOSE
 	if (area != NULL)
-		LOG("update area %d (%d, %d) %dx%d", wfid,
-		    area->left, area->top, area->width, area->height);
+		dlog(DLOG_S1D135XX_UPDATE_AREA, wfid,
+		     area->left, area->top, area->width, area->height);
 	else
-		LOG("update %d", wfid);
+		dlog(DLOG_S1D135XX_UPDATE, wfid);
 #endif
 	uint8_t command = S1D135XX_CMD_UPDATE_FULL + mode;
 	set_cs(p, 0);
@@ -451,27 +789,41 @@ int s1d135xx_wait_update_end(struct s1d135xx *p)
 int s1d135xx_wait_idle(struct s1d135xx *p)
 {
 	unsigned long timeout = 100000;
+#if CONFIG_EPDC_TRACE
+	const uint32_t start = ticks_now();
+#endif
 
+	PL_PROF_START(PL_PROF_WAIT_IDLE);
 	while (!get_hrdy(p) && --timeout);
+	PL_PROF_STOP(PL_PROF_WAIT_IDLE);
 
 	if (!timeout) {
-		LOG("HRDY timeout");
+		dlog(DLOG_HRDY_TIMEOUT);
 		return -1;
 	}
 
+	PL_TRACE(PL_TRACE_WAIT, 0, ticks_now() - start);
+
 	return 0;
 }
 
-int s1d135xx_set_power_state(struct s1d135xx *p,
-			     enum pl_epdc_power_state state)
+void s1d135xx_power_on(struct s1d135xx *p)
 {
 	const struct s1d135xx_data *data = p->data;
-	int stat;
 
 	set_cs(p, 1);
 	set_hdc(p, 1);
 	pl_gpio_set(p->gpio, data->vcc_en, 1);
 	pl_gpio_set(p->gpio, data->clk_en, 1);
+}
+
+int s1d135xx_set_power_state(struct s1d135xx *p,
+			     enum pl_epdc_power_state state)
+{
+	const struct s1d135xx_data *data = p->data;
+	int stat;
+
+	s1d135xx_power_on(p);
 
 	if (s1d135xx_wait_idle(p))
 		return -1;
@@ -503,16 +855,45 @@ int s1d135xx_set_power_state(struct s1d135xx *p,
 		break;
 	}
 
+	s1d135xx_lose_state(p, s1d135xx_kept_state(p, state));
+
 	return stat;
 }
 
+/* State bits kept by the controller in the given power state */
+uint8_t s1d135xx_kept_state(struct s1d135xx *p,
+			    enum pl_epdc_power_state state)
+{
+	switch (state) {
+	case PL_EPDC_RUN:
+	case PL_EPDC_STANDBY:
+		return S1D135XX_STATE_ALL;
+	case PL_EPDC_SLEEP:
+		return p->sleep_state;
+	case PL_EPDC_OFF:
+	default:
+		return 0;
+	}
+}
+
+void s1d135xx_lose_state(struct s1d135xx *p, uint8_t kept)
+{
+	p->state &= kept;
+
+	if (!(kept & S1D135XX_STATE_INIT_CODE))
+		p->shadow_valid = 0;
+
+	if (!(kept & S1D135XX_STATE_IMAGE))
+		cache_invalidate(p, 1);
+}
+
 int s1d135xx_set_epd_power(struct s1d135xx *p, int on)
 {
 	uint16_t arg = on ? S1D135XX_PWR_CTRL_UP : S1D135XX_PWR_CTRL_DOWN;
 	uint16_t tmp;
 
 #if VERBOSE
-	LOG("EPD power o%s", on ? "n" : "ff");
+	dlog(DLOG_S1D135XX_EPD_POWER, on);
 #endif
 
 	if (s1d135xx_wait_idle(p))
@@ -563,28 +944,52 @@ void s1d135xx_cmd(struct s1d135xx *p, uint16_t cmd, const uint16_t *params,
 	set_cs(p, 1);
 }
 
+/* Registers in the list are read once and then served from memory, so they
+ * must only be changed by s1d135xx_write_reg().  Status registers such as
+ * SYSTEM_STATUS, INT_RAW_STAT or DISPLAY_BUSY must not be in the list. */
+void s1d135xx_set_shadow(struct s1d135xx *p, const uint16_t *regs,
+			 unsigned n)
+{
+	assert(n <= S1D135XX_SHADOW_MAX);
+
+	p->shadow_regs = regs;
+	p->n_shadow_regs = n;
+	p->shadow_valid = 0;
+}
+
 uint16_t s1d135xx_read_reg(struct s1d135xx *p, uint16_t reg)
 {
+	const int i = shadow_index(p, reg);
 	uint16_t val;
 
-	set_cs(p, 0);
-	send_cmd(p, S1D135XX_CMD_READ_REG);
-	send_param(p, reg);
-	p->interface->read((uint8_t *)&val, sizeof(uint16_t));
-	p->interface->read((uint8_t *)&val, sizeof(uint16_t));
-	set_cs(p, 1);
+	if ((i >= 0) && (p->shadow_valid & (1 << i)))
+		return p->shadow[i];
+
+	val = read_reg(p, reg);
+	PL_TRACE(PL_TRACE_READ, val, 0);
 
-	return be16toh(val);
+	if (i >= 0) {
+		p->shadow[i] = val;
+		p->shadow_valid |= (1 << i);
+	}
+
+	return val;
 }
 
 void s1d135xx_write_reg(struct s1d135xx *p, uint16_t reg, uint16_t val)
 {
 	const uint16_t params[] = { reg, val };
+	const int i = shadow_index(p, reg);
 
 	set_cs(p, 0);
 	send_cmd(p, S1D135XX_CMD_WRITE_REG);
 	send_params(p, params, ARRAY_SIZE(params));
 	set_cs(p, 1);
+
+	if (i >= 0) {
+		p->shadow[i] = val;
+		p->shadow_valid |= (1 << i);
+	}
 }
 
 int s1d135xx_load_register_overrides(struct s1d135xx *p)
@@ -599,6 +1004,7 @@ int s1d135xx_load_register_overrides(struct s1d135xx *p)
 	res = f_open(&file, override_path, FA_READ);
 	if (res != FR_OK) {
 		if (res == FR_NO_FILE) {
+			p->state |= S1D135XX_STATE_OVERRIDES;
 			return 0;
 		}
 		else {
@@ -638,13 +1044,16 @@ int s1d135xx_load_register_overrides(struct s1d135xx *p)
 			break;
 
 		s1d135xx_write_reg(p, reg, val);
-		if (val == s1d135xx_read_reg(p, reg)) {
+		if (val == read_reg(p, reg)) {
 			stat = 0;	/* success */
 		}
 	}
 
 	f_close(&file);
 
+	if (!stat)
+		p->state |= S1D135XX_STATE_OVERRIDES;
+
 	return stat;
 }
 
@@ -652,23 +1061,151 @@ int s1d135xx_load_register_overrides(struct s1d135xx *p)
  * private functions
  */
 
+/* Resolve the GPIOs used on every access so they don't need to be looked up
+ * each time */
+static void init_gpio_handles(struct s1d135xx *p)
+{
+	if (pl_gpio_get_handle(p->gpio, p->data->cs0, &p->cs0_h) ||
+	    pl_gpio_get_handle(p->gpio, p->data->hdc, &p->hdc_h) ||
+	    pl_gpio_get_handle(p->gpio, p->data->hrdy, &p->hrdy_h))
+		abort_msg("Failed to get S1D135xx GPIO handles",
+			  ABORT_EPDC_INIT);
+
+	p->flags.gpio_handles_done = 1;
+}
+
+static int shadow_index(struct s1d135xx *p, uint16_t reg)
+{
+	unsigned i;
+
+	for (i = 0; i < p->n_shadow_regs; ++i)
+		if (p->shadow_regs[i] == reg)
+			return i;
+
+	return -1;
+}
+
+static uint16_t read_reg(struct s1d135xx *p, uint16_t reg)
+{
+	uint16_t val[2];
+
+	set_cs(p, 0);
+	send_cmd(p, S1D135XX_CMD_READ_REG);
+	send_param(p, reg);
+
+	if (p->interface->read_words != NULL) {
+		p->interface->read_words(val, 2);
+		set_cs(p, 1);
+		return val[1];
+	}
+
+	p->interface->read((uint8_t *)&val[0], sizeof(uint16_t));
+	p->interface->read((uint8_t *)&val[0], sizeof(uint16_t));
+	set_cs(p, 1);
+
+	return be16toh(val[0]);
+}
+
+static void cache_set_slot(struct s1d135xx *p, unsigned i)
+{
+	struct s1d135xx_cache *c = p->cache;
+	uint32_t addr;
+
+	if (i == c->current)
+		return;
+
+	addr = i ? (c->base + ((i - 1) * c->slot_size)) : c->img_buf;
+	s1d135xx_write_reg(p, c->img_buf_reg, addr & 0xFFFF);
+	s1d135xx_write_reg(p, c->img_buf_reg + 2, (addr >> 16) & 0xFFFF);
+	c->current = i;
+}
+
+/* Called when image data gets written other than to load a cached image */
+static void cache_invalidate(struct s1d135xx *p, int all)
+{
+	struct s1d135xx_cache *c = p->cache;
+	unsigned i;
+
+	if ((c == NULL) || c->loading)
+		return;
+
+	if (!all) {
+		c->slots[c->current].valid = 0;
+		return;
+	}
+
+	for (i = 0; i < c->n_slots; ++i)
+		c->slots[i].valid = 0;
+}
+
 static int get_hrdy(struct s1d135xx *p)
 {
 	uint16_t status;
 
+	if (!p->flags.gpio_handles_done)
+		init_gpio_handles(p);
+
 	if (p->data->hrdy != PL_GPIO_NONE)
-		return pl_gpio_get(p->gpio, p->data->hrdy);
+		return pl_gpio_fast_get(&p->hrdy_h);
 
+	PL_TRACE_PAUSE(1);
 	status = s1d135xx_read_reg(p, S1D135XX_REG_SYSTEM_STATUS);
+	PL_TRACE_PAUSE(0);
 
 	return ((status & p->hrdy_mask) == p->hrdy_result);
 }
 
-static int do_fill(struct s1d135xx *p, const struct pl_area *area,
-		   unsigned bpp, uint8_t g)
+/* Wait until the controller can be accessed after a hard reset */
+static void wait_reset_end(void)
+{
+	if (!g_reset_pending)
+		return;
+
+	while ((ticks_now() - g_reset_release) < S1D135XX_RESET_READY_US);
+
+	g_reset_pending = 0;
+}
+
+/* Poll HRDY and optionally some register bits until they are all set, or
+ * until the deadline.  This replaces fixed sleeps after long commands. */
+static int wait_ready_ms(struct s1d135xx *p, unsigned timeout_ms,
+			 uint16_t reg, uint16_t mask)
+{
+	const uint32_t start = ticks_now();
+	const uint32_t timeout = (uint32_t)timeout_ms * 1000;
+
+	/* give HRDY some time to go low after the command */
+	udelay(S1D135XX_CMD_SETTLE_US);
+
+	for (;;) {
+		int ready;
+
+		PL_TRACE_PAUSE(1);
+		ready = (get_hrdy(p) &&
+			 (!mask || ((s1d135xx_read_reg(p, reg) & mask) == mask)));
+		PL_TRACE_PAUSE(0);
+
+		if (ready) {
+			PL_TRACE(PL_TRACE_WAIT, 0, ticks_now() - start);
+			return 0;
+		}
+
+		if ((ticks_now() - start) > timeout)
+			break;
+	}
+
+	if (mask)
+		dlog(DLOG_S1D135XX_REG_TIMEOUT, reg, mask);
+	else
+		dlog(DLOG_HRDY_TIMEOUT);
+
+	return -1;
+}
+
+/* Word to send for a grey level and number of words to fill an area */
+static int fill_word(const struct pl_area *area, unsigned bpp, uint8_t g,
+		     uint16_t *val16, uint32_t *words)
 {
-	uint16_t val16;
-	uint16_t lines;
 	uint16_t pixels;
 
 	/* Only 16-bit transfers for now... */
@@ -680,20 +1217,32 @@ static int do_fill(struct s1d135xx *p, const struct pl_area *area,
 		LOG("Unsupported bpp");
 		return -1;
 	case 4:
-		val16 = g & 0xF0;
-		val16 |= val16 >> 4;
-		val16 |= val16 << 8;
+		*val16 = g & 0xF0;
+		*val16 |= *val16 >> 4;
+		*val16 |= *val16 << 8;
 		pixels = area->width / 4;
 		break;
 	case 8:
-		val16 = g | (g << 8);
+		*val16 = g | (g << 8);
 		pixels = area->width / 2;
 		break;
 	default:
 		assert_fail("Invalid bpp");
 	}
 
-	lines = area->height;
+	*words = (uint32_t)pixels * area->height;
+
+	return 0;
+}
+
+static int do_fill(struct s1d135xx *p, const struct pl_area *area,
+		   unsigned bpp, uint8_t g)
+{
+	uint16_t val16;
+	uint32_t words;
+
+	if (fill_word(area, bpp, g, &val16, &words))
+		return -1;
 
 	if (s1d135xx_wait_idle(p))
 		return -1;
@@ -701,14 +1250,7 @@ static int do_fill(struct s1d135xx *p, const struct pl_area *area,
 	set_cs(p, 0);
 	send_cmd(p, S1D135XX_CMD_WRITE_REG);
 	send_param(p, S1D135XX_REG_HOST_MEM_PORT);
-
-	while (lines--) {
-		uint16_t x = pixels;
-
-		while (x--)
-			send_param(p, val16);
-	}
-
+	send_repeat(p, &val16, 1, words);
 	set_cs(p, 1);
 
 	if (s1d135xx_wait_idle(p))
@@ -734,19 +1276,19 @@ static int wflib_wr(void *ctx, const uint8_t *data, size_t n)
 
 static int transfer_file(struct s1d135xx *p, FIL *file)
 {
-	uint8_t data[DATA_BUFFER_LENGTH];
-
-	for (;;) {
-		size_t count;
+	uint16_t data[DATA_BUFFER_LENGTH / 2];
+	struct readahead ra;
+	const uint8_t *buf;
+	int count;
 
-		if (f_read(file, data, sizeof(data), &count) != FR_OK)
-			return -1;
+	if (readahead_init(&ra, file, NULL, (uint8_t *)data, sizeof(data), 2))
+		return -1;
 
-		if (!count)
-			break;
+	while ((count = readahead_next(&ra, &buf)) > 0)
+		transfer_data(p, buf, count);
 
-		transfer_data(p, data, count);
-	}
+	if (readahead_end(&ra) || count)
+		return -1;
 
 	return 0;
 }
@@ -785,30 +1327,56 @@ static int transfer_file_scrambled(struct s1d135xx *p, FIL *file, int xres)
 {
 	//LOG("%s", __func__);
 	// we need to scramble the image so we need to read the file line by line
-	uint8_t data[DATA_BUFFER_LENGTH];
+	uint16_t data[DATA_BUFFER_LENGTH / 2];
 	uint8_t scrambled_data[DATA_BUFFER_LENGTH];
-	uint16_t xpad = align8(p->source_offset/2)-(align8(p->source_offset) - p->source_offset);
+	/* static to keep it off the stack, next to the two buffers above */
+	static uint16_t ra_mem[CONFIG_READAHEAD_SECTORS * READAHEAD_SECTOR_SIZE];
+	uint16_t xpad = scramble_source_pad(p->source_offset);
+	struct readahead ra;
+
+	if (readahead_init(&ra, file, NULL, (uint8_t *)ra_mem, sizeof(ra_mem),
+			   2))
+		return -1;
+
 	for (;;) {
+		const uint8_t *line;
 		size_t count;
 		uint16_t gl = 1;
 		uint16_t sl = xres;
-		// read one line of the image
-		if (f_read(file, data, xres, &count) != FR_OK)
-			return -1;
+		uint16_t scrambled;
+		// read one line of the image, only copied to data if split
+		// between two read-ahead buffers or at the end of the file
+		line = readahead_get(&ra, xres, (uint8_t *)data, &count);
+
+		if (ra.error)
+			break;
 
 		if (!count)
 			break;
+
+		if (line == NULL)
+			line = (const uint8_t *)data;
 		// scramble that line to up to 2 lines
-		if(scramble_array(data, scrambled_data, &gl, &sl ,p->scrambling)){
-			memory_padding(scrambled_data, data, gl, sl, gl, p->xres, 0, xpad );
-			transfer_data(p, data, p->xres*gl);
+		PL_PROF_START(PL_PROF_SCRAMBLE);
+		scrambled = scramble_array((uint8_t *)line, scrambled_data, &gl, &sl ,p->scrambling);
+		PL_PROF_STOP(PL_PROF_SCRAMBLE);
+
+		if(scrambled){
+			/* the padding pixels are not written by memory_padding */
+			memset(data, 0xFF, p->xres*gl);
+			memory_padding(scrambled_data, (uint8_t *)data, gl, sl, gl, p->xres, 0, xpad );
+			transfer_data(p, (const uint8_t *)data, p->xres*gl);
 		}else{
-			transfer_data(p, data, xres);
+			/* words need to be aligned */
+			if ((uintptr_t)line & 1)
+				line = memcpy(data, line, count);
+
+			transfer_data(p, line, count);
 		}
 
 	}
 
-	return 0;
+	return readahead_end(&ra);
 }
 
 static int transfer_image(struct s1d135xx *p, FIL *f, const struct pl_area *area, int left,
@@ -850,11 +1418,21 @@ static int transfer_image(struct s1d135xx *p, FIL *f, const struct pl_area *area
 		while (remaining) {
 			size_t btr = (remaining <= buffer_length) ?
 					remaining : buffer_length;
+			uint16_t scrambled;
+			FRESULT res;
 
-			if (f_read(f, data, btr, &count) != FR_OK)
+			PL_PROF_START(PL_PROF_SD_READ);
+			res = f_read(f, data, btr, &count);
+			PL_PROF_STOP(PL_PROF_SD_READ);
+
+			if (res != FR_OK)
 				return -1;
 
-			if(scramble_array(data, scrambled_data, &gl, &sl ,scramble)){
+			PL_PROF_START(PL_PROF_SCRAMBLE);
+			scrambled = scramble_array(data, scrambled_data, &gl, &sl ,scramble);
+			PL_PROF_STOP(PL_PROF_SCRAMBLE);
+
+			if(scrambled){
 				transfer_data(p, scrambled_data, btr);
 			}else{
 				transfer_data(p, data, btr);
@@ -870,14 +1448,231 @@ static int transfer_image(struct s1d135xx *p, FIL *f, const struct pl_area *area
 	return 0;
 }
 
+/* Image containers already have the pixel data scrambled, padded and in the
+ * byte order of the host interface so it is sent without any processing.
+ * Only the strips which contain the lines of the area are decoded. */
+struct plimg_crop {
+	struct s1d135xx *p;
+	uint32_t line_size;     /* bytes in each line of the image */
+	uint32_t pos;           /* position in the current line */
+	uint32_t first;         /* offset of the first byte in each line */
+	uint32_t last;          /* offset after the last byte in each line */
+	uint16_t skip;          /* number of lines to skip */
+	uint16_t lines;         /* number of lines left to send */
+};
+
+static int load_plimg(struct s1d135xx *p, struct plimg *img, uint16_t mode,
+		      unsigned bpp, const struct pl_area *area, int left,
+		      int top)
+{
+	const struct plimg_header *hdr = &img->hdr;
+	struct plimg_crop crop;
+	struct pl_area img_area;
+	unsigned strip;
+	int stat = 0;
+
+	if (plimg_check_config(hdr, &global_config))
+		return -1;
+
+	if (hdr->bpp != bpp) {
+		LOG("Unsupported image bpp: %d", hdr->bpp);
+		return -1;
+	}
+
+	if ((area != NULL) && hdr->scrambling) {
+		LOG("Ignoring area with scrambled image");
+		area = NULL;
+	}
+
+	if (area == NULL) {
+		img_area.left = img_area.top = 0;
+		img_area.width = hdr->width;
+		img_area.height = hdr->height;
+		left = top = 0;
+	} else {
+		img_area = *area;
+	}
+
+	if (((left + img_area.width) > hdr->width) ||
+	    ((top + img_area.height) > hdr->height) ||
+	    ((img_area.left + img_area.width) > p->xres) ||
+	    ((img_area.top + img_area.height) > p->yres) ||
+	    (((left * bpp) / 8) % 2) || (((img_area.width * bpp) / 8) % 2)) {
+		LOG("Invalid combination of width/left/area");
+		return -1;
+	}
+
+	crop.p = p;
+	crop.line_size = PLIMG_LINE_SIZE(hdr);
+	crop.pos = 0;
+	crop.first = ((uint32_t)left * bpp) / 8;
+	crop.last = crop.first + ((uint32_t)img_area.width * bpp) / 8;
+	crop.skip = top % hdr->strip_lines;
+	crop.lines = img_area.height;
+
+	set_cs(p, 0);
+
+	if ((img_area.width == p->xres) && (img_area.height == p->yres)) {
+		send_cmd(p, S1D135XX_CMD_LD_IMG);
+		send_param(p, mode);
+	} else {
+		send_cmd_area(p, S1D135XX_CMD_LD_IMG_AREA, mode, &img_area);
+	}
+
+	set_cs(p, 1);
+
+	if (s1d135xx_wait_idle(p))
+		return -1;
+
+	set_cs(p, 0);
+	send_cmd(p, S1D135XX_CMD_WRITE_REG);
+	send_param(p, S1D135XX_REG_HOST_MEM_PORT);
+
+	for (strip = top / hdr->strip_lines; !stat && crop.lines; ++strip) {
+		stat = plimg_read_strip(img, strip, plimg_crop_sink, &crop);
+
+		/* the sink stops the decoder after the last line */
+		if (stat && !crop.lines)
+			stat = 0;
+	}
+
+	set_cs(p, 1);
+
+	if (stat)
+		return -1;
+
+	if (s1d135xx_wait_idle(p))
+		return -1;
+
+	send_cmd_cs(p, S1D135XX_CMD_LD_IMG_END);
+
+	return s1d135xx_wait_idle(p);
+}
+
+static int plimg_crop_sink(const uint8_t *data, size_t n, void *ctx)
+{
+	struct plimg_crop *crop = ctx;
+
+	while (n) {
+		const size_t chunk = min(n, crop->line_size - crop->pos);
+
+		if (!crop->skip) {
+			const uint32_t start = max(crop->pos, crop->first);
+			const uint32_t end = min(crop->pos + chunk, crop->last);
+
+			if (start < end)
+				transfer_raw(crop->p, &data[start - crop->pos],
+					     end - start);
+		}
+
+		crop->pos += chunk;
+		data += chunk;
+		n -= chunk;
+
+		if (crop->pos == crop->line_size) {
+			crop->pos = 0;
+
+			if (crop->skip)
+				crop->skip--;
+			else if (!--crop->lines)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* The interface functions can only send up to 255 bytes at a time */
+static void transfer_raw(struct s1d135xx *p, const uint8_t *data, size_t n)
+{
+	PL_TRACE(PL_TRACE_DATA, 0, n);
+
+	if (p->interface->write_async != NULL) {
+		transfer_async(p, data, n, 0);
+		return;
+	}
+
+	PL_PROF_START(PL_PROF_XFER);
+
+	while (n) {
+		const uint8_t chunk = min(n, 254);
+
+		p->interface->write((uint8_t *)data, chunk);
+		data += chunk;
+		n -= chunk;
+	}
+
+	PL_PROF_STOP(PL_PROF_XFER);
+}
+
 static void transfer_data(struct s1d135xx *p, const uint8_t *data, size_t n)
 {
 	const uint16_t *data16 = (const uint16_t *)data;
 
+	PL_TRACE(PL_TRACE_DATA, 0, n);
+
+	if (p->interface->write_words != NULL) {
+		PL_PROF_START(PL_PROF_XFER);
+		p->interface->write_words(data16, n / 2);
+		PL_PROF_STOP(PL_PROF_XFER);
+		return;
+	}
+
+	if (p->interface->write_async != NULL) {
+		transfer_async(p, data, n, 1);
+		return;
+	}
+
 	n /= 2;
 
+	PL_PROF_START(PL_PROF_XFER);
+	PL_TRACE_PAUSE(1);
+
 	while (n--)
 		send_param(p, *data16++);
+
+	PL_TRACE_PAUSE(0);
+	PL_PROF_STOP(PL_PROF_XFER);
+}
+
+/* Copy the next chunk to a free buffer, swapping the bytes of each word as
+ * send_param() does if needed, and start sending it */
+static void transfer_async(struct s1d135xx *p, const uint8_t *data, size_t n,
+			   int swap)
+{
+	PL_PROF_START(PL_PROF_XFER);
+
+	while (n) {
+		const size_t chunk = min(n, XFER_ASYNC_LENGTH) & ~1;
+		uint16_t *buf = g_xfer_bufs[g_xfer_buf];
+
+		if (!chunk)
+			break;
+
+		if (swap) {
+			const uint16_t *data16 = (const uint16_t *)data;
+			size_t i;
+
+			for (i = 0; i < (chunk / 2); ++i)
+				buf[i] = htobe16(data16[i]);
+		} else {
+			memcpy(buf, data, chunk);
+		}
+
+		p->interface->write_async((const uint8_t *)buf, chunk, NULL,
+					  NULL);
+		g_xfer_buf ^= 1;
+		data += chunk;
+		n -= chunk;
+	}
+
+	PL_PROF_STOP(PL_PROF_XFER);
+}
+
+static void transfer_wait(struct s1d135xx *p)
+{
+	if (p->interface->wait != NULL)
+		p->interface->wait();
 }
 
 static void send_cmd_area(struct s1d135xx *p, uint16_t cmd, uint16_t mode,
@@ -909,10 +1704,15 @@ static void send_cmd_cs(struct s1d135xx *p, uint16_t cmd)
 
 static void send_cmd(struct s1d135xx *p, uint16_t cmd)
 {
-	cmd = htobe16(cmd);
+	if ((cmd == S1D135XX_CMD_LD_IMG) || (cmd == S1D135XX_CMD_LD_IMG_AREA)) {
+		cache_invalidate(p, 0);
+		p->state |= S1D135XX_STATE_IMAGE;
+	}
+
+	PL_TRACE(PL_TRACE_CMD, cmd, 0);
 
 	set_hdc(p, 0);
-	p->interface->write((uint8_t *)&cmd, sizeof(uint16_t));
+	send_param(p, cmd);
 	set_hdc(p, 1);
 }
 
@@ -920,27 +1720,81 @@ static void send_params(struct s1d135xx *p, const uint16_t *params, size_t n)
 {
 	size_t i;
 
+	if (p->interface->write_words != NULL) {
+#if CONFIG_EPDC_TRACE
+		for (i = 0; i < n; ++i)
+			PL_TRACE(PL_TRACE_PARAM, params[i], 0);
+#endif
+		p->interface->write_words(params, n);
+		return;
+	}
+
 	for (i = 0; i < n; ++i)
 		send_param(p, params[i]);
 }
 
 static void send_param(struct s1d135xx *p, uint16_t param)
 {
+	PL_TRACE(PL_TRACE_PARAM, param, 0);
+
+	if (p->interface->write_words != NULL) {
+		p->interface->write_words(&param, 1);
+		return;
+	}
+
 	param = htobe16(param);
 	p->interface->write((uint8_t *)&param, sizeof(uint16_t));
 }
 
+/* Without a transport primitive, send a buffer with as many whole cycles of
+ * the pattern as possible */
+static void send_repeat(struct s1d135xx *p, const uint16_t *pattern,
+			uint8_t len, uint32_t n)
+{
+	uint16_t buf[S1D135XX_REPEAT_MAX];
+	uint16_t chunk;
+	uint16_t i;
+
+	assert(len && (len <= S1D135XX_REPEAT_MAX));
+
+	PL_TRACE(PL_TRACE_DATA, 0, n * 2);
+
+	if (p->interface->write_repeat != NULL) {
+		p->interface->write_repeat(pattern, len, n);
+		return;
+	}
+
+	chunk = (S1D135XX_REPEAT_MAX / len) * len;
+
+	for (i = 0; i < chunk; ++i)
+		buf[i] = htobe16(pattern[i % len]);
+
+	while (n) {
+		const uint16_t k = (n < chunk) ? n : chunk;
+
+		p->interface->write((uint8_t *)buf, k * 2);
+		n -= k;
+	}
+}
+
 static void set_cs(struct s1d135xx *p, int state)
 {
-	pl_gpio_set(p->gpio, p->data->cs0, state);
+	transfer_wait(p);
+
+	if (!p->flags.gpio_handles_done)
+		init_gpio_handles(p);
+
+	pl_gpio_fast_set(&p->cs0_h, state);
 }
 
 static void set_hdc(struct s1d135xx *p, int state)
 {
-	const unsigned hdc = p->data->hdc;
+	transfer_wait(p);
 
-	if (hdc != PL_GPIO_NONE)
-		pl_gpio_set(p->gpio, hdc, state);
+	if (!p->flags.gpio_handles_done)
+		init_gpio_handles(p);
+
+	pl_gpio_fast_set(&p->hdc_h, state);
 }
 
 int set_init_rot_mode(struct s1d135xx *p)
@@ -949,6 +1803,6 @@ int set_init_rot_mode(struct s1d135xx *p)
 	send_cmd(p, S1D135XX_CMD_INIT_ROT_MODE);
 	send_param(p, 0x0400);
 	set_cs(p, 1);
-	mdelay(100);
-	return s1d135xx_wait_idle(p);
+
+	return wait_ready_ms(p, S1D135XX_INIT_TIMEOUT_MS, 0, 0);
 }
@@ -28,6 +28,7 @@
 #define INCLUDE_EPSON_S1D135XX_H
 
 #include <pl/epdc.h>
+#include <pl/gpio.h>
 #include <pl/interface.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -38,6 +39,8 @@ struct pl_wflib;
 /* Set to 1 to enable verbose temperature log messages */
 #define VERBOSE_TEMPERATURE                  0
 #define S1D135XX_TEMP_MASK                   0x00FF
+#define S1D135XX_SHADOW_MAX                  8
+#define S1D135XX_REPEAT_MAX                  32 /* longest word cycle */
 
 enum s1d135xx_reg {
 	S1D135XX_REG_REV_CODE              = 0x0002,
@@ -71,6 +74,39 @@ struct s1d135xx_data {
 	unsigned vcc_en;
 };
 
+/* Controller state which may be lost in low power states */
+enum s1d135xx_state {
+	S1D135XX_STATE_INIT_CODE = (1 << 0),
+	S1D135XX_STATE_OVERRIDES = (1 << 1),
+	S1D135XX_STATE_WFLIB     = (1 << 2),
+	S1D135XX_STATE_IMAGE     = (1 << 3),
+	S1D135XX_STATE_ALL       = 0x0F,
+};
+
+/* Off-screen image cache: full frames kept in spare controller memory and
+ * shown by pointing the image buffer at them, see s1d135xx_cache_init().
+ * Images are identified by a key (the first cluster of the file) and their
+ * size, so a file rewritten in place with the same size is not detected and
+ * the stale image is shown. */
+struct s1d135xx_cache_slot {
+	uint32_t key;
+	uint32_t size;
+	uint16_t used;                  /* cache clock value of the last use */
+	uint8_t valid;
+};
+
+struct s1d135xx_cache {
+	uint32_t img_buf;               /* original image buffer, slot 0 */
+	uint32_t base;                  /* address of slot 1 */
+	uint32_t slot_size;
+	uint16_t img_buf_reg;           /* image buffer start address register */
+	uint16_t clock;
+	uint8_t n_slots;
+	uint8_t current;                /* slot used as the image buffer */
+	uint8_t loading;                /* set while loading into a slot */
+	struct s1d135xx_cache_slot *slots;
+};
+
 struct s1d135xx {
 	const struct s1d135xx_data *data;
 	struct pl_gpio *gpio;
@@ -80,11 +116,29 @@ struct s1d135xx {
 	uint16_t hrdy_mask;
 	uint16_t hrdy_result;
 	int measured_temp;
+	int wf_temp;            /* temperature when the waveforms were loaded */
 	unsigned xres;
 	unsigned yres;
 	struct {
 		uint8_t needs_update:1;
+		uint8_t early_init_done:1;
+		uint8_t wf_update_pending:1;
+		uint8_t gpio_handles_done:1;
+		uint8_t resuming:1;
 	} flags;
+	/* resolved on first access to the controller */
+	struct pl_gpio_handle cs0_h;
+	struct pl_gpio_handle hdc_h;
+	struct pl_gpio_handle hrdy_h;
+	struct s1d135xx_cache *cache;   /* optional */
+	uint8_t state;                  /* valid S1D135XX_STATE_ bits */
+	uint8_t sleep_state;            /* bits kept in PL_EPDC_SLEEP */
+	/* register shadow, only for registers which the controller never
+	 * changes by itself, see s1d135xx_set_shadow() */
+	const uint16_t *shadow_regs;
+	uint8_t n_shadow_regs;
+	uint8_t shadow_valid;           /* one bit per shadow register */
+	uint16_t shadow[S1D135XX_SHADOW_MAX];
 };
 
 extern void s1d135xx_hard_reset(struct pl_gpio *gpio,
@@ -94,26 +148,54 @@ extern int s1d135xx_check_prod_code(struct s1d135xx *p, uint16_t code);
 extern int s1d135xx_load_init_code(struct s1d135xx *p);
 extern int s1d135xx_load_wflib(struct s1d135xx *p, struct pl_wflib *wflib,
 			       uint32_t addr);
+extern int s1d135xx_load_wflib_part(struct s1d135xx *p,
+				    struct pl_wflib *wflib, uint32_t addr,
+				    uint32_t offset, uint32_t n);
 extern int s1d135xx_init_gate_drv(struct s1d135xx *p);
 extern int s1d135xx_wait_dspe_trig(struct s1d135xx *p);
 extern int s1d135xx_clear_init(struct s1d135xx *p);
 extern int s1d135xx_fill(struct s1d135xx *p, uint16_t mode, unsigned bpp,
 			 const struct pl_area *a, uint8_t grey);
+extern int s1d135xx_fill_areas(struct s1d135xx *p, uint16_t mode,
+			       unsigned bpp, const struct pl_area *areas,
+			       const uint8_t *greys, unsigned n);
 extern int s1d135xx_pattern_check(struct s1d135xx *p, uint16_t height,
 			uint16_t width, uint16_t checker_size, uint16_t mode);
 extern int s1d135xx_load_image(struct s1d135xx *p, const char *path,
 			       uint16_t mode, unsigned bpp,
 			       struct pl_area *area, int left, int top);
+extern int s1d135xx_load_image_file(struct s1d135xx *p, FIL *img_file,
+				    uint16_t mode, unsigned bpp,
+				    struct pl_area *area, int left, int top);
+extern int s1d135xx_cache_init(struct s1d135xx *p,
+			       struct s1d135xx_cache *cache,
+			       struct s1d135xx_cache_slot *slots,
+			       unsigned n_slots, uint16_t img_buf_reg,
+			       uint32_t base, uint32_t slot_size);
+extern int s1d135xx_load_image_cached(struct s1d135xx *p, FIL *img_file,
+				      uint32_t key, uint16_t mode,
+				      unsigned bpp);
+extern int s1d135xx_load_area_begin(struct s1d135xx *p, uint16_t mode,
+				    const struct pl_area *area);
+extern void s1d135xx_load_area_data(struct s1d135xx *p, const uint8_t *data,
+				    size_t n);
+extern int s1d135xx_load_area_end(struct s1d135xx *p);
 extern int s1d135xx_update(struct s1d135xx *p, int wfid,
 				enum pl_update_mode mode,
 				const struct pl_area *area);
 extern int s1d135xx_wait_update_end(struct s1d135xx *p);
 extern int s1d135xx_wait_idle(struct s1d135xx *p);
+extern void s1d135xx_power_on(struct s1d135xx *p);
 extern int s1d135xx_set_power_state(struct s1d135xx *p,
 				    enum pl_epdc_power_state state);
+extern uint8_t s1d135xx_kept_state(struct s1d135xx *p,
+				   enum pl_epdc_power_state state);
+extern void s1d135xx_lose_state(struct s1d135xx *p, uint8_t kept);
 extern int s1d135xx_set_epd_power(struct s1d135xx *p, int on);
 extern void s1d135xx_cmd(struct s1d135xx *p, uint16_t cmd,
 			 const uint16_t *params, size_t n);
+extern void s1d135xx_set_shadow(struct s1d135xx *p, const uint16_t *regs,
+				unsigned n);
 extern uint16_t s1d135xx_read_reg(struct s1d135xx *p, uint16_t reg);
 extern void s1d135xx_write_reg(struct s1d135xx *p, uint16_t reg, uint16_t val);
 extern int s1d135xx_load_register_overrides(struct s1d135xx *p);
@@ -0,0 +1,125 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * font-5x9.c -- Built-in 5x9 bitmap font
+ */
+
+#include "font.h"
+
+/* ASCII characters 32 to 126 in 6x9 cells, with 7 lines above the baseline
+ * and 2 for the descenders.  All the glyphs have one blank column on the
+ * right so the text needs no extra spacing.  Use "font-convert -p 5x9" in
+ * tools/convert to see them. */
+static const uint8_t font_5x9_strike[] = {
+	/* line 0 */
+	0x00, 0x85, 0x14, 0x23, 0x06, 0x08, 0x11, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x70, 0x87, 0x3E, 0x13,
+	0xE3, 0x3E, 0x71, 0xC0, 0x00, 0x10, 0x04, 0x1C,
+	0x71, 0xCF, 0x1C, 0xE3, 0xEF, 0x9C, 0x89, 0xC3,
+	0xA2, 0x82, 0x28, 0x9C, 0xF1, 0xCF, 0x1E, 0xFA,
+	0x28, 0xA2, 0x8A, 0x2F, 0x9C, 0x01, 0xC2, 0x00,
+	0x40, 0x08, 0x00, 0x08, 0x03, 0x00, 0x80, 0x81,
+	0x20, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40,
+	0x00, 0x00, 0x00, 0x00, 0x04, 0x21, 0x00, 0x00,
+	/* line 1 */
+	0x00, 0x85, 0x14, 0x7B, 0x29, 0x08, 0x20, 0x82,
+	0x08, 0x00, 0x00, 0x02, 0x89, 0x88, 0x84, 0x32,
+	0x04, 0x02, 0x8A, 0x26, 0x18, 0x20, 0x02, 0x22,
+	0x8A, 0x28, 0xA2, 0x92, 0x08, 0x22, 0x88, 0x81,
+	0x24, 0x83, 0x68, 0xA2, 0x8A, 0x28, 0xA0, 0x22,
+	0x28, 0xA2, 0x8A, 0x20, 0x90, 0x80, 0x45, 0x00,
+	0x20, 0x08, 0x00, 0x08, 0x04, 0x80, 0x80, 0x00,
+	0x20, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40,
+	0x00, 0x00, 0x00, 0x00, 0x08, 0x20, 0x80, 0x00,
+	/* line 2 */
+	0x00, 0x85, 0x3E, 0xA0, 0x4A, 0x10, 0x40, 0x4A,
+	0x88, 0x00, 0x00, 0x04, 0x98, 0x80, 0x88, 0x53,
+	0xC8, 0x04, 0x8A, 0x26, 0x18, 0x43, 0xE1, 0x02,
+	0x0A, 0x28, 0xA0, 0x8A, 0x08, 0x20, 0x88, 0x81,
+	0x28, 0x82, 0xAC, 0xA2, 0x8A, 0x28, 0xA0, 0x22,
+	0x28, 0xA2, 0x51, 0x41, 0x10, 0x40, 0x48, 0x80,
+	0x11, 0xCB, 0x1C, 0x69, 0xC4, 0x1E, 0xB1, 0x83,
+	0x24, 0x23, 0x4B, 0x1C, 0xF1, 0xEB, 0x1E, 0xE2,
+	0x28, 0xA2, 0x8A, 0x2F, 0x88, 0x20, 0x84, 0x00,
+	/* line 3 */
+	0x00, 0x80, 0x14, 0x70, 0x84, 0x00, 0x40, 0x47,
+	0x3E, 0x03, 0xE0, 0x08, 0xA8, 0x81, 0x04, 0x90,
+	0x2F, 0x08, 0x71, 0xE0, 0x00, 0x80, 0x00, 0x84,
+	0x6B, 0xEF, 0x20, 0x8B, 0xCF, 0x2E, 0xF8, 0x81,
+	0x30, 0x82, 0xAA, 0xA2, 0xF2, 0x2F, 0x1C, 0x22,
+	0x28, 0xAA, 0x20, 0x82, 0x10, 0x20, 0x40, 0x00,
+	0x00, 0x2C, 0xA0, 0x9A, 0x2E, 0x22, 0xC8, 0x81,
+	0x28, 0x22, 0xAC, 0xA2, 0x8A, 0x2C, 0xA0, 0x42,
+	0x28, 0xA2, 0x52, 0x21, 0x10, 0x20, 0x4A, 0x80,
+	/* line 4 */
+	0x00, 0x80, 0x3E, 0x29, 0x0A, 0x80, 0x40, 0x4A,
+	0x88, 0x00, 0x00, 0x10, 0xC8, 0x82, 0x02, 0xF8,
+	0x28, 0x90, 0x88, 0x26, 0x18, 0x43, 0xE1, 0x08,
+	0xAA, 0x28, 0xA0, 0x8A, 0x08, 0x22, 0x88, 0x81,
+	0x28, 0x82, 0x29, 0xA2, 0x82, 0xAA, 0x02, 0x22,
+	0x28, 0xAA, 0x50, 0x84, 0x10, 0x10, 0x40, 0x00,
+	0x01, 0xE8, 0xA0, 0x8B, 0xE4, 0x22, 0x88, 0x81,
+	0x30, 0x22, 0xA8, 0xA2, 0x8A, 0x28, 0x1C, 0x42,
+	0x28, 0xAA, 0x22, 0x22, 0x08, 0x20, 0x81, 0x00,
+	/* line 5 */
+	0x00, 0x00, 0x14, 0xF2, 0x69, 0x00, 0x20, 0x82,
+	0x08, 0x60, 0x06, 0x20, 0x88, 0x84, 0x22, 0x12,
+	0x28, 0x90, 0x88, 0x46, 0x18, 0x20, 0x02, 0x00,
+	0xAA, 0x28, 0xA2, 0x92, 0x08, 0x22, 0x88, 0x89,
+	0x24, 0x82, 0x28, 0xA2, 0x82, 0x49, 0x02, 0x22,
+	0x25, 0x2A, 0x88, 0x88, 0x10, 0x08, 0x40, 0x00,
+	0x02, 0x28, 0xA2, 0x8A, 0x04, 0x22, 0x88, 0x81,
+	0x28, 0x22, 0x28, 0xA2, 0x8A, 0x28, 0x02, 0x4A,
+	0x65, 0x2A, 0x52, 0x24, 0x08, 0x20, 0x80, 0x00,
+	/* line 6 */
+	0x00, 0x80, 0x14, 0x20, 0x66, 0x80, 0x11, 0x00,
+	0x00, 0x60, 0x06, 0x00, 0x71, 0xCF, 0x9C, 0x11,
+	0xC7, 0x10, 0x71, 0x80, 0x08, 0x10, 0x04, 0x08,
+	0x72, 0x2F, 0x1C, 0xE3, 0xE8, 0x1E, 0x89, 0xC6,
+	0x22, 0xFA, 0x28, 0x9C, 0x81, 0xA8, 0xBC, 0x21,
+	0xC2, 0x14, 0x88, 0x8F, 0x9C, 0x01, 0xC0, 0x00,
+	0x01, 0xEF, 0x1C, 0x79, 0xC4, 0x1E, 0x89, 0xC1,
+	0x24, 0x72, 0x28, 0x9C, 0xF1, 0xE8, 0x3C, 0x31,
+	0xA2, 0x14, 0x89, 0xEF, 0x84, 0x21, 0x00, 0x00,
+	/* line 7 */
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3E,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x09,
+	0x00, 0x00, 0x00, 0x00, 0x80, 0x20, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00,
+	/* line 8 */
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x00, 0x06,
+	0x00, 0x00, 0x00, 0x00, 0x80, 0x20, 0x00, 0x00,
+	0x00, 0x00, 0x01, 0xC0, 0x00, 0x00, 0x00, 0x00,
+};
+
+const struct font font_5x9 = {
+	1, 9, 7, 32, 95, 6, FONT_ROW_SIZE(95 * 6, 1), NULL, font_5x9_strike,
+	NULL, 0
+};
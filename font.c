@@ -0,0 +1,267 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * font.c -- Bitmap fonts and text rendering
+ */
+
+#include "font.h"
+#include "crc16.h"
+#include <stddef.h>
+#include <string.h>
+
+#define LOG_TAG "font"
+#include "utils.h"
+
+static uint16_t glyph(const struct font *font, uint8_t c, uint16_t *x);
+static uint16_t glyph_at(const struct font *font, uint8_t c, uint16_t *x);
+static uint8_t pixel(const struct font *font, const uint8_t *row,
+		     uint16_t x);
+static int read_row(struct font_text *t, uint16_t y, const uint8_t **row);
+
+int font_open(struct font *font, FIL *f)
+{
+	struct font_header hdr;
+	uint16_t *offsets;
+	uint32_t row_size;
+	size_t size;
+	unsigned i;
+	UINT count;
+
+	if (f_read(f, &hdr, sizeof(hdr), &count) != FR_OK)
+		return -1;
+
+	if ((count != sizeof(hdr)) ||
+	    memcmp(hdr.magic, FONT_MAGIC, sizeof(hdr.magic))) {
+		LOG("Not a font file");
+		return -1;
+	}
+
+	if (hdr.version != FONT_VERSION) {
+		LOG("Unsupported version: %d", hdr.version);
+		return -1;
+	}
+
+	if (crc16_run(crc16_init, (const uint8_t *)&hdr,
+		      offsetof(struct font_header, header_crc))
+	    != hdr.header_crc) {
+		LOG("Header CRC error");
+		return -1;
+	}
+
+	row_size = FONT_ROW_SIZE(hdr.strike_width, hdr.bpp);
+
+	if (((hdr.bpp != 1) && (hdr.bpp != 4)) || !hdr.height ||
+	    (hdr.baseline > hdr.height) || !hdr.count ||
+	    ((hdr.first + hdr.count) > 256) ||
+	    ((f->fsize - f->fptr) < ((hdr.count + 1) * sizeof(uint16_t) +
+				     (row_size * hdr.height)))) {
+		LOG("Invalid header");
+		return -1;
+	}
+
+	size = (hdr.count + 1) * sizeof(uint16_t);
+	offsets = malloc(size);
+
+	if (offsets == NULL) {
+		LOG("Not enough memory");
+		return -1;
+	}
+
+	if ((f_read(f, offsets, size, &count) != FR_OK) || (count != size))
+		goto err_free;
+
+	for (i = 0; i < hdr.count; ++i)
+		if (offsets[i] > offsets[i + 1])
+			break;
+
+	if ((i != hdr.count) || (offsets[hdr.count] > hdr.strike_width)) {
+		LOG("Invalid offsets table");
+		goto err_free;
+	}
+
+	font->bpp = hdr.bpp;
+	font->height = hdr.height;
+	font->baseline = hdr.baseline;
+	font->first = hdr.first;
+	font->count = hdr.count;
+	font->width = 0;
+	font->row_size = row_size;
+	font->offsets = offsets;
+	font->strike = NULL;
+	font->f = f;
+	font->data_offset = f->fptr;
+
+	return 0;
+
+err_free:
+	free(offsets);
+
+	return -1;
+}
+
+void font_close(struct font *font)
+{
+	if (font->f != NULL) {
+		free((void *)font->offsets);
+		font->offsets = NULL;
+		font->f = NULL;
+	}
+}
+
+uint16_t font_text_width(const struct font *font, const char *text)
+{
+	uint16_t width = 0;
+	uint16_t x;
+
+	while (*text)
+		width += glyph(font, *text++, &x);
+
+	return width;
+}
+
+int font_text_init(struct font_text *t, uint8_t *buffer, size_t size)
+{
+	unsigned i;
+
+	if ((t->font == NULL) || (t->text == NULL) || !t->width ||
+	    !t->scale)
+		return -1;
+
+	if ((t->font->strike == NULL) &&
+	    ((buffer == NULL) || (size < t->font->row_size)))
+		return -1;
+
+	/* blend the text with the background for each 4-bit pixel value and
+	 * round to one of the 16 grey levels */
+	for (i = 0; i < 16; ++i) {
+		const unsigned v = ((t->bg * (15 - i)) + (t->fg * i) + 7) / 15;
+		const uint8_t level = ((v * 15) + 127) / 255;
+
+		t->levels[i] = (level << 4) | level;
+	}
+
+	t->row = buffer;
+	t->row_y = -1;
+
+	return 0;
+}
+
+int font_text_line(struct font_text *t, uint16_t y, uint8_t *line)
+{
+	const struct font *font = t->font;
+	const uint8_t *row;
+	const char *c;
+	uint16_t x = 0;
+
+	y /= t->scale;
+
+	if (y >= font->height) {
+		memset(line, t->levels[0], t->width);
+		return 0;
+	}
+
+	if (read_row(t, y, &row))
+		return -1;
+
+	for (c = t->text; *c && (x < t->width); ++c) {
+		uint16_t gx;
+		uint16_t gw;
+
+		for (gw = glyph(font, *c, &gx); gw && (x < t->width); --gw) {
+			const uint8_t level = t->levels[pixel(font, row, gx++)];
+			uint8_t s;
+
+			for (s = t->scale; s && (x < t->width); --s)
+				line[x++] = level;
+		}
+	}
+
+	if (x < t->width)
+		memset(&line[x], t->levels[0], (t->width - x));
+
+	return 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * static functions
+ */
+
+/* Get the offset and width of a glyph, or the '?' glyph if the font doesn't
+ * have it */
+static uint16_t glyph(const struct font *font, uint8_t c, uint16_t *x)
+{
+	const uint16_t width = glyph_at(font, c, x);
+
+	return width ? width : glyph_at(font, '?', x);
+}
+
+static uint16_t glyph_at(const struct font *font, uint8_t c, uint16_t *x)
+{
+	const unsigned i = c - font->first;
+
+	if ((c < font->first) || (i >= font->count))
+		return 0;
+
+	if (font->width) {
+		*x = i * font->width;
+		return font->width;
+	}
+
+	*x = font->offsets[i];
+
+	return font->offsets[i + 1] - font->offsets[i];
+}
+
+/* 4-bit value of pixel x in a strike line, 1-bit pixels are either 0 or 15 */
+static uint8_t pixel(const struct font *font, const uint8_t *row,
+		     uint16_t x)
+{
+	if (font->bpp == 1)
+		return (row[x >> 3] & (0x80 >> (x & 7))) ? 15 : 0;
+
+	return (x & 1) ? (row[x >> 1] & 0xF) : (row[x >> 1] >> 4);
+}
+
+static int read_row(struct font_text *t, uint16_t y, const uint8_t **row)
+{
+	const struct font *font = t->font;
+	UINT count;
+
+	if (font->strike != NULL) {
+		*row = &font->strike[(uint32_t)y * font->row_size];
+		return 0;
+	}
+
+	if (t->row_y != y) {
+		if (f_lseek(font->f, (font->data_offset +
+				      ((uint32_t)y * font->row_size)))
+		    != FR_OK)
+			return -1;
+
+		if ((f_read(font->f, t->row, font->row_size, &count) != FR_OK)
+		    || (count != font->row_size))
+			return -1;
+
+		t->row_y = y;
+	}
+
+	*row = t->row;
+
+	return 0;
+}
@@ -0,0 +1,127 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * font.h -- Bitmap fonts and text rendering
+ */
+
+#ifndef INCLUDE_FONT_H
+#define INCLUDE_FONT_H 1
+
+#include <FatFs/ff.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+   @file font.h
+
+   Bitmap fonts with 1-bit pixels, or 4-bit pixels for anti-aliased fonts,
+   used to render text one line at a time so it can be sent to the EPDC
+   without any frame buffer or image file.
+
+   All the glyphs of a font are stored side by side in a single bitmap
+   called the strike, with a table of the horizontal offset of each glyph.
+   Each line of text needs one line of the strike, so fonts can be read from
+   the SD card one strike line at a time as well as used directly from
+   flash.  The pixels are packed with the first one in the most significant
+   bits, and each strike line starts on a byte boundary.
+
+   Font files start with a font_header, followed by a table of count + 1
+   16-bit glyph offsets and then the strike lines.  All the header fields are
+   little-endian.  Font files are created by the tools/convert/font-convert
+   host tool.
+*/
+
+#define FONT_MAGIC "PLFN"
+#define FONT_VERSION 1
+
+struct __attribute__((__packed__)) font_header {
+	char magic[4];          /* FONT_MAGIC */
+	uint8_t version;        /* FONT_VERSION */
+	uint8_t bpp;            /* bits per pixel: 1 or 4 */
+	uint8_t height;         /* number of lines */
+	uint8_t baseline;       /* number of lines above the baseline */
+	uint8_t first;          /* code of the first character */
+	uint8_t count;          /* number of characters */
+	uint16_t strike_width;  /* width of the strike in pixels */
+	uint16_t header_crc;    /* CRC16 of all the fields above */
+};
+
+/** Number of bytes in each line of the strike */
+#define FONT_ROW_SIZE(_strike_width, _bpp) \
+	((((uint32_t)(_strike_width) * (_bpp)) + 7) / 8)
+
+struct font {
+	uint8_t bpp;            /**< bits per pixel: 1 or 4 */
+	uint8_t height;         /**< number of lines */
+	uint8_t baseline;       /**< number of lines above the baseline */
+	uint8_t first;          /**< code of the first character */
+	uint8_t count;          /**< number of characters */
+	uint8_t width;          /**< width of all the glyphs, or 0 to use the
+				     offsets table */
+	uint16_t row_size;      /**< number of bytes in each strike line */
+	const uint16_t *offsets; /**< count + 1 glyph offsets in the strike */
+	const uint8_t *strike;  /**< strike data, or NULL to read it from f */
+	FIL *f;                 /**< font file when strike is NULL */
+	uint32_t data_offset;   /**< position of the strike in f */
+};
+
+/** Built-in 5x9 font with ASCII characters 32 to 126 */
+extern const struct font font_5x9;
+
+/** Read the header and offsets table of a font file, the file needs to stay
+ * open until font_close is called.  Returns -1 if the file is not a valid
+ * font, 0 otherwise. */
+extern int font_open(struct font *font, FIL *f);
+
+/** Free the resources allocated by font_open */
+extern void font_close(struct font *font);
+
+/** Width of a string in pixels, without scaling */
+extern uint16_t font_text_width(const struct font *font, const char *text);
+
+/** Text rendered one line at a time in 8-bit pixels */
+struct font_text {
+	const struct font *font;
+	const char *text;
+	uint16_t width;         /**< width of the area in pixels */
+	uint8_t scale;          /**< integer scaling factor, 1 or more */
+	uint8_t fg;             /**< 8-bit grey level of the text */
+	uint8_t bg;             /**< 8-bit grey level of the background */
+	/* private */
+	uint8_t levels[16];
+	uint8_t *row;
+	int row_y;
+};
+
+/** Initialise the text once its public fields have been set, with a buffer
+ * to read the strike lines of font files.  No buffer is needed for fonts in
+ * memory.
+    @return -1 if the settings are invalid or the buffer is too small for a
+    strike line, 0 otherwise
+*/
+extern int font_text_init(struct font_text *t, uint8_t *buffer, size_t size);
+
+/** Render line y of the text into line, which needs to hold width bytes.
+ * The text is clipped to the width of the area and the lines below the font
+ * are filled with the background level.
+    @return -1 if the strike line could not be read, 0 otherwise
+*/
+extern int font_text_line(struct font_text *t, uint16_t y, uint8_t *line);
+
+#endif /* INCLUDE_FONT_H */
@@ -0,0 +1,123 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * i2c-regcache.c -- Shadow cache for 8-bit I2C device registers
+ */
+
+#include <pl/i2c.h>
+#include "i2c-regcache.h"
+#include "assert.h"
+
+#define LOG_TAG "i2c-regcache"
+#include "utils.h"
+
+static int is_cached(const struct i2c_regcache *c, uint8_t reg)
+{
+	const uint32_t bit = I2C_REGCACHE_BIT(reg);
+
+	return (c->valid & bit) && !(c->volatile_regs & bit);
+}
+
+void i2c_regcache_init(struct i2c_regcache *c, struct pl_i2c *i2c,
+		       uint8_t i2c_addr, uint8_t n_regs, uint32_t volatile_regs)
+{
+	assert(c != NULL);
+	assert(n_regs <= I2C_REGCACHE_MAX_REGS);
+
+	c->i2c = i2c;
+	c->i2c_addr = i2c_addr;
+	c->n_regs = n_regs;
+	c->volatile_regs = volatile_regs;
+	c->valid = 0;
+	c->written = 0;
+}
+
+void i2c_regcache_invalidate(struct i2c_regcache *c)
+{
+	c->valid = 0;
+}
+
+int i2c_regcache_read(struct i2c_regcache *c, uint8_t reg, uint8_t *data)
+{
+	assert(reg < c->n_regs);
+
+	if (is_cached(c, reg)) {
+		*data = c->values[reg];
+		return 0;
+	}
+
+	if (pl_i2c_reg_read_8(c->i2c, c->i2c_addr, reg, data))
+		return -1;
+
+	c->values[reg] = *data;
+	c->valid |= I2C_REGCACHE_BIT(reg);
+
+	return 0;
+}
+
+int i2c_regcache_write(struct i2c_regcache *c, uint8_t reg, uint8_t data)
+{
+	assert(reg < c->n_regs);
+
+	if (is_cached(c, reg) && (c->values[reg] == data))
+		return 0;
+
+	if (pl_i2c_reg_write_8(c->i2c, c->i2c_addr, reg, data)) {
+		/* the register may or may not have been written */
+		c->valid &= ~I2C_REGCACHE_BIT(reg);
+		return -1;
+	}
+
+	c->values[reg] = data;
+	c->valid |= I2C_REGCACHE_BIT(reg);
+
+	/* triggers and other volatile registers are not written again */
+	if (!(c->volatile_regs & I2C_REGCACHE_BIT(reg)))
+		c->written |= I2C_REGCACHE_BIT(reg);
+
+	return 0;
+}
+
+int i2c_regcache_restore(struct i2c_regcache *c)
+{
+	uint8_t reg;
+
+	for (reg = 0; reg < c->n_regs; ++reg) {
+		const uint32_t bit = I2C_REGCACHE_BIT(reg);
+
+		if ((c->written & bit) && !(c->valid & bit) &&
+		    i2c_regcache_write(c, reg, c->values[reg]))
+			return -1;
+	}
+
+	return 0;
+}
+
+int i2c_regcache_update(struct i2c_regcache *c, uint8_t reg, uint8_t mask,
+			uint8_t data)
+{
+	uint8_t value;
+
+	if (i2c_regcache_read(c, reg, &value))
+		return -1;
+
+	value = (value & ~mask) | (data & mask);
+
+	return i2c_regcache_write(c, reg, value);
+}
@@ -0,0 +1,70 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * i2c-regcache.h -- Shadow cache for 8-bit I2C device registers
+ */
+
+#ifndef INCLUDE_I2C_REGCACHE_H
+#define INCLUDE_I2C_REGCACHE_H 1
+
+#include <stdint.h>
+
+struct pl_i2c;
+
+/** Maximum number of registers in a cache, starting from address 0 */
+#define I2C_REGCACHE_MAX_REGS 32
+
+/** Bit mask for a register in the valid and volatile maps */
+#define I2C_REGCACHE_BIT(_reg) (1UL << (_reg))
+
+/**
+   Write-through cache of the registers of an I2C device.
+
+   Reading a cached register does not cause any I2C transfer, and writing a
+   value which is already in the cache is skipped.  Volatile registers (status,
+   measurements, triggers...) are never cached.  The cache must be invalidated
+   whenever the device may have lost its register values, for example after a
+   power cycle.  The values last written to the other registers are kept, so
+   i2c_regcache_restore() can write them again once the device is back.
+*/
+struct i2c_regcache {
+	struct pl_i2c *i2c;
+	uint8_t i2c_addr;
+	uint8_t n_regs;
+	uint32_t volatile_regs;      /* bit mask of volatile registers */
+	uint32_t valid;              /* bit mask of cached registers */
+	uint32_t written;            /* bit mask of registers to restore */
+	uint8_t values[I2C_REGCACHE_MAX_REGS];
+};
+
+extern void i2c_regcache_init(struct i2c_regcache *c, struct pl_i2c *i2c,
+			      uint8_t i2c_addr, uint8_t n_regs,
+			      uint32_t volatile_regs);
+extern void i2c_regcache_invalidate(struct i2c_regcache *c);
+/* Write the non-volatile registers again after invalidating the cache */
+extern int i2c_regcache_restore(struct i2c_regcache *c);
+extern int i2c_regcache_read(struct i2c_regcache *c, uint8_t reg,
+			     uint8_t *data);
+extern int i2c_regcache_write(struct i2c_regcache *c, uint8_t reg,
+			      uint8_t data);
+/* Read-modify-write, only the bits in mask are changed */
+extern int i2c_regcache_update(struct i2c_regcache *c, uint8_t reg,
+			       uint8_t mask, uint8_t data);
+
+#endif /* INCLUDE_I2C_REGCACHE_H */
@@ -29,6 +29,7 @@
 #include <pl/platform.h>
 #include <pl/gpio.h>
 #include <pl/interface.h>
+#include <pl/serial.h>
 #include <pl/hwinfo.h>
 #include <pl/wflib.h>
 #include <app/app.h>
@@ -78,12 +79,22 @@
 /* Ruddock shutdown (power control) */
 #define RUDDOCK_SHUTDOWN MSP430_GPIO(5,1)
 
+/* Serial port baud rate, faster when streaming images */
+#if CONFIG_DEMO_STREAM
+#define UART_BAUD_RATE BR_460800
+#else
+#define UART_BAUD_RATE BR_115200
+#endif
+
 /* Version of pl-mcu-epd */
 static const char VERSION[] = "v011";
 
 /* Platform instance, to be passed to other modules */
 static struct pl_platform g_plat;
 
+/* Serial port used to receive images and commands */
+static struct pl_serial g_serial;
+
 /* --- System GPIOs --- */
 
 static const struct pl_gpio_config g_gpios[] = {
@@ -262,6 +273,51 @@ static const char* g_wflib_fatfs_path(void){
 }
 
 static FIL g_wflib_fatfs_file;
+
+/* --- boot timing --- */
+
+#if CONFIG_BOOT_TIMING
+#define BOOT_MAX_STAGES 12
+
+struct boot_stage {
+	const char *name;
+	uint32_t ticks;
+};
+
+static struct boot_stage g_boot_stages[BOOT_MAX_STAGES];
+static unsigned g_boot_n_stages;
+
+/* Record the end of a boot stage, timed from ticks_init() in main() */
+static void boot_stage(const char *name)
+{
+	if (g_boot_n_stages == BOOT_MAX_STAGES)
+		return;
+
+	g_boot_stages[g_boot_n_stages].name = name;
+	g_boot_stages[g_boot_n_stages].ticks = ticks_now();
+	g_boot_n_stages++;
+}
+
+static void boot_report(void)
+{
+	uint32_t last = 0;
+	unsigned i;
+
+	LOG("Boot timing:");
+
+	for (i = 0; i < g_boot_n_stages; ++i) {
+		const struct boot_stage *s = &g_boot_stages[i];
+
+		LOG("  %-12s %6lu us", s->name, (unsigned long)(s->ticks - last));
+		last = s->ticks;
+	}
+
+	LOG("  %-12s %6lu us", "total", (unsigned long)last);
+}
+#else
+#define boot_stage(_name) do {} while (0)
+#define boot_report() do {} while (0)
+#endif
 struct pl_interface epson_spi;
 struct pl_interface epson_parallel;
 
@@ -303,11 +359,15 @@ int main_init(void)
 		abort_msg("System GPIO init failed", ABORT_MSP430_GPIO_INIT);
 
 	/* initialise MSP430 UART */
-	if (msp430_uart_init(&g_plat.gpio, BR_115200, 'N', 8, 1))
+	if (msp430_uart_init(&g_plat.gpio, UART_BAUD_RATE, 'N', 8, 1))
 		abort_msg("UART init failed", ABORT_MSP430_COMMS_INIT);
 
+	msp430_uart_serial_init(&g_serial);
+	g_plat.serial = &g_serial;
+
 	LOG("------------------------");
 	LOG("Starting pl-mcu-epd %s", VERSION);
+	boot_stage("gpio-uart");
 
 	/* initialize HV-PMIC GPIOs */
 	if (pl_gpio_config_list(&g_plat.gpio, g_hvpmic_gpios,
@@ -319,7 +379,8 @@ int main_init(void)
 				ARRAY_SIZE(g_epson_gpios)))
 		abort_msg("Epson GPIO init failed", ABORT_MSP430_GPIO_INIT);
 
-	/* hard-reset Epson controller to avoid errors during soft reset */
+	/* hard-reset Epson controller to avoid errors during soft reset, it
+	 * then comes out of reset while the next steps are being run */
 	s1d135xx_hard_reset(&g_plat.gpio, &g_s1d135xx_data);
 
 	/* initialise Epson parallel interface GPIOs */
@@ -344,18 +405,21 @@ int main_init(void)
 			abort_msg("SPI init failed", ABORT_MSP430_COMMS_INIT);
 		s1d135xx.interface = &epson_spi;
 	}
+	boot_stage("interfaces");
 
 	/* initialise SD-card */
 	SDCard_plat = &g_plat;
 	f_chdrive(0);
 	if (f_mount(0, &sdcard) != FR_OK)
 		abort_msg("SD card init failed", ABORT_MSP430_COMMS_INIT);
+	boot_stage("sd-mount");
 
 	/* read configuration */
 	if(read_config("config.txt", &global_config))
 		abort_msg("Read config file failed!",ABORT_CONFIG);
 	s1d135xx.scrambling = global_config.scrambling;
 	s1d135xx.source_offset = global_config.source_offset;
+	boot_stage("config");
 
 	struct pl_hwinfo g_hwinfo_default = init_hw_info_default();
 
@@ -371,10 +435,12 @@ int main_init(void)
 		exit(-1);
 	}
 	pl_hwinfo_log(g_plat.hwinfo);
+	boot_stage("hwinfo");
 
 	/* initialise platform I2C bus */
 	if (probe_i2c(&g_plat, &s1d135xx, &host_i2c, &disp_i2c))
 		abort_msg("Platform I2C init failed", ABORT_I2C_INIT);
+	boot_stage("i2c");
 
 	/* load display information */
 	disp_eeprom.i2c = g_plat.i2c;
@@ -384,10 +450,12 @@ int main_init(void)
 		abort_msg("Failed to load dispinfo", ABORT_DISP_INFO);
 	g_plat.dispinfo = &dispinfo;
 	pl_dispinfo_log(&dispinfo);
+	boot_stage("dispinfo");
 
 	/* initialise EPD HV-PSU and HV-PMIC */
 	if (probe_hvpmic(&g_plat, &vcom_cal, &g_epdpsu_gpio, &pmic_info))
 		abort_msg("HV-PMIC and EPD PSU init failed", ABORT_HVPSU_INIT);
+	boot_stage("hvpmic");
 
 	/* initialise EPDC */
 	if (probe_epdc(&g_plat, &s1d135xx))
@@ -397,6 +465,8 @@ int main_init(void)
 	uint8_t blob[16];
 	s1d13541_read_prom(&s1d135xx, blob);
 	s1d13541_extract_prom_blob(blob);
+	boot_stage("epdc");
+	boot_report();
 
 	/* run the application */
 	if (app_demo(&g_plat))
@@ -413,6 +483,11 @@ void abort_now(const char *abort_msg, enum abort_error error_code)
 	if (abort_msg != NULL)
 		fprintf(stderr, "%s\r\n", abort_msg);
 
+#if CONFIG_UART_PRINTF
+	fflush(stdout);
+	msp430_uart_flush();
+#endif
+
 	/* Force LED off for case where error_code == 0 */
 	g_plat.gpio.set(g_plat.sys_gpio->assert_led, 0);
 
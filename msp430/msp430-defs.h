@@ -38,6 +38,7 @@
 #define	UCxnTXBUF	PREEXPAND(UC, USCI_UNIT, USCI_CHAN, TXBUF)
 #define	UCxnRXBUF	PREEXPAND(UC, USCI_UNIT, USCI_CHAN, RXBUF)
 #define	UCxnSTAT	PREEXPAND(UC, USCI_UNIT, USCI_CHAN, STAT)
+#define	UCxnIV		PREEXPAND(UC, USCI_UNIT, USCI_CHAN, IV)
 
 #define	UCxnI2COA	PREEXPAND(UC, USCI_UNIT, USCI_CHAN, I2COA)
 #define	UCxnI2CSA  	PREEXPAND(UC, USCI_UNIT, USCI_CHAN, I2CSA)
@@ -235,6 +235,30 @@ void msp430_gpio_set(unsigned gpio, int value)
 		*port->out &= ~pinmask;
 }
 
+int msp430_gpio_get_handle(unsigned gpio, struct pl_gpio_handle *h)
+{
+	/* handles for PL_GPIO_NONE point to this with an empty mask */
+	static volatile uint8_t none;
+	const struct io_config *port;
+
+	h->out = h->in = &none;
+	h->mask = 0;
+
+	if (gpio == PL_GPIO_NONE)
+		return 0;
+
+	port = msp430_gpio_get_port(gpio);
+
+	if (port->in == NULL)
+		return -1;
+
+	h->out = port->out;
+	h->in = port->in;
+	h->mask = GPIO_PIN(gpio);
+
+	return 0;
+}
+
 int msp430_gpio_init(struct pl_gpio *gpio)
 {
 	gpio->config = msp430_gpio_config;
@@ -27,6 +27,7 @@
 
 #include <pl/gpio.h>
 #include <pl/i2c.h>
+#include <pl/prof.h>
 #include <msp430.h>
 #include <stdint.h>
 #include "utils.h"
@@ -124,6 +125,7 @@ static int msp430_i2c_write(struct pl_i2c *i2c, uint8_t i2c_addr,
 	int timeout = 0;
 	unsigned int gie = __get_SR_register() & GIE; //Store current GIE state
 
+	PL_PROF_START(PL_PROF_I2C);
 	__disable_interrupt();              	// Make this operation atomic
 
 	if (count == 0)							// no data but may want to stop
@@ -174,6 +176,7 @@ error:
 	}
 
 	__bis_SR_register(gie);             	// Restore original GIE state
+	PL_PROF_STOP(PL_PROF_I2C);
 
 	return result;
 }
@@ -193,6 +196,7 @@ static int msp430_i2c_read(struct pl_i2c *i2c, uint8_t i2c_addr, uint8_t *data,
 	int stop_sent = 0;
 	unsigned int gie = __get_SR_register() & GIE; // store current GIE state
 
+	PL_PROF_START(PL_PROF_I2C);
 	__disable_interrupt();              	// Make this operation atomic
 
 	send_stop = (!(flags & PL_I2C_NO_STOP) && (count == 1));
@@ -247,6 +251,7 @@ error:
 		while(UCxnCTL1 & UCTXSTP);          // Ensure stop condition got sent
 	}
 	__bis_SR_register(gie);             	// Restore original GIE state
+	PL_PROF_STOP(PL_PROF_I2C);
 
 	return result;
 }
@@ -24,6 +24,7 @@
  */
 
 #include <msp430.h>
+#include "config.h"
 #include "msp430-gpio.h"
 #include <stdint.h>
 
@@ -78,17 +79,20 @@ __interrupt void Port_2(void)
 #if 0
 #pragma vector=PORT2_VECTOR
 #pragma vector=TIMER0_A1_VECTOR
+#pragma vector=TIMER0_B1_VECTOR
+#pragma vector=USCI_A1_VECTOR
 #pragma vector=RTC_VECTOR
 #endif
 /* Initialize unused ISR vectors with a trap function */
 #pragma vector=USCI_B3_VECTOR
 #pragma vector=USCI_A3_VECTOR
 #pragma vector=USCI_B1_VECTOR
-#pragma vector=USCI_A1_VECTOR
 #pragma vector=PORT1_VECTOR
 #pragma vector=TIMER1_A1_VECTOR
 #pragma vector=TIMER1_A0_VECTOR
+#if !CONFIG_SPI_DMA /* used in msp430-spi.c */
 #pragma vector=DMA_VECTOR
+#endif
 #pragma vector=USCI_B2_VECTOR
 #pragma vector=USCI_A2_VECTOR
 #pragma vector=TIMER0_A0_VECTOR
@@ -96,7 +100,6 @@ __interrupt void Port_2(void)
 #pragma vector=USCI_B0_VECTOR
 #pragma vector=USCI_A0_VECTOR
 #pragma vector=WDT_VECTOR
-#pragma vector=TIMER0_B1_VECTOR
 #pragma vector=TIMER0_B0_VECTOR
 #pragma vector=UNMI_VECTOR
 #pragma vector=SYSNMI_VECTOR
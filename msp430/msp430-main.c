@@ -77,6 +77,7 @@ static void board_init(void)
 int main(void)
 {
 	board_init();
+	ticks_init();
 	__bis_SR_register(GIE);
 
 	return main_init();
@@ -44,6 +44,65 @@
 
 int msp430_parallel_read_bytes(uint8_t *buff, uint8_t size);
 int msp430_parallel_write_bytes(uint8_t *buff, uint8_t size);
+static int msp430_parallel_read_words(uint16_t *words, uint16_t n);
+static int msp430_parallel_write_words(const uint16_t *words, uint16_t n);
+static int msp430_parallel_write_repeat(const uint16_t *pattern, uint8_t len,
+					uint32_t n);
+
+static struct pl_gpio_handle g_read_strobe;
+static struct pl_gpio_handle g_write_strobe;
+
+/* Cached data bus direction, to only change it when needed */
+enum bus_dir {
+	BUS_DIR_UNKNOWN = 0,
+	BUS_DIR_INPUT,
+	BUS_DIR_OUTPUT,
+};
+static enum bus_dir g_bus_dir;
+
+/* One bus cycle, with the high byte on port 6 and the low byte on port 4 */
+#define WRITE_CYCLE(_hi, _lo) do {			\
+		*strobe &= ~mask;			\
+		P6OUT = (_hi);				\
+		P4OUT = (_lo);				\
+		*strobe |= mask;			\
+		__no_operation();			\
+	} while (0)
+
+/* Same bus cycle with the data already on the ports */
+#define STROBE_CYCLE() do {				\
+		*strobe &= ~mask;			\
+		__no_operation();			\
+		*strobe |= mask;			\
+		__no_operation();			\
+	} while (0)
+
+#define READ_CYCLE(_hi, _lo) do {			\
+		*strobe &= ~mask;			\
+		__no_operation();			\
+		(_hi) = P6IN;				\
+		(_lo) = P4IN;				\
+		*strobe |= mask;			\
+		__no_operation();			\
+	} while (0)
+
+static inline void bus_input(void)
+{
+	if (g_bus_dir != BUS_DIR_INPUT) {
+		P6DIR = 0x00;
+		P4DIR = 0x00;
+		g_bus_dir = BUS_DIR_INPUT;
+	}
+}
+
+static inline void bus_output(void)
+{
+	if (g_bus_dir != BUS_DIR_OUTPUT) {
+		P6DIR = 0xff;
+		P4DIR = 0xff;
+		g_bus_dir = BUS_DIR_OUTPUT;
+	}
+}
 
 int msp430_parallel_init(struct pl_gpio *gpio, struct pl_interface *iface)
 {
@@ -56,8 +115,19 @@ int msp430_parallel_init(struct pl_gpio *gpio, struct pl_interface *iface)
 
 	if (pl_gpio_config_list(gpio, gpios, ARRAY_SIZE(gpios)))
 		return -1;
+
+	if (pl_gpio_get_handle(gpio, READ_STROBE, &g_read_strobe) ||
+	    pl_gpio_get_handle(gpio, WRITE_STROBE, &g_write_strobe))
+		return -1;
+
+	g_bus_dir = BUS_DIR_UNKNOWN;
+	bus_input();
+
 	iface->write = msp430_parallel_write_bytes;
 	iface->read = msp430_parallel_read_bytes;
+	iface->write_words = msp430_parallel_write_words;
+	iface->read_words = msp430_parallel_read_words;
+	iface->write_repeat = msp430_parallel_write_repeat;
 	return 0;
 }
 
@@ -65,52 +135,120 @@ int msp430_parallel_init(struct pl_gpio *gpio, struct pl_interface *iface)
 // in parallel port as its valid data.
 int msp430_parallel_read_bytes(uint8_t *buff, uint8_t size)
 {
+	volatile uint8_t * const strobe = g_read_strobe.out;
+	const uint8_t mask = g_read_strobe.mask;
+
 	assert((size & 1) == 0);
 
-	// define ports as input
-	P6DIR = 0x00;
-	P4DIR = 0x00;
-
-	do {
-		msp430_gpio_set(READ_STROBE, 0);
-		__no_operation();
-		*buff++ = P6IN;
-		*buff++ = P4IN;
-		msp430_gpio_set(READ_STROBE, 1);
-		__no_operation();
-	} while (size -= 2);
+	bus_input();
+
+	for (size /= 2; size; --size) {
+		READ_CYCLE(buff[0], buff[1]);
+		buff += 2;
+	}
+
 	return 0;
 }
+
 int msp430_parallel_write_bytes(uint8_t *buff, uint8_t size)
 {
+	volatile uint8_t * const strobe = g_write_strobe.out;
+	const uint8_t mask = g_write_strobe.mask;
+
 	assert((size & 1) == 0);
 
-	// define ports as output
-	P6DIR = 0xff;
-	P4DIR = 0xff;
-#if 0
-	{
-		uint8_t bit = 1;
-		while (bit)
-		{
-			P4OUT = bit;
-			P6OUT = bit;
-			bit <<= 1;
-		}
+	bus_output();
+
+	for (size /= 2; size >= 4; size -= 4) {
+		WRITE_CYCLE(buff[0], buff[1]);
+		WRITE_CYCLE(buff[2], buff[3]);
+		WRITE_CYCLE(buff[4], buff[5]);
+		WRITE_CYCLE(buff[6], buff[7]);
+		buff += 8;
 	}
-#endif
-	do {
-		msp430_gpio_set(WRITE_STROBE, 0);
-		P6OUT = *buff++;
-		P4OUT = *buff++;
-		msp430_gpio_set(WRITE_STROBE, 1);
-		__no_operation();
-	} while (size -= 2);
+
+	for (; size; --size) {
+		WRITE_CYCLE(buff[0], buff[1]);
+		buff += 2;
+	}
+
+	return 0;
+}
+
+/* Native 16-bit words, split into the two bus bytes on the fly so no
+ * byte-swapped copy of the data is needed */
+static int msp430_parallel_read_words(uint16_t *words, uint16_t n)
+{
+	volatile uint8_t * const strobe = g_read_strobe.out;
+	const uint8_t mask = g_read_strobe.mask;
+	uint8_t hi, lo;
+
+	bus_input();
+
+	while (n--) {
+		READ_CYCLE(hi, lo);
+		*words++ = ((uint16_t)hi << 8) | lo;
+	}
+
 	return 0;
 }
 
+static int msp430_parallel_write_words(const uint16_t *words, uint16_t n)
+{
+	volatile uint8_t * const strobe = g_write_strobe.out;
+	const uint8_t mask = g_write_strobe.mask;
 
+	bus_output();
 
+	for (; n >= 4; n -= 4) {
+		WRITE_CYCLE(words[0] >> 8, words[0]);
+		WRITE_CYCLE(words[1] >> 8, words[1]);
+		WRITE_CYCLE(words[2] >> 8, words[2]);
+		WRITE_CYCLE(words[3] >> 8, words[3]);
+		words += 4;
+	}
+
+	for (; n; --n) {
+		WRITE_CYCLE(*words >> 8, *words);
+		words++;
+	}
 
+	return 0;
+}
 
+/* The data lines only need to be set once to send the same word again */
+static int msp430_parallel_write_repeat(const uint16_t *pattern, uint8_t len,
+					uint32_t n)
+{
+	volatile uint8_t * const strobe = g_write_strobe.out;
+	const uint8_t mask = g_write_strobe.mask;
 
+	bus_output();
+
+	if (len == 1) {
+		P6OUT = pattern[0] >> 8;
+		P4OUT = pattern[0];
+
+		for (; n >= 4; n -= 4) {
+			STROBE_CYCLE();
+			STROBE_CYCLE();
+			STROBE_CYCLE();
+			STROBE_CYCLE();
+		}
+
+		for (; n; --n)
+			STROBE_CYCLE();
+
+		return 0;
+	}
+
+	while (n) {
+		const uint16_t *w = pattern;
+		uint8_t i;
+
+		for (i = len; i && n; --i, --n, ++w)
+			WRITE_CYCLE(*w >> 8, *w);
+	}
+
+	return 0;
+}
@@ -26,6 +26,7 @@
 #include <pl/gpio.h>
 #include <pl/interface.h>
 #include <msp430.h>
+#include "config.h"
 #include "utils.h"
 #include "assert.h"
 #include "msp430-defs.h"
@@ -46,6 +47,25 @@
 
 int msp430_spi_read_bytes(uint8_t *buff, uint8_t size);
 int msp430_spi_write_bytes(uint8_t *buff, uint8_t size);
+static int msp430_spi_write_repeat(const uint16_t *pattern, uint8_t len,
+				   uint32_t n);
+
+#if CONFIG_SPI_DMA
+/* DMA channel 0 writes one byte to the transmit buffer each time the
+ * USCI_A0 transmit flag is set (trigger 17 on the MSP430F5438) */
+#define SPI_DMA_TRIGGER DMA0TSEL_17
+#define SPI_DMA_TSEL_MASK 0x001F
+
+static int msp430_spi_write_async(const uint8_t *buff, uint16_t size,
+				  pl_interface_done_t done, void *ctx);
+static int msp430_spi_wait(void);
+static void dma_complete(void);
+static void dma_repeat_byte(uint8_t byte, uint32_t size);
+
+static volatile uint8_t dma_busy;
+static pl_interface_done_t dma_done;
+static void *dma_ctx;
+#endif
 /* We only support a single SPI bus and that bus is defined at compile
  * time.
  */
@@ -77,6 +97,12 @@ int msp430_spi_init(struct pl_gpio *gpio, uint8_t spi_channel, uint16_t divisor,
 
 	iface->read = msp430_spi_read_bytes;
 	iface->write = msp430_spi_write_bytes;
+	iface->write_repeat = msp430_spi_write_repeat;
+#if CONFIG_SPI_DMA
+	iface->write_async = msp430_spi_write_async;
+	iface->wait = msp430_spi_wait;
+	DMACTL0 = (DMACTL0 & ~SPI_DMA_TSEL_MASK) | SPI_DMA_TRIGGER;
+#endif
 
 	return 0;
 }
@@ -90,6 +116,10 @@ int msp430_spi_read_bytes(uint8_t *buff, uint8_t size)
 {
 	unsigned int gie = __get_SR_register() & GIE;	// Store current GIE state
 
+#if CONFIG_SPI_DMA
+	msp430_spi_wait();
+#endif
+
     __disable_interrupt();							// Make this operation atomic
 
     UCxnIFG &= ~UCRXIFG;							// Ensure RXIFG is clear
@@ -110,6 +140,10 @@ int msp430_spi_write_bytes(uint8_t *buff, uint8_t size)
 {
 	unsigned int gie = __get_SR_register() & GIE;   // Store current GIE state
 
+#if CONFIG_SPI_DMA
+	msp430_spi_wait();
+#endif
+
     __disable_interrupt();                          // Make this operation atomic
 
     // Clock the actual data transfer and send the bytes. Note that we
@@ -129,4 +163,134 @@ int msp430_spi_write_bytes(uint8_t *buff, uint8_t size)
     return 0;
 }
 
+/* Send the pattern without making a copy of it, or with DMA reading the same
+ * byte again when both bytes of the repeated word are identical which is the
+ * case of solid fills */
+static int msp430_spi_write_repeat(const uint16_t *pattern, uint8_t len,
+				   uint32_t n)
+{
+	unsigned int gie = __get_SR_register() & GIE;
+
+#if CONFIG_SPI_DMA
+	msp430_spi_wait();
+
+	if ((len == 1) && ((pattern[0] >> 8) == (pattern[0] & 0xFF))) {
+		dma_repeat_byte(pattern[0], n * 2);
+		return 0;
+	}
+#endif
+
+	__disable_interrupt();
+
+	while (n) {
+		const uint16_t *w = pattern;
+		uint8_t i;
+
+		for (i = len; i && n; --i, --n, ++w) {
+			while (!(UCxnIFG & UCTXIFG)) ;
+			UCxnTXBUF = *w >> 8;
+			while (!(UCxnIFG & UCTXIFG)) ;
+			UCxnTXBUF = *w;
+		}
+	}
+
+	while (UCxnSTAT & UCBUSY) ;
+	UCxnRXBUF;
+	__bis_SR_register(gie);
+
+	return 0;
+}
+
+#if CONFIG_SPI_DMA
+static int msp430_spi_write_async(const uint8_t *buff, uint16_t size,
+				  pl_interface_done_t done, void *ctx)
+{
+	msp430_spi_wait();
+
+	if (!size) {
+		if (done != NULL)
+			done(ctx);
+
+		return 0;
+	}
+
+	dma_done = done;
+	dma_ctx = ctx;
+	dma_busy = 1;
+
+	__data16_write_addr((unsigned short)&DMA0SA, (unsigned long)buff);
+	__data16_write_addr((unsigned short)&DMA0DA,
+			    (unsigned long)&UCxnTXBUF);
+	DMA0SZ = size;
+	DMA0CTL = DMADT_0 | DMASRCINCR_3 | DMADSTINCR_0 | DMASRCBYTE |
+		DMADSTBYTE | DMAIE | DMAEN;
+
+	// The trigger is edge sensitive and the transmit flag is already set,
+	// so toggle it to start the first byte
+	UCxnIFG &= ~UCTXIFG;
+	UCxnIFG |= UCTXIFG;
 
+	return 0;
+}
+
+static int msp430_spi_wait(void)
+{
+	while (dma_busy) {
+		// The interrupt can't be serviced, complete the transfer here
+		if (!(__get_SR_register() & GIE) && (DMA0CTL & DMAIFG)) {
+			DMA0CTL &= ~DMAIFG;
+			dma_complete();
+		}
+	}
+
+	return 0;
+}
+
+/* Synchronous DMA transfer from a fixed source address, without interrupt */
+static void dma_repeat_byte(uint8_t byte, uint32_t size)
+{
+	static uint8_t src;
+
+	src = byte;
+	__data16_write_addr((unsigned short)&DMA0SA, (unsigned long)&src);
+	__data16_write_addr((unsigned short)&DMA0DA,
+			    (unsigned long)&UCxnTXBUF);
+
+	while (size) {
+		const uint16_t chunk = (size > 0xFFFE) ? 0xFFFE : size;
+
+		DMA0SZ = chunk;
+		DMA0CTL = DMADT_0 | DMASRCINCR_0 | DMADSTINCR_0 | DMASRCBYTE |
+			DMADSTBYTE | DMAEN;
+		UCxnIFG &= ~UCTXIFG;
+		UCxnIFG |= UCTXIFG;
+
+		while (!(DMA0CTL & DMAIFG)) ;
+
+		DMA0CTL &= ~DMAIFG;
+		size -= chunk;
+	}
+
+	while (UCxnSTAT & UCBUSY) ;
+
+	UCxnRXBUF;
+}
+
+static void dma_complete(void)
+{
+	while (UCxnSTAT & UCBUSY) ;                     // Wait for the last byte
+
+	UCxnRXBUF;                                      // Clear overrun condition
+	dma_busy = 0;
+
+	if (dma_done != NULL)
+		dma_done(dma_ctx);
+}
+
+#pragma vector=DMA_VECTOR
+__interrupt void DMA_ISR(void)
+{
+	if (__even_in_range(DMAIV, 16) == DMAIV_DMA0IFG)
+		dma_complete();
+}
+#endif
@@ -32,6 +32,7 @@
 #define INIT_COUNT_H 0x50
 
 static int delay;
+static volatile uint16_t ticks_hi;
 
 #define CPU_CYCLES_PER_USECOND (CPU_CLOCK_SPEED_IN_HZ/1000000L)
 #define CPU_CYCLES_PER_MSECOND (CPU_CLOCK_SPEED_IN_HZ/1000L)
@@ -59,6 +60,48 @@ void msleep(uint16_t ms)
 }
 
 
+/* Free-running tick counter: Timer B0 clocked at SMCLK / 4 / 5 = 1MHz, with
+ * the overflow interrupt extending it to 32 bits */
+void ticks_init(void)
+{
+	ticks_hi = 0;
+	TB0CTL = TBSSEL_2 | ID_2 | TBCLR;	// SMCLK / 4, clear
+	TB0EX0 = TBIDEX_4;			// further / 5 => 1MHz
+	TB0CTL |= MC_2 | TBIE;			// contmode, overflow interrupt enable
+}
+
+uint32_t ticks_now(void)
+{
+	unsigned int gie = __get_SR_register() & GIE;
+	uint16_t hi;
+	uint16_t lo;
+
+	__disable_interrupt();
+	lo = TB0R;
+	hi = ticks_hi;
+
+	/* overflow happened but the interrupt has not been serviced yet */
+	if ((TB0CTL & TBIFG) && !(lo & 0x8000))
+		hi++;
+
+	__bis_SR_register(gie);
+
+	return ((uint32_t)hi << 16) | lo;
+}
+
+#pragma vector = TIMER0_B1_VECTOR
+__interrupt void TIMER0_B1_ISR(void)
+{
+	switch(__even_in_range(TB0IV,14))
+	{
+	case 14:				// TBIFG => overflow
+		ticks_hi++;
+		break;
+	default:break;
+	}
+}
+
+
 void init_rtc()
 {
 	  // Setup RTC Timer
@@ -26,7 +26,9 @@
  */
 
 #include <pl/gpio.h>
+#include <pl/serial.h>
 #include <stdint.h>
+#include <string.h>
 #include <file.h>
 #include "utils.h"
 #include "msp430.h"
@@ -41,26 +43,294 @@
 #define	UART_TX                 MSP430_GPIO(5,6)
 #define	UART_RX                 MSP430_GPIO(5,7)
 
-#if CONFIG_UART_PRINTF
 // protect from calls before intialisation is complete.
 static uint8_t init_done = 0;
 
+#if CONFIG_UART_TX_BUFFER & (CONFIG_UART_TX_BUFFER - 1)
+#error CONFIG_UART_TX_BUFFER must be a power of 2
+#endif
+#if !CONFIG_UART_RX_BUFFER || (CONFIG_UART_RX_BUFFER & (CONFIG_UART_RX_BUFFER - 1))
+#error CONFIG_UART_RX_BUFFER must be a power of 2
+#endif
+#define TX_MASK (CONFIG_UART_TX_BUFFER - 1)
+#define RX_MASK (CONFIG_UART_RX_BUFFER - 1)
+
+#if CONFIG_UART_TX_BUFFER
+/* Transmit ring buffer, emptied by the TX interrupt */
+static uint8_t tx_buffer[CONFIG_UART_TX_BUFFER];
+static volatile uint16_t tx_head;	// next byte to be queued
+static volatile uint16_t tx_tail;	// next byte to be sent
+static uint16_t tx_dropped;		// number of text messages dropped
+#endif
+
+/* Receive ring buffer, filled by the RX interrupt */
+static uint8_t rx_buffer[CONFIG_UART_RX_BUFFER];
+static volatile uint16_t rx_head;	// next byte to be received
+static volatile uint16_t rx_tail;	// next byte to be read
+static volatile uint16_t rx_overruns;	// number of bytes lost
+
+#if CONFIG_UART_TX_BUFFER
+/* Queue all the bytes or none of them if there is not enough room, with
+ * each '\n' sent as "\r\n" when crlf is set */
+static int tx_queue_data(const uint8_t *data, uint16_t n, int crlf)
+{
+	unsigned int gie = __get_SR_register() & GIE;
+	uint16_t len = n;
+	uint16_t i;
+	int stat = -1;
+
+	if (crlf) {
+		for (i = 0; i < n; ++i)
+			if (data[i] == '\n')
+				len++;
+	}
+
+	__disable_interrupt();
+
+	if ((TX_MASK - ((tx_head - tx_tail) & TX_MASK)) >= len) {
+		while (n--) {
+			if (crlf && (*data == '\n')) {
+				tx_buffer[tx_head] = '\r';
+				tx_head = (tx_head + 1) & TX_MASK;
+			}
+
+			tx_buffer[tx_head] = *data++;
+			tx_head = (tx_head + 1) & TX_MASK;
+		}
+
+		UCxnIE |= UCTXIE;		// the ISR will start sending
+		stat = 0;
+	}
+
+	__bis_SR_register(gie);
+
+	return stat;
+}
+
+static int tx_queue(const uint8_t *data, uint16_t n)
+{
+	return tx_queue_data(data, n, 0);
+}
+
+static void tx_send_next(void)
+{
+	if (tx_tail == tx_head) {
+		UCxnIE &= ~UCTXIE;		// nothing left to send
+		return;
+	}
+
+	UCxnTXBUF = tx_buffer[tx_tail];
+	tx_tail = (tx_tail + 1) & TX_MASK;
+}
+#else
+static int tx_queue_data(const uint8_t *data, uint16_t n, int crlf)
+{
+	while (n--) {
+		if (crlf && (*data == '\n')) {
+			while(!(UCxnIFG & UCTXIFG));
+			UCxnTXBUF = '\r';
+		}
+
+		while(!(UCxnIFG & UCTXIFG));
+		UCxnTXBUF = *data++;
+	}
+
+	return 0;
+}
+
+static int tx_queue(const uint8_t *data, uint16_t n)
+{
+	return tx_queue_data(data, n, 0);
+}
+#endif
+
+static void rx_receive(void)
+{
+	const uint8_t c = UCxnRXBUF;	// reading clears UCRXIFG
+	const uint16_t next = (rx_head + 1) & RX_MASK;
+
+	if (next == rx_tail) {
+		if (rx_overruns != 0xFFFF)
+			rx_overruns++;
+		return;
+	}
+
+	rx_buffer[rx_head] = c;
+	rx_head = next;
+}
+
+#pragma vector=USCI_A1_VECTOR
+__interrupt void USCI_A1_ISR(void)
+{
+	switch(__even_in_range(UCxnIV,4))
+	{
+	case 2:					// UCRXIFG
+		rx_receive();
+		break;
+#if CONFIG_UART_TX_BUFFER
+	case 4:					// UCTXIFG
+		tx_send_next();
+		break;
+#endif
+	default:break;
+	}
+}
+
+int msp430_uart_write_frame(const uint8_t *data, uint16_t n)
+{
+	if (!init_done)
+		return -1;
+
+	return tx_queue(data, n);
+}
+
+void msp430_uart_flush(void)
+{
+#if CONFIG_UART_TX_BUFFER
+	if (!init_done)
+		return;
+
+	while (tx_tail != tx_head) {
+		/* send the data here if the interrupts are disabled */
+		if (!(__get_SR_register() & GIE) && (UCxnIFG & UCTXIFG))
+			tx_send_next();
+	}
+#endif
+}
+
+uint16_t msp430_uart_read_bytes(uint8_t *data, uint16_t n)
+{
+	uint16_t count = 0;
+
+	while ((count < n) && (rx_tail != rx_head)) {
+		*data++ = rx_buffer[rx_tail];
+		rx_tail = (rx_tail + 1) & RX_MASK;
+		count++;
+	}
+
+	return count;
+}
+
+unsigned msp430_uart_get_overruns(void)
+{
+	return rx_overruns;
+}
+
+/* --- pl_serial implementation --- */
+
+static int msp430_uart_serial_read(struct pl_serial *serial, uint8_t *data,
+				   size_t n, unsigned timeout_ms)
+{
+	const uint32_t start = ticks_now();
+	const uint32_t timeout = (uint32_t)timeout_ms * (TICKS_PER_SEC / 1000);
+	size_t count = 0;
+
+	while (count < n) {
+		count += msp430_uart_read_bytes(&data[count], (n - count));
+
+		if ((ticks_now() - start) > timeout)
+			break;
+	}
+
+	return count;
+}
+
+static unsigned msp430_uart_serial_get_overruns(struct pl_serial *serial)
+{
+	return msp430_uart_get_overruns();
+}
+
+static int msp430_uart_serial_write(struct pl_serial *serial,
+				    const uint8_t *data, size_t n)
+{
+	if (!init_done)
+		return -1;
+
+#if CONFIG_UART_TX_BUFFER
+	/* wait until there is enough room, split long blocks */
+	while (n) {
+		const uint16_t chunk = min(n, (CONFIG_UART_TX_BUFFER / 2));
+
+		while ((TX_MASK - ((tx_head - tx_tail) & TX_MASK)) < chunk);
+
+		if (tx_queue(data, chunk))
+			return -1;
+
+		data += chunk;
+		n -= chunk;
+	}
+
+	return 0;
+#else
+	return tx_queue(data, n);
+#endif
+}
+
+int msp430_uart_serial_init(struct pl_serial *serial)
+{
+	serial->read = msp430_uart_serial_read;
+	serial->write = msp430_uart_serial_write;
+	serial->get_overruns = msp430_uart_serial_get_overruns;
+	serial->priv = NULL;
+
+	return 0;
+}
+
+#if CONFIG_UART_PRINTF
 int msp430_uart_getc(void)
 {
-	if (init_done && (UCxnIFG & UCRXIFG))
-		return (UCxnRXBUF & 0x00ff);
+	uint8_t c;
+
+	if (init_done && msp430_uart_read_bytes(&c, 1))
+		return c;
 
 	return -1;
 }
 
+#if CONFIG_UART_TX_BUFFER
+/* Queue a text message, or drop all of it if there is not enough room.  The
+ * number of dropped messages is sent first as soon as there is room again. */
+static void tx_queue_text(const char *s, uint16_t n)
+{
+	if (tx_dropped) {
+		static const char msg[] = " message(s) dropped\n";
+		char note[5 + sizeof(msg)];
+		char *it = &note[5];
+		unsigned count = tx_dropped;
+
+		do {
+			*--it = '0' + (count % 10);
+			count /= 10;
+		} while (count);
+
+		memcpy(&note[5], msg, (sizeof(msg) - 1));
+
+		if (tx_queue_data((const uint8_t *)it,
+				  (&note[5] - it + sizeof(msg) - 1), 1)) {
+			if (tx_dropped != 0xFFFF)
+				tx_dropped++;
+			return;
+		}
+
+		tx_dropped = 0;
+	}
+
+	if (tx_queue_data((const uint8_t *)s, n, 1) && (tx_dropped != 0xFFFF))
+		tx_dropped++;
+}
+#else
+static void tx_queue_text(const char *s, uint16_t n)
+{
+	tx_queue_data((const uint8_t *)s, n, 1);
+}
+#endif
+
 int msp430_uart_putc(int c)
 {
 	if (init_done) {
-		if (c == '\n')
-			msp430_uart_putc('\r');
+		const char c8 = c;
 
-		while(!(UCxnIFG & UCTXIFG));
-		UCxnTXBUF = (unsigned char)c;
+		tx_queue_text(&c8, 1);
 	}
 
 	return (unsigned char)c;
@@ -73,12 +343,18 @@ int msp430_uart_puts(const char *s)
 	if (!init_done)
 		return 1;
 
-	for(i = 0; s[i]; i++)
-		msp430_uart_putc(s[i]);
+	i = strlen(s);
+	tx_queue_text(s, i);
 
 	return i;
 }
 
+#if CONFIG_UART_TX_BUFFER
+/* Size of the stdout line buffer, longer lines are sent in several parts */
+#define STDOUT_BUFFER_SIZE 128
+static char stdout_buffer[STDOUT_BUFFER_SIZE];
+#endif
+
 int msp430_uart_register_files()
 {
 	add_device("msp430UART", _MSA,
@@ -102,11 +378,19 @@ int msp430_uart_register_files()
 		return -1;
 	}
 
+#if CONFIG_UART_TX_BUFFER
+	/* Buffer each line so it is sent or dropped as a whole */
+	if (setvbuf(stdout, stdout_buffer, _IOLBF, sizeof(stdout_buffer))) {
+		LOG("Failed to setvbuf stdout");
+		return -1;
+	}
+#else
 	/* Don't buffer (saves calling fflush) */
 	if (setvbuf(stdout, NULL, _IONBF, 0)) {
 		LOG("Failed to setvbuf stdout");
 		return -1;
 	}
+#endif
 
 	return 0;
 }
@@ -207,6 +491,19 @@ int msp430_uart_init(struct pl_gpio *gpio, int baud_rate_id, char parity,
 			UCxnBR1 = 0;
 			UCxnMCTL = (UCOS16 | UCBRS_0 | UCBRF_7);
 			break;
+		/* Not in the tables, low-frequency mode with
+		 * N = 20MHz / baud rate, UCBRx = INT(N),
+		 * UCBRSx = round((N - INT(N)) * 8) */
+		case BR_460800:
+			UCxnBR0 = 43;
+			UCxnBR1 = 0;
+			UCxnMCTL = (UCBRS_3 | UCBRF_0);
+			break;
+		case BR_921600:
+			UCxnBR0 = 21;
+			UCxnBR1 = 0;
+			UCxnMCTL = (UCBRS_6 | UCBRF_0);
+			break;
 		default:
 			return -1;
 	}
@@ -214,8 +511,17 @@ int msp430_uart_init(struct pl_gpio *gpio, int baud_rate_id, char parity,
 	// release unit from reset
 	UCxnCTL1 &= ~UCSWRST;
 
-#if CONFIG_UART_PRINTF
+	// receive in the background, this needs to be set after reset
+	UCxnIE |= UCRXIE;
+
+	/* Only register the files the first time, the baud rate may be
+	 * changed later on by calling this function again */
+	if (init_done)
+		return 0;
+
 	init_done = 1;
+
+#if CONFIG_UART_PRINTF
 	return msp430_uart_register_files();
 #else
 	return 0;
@@ -247,15 +553,12 @@ int msp430_uart_read(int dev_fd, char *buf, unsigned count)
 
 int msp430_uart_write(int dev_fd, const char *buf, unsigned count)
 {
-	unsigned int i;
-
 	if (!init_done)
 		return -1;
 
-	for(i = 0; i < count; i++)
-		msp430_uart_putc(buf[i]);
+	tx_queue_text(buf, count);
 
-	return i;
+	return count;
 }
 
 
@@ -28,14 +28,19 @@
 #ifndef MSP430_UART_H
 #define MSP430_UART_H 1
 
+#include <stdint.h>
+
 #define	BR_9600		1
 #define	BR_19200	2
 #define	BR_38400	3
 #define	BR_57600	4
 #define	BR_115200	5
 #define	BR_230400	6
+#define	BR_460800	7
+#define	BR_921600	8
 
 struct pl_gpio;
+struct pl_serial;
 
 int    msp430_uart_open(const char *path, unsigned flags, int llv_fd);
 int    msp430_uart_close(int dev_fd);
@@ -48,4 +53,20 @@ int    msp430_uart_rename(const char *old_name, const char *new_name);
 extern int msp430_uart_init(struct pl_gpio *gpio, int baud_rate_id,
 			    char parity, int data_bits, int stop_bits);
 
+/** Queue a block of binary data to be sent in one go, or drop it all and
+ * return -1 if there is not enough room in the transmit buffer */
+extern int msp430_uart_write_frame(const uint8_t *data, uint16_t n);
+
+/** Wait until all the queued data has been sent */
+extern void msp430_uart_flush(void);
+
+/** Read up to n bytes already received, return the number of bytes read */
+extern uint16_t msp430_uart_read_bytes(uint8_t *data, uint16_t n);
+
+/** Number of bytes lost because the receive buffer was full */
+extern unsigned msp430_uart_get_overruns(void);
+
+/** Initialise a pl_serial instance to use this UART */
+extern int msp430_uart_serial_init(struct pl_serial *serial);
+
 #endif /* MSP430_UART_H */
@@ -27,10 +27,36 @@
 #ifndef INCLUDE_MSP430_PLAT_GPIO_H
 #define INCLUDE_MSP430_PLAT_GPIO_H 1
 
+#include <stdint.h>
+
 extern int msp430_gpio_get(unsigned gpio);
 extern void msp430_gpio_set(unsigned gpio, int value);
 
 #define pl_gpio_get(_p, _gpio) msp430_gpio_get((_gpio))
 #define pl_gpio_set(_p, _gpio, _value) msp430_gpio_set((_gpio), (_value))
 
+/* GPIO handles with the port registers and pin mask resolved once, so each
+ * access is a single instruction */
+#define PL_GPIO_HANDLE 1
+
+struct pl_gpio_handle {
+	volatile uint8_t *out;
+	volatile uint8_t *in;
+	uint8_t mask;
+};
+
+extern int msp430_gpio_get_handle(unsigned gpio, struct pl_gpio_handle *h);
+
+#define pl_gpio_get_handle(_p, _gpio, _h) \
+	msp430_gpio_get_handle((_gpio), (_h))
+#define pl_gpio_fast_high(_h) (*(_h)->out |= (_h)->mask)
+#define pl_gpio_fast_low(_h) (*(_h)->out &= ~(_h)->mask)
+#define pl_gpio_fast_set(_h, _value) do {		\
+		if (_value)				\
+			pl_gpio_fast_high(_h);		\
+		else					\
+			pl_gpio_fast_low(_h);		\
+	} while (0)
+#define pl_gpio_fast_get(_h) ((*(_h)->in & (_h)->mask) ? 1 : 0)
+
 #endif /* INCLUDE_MSP430_PLAT_GPIO_H */
@@ -0,0 +1,191 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * pattern.c -- Procedural test patterns
+ */
+
+#include "pattern.h"
+#include <string.h>
+
+/* Same order as enum pattern_type */
+static const char * const pattern_names[PATTERN_N] = {
+	"checker", "hgrad", "vgrad", "vstripes", "hstripes", "crosshatch",
+	"frame",
+};
+
+static uint16_t line_class(const struct pattern *p, uint16_t y);
+static uint8_t pixel(const struct pattern *p, uint16_t cls, uint16_t x);
+static uint8_t grad_level(const struct pattern *p, uint16_t i, uint16_t n);
+static void render(const struct pattern *p, uint16_t cls, uint8_t *line);
+
+int pattern_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < PATTERN_N; ++i)
+		if (!strcmp(pattern_names[i], name))
+			return i;
+
+	return -1;
+}
+
+const char *pattern_name(enum pattern_type type)
+{
+	return (type < PATTERN_N) ? pattern_names[type] : "?";
+}
+
+int pattern_init(struct pattern *p, uint8_t *buffer, size_t size)
+{
+	unsigned i;
+
+	if ((p->type >= PATTERN_N) || !p->width || !p->height ||
+	    ((p->bpp != 1) && (p->bpp != 2) && (p->bpp != 4) &&
+	     (p->bpp != 8)))
+		return -1;
+
+	/* gradients default to the 16 grey levels */
+	if (!p->size)
+		p->size = ((p->type == PATTERN_HGRAD) ||
+			   (p->type == PATTERN_VGRAD)) ? 16 : 1;
+
+	p->line_size = PATTERN_LINE_SIZE(p->width, p->bpp);
+
+	if (size < p->line_size)
+		return -1;
+
+	size /= p->line_size;
+	p->n_tpl = (size < PATTERN_MAX_TEMPLATES) ?
+		size : PATTERN_MAX_TEMPLATES;
+
+	for (i = 0; i < p->n_tpl; ++i) {
+		p->tpl[i] = buffer + (i * p->line_size);
+		p->tpl_class[i] = 0xFFFF;
+	}
+
+	p->next_tpl = 0;
+
+	return 0;
+}
+
+const uint8_t *pattern_line(struct pattern *p, uint16_t y)
+{
+	const uint16_t cls = line_class(p, y);
+	uint8_t *line;
+	unsigned i;
+
+	for (i = 0; i < p->n_tpl; ++i)
+		if (p->tpl_class[i] == cls)
+			return p->tpl[i];
+
+	/* replace the templates in turn */
+	line = p->tpl[p->next_tpl];
+	p->tpl_class[p->next_tpl] = cls;
+	p->next_tpl = (p->next_tpl + 1) % p->n_tpl;
+	render(p, cls, line);
+
+	return line;
+}
+
+/* ----------------------------------------------------------------------------
+ * static functions
+ */
+
+/* All the lines with the same class have the same data */
+static uint16_t line_class(const struct pattern *p, uint16_t y)
+{
+	switch (p->type) {
+	case PATTERN_CHECKER:
+	case PATTERN_HSTRIPES:
+		return (y / p->size) & 1;
+	case PATTERN_VGRAD:
+		return ((uint32_t)y * p->size) / p->height;
+	case PATTERN_CROSSHATCH:
+		return ((y % p->size) == 0) || (y == (p->height - 1));
+	case PATTERN_FRAME:
+		return (y < p->size) || (y >= (p->height - p->size));
+	default:
+		return 0;
+	}
+}
+
+static uint8_t pixel(const struct pattern *p, uint16_t cls, uint16_t x)
+{
+	switch (p->type) {
+	case PATTERN_CHECKER:
+		return (((x / p->size) & 1) ^ cls) ? p->bg : p->fg;
+	case PATTERN_HGRAD:
+		return grad_level(p, ((uint32_t)x * p->size) / p->width,
+				  p->size);
+	case PATTERN_VGRAD:
+		return grad_level(p, cls, p->size);
+	case PATTERN_VSTRIPES:
+		return ((x / p->size) & 1) ? p->bg : p->fg;
+	case PATTERN_HSTRIPES:
+		return cls ? p->bg : p->fg;
+	case PATTERN_CROSSHATCH:
+		return (cls || !(x % p->size) || (x == (p->width - 1))) ?
+			p->fg : p->bg;
+	case PATTERN_FRAME:
+		return (cls || (x < p->size) || (x >= (p->width - p->size))) ?
+			p->fg : p->bg;
+	default:
+		return p->bg;
+	}
+}
+
+/* Level of step i out of n from fg to bg, rounded to one of the 16 grey
+ * levels so each step is a solid grey */
+static uint8_t grad_level(const struct pattern *p, uint16_t i, uint16_t n)
+{
+	const int from = p->fg >> 4;
+	const int to = p->bg >> 4;
+	int level;
+
+	if (n < 2)
+		level = from;
+	else if (to >= from)
+		level = from + (((to - from) * (int)i * 2 + (int)(n - 1)) /
+				(2 * (int)(n - 1)));
+	else
+		level = from - (((from - to) * (int)i * 2 + (int)(n - 1)) /
+				(2 * (int)(n - 1)));
+
+	return (level << 4) | level;
+}
+
+static void render(const struct pattern *p, uint16_t cls, uint8_t *line)
+{
+	const unsigned ppb = 8 / p->bpp;
+	uint16_t x;
+
+	if (p->bpp == 8) {
+		for (x = 0; x < p->width; ++x)
+			line[x] = pixel(p, cls, x);
+
+		return;
+	}
+
+	memset(line, 0, p->line_size);
+
+	for (x = 0; x < p->width; ++x) {
+		const uint8_t g = pixel(p, cls, x) >> (8 - p->bpp);
+
+		line[x / ppb] |= g << ((x % ppb) * p->bpp);
+	}
+}
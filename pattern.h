@@ -0,0 +1,100 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * pattern.h -- Procedural test patterns
+ */
+
+#ifndef INCLUDE_PATTERN_H
+#define INCLUDE_PATTERN_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+   @file pattern.h
+
+   Test patterns generated one line at a time, so test cards can be sent to
+   the EPDC without any image file.
+
+   All the lines of a pattern belong to a small number of line classes (i.e.
+   the two phases of a checkerboard, or a grid line and the space between
+   two grid lines).  Each class is rendered once into a line template in the
+   buffer given by the caller, and the same template is returned for all the
+   lines of that class until it has to be replaced by another one.
+
+   This file has no platform dependencies so it can also be used by the host
+   tools.
+*/
+
+enum pattern_type {
+	PATTERN_CHECKER,       /**< squares of size pixels */
+	PATTERN_HGRAD,         /**< grey steps from left to right */
+	PATTERN_VGRAD,         /**< grey steps from top to bottom */
+	PATTERN_VSTRIPES,      /**< vertical stripes of size pixels */
+	PATTERN_HSTRIPES,      /**< horizontal stripes of size pixels */
+	PATTERN_CROSSHATCH,    /**< 1-pixel grid lines every size pixels */
+	PATTERN_FRAME,         /**< border of size pixels */
+	PATTERN_N
+};
+
+/** Maximum number of line templates kept at the same time */
+#define PATTERN_MAX_TEMPLATES 4
+
+struct pattern {
+	enum pattern_type type;
+	uint16_t width;        /**< width of the area in pixels */
+	uint16_t height;       /**< height of the area in lines */
+	uint16_t size;         /**< size of the squares, stripes or border, or
+				    number of steps of the gradients */
+	uint8_t fg;            /**< 8-bit grey level of the pattern, or
+				    first level of the gradients */
+	uint8_t bg;            /**< 8-bit grey level of the background, or
+				    last level of the gradients */
+	uint8_t bpp;           /**< bits per pixel: 1, 2, 4 or 8 */
+	/* private */
+	uint16_t line_size;
+	uint8_t n_tpl;
+	uint8_t next_tpl;
+	uint16_t tpl_class[PATTERN_MAX_TEMPLATES];
+	uint8_t *tpl[PATTERN_MAX_TEMPLATES];
+};
+
+/** Get a pattern type from its name or -1 if not found, the names are
+ * checker, hgrad, vgrad, vstripes, hstripes, crosshatch and frame */
+extern int pattern_find(const char *name);
+
+/** Get the name of a pattern type */
+extern const char *pattern_name(enum pattern_type type);
+
+/** Number of bytes in each line, with pixels packed in bytes for bpp lower
+ * than 8 and the first pixel in the lowest bits as in tools/convert */
+#define PATTERN_LINE_SIZE(_width, _bpp) ((((_width) * (_bpp)) + 7) / 8)
+
+/** Initialise a pattern once its public fields have been set, with a buffer
+ * to store the line templates.  A larger buffer holding more templates means
+ * fewer templates need to be rendered again.
+    @return -1 if the settings are invalid or the buffer is too small for a
+    single line, 0 otherwise
+*/
+extern int pattern_init(struct pattern *p, uint8_t *buffer, size_t size);
+
+/** Get the data of line y, which remains valid until the next call */
+extern const uint8_t *pattern_line(struct pattern *p, uint16_t y);
+
+#endif /* INCLUDE_PATTERN_H */
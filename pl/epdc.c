@@ -31,6 +31,7 @@
 #endif
 #include <string.h>
 #include "assert.h"
+#include "config.h"
 
 #define LOG_TAG "epdc"
 #include "utils.h"
@@ -60,10 +61,44 @@ int pl_epdc_get_wfid(struct pl_epdc *p, int wf_from)
 }
 #endif
 
+int pl_epdc_update_temp(struct pl_epdc *p)
+{
+	struct pl_epdc_temp_cache *t = &p->temp;
+	const uint32_t now = ticks_now();
+
+	/* Note: the tick counter wraps after about 71 minutes, a sample may
+	 * then be reused once for longer than CONFIG_TEMP_TTL_MS */
+	if (t->valid && (t->mode == p->temp_mode) &&
+	    ((p->temp_mode != PL_EPDC_TEMP_MANUAL) ||
+	     (t->manual_temp == p->manual_temp)) &&
+	    ((now - t->sampled) < ((uint32_t)CONFIG_TEMP_TTL_MS * 1000))) {
+		t->cached++;
+		return 0;
+	}
+
+	t->valid = 0;
+
+	if (p->update_temp(p))
+		return -1;
+
+	t->sampled = now;
+	t->mode = p->temp_mode;
+	t->manual_temp = p->manual_temp;
+	t->samples++;
+	t->valid = 1;
+
+	return 0;
+}
+
+void pl_epdc_invalidate_temp(struct pl_epdc *p)
+{
+	p->temp.valid = 0;
+}
+
 int pl_epdc_single_update(struct pl_epdc *epdc, struct pl_epdpsu *psu,
 			  int wfid, enum pl_update_mode mode, const struct pl_area *area)
 {
-	if (epdc->update_temp(epdc))
+	if (pl_epdc_update_temp(epdc))
 		return -1;
 
 	if (psu->on(psu))
@@ -78,6 +113,79 @@ int pl_epdc_single_update(struct pl_epdc *epdc, struct pl_epdpsu *psu,
 	return psu->off(psu);
 }
 
+int pl_epdc_load_wflib(struct pl_epdc *p)
+{
+	const uint32_t start = ticks_now();
+
+	p->wflib_state = PL_EPDC_WFLIB_PENDING;
+	p->wflib_offset = 0;
+
+	if (p->load_wflib(p)) {
+		LOG("Failed to load wflib");
+		p->wflib_state = PL_EPDC_WFLIB_ERROR;
+		return -1;
+	}
+
+	p->wflib_load_us = ticks_now() - start;
+	p->wflib_offset = p->wflib.size;
+	p->wflib_state = PL_EPDC_WFLIB_READY;
+
+	return 0;
+}
+
+void pl_epdc_wflib_defer(struct pl_epdc *p)
+{
+	p->wflib_state = PL_EPDC_WFLIB_PENDING;
+	p->wflib_offset = 0;
+	p->wflib_load_us = 0;
+}
+
+int pl_epdc_wflib_poll(struct pl_epdc *p)
+{
+	uint32_t start;
+	int stat;
+
+	if (p->wflib_state != PL_EPDC_WFLIB_PENDING)
+		return (p->wflib_state == PL_EPDC_WFLIB_ERROR) ? -1 : 0;
+
+	start = ticks_now();
+
+	if ((p->load_wflib_part == NULL) || (p->wflib.xfer_part == NULL)) {
+		stat = p->load_wflib(p);
+		p->wflib_offset = p->wflib.size;
+	} else {
+		const uint32_t n = min((uint32_t)PL_EPDC_WFLIB_CHUNK,
+				       (p->wflib.size - p->wflib_offset));
+
+		stat = p->load_wflib_part(p, p->wflib_offset, n);
+		p->wflib_offset += n;
+	}
+
+	p->wflib_load_us += ticks_now() - start;
+
+	if (stat) {
+		LOG("Failed to load wflib");
+		p->wflib_state = PL_EPDC_WFLIB_ERROR;
+		return -1;
+	}
+
+	if (p->wflib_offset == p->wflib.size) {
+		LOG("wflib loaded in %lu us", (unsigned long)p->wflib_load_us);
+		p->wflib_state = PL_EPDC_WFLIB_READY;
+	}
+
+	return 0;
+}
+
+int pl_epdc_wflib_wait(struct pl_epdc *p)
+{
+	while (p->wflib_state == PL_EPDC_WFLIB_PENDING)
+		if (pl_epdc_wflib_poll(p))
+			return -1;
+
+	return (p->wflib_state == PL_EPDC_WFLIB_ERROR) ? -1 : 0;
+}
+
 #if PL_EPDC_STUB
 /* ----------------------------------------------------------------------------
  * Stub EPDC implementation
@@ -193,6 +301,31 @@ static int stub_load_image(struct pl_epdc *p, const char *path,
 	return 0;
 }
 
+static int stub_load_area_begin(struct pl_epdc *p,
+				const struct pl_area *area)
+{
+#if STUB_VERBOSE
+	if (area != NULL)
+		STUB_LOG("load_area start=(%d, %d), dim=%dx%d",
+			 area->left, area->top, area->width, area->height);
+	else
+		STUB_LOG("load_area");
+#endif
+
+	return 0;
+}
+
+static int stub_load_area_data(struct pl_epdc *p, const uint8_t *data,
+			       size_t n)
+{
+	return 0;
+}
+
+static int stub_load_area_end(struct pl_epdc *p)
+{
+	return 0;
+}
+
 int pl_epdc_stub_init(struct pl_epdc *p)
 {
 	STUB_LOG("stub init");
@@ -208,6 +341,9 @@ int pl_epdc_stub_init(struct pl_epdc *p)
 	p->update_temp = stub_update_temp;
 	p->fill = stub_fill;
 	p->load_image = stub_load_image;
+	p->load_area_begin = stub_load_area_begin;
+	p->load_area_data = stub_load_area_data;
+	p->load_area_end = stub_load_area_end;
 	p->wf_table = stub_wf_table;
 	p->xres = 640;
 	p->yres = 480;
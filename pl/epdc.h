@@ -62,6 +62,26 @@ enum pl_update_mode {
 	UPDATE_PARTIAL_AREA = 3, //0x36,
 };
 
+enum pl_epdc_wflib_state {
+	PL_EPDC_WFLIB_READY = 0,   /* loaded, or not needed (i.e. stub) */
+	PL_EPDC_WFLIB_PENDING,     /* deferred, not fully loaded yet */
+	PL_EPDC_WFLIB_ERROR,       /* failed to load */
+};
+
+/* Size of each chunk when loading the wflib in the background */
+#define PL_EPDC_WFLIB_CHUNK 1024
+
+/* Temperature sampling state and statistics, see pl_epdc_update_temp() */
+struct pl_epdc_temp_cache {
+	uint32_t sampled;               /* ticks_now() of the last sample */
+	enum pl_epdc_temp_mode mode;    /* mode used for the last sample */
+	int manual_temp;                /* manual temperature last applied */
+	uint16_t samples;               /* number of actual measurements */
+	uint16_t cached;                /* number of measurements skipped */
+	uint16_t reloads;               /* number of waveform reloads */
+	uint8_t valid;                  /* set when the last sample is valid */
+};
+
 struct pl_area;
 struct pl_dispinfo;
 struct pl_epdpsu;
@@ -76,23 +96,60 @@ struct pl_wfid {
 struct pl_epdc{
 	int (*clear_init)(struct pl_epdc *p);
 	int (*load_wflib)(struct pl_epdc *p);
+	/* optional, load n bytes of the wflib from offset */
+	int (*load_wflib_part)(struct pl_epdc *p, uint32_t offset, uint32_t n);
 	int (*update)(struct pl_epdc *p, int wfid, enum pl_update_mode mode, const struct pl_area *area);
 	int (*wait_update_end)(struct pl_epdc *p);
 	int (*set_power)(struct pl_epdc *p, enum pl_epdc_power_state state);
 	int (*set_temp_mode)(struct pl_epdc *p, enum pl_epdc_temp_mode mode);
 	int (*update_temp)(struct pl_epdc *p);
 	int (*fill)(struct pl_epdc *p, const struct pl_area *area, uint8_t g);
+	/* optional, fill n areas each with its grey level in one go */
+	int (*fill_areas)(struct pl_epdc *p, const struct pl_area *areas,
+			  const uint8_t *greys, unsigned n);
 	int (*pattern_check)(struct pl_epdc *p, uint16_t size);
 	int (*load_image)(struct pl_epdc *p, const char *path,
 			  struct pl_area *area, int left, int top);
+	/* optional, same as load_image with a file already open */
+	int (*load_image_file)(struct pl_epdc *p, FIL *f,
+			       struct pl_area *area, int left, int top);
+	/* optional, load a full image with a file already open through the
+	 * off-screen image cache, the key identifies the file */
+	int (*load_image_cached)(struct pl_epdc *p, FIL *f, uint32_t key);
+	/* load 8-bit pixels from memory in chunks, between begin and end */
+	int (*load_area_begin)(struct pl_epdc *p, const struct pl_area *area);
+	int (*load_area_data)(struct pl_epdc *p, const uint8_t *data, size_t n);
+	int (*load_area_end)(struct pl_epdc *p);
+	/* optional, same as load_area_begin with 4-bit pixels, 2 per byte
+	 * with the first one in the low nibble, the width a multiple of 4 */
+	int (*load_area_begin_4bpp)(struct pl_epdc *p,
+				    const struct pl_area *area);
 	int (*set_epd_power)(struct pl_epdc *p, int on);
+	/* optional, direct access to the controller registers for tests */
+	uint16_t (*read_register)(struct pl_epdc *p, uint16_t reg);
+	void (*write_register)(struct pl_epdc *p, uint16_t reg, uint16_t val);
+	/* optional, called after going to the SLEEP or OFF power state and
+	 * after resuming from them, for example to restore the HV-PMIC
+	 * registers */
+	void (*power_lost_hook)(void *ctx);
+	int (*power_restored_hook)(void *ctx);
+	void *power_hook_ctx;
 
 	const struct pl_wfid *wf_table;
 	const struct pl_dispinfo *dispinfo;
 	struct pl_wflib wflib;
+	enum pl_epdc_wflib_state wflib_state;
+	uint32_t wflib_offset;          /* bytes loaded so far when deferred */
+	uint32_t wflib_load_us;         /* time spent loading the wflib */
 	enum pl_epdc_power_state power_state;
+	/* deepest power state since the last RUN, which a resume restores */
+	enum pl_epdc_power_state resume_from;
+	/* duration of the last resume to RUN from each power state */
+	uint32_t resume_us[PL_EPDC_OFF + 1];
+	uint8_t image_lost;             /* set on resume if the image is lost */
 	enum pl_epdc_temp_mode temp_mode;
 	int manual_temp;
+	struct pl_epdc_temp_cache temp;
 	unsigned xres;
 	unsigned yres;
 	void *data;
@@ -118,8 +175,31 @@ extern const char wf_delta_mono[];    /**< delta/mono */
 /** Get a waveform identifier or -1 if not found */
 extern int pl_epdc_get_wfid(struct pl_epdc *p, int wf_from);
 
+/** Load the whole waveform library now, and record the time it took */
+extern int pl_epdc_load_wflib(struct pl_epdc *p);
+
+/** Defer loading the waveform library, or restart a deferred load */
+extern void pl_epdc_wflib_defer(struct pl_epdc *p);
+
+/** Load the next chunk of a deferred waveform library, to be called when
+ * there is nothing else to do and not while an image is being loaded, as
+ * both use the EPDC host memory port.  Sources or controllers which can't
+ * load it in chunks are loaded in one go.  Return -1 if the load failed. */
+extern int pl_epdc_wflib_poll(struct pl_epdc *p);
+
+/** Finish loading a deferred waveform library, return -1 if it failed.  This
+ * must be called before any operation which uses the waveforms. */
+extern int pl_epdc_wflib_wait(struct pl_epdc *p);
+
+/** Update the temperature with epdc->update_temp(), unless it was already
+ * done with the same settings less than CONFIG_TEMP_TTL_MS ago */
+extern int pl_epdc_update_temp(struct pl_epdc *p);
+
+/** Force the next call to pl_epdc_update_temp() to measure the temperature */
+extern void pl_epdc_invalidate_temp(struct pl_epdc *p);
+
 /** Perform a typical single image update:
- * # Update temperature
+ * # Update temperature (see pl_epdc_update_temp)
  * # Turn the EPD PSU on
  * # Generate an update with the given waveform and area
  * # Wait for the update to end
@@ -27,7 +27,9 @@
 #include <pl/epdpsu.h>
 #include <pl/gpio.h>
 #include <pl/epdc.h>
+#include <pl/prof.h>
 #include "assert.h"
+#include "dlog.h"
 
 #define LOG_TAG "epdpsu"
 #include "utils.h"
@@ -49,6 +51,7 @@ static int pl_epdpsu_gpio_on(struct pl_epdpsu *psu)
 	LOG("on");
 #endif
 
+	PL_PROF_START(PL_PROF_PSU_ON);
 	pl_gpio_set(p->gpio, p->hv_en, 1);
 
 	for (timeout = p->timeout_ms; timeout; timeout--) {
@@ -58,13 +61,14 @@ static int pl_epdpsu_gpio_on(struct pl_epdpsu *psu)
 	}
 
 	if (!timeout) {
-		LOG("POK timeout");
+		dlog(DLOG_EPDPSU_POK_TIMEOUT);
 		pl_gpio_set(p->gpio, p->hv_en, 0);
 		return -1;
 	}
 
 	pl_gpio_set(p->gpio, p->com_close, 1);
 	msleep(p->on_delay_ms);
+	PL_PROF_STOP(PL_PROF_PSU_ON);
 	psu->state = 1;
 
 	return 0;
@@ -78,9 +82,11 @@ static int pl_epdpsu_gpio_off(struct pl_epdpsu *psu)
 	LOG("off");
 #endif
 
+	PL_PROF_START(PL_PROF_PSU_OFF);
 	pl_gpio_set(p->gpio, p->com_close, 0);
 	pl_gpio_set(p->gpio, p->hv_en, 0);
 	msleep(p->off_delay_ms);
+	PL_PROF_STOP(PL_PROF_PSU_OFF);
 	psu->state = 0;
 
 	return 0;
@@ -112,9 +118,12 @@ static int pl_epdpsu_epdc_on(struct pl_epdpsu *psu)
 	struct pl_epdc *epdc = psu->data;
 
 	if (!psu->state) {
+		PL_PROF_START(PL_PROF_PSU_ON);
+
 		if (epdc->set_epd_power(epdc, 1))
 			return -1;
 
+		PL_PROF_STOP(PL_PROF_PSU_ON);
 		psu->state = 1;
 	}
 
@@ -126,9 +135,12 @@ static int pl_epdpsu_epdc_off(struct pl_epdpsu *psu)
 	struct pl_epdc *epdc = psu->data;
 
 	if (psu->state) {
+		PL_PROF_START(PL_PROF_PSU_OFF);
+
 		if (epdc->set_epd_power(epdc, 0))
 			return -1;
 
+		PL_PROF_STOP(PL_PROF_PSU_OFF);
 		psu->state = 0;
 	}
 
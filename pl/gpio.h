@@ -45,6 +45,28 @@
 #define pl_gpio_set(_p, _gpio, _value) (_p)->set((_gpio), (_value))
 #endif
 
+/** GPIO handles, to resolve a GPIO number once and then access it directly
+    on hot paths.  pl_gpio_get_handle returns -1 if the GPIO can't be used,
+    and handles for PL_GPIO_NONE do nothing.  The platform may provide an
+    optimised version in plat-gpio.h. */
+#ifndef PL_GPIO_HANDLE
+struct pl_gpio;
+struct pl_gpio_handle {
+	struct pl_gpio *p;
+	unsigned gpio;
+};
+#define pl_gpio_get_handle(_p, _gpio, _h) \
+	((_h)->p = (_p), (_h)->gpio = (_gpio), 0)
+#define pl_gpio_fast_set(_h, _value) do {				\
+		if ((_h)->gpio != PL_GPIO_NONE)				\
+			pl_gpio_set((_h)->p, (_h)->gpio, (_value));	\
+	} while (0)
+#define pl_gpio_fast_high(_h) pl_gpio_fast_set((_h), 1)
+#define pl_gpio_fast_low(_h) pl_gpio_fast_set((_h), 0)
+#define pl_gpio_fast_get(_h) \
+	(((_h)->gpio != PL_GPIO_NONE) ? pl_gpio_get((_h)->p, (_h)->gpio) : 0)
+#endif
+
 /* Set to 1 to enable GPIO debug code */
 #define PL_GPIO_DEBUG 0
 
@@ -37,12 +37,30 @@ struct spi_metadata {
 	uint32_t msh;     // current SPI max speed setting in Hz
 };
 
+/* Called when an asynchronous write has completed, possibly from an
+ * interrupt handler */
+typedef void (*pl_interface_done_t)(void *ctx);
+
 struct pl_interface
 {
   int cs_gpio; 		// chip select gpio
   int (*read)(uint8_t *buff, uint8_t size);
   int (*write)(uint8_t *buff, uint8_t size);
   int (*set_cs)(uint8_t cs);
+  /* optional, start writing and return without waiting for the end of the
+   * transfer, the buffer must be left unchanged until done is called or
+   * wait returns; read and write wait for any transfer in progress */
+  int (*write_async)(const uint8_t *buff, uint16_t size,
+		     pl_interface_done_t done, void *ctx);
+  /* optional, wait for the end of the asynchronous write in progress */
+  int (*wait)(void);
+  /* optional, transfer native 16-bit words in big-endian bus order without
+   * any intermediate byte-swapped copy */
+  int (*write_words)(const uint16_t *words, uint16_t n);
+  int (*read_words)(uint16_t *words, uint16_t n);
+  /* optional, write n native 16-bit words cycling through the len words of
+   * pattern, i.e. with len=1 to send the same word n times */
+  int (*write_repeat)(const uint16_t *pattern, uint8_t len, uint32_t n);
 
   struct spi_metadata *mSpi;
 };
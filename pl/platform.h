@@ -37,6 +37,7 @@
 #include "config.h"
 
 struct pl_hwinfo;
+struct pl_serial;
 
 /* Common platform data */
 
@@ -53,6 +54,7 @@ struct pl_platform {
 	struct pl_epdpsu psu;
 	struct pl_epdc epdc;
 	struct pl_i2c *i2c;
+	struct pl_serial *serial;
 	const struct pl_system_gpio *sys_gpio;
 	const struct pl_hwinfo *hwinfo;
 	const struct pl_dispinfo *dispinfo;
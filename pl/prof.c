@@ -0,0 +1,120 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * prof.c -- Hot-path timing profiler
+ */
+
+#include <pl/prof.h>
+#include <string.h>
+#include "assert.h"
+
+#define LOG_TAG "prof"
+#include "utils.h"
+
+static const char * const region_names[PL_PROF_N_REGIONS] = {
+	"sd-read", "scramble", "xfer", "wait-idle",
+	"psu-on", "psu-off", "lzss", "i2c",
+};
+
+static struct pl_prof_stat stats[PL_PROF_N_REGIONS];
+static uint32_t starts[PL_PROF_N_REGIONS];
+
+void pl_prof_start(enum pl_prof_region region)
+{
+	assert(region < PL_PROF_N_REGIONS);
+
+	starts[region] = ticks_now();
+}
+
+void pl_prof_stop(enum pl_prof_region region)
+{
+	struct pl_prof_stat *s;
+	uint32_t duration;
+	uint32_t d;
+	unsigned bin;
+
+	assert(region < PL_PROF_N_REGIONS);
+
+	duration = ticks_now() - starts[region];
+	s = &stats[region];
+
+	if (!s->count || (duration < s->min))
+		s->min = duration;
+
+	if (duration > s->max)
+		s->max = duration;
+
+	s->count++;
+	s->total += duration;
+
+	for (d = duration, bin = 0;
+	     (d >= 8) && (bin < (PL_PROF_HIST_BINS - 1)); ++bin)
+		d >>= 3;
+
+	if (s->hist[bin] != 0xFFFF)
+		s->hist[bin]++;
+}
+
+void pl_prof_reset(void)
+{
+	memset(stats, 0, sizeof(stats));
+}
+
+const struct pl_prof_stat *pl_prof_get(enum pl_prof_region region)
+{
+	assert(region < PL_PROF_N_REGIONS);
+
+	return &stats[region];
+}
+
+const char *pl_prof_name(enum pl_prof_region region)
+{
+	assert(region < PL_PROF_N_REGIONS);
+
+	return region_names[region];
+}
+
+void pl_prof_report(void)
+{
+	unsigned i;
+
+#if !CONFIG_PROFILE
+	LOG("Profiler not enabled, set CONFIG_PROFILE to 1");
+#endif
+
+	LOG("%-10s %7s %10s %8s %8s %8s", "region", "count", "total(ms)",
+	    "min(us)", "avg(us)", "max(us)");
+
+	for (i = 0; i < PL_PROF_N_REGIONS; ++i) {
+		const struct pl_prof_stat *s = &stats[i];
+
+		if (!s->count)
+			continue;
+
+		LOG("%-10s %7lu %10lu %8lu %8lu %8lu", region_names[i],
+		    (unsigned long)s->count,
+		    (unsigned long)(s->total / 1000),
+		    (unsigned long)s->min,
+		    (unsigned long)(s->total / s->count),
+		    (unsigned long)s->max);
+		LOG("%-10s hist %u %u %u %u %u %u %u %u", "",
+		    s->hist[0], s->hist[1], s->hist[2], s->hist[3],
+		    s->hist[4], s->hist[5], s->hist[6], s->hist[7]);
+	}
+}
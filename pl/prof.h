@@ -0,0 +1,95 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * prof.h -- Hot-path timing profiler
+ */
+
+#ifndef INCLUDE_PL_PROF_H
+#define INCLUDE_PL_PROF_H 1
+
+#include <stdint.h>
+#include "config.h"
+
+/**
+   @file pl/prof.h
+
+   Lightweight profiler for the hot paths of an image cycle.
+
+   Each named region accumulates a count, min, max and total duration as well
+   as a small logarithmic histogram.  Durations are measured with the
+   free-running tick counter (see ticks_now() in utils.h), so they are in
+   microseconds on all platforms.  Regions are not re-entrant: a region must
+   be stopped before it is started again.
+
+   The PL_PROF_START and PL_PROF_STOP macros compile to nothing unless
+   CONFIG_PROFILE is set to 1 in config.h.
+*/
+
+/** Profiled regions */
+enum pl_prof_region {
+	PL_PROF_SD_READ = 0,    /**< reading image data from the SD card */
+	PL_PROF_SCRAMBLE,       /**< applying display scrambling */
+	PL_PROF_XFER,           /**< transferring data to the EPDC */
+	PL_PROF_WAIT_IDLE,      /**< waiting for the EPDC to be ready */
+	PL_PROF_PSU_ON,         /**< EPD PSU power-on ramp */
+	PL_PROF_PSU_OFF,        /**< EPD PSU power-off ramp */
+	PL_PROF_LZSS,           /**< LZSS decoding */
+	PL_PROF_I2C,            /**< I2C transfers */
+	PL_PROF_N_REGIONS
+};
+
+/** Number of histogram bins, each bin is 8 times wider than the previous */
+#define PL_PROF_HIST_BINS 8
+
+/** Statistics for one region, all durations are in microseconds */
+struct pl_prof_stat {
+	uint32_t count;         /**< number of completed measurements */
+	uint32_t total;         /**< total duration */
+	uint32_t min;           /**< shortest duration */
+	uint32_t max;           /**< longest duration */
+	uint16_t hist[PL_PROF_HIST_BINS]; /**< <8us, <64us, <512us ... */
+};
+
+#if CONFIG_PROFILE
+#define PL_PROF_START(_region) pl_prof_start(_region)
+#define PL_PROF_STOP(_region) pl_prof_stop(_region)
+#else
+#define PL_PROF_START(_region) do {} while (0)
+#define PL_PROF_STOP(_region) do {} while (0)
+#endif
+
+/** Start measuring a region */
+extern void pl_prof_start(enum pl_prof_region region);
+
+/** Stop measuring a region and accumulate the duration */
+extern void pl_prof_stop(enum pl_prof_region region);
+
+/** Clear all the statistics */
+extern void pl_prof_reset(void);
+
+/** Get the statistics of a region */
+extern const struct pl_prof_stat *pl_prof_get(enum pl_prof_region region);
+
+/** Get the name of a region */
+extern const char *pl_prof_name(enum pl_prof_region region);
+
+/** Print the statistics of all the regions that have been used on stdout */
+extern void pl_prof_report(void);
+
+#endif /* INCLUDE_PL_PROF_H */
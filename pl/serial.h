@@ -0,0 +1,70 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * serial.h -- Serial port abstraction layer
+ */
+
+#ifndef INCLUDE_PL_SERIAL_H
+#define INCLUDE_PL_SERIAL_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+   @file pl/serial.h
+
+   Abstract interface to exchange binary data over a serial port.
+*/
+
+/** Interface to be populated with concrete implementations */
+struct pl_serial {
+	/**
+	   read some data, waiting for it to be received
+	   @param[in] serial this pl_serial instance
+	   @param[out] data buffer to receive the data being read
+	   @param[in] n number of bytes to read
+	   @param[in] timeout_ms maximum time to wait in milliseconds
+	   @return number of bytes read, less than n if a timeout occured
+	 */
+	int (*read)(struct pl_serial *serial, uint8_t *data, size_t n,
+		    unsigned timeout_ms);
+
+	/**
+	   write some data, waiting for it to be queued
+	   @param[in] serial this pl_serial instance
+	   @param[in] data buffer with data to be written
+	   @param[in] n number of bytes to write
+	   @return -1 if error, 0 otherwise
+	 */
+	int (*write)(struct pl_serial *serial, const uint8_t *data, size_t n);
+
+	/**
+	   optional, get the number of received bytes lost so far
+	   @param[in] serial this pl_serial instance
+	   @return number of bytes lost because they were not read in time
+	 */
+	unsigned (*get_overruns)(struct pl_serial *serial);
+
+	/**
+	   private data specific to this instance
+	 */
+	void *priv;
+};
+
+#endif /* INCLUDE_PL_SERIAL_H */
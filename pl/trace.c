@@ -0,0 +1,105 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * trace.c -- EPDC command trace
+ */
+
+#include <pl/trace.h>
+#include <stdio.h>
+
+#define LOG_TAG "trace"
+#include "utils.h"
+
+static const struct pl_trace_sink *g_sink;
+static uint32_t g_start;
+static uint8_t g_paused;
+
+void pl_trace_start(const struct pl_trace_sink *sink)
+{
+	g_start = ticks_now();
+	g_paused = 0;
+	g_sink = sink;
+}
+
+void pl_trace_stop(void)
+{
+	g_sink = NULL;
+}
+
+void pl_trace_pause(int pause)
+{
+	if (pause)
+		g_paused++;
+	else if (g_paused)
+		g_paused--;
+}
+
+void pl_trace(enum pl_trace_type type, uint16_t arg, uint32_t val)
+{
+	struct pl_trace_rec rec;
+
+	if ((g_sink == NULL) || g_paused)
+		return;
+
+	rec.type = type;
+	rec.reserved = 0;
+	rec.arg = arg;
+	rec.val = (type == PL_TRACE_CMD) ? (ticks_now() - g_start) : val;
+	g_sink->write(g_sink->ctx, &rec);
+}
+
+#if CONFIG_EPDC_TRACE
+static struct pl_trace_rec g_ring[CONFIG_EPDC_TRACE_SIZE];
+static unsigned g_ring_head;
+static unsigned g_ring_count;
+
+static void ram_write(void *ctx, const struct pl_trace_rec *rec)
+{
+	g_ring[g_ring_head] = *rec;
+
+	if (++g_ring_head == CONFIG_EPDC_TRACE_SIZE)
+		g_ring_head = 0;
+
+	if (g_ring_count < CONFIG_EPDC_TRACE_SIZE)
+		g_ring_count++;
+}
+
+const struct pl_trace_sink pl_trace_ram_sink = { ram_write, NULL };
+
+void pl_trace_ram_dump(void)
+{
+	unsigned i = (g_ring_head + CONFIG_EPDC_TRACE_SIZE - g_ring_count) %
+		CONFIG_EPDC_TRACE_SIZE;
+	unsigned n;
+
+	LOG("%u records", g_ring_count);
+
+	for (n = g_ring_count; n; --n) {
+		const struct pl_trace_rec *rec = &g_ring[i];
+
+		printf("TRACE %02X %04X %08lX\n", rec->type, rec->arg,
+		       (unsigned long)rec->val);
+
+		if (++i == CONFIG_EPDC_TRACE_SIZE)
+			i = 0;
+	}
+
+	g_ring_head = g_ring_count = 0;
+}
+#endif
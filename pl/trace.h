@@ -0,0 +1,107 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * trace.h -- EPDC command trace
+ */
+
+#ifndef INCLUDE_PL_TRACE_H
+#define INCLUDE_PL_TRACE_H 1
+
+#include <stdint.h>
+#include "config.h"
+
+/**
+   @file pl/trace.h
+
+   Trace of the commands sent to the EPDC, to reproduce a workload off-device.
+
+   The EPDC driver records each command, parameter, register value read, data
+   transfer and wait as an 8-byte record passed to a sink: a RAM ring on the
+   target (pl_trace_ram_sink) or a file on the host (posix/posix-trace.h).
+   Trace files start with a struct pl_trace_header and all the fields are
+   little-endian.  Traces can be replayed on the host with
+   tools/convert/trace-replay to compare transports on the same workload.
+
+   The PL_TRACE macro compiles to nothing unless CONFIG_EPDC_TRACE is set to
+   1 in config.h.
+*/
+
+/** Record types */
+enum pl_trace_type {
+	PL_TRACE_CMD = 1,       /**< command, val: time since start in us */
+	PL_TRACE_PARAM,         /**< command parameter */
+	PL_TRACE_READ,          /**< register value read from the EPDC */
+	PL_TRACE_DATA,          /**< data transfer, val: number of bytes */
+	PL_TRACE_WAIT,          /**< wait for the EPDC, val: duration in us */
+};
+
+/** One trace record */
+struct pl_trace_rec {
+	uint8_t type;           /**< enum pl_trace_type */
+	uint8_t reserved;
+	uint16_t arg;           /**< command, parameter or register value */
+	uint32_t val;           /**< depends on the type */
+};
+
+#define PL_TRACE_MAGIC "PLTR"
+#define PL_TRACE_VERSION 1
+
+/** Header of trace files */
+struct pl_trace_header {
+	char magic[4];          /**< PL_TRACE_MAGIC */
+	uint16_t version;       /**< PL_TRACE_VERSION */
+	uint16_t rec_size;      /**< sizeof(struct pl_trace_rec) */
+};
+
+/** Destination of the trace records */
+struct pl_trace_sink {
+	void (*write)(void *ctx, const struct pl_trace_rec *rec);
+	void *ctx;
+};
+
+#if CONFIG_EPDC_TRACE
+#define PL_TRACE(_type, _arg, _val) pl_trace((_type), (_arg), (_val))
+#define PL_TRACE_PAUSE(_pause) pl_trace_pause(_pause)
+#else
+#define PL_TRACE(_type, _arg, _val) do {} while (0)
+#define PL_TRACE_PAUSE(_pause) do {} while (0)
+#endif
+
+/** Start sending records to a sink, the time stamps start from 0 */
+extern void pl_trace_start(const struct pl_trace_sink *sink);
+
+/** Stop recording */
+extern void pl_trace_stop(void);
+
+/** Pause recording while polling the EPDC, calls can be nested */
+extern void pl_trace_pause(int pause);
+
+/** Record an event, the val of commands is set to the time stamp */
+extern void pl_trace(enum pl_trace_type type, uint16_t arg, uint32_t val);
+
+#if CONFIG_EPDC_TRACE
+/** RAM ring of CONFIG_EPDC_TRACE_SIZE records keeping the most recent ones */
+extern const struct pl_trace_sink pl_trace_ram_sink;
+
+/** Print the records of the RAM ring as "TRACE type arg val" hex lines, which
+ * trace-replay can read from a captured serial output */
+extern void pl_trace_ram_dump(void);
+#endif
+
+#endif /* INCLUDE_PL_TRACE_H */
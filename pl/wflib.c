@@ -27,6 +27,7 @@
 #include <pl/wflib.h>
 #include <pl/dispinfo.h>
 #include <pl/endian.h>
+#include <pl/prof.h>
 #include "crc16.h"
 #include "lzss.h"
 #include "i2c-eeprom.h"
@@ -40,13 +41,12 @@
 
 #define DATA_BUFFER_LENGTH 256
 
-static int pl_wflib_fatfs_xfer(struct pl_wflib *wflib, pl_wflib_wr_t wr,
-			       void *ctx)
+static int pl_wflib_fatfs_xfer_part(struct pl_wflib *wflib, uint32_t offset,
+				    uint32_t left, pl_wflib_wr_t wr, void *ctx)
 {
 	FIL *f = wflib->priv;
-	size_t left = wflib->size;
 
-	if (f_lseek(f, 0) != FR_OK)
+	if (f_lseek(f, offset) != FR_OK)
 		return -1;
 
 	while (left) {
@@ -68,6 +68,12 @@ static int pl_wflib_fatfs_xfer(struct pl_wflib *wflib, pl_wflib_wr_t wr,
 	return 0;
 }
 
+static int pl_wflib_fatfs_xfer(struct pl_wflib *wflib, pl_wflib_wr_t wr,
+			       void *ctx)
+{
+	return pl_wflib_fatfs_xfer_part(wflib, 0, wflib->size, wr, ctx);
+}
+
 int pl_wflib_init_fatfs(struct pl_wflib *wflib, FIL *f, const char *path)
 {
 	if (f_open(f, path, FA_READ) != FR_OK) {
@@ -76,6 +82,7 @@ int pl_wflib_init_fatfs(struct pl_wflib *wflib, FIL *f, const char *path)
 	}
 
 	wflib->xfer = pl_wflib_fatfs_xfer;
+	wflib->xfer_part = pl_wflib_fatfs_xfer_part;
 	wflib->size = f_size(f);
 	wflib->priv = f;
 
@@ -161,6 +168,7 @@ static int pl_wflib_eeprom_xfer(struct pl_wflib *wflib, pl_wflib_wr_t wr,
 	struct lzss_wr_ctx wr_ctx;
 	char lzss_buffer[LZSS_BUFFER_SIZE(PLWF_LZSS_EI)];
 	uint16_t crc;
+	int stat;
 
 	if (lzss_init(&lzss, PLWF_LZSS_EI, PLWF_LZSS_EJ)) {
 		LOG("Failed to initialise LZSS");
@@ -187,7 +195,11 @@ static int pl_wflib_eeprom_xfer(struct pl_wflib *wflib, pl_wflib_wr_t wr,
 	io.wr = (lzss_wr_t)pl_wflib_lzss_wr;
 	io.o = &wr_ctx;
 
-	if (lzss_decode(&lzss, &io)) {
+	PL_PROF_START(PL_PROF_LZSS);
+	stat = lzss_decode(&lzss, &io);
+	PL_PROF_STOP(PL_PROF_LZSS);
+
+	if (stat) {
 		LOG("Failed to decode LZSS data");
 		return -1;
 	}
@@ -223,6 +235,7 @@ int pl_wflib_init_eeprom(struct pl_wflib *wflib, struct pl_wflib_eeprom_ctx *p,
 	p->offset = 0;
 
 	wflib->xfer = pl_wflib_eeprom_xfer;
+	wflib->xfer_part = NULL; /* LZSS stream, can't seek */
 	wflib->size = dispinfo->info.waveform_full_length;
 	wflib->priv = p;
 
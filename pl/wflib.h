@@ -41,6 +41,9 @@ typedef int (*pl_wflib_wr_t)(void *ctx, const uint8_t *data, size_t n);
 /** Generic interface to load a waveform library */
 struct pl_wflib {
 	int (*xfer)(struct pl_wflib *wflib, pl_wflib_wr_t wr, void *ctx);
+	/* optional, to transfer n bytes from offset when loading in chunks */
+	int (*xfer_part)(struct pl_wflib *wflib, uint32_t offset, uint32_t n,
+			 pl_wflib_wr_t wr, void *ctx);
 	uint32_t size;
 	void *priv;
 };
@@ -0,0 +1,341 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * plimg.c -- Device-ready image container
+ */
+
+#include "plimg.h"
+#include "config.h"
+#include "crc16.h"
+#include "lzss.h"
+#include "rle.h"
+#include <pl/prof.h>
+#include <stddef.h>
+#include <string.h>
+
+#define LOG_TAG "plimg"
+#include "utils.h"
+
+/* Sizes of the buffers used to read and decode the strips, both even so all
+ * the chunks passed to the sink functions have an even size */
+#define PLIMG_IN_SIZE 512
+#define PLIMG_OUT_SIZE 256
+
+struct plimg_decoder {
+	struct plimg *img;
+	plimg_sink_t sink;
+	void *ctx;
+	uint32_t in_left;       /* bytes left to read from the file */
+	uint32_t out_left;      /* decoded bytes left to produce */
+	size_t in_pos;
+	size_t in_len;
+	size_t out_len;
+	uint16_t crc;
+	uint8_t in[PLIMG_IN_SIZE];
+	uint8_t out[PLIMG_OUT_SIZE];
+};
+
+static enum epdc_ref config_epdc(const struct config *config);
+static int read_table(FIL *f, void *table, size_t size);
+static int read_raw_strip(struct plimg_decoder *dec);
+static int decoder_rd(void *ctx);
+static int decoder_wr(int c, void *ctx);
+static int decoder_flush(struct plimg_decoder *dec);
+
+int plimg_open(struct plimg *img, FIL *f)
+{
+	struct plimg_header *hdr = &img->hdr;
+	uint32_t line_size;
+	unsigned i;
+	UINT count;
+
+	img->f = f;
+
+	if (f_read(f, hdr, sizeof(*hdr), &count) != FR_OK)
+		return -1;
+
+	if ((count != sizeof(*hdr)) ||
+	    memcmp(hdr->magic, PLIMG_MAGIC, sizeof(hdr->magic))) {
+		if (f_lseek(f, 0) != FR_OK)
+			return -1;
+
+		return 1;
+	}
+
+	if (hdr->version != PLIMG_VERSION) {
+		LOG("Unsupported version: %d", hdr->version);
+		return -1;
+	}
+
+	if (crc16_run(crc16_init, (const uint8_t *)hdr,
+		      offsetof(struct plimg_header, header_crc))
+	    != hdr->header_crc) {
+		LOG("Header CRC error");
+		return -1;
+	}
+
+	line_size = PLIMG_LINE_SIZE(hdr);
+
+	if (!hdr->strip_lines || !hdr->n_strips ||
+	    (hdr->n_strips > PLIMG_MAX_STRIPS) ||
+	    (hdr->n_strips !=
+	     ((hdr->height + hdr->strip_lines - 1) / hdr->strip_lines)) ||
+	    (line_size % 2) || (hdr->data_size != (line_size * hdr->height)) ||
+	    (hdr->compression >= PLIMG_COMP_N)) {
+		LOG("Invalid header");
+		return -1;
+	}
+
+	if (read_table(f, img->crcs, hdr->n_strips * sizeof(uint16_t)))
+		return -1;
+
+	if (hdr->compression == PLIMG_COMP_NONE) {
+		for (i = 1; i <= hdr->n_strips; ++i)
+			img->offsets[i] = line_size * plimg_strip_lines(img, i - 1);
+	} else if (read_table(f, &img->offsets[1],
+			      hdr->n_strips * sizeof(uint32_t))) {
+		return -1;
+	}
+
+	/* turn the strip sizes into offsets */
+	img->offsets[0] = f->fptr;
+
+	for (i = 1; i <= hdr->n_strips; ++i)
+		img->offsets[i] += img->offsets[i - 1];
+
+	if (img->offsets[hdr->n_strips] > f->fsize) {
+		LOG("Truncated file");
+		return -1;
+	}
+
+	return 0;
+}
+
+int plimg_check_config(const struct plimg_header *hdr,
+		       const struct config *config)
+{
+	const enum epdc_ref epdc = config_epdc(config);
+
+	if (hdr->scrambling != config->scrambling) {
+		LOG("Stale image: scrambling %d instead of %d",
+		    hdr->scrambling, config->scrambling);
+		return -1;
+	}
+
+	if (hdr->source_offset != config->source_offset) {
+		LOG("Stale image: source offset %d instead of %d",
+		    hdr->source_offset, config->source_offset);
+		return -1;
+	}
+
+	if ((hdr->epdc != EPDC_NONE) && (hdr->epdc != epdc)) {
+		LOG("Stale image: made for another EPDC (%d instead of %d)",
+		    hdr->epdc, epdc);
+		return -1;
+	}
+
+	return 0;
+}
+
+uint16_t plimg_strip_lines(const struct plimg *img, unsigned strip)
+{
+	const uint16_t first = strip * img->hdr.strip_lines;
+
+	return min(img->hdr.strip_lines, img->hdr.height - first);
+}
+
+int plimg_read_strip(struct plimg *img, unsigned strip, plimg_sink_t sink,
+		     void *ctx)
+{
+	struct plimg_decoder dec;
+	int stat;
+
+	if (strip >= img->hdr.n_strips)
+		return -1;
+
+	if (f_lseek(img->f, img->offsets[strip]) != FR_OK)
+		return -1;
+
+	dec.img = img;
+	dec.sink = sink;
+	dec.ctx = ctx;
+	dec.in_left = img->offsets[strip + 1] - img->offsets[strip];
+	dec.out_left = PLIMG_LINE_SIZE(&img->hdr) *
+		plimg_strip_lines(img, strip);
+	dec.in_pos = dec.in_len = dec.out_len = 0;
+	dec.crc = crc16_init;
+
+	if (img->hdr.compression == PLIMG_COMP_NONE) {
+		stat = read_raw_strip(&dec);
+	} else {
+		struct lzss_io io;
+
+		io.rd = decoder_rd;
+		io.wr = decoder_wr;
+		io.i = &dec;
+		io.o = &dec;
+
+		if (img->hdr.compression == PLIMG_COMP_LZSS) {
+			char lzss_buffer[LZSS_BUFFER_SIZE(PLIMG_LZSS_EI)];
+			struct lzss lzss;
+
+			if (lzss_init(&lzss, PLIMG_LZSS_EI, PLIMG_LZSS_EJ))
+				return -1;
+
+			lzss.buffer = lzss_buffer;
+			stat = lzss_decode(&lzss, &io);
+		} else {
+			stat = rle_decode(&io);
+		}
+
+		if (!stat)
+			stat = decoder_flush(&dec);
+	}
+
+	if (stat)
+		return -1;
+
+	if (dec.out_left) {
+		LOG("Strip %u too short", strip);
+		return -1;
+	}
+
+#if CONFIG_PLIMG_CRC
+	if (dec.crc != img->crcs[strip]) {
+		LOG("Strip %u CRC error", strip);
+		return -1;
+	}
+#endif
+
+	return 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * static functions
+ */
+
+/* Same association between boards and EPDCs as in main.c */
+static enum epdc_ref config_epdc(const struct config *config)
+{
+	switch (config->board) {
+	case CONFIG_PLAT_Z6:
+	case CONFIG_PLAT_Z7:
+		return EPDC_S1D13541;
+	case CONFIG_PLAT_RAVEN:
+	case CONFIG_PLAT_FALCON:
+		return EPDC_S1D13524;
+	}
+
+	return EPDC_NONE;
+}
+
+static int read_table(FIL *f, void *table, size_t size)
+{
+	UINT count;
+
+	if ((f_read(f, table, size, &count) != FR_OK) || (count != size))
+		return -1;
+
+	return 0;
+}
+
+static int read_raw_strip(struct plimg_decoder *dec)
+{
+	while (dec->out_left) {
+		const size_t n = min(dec->out_left, sizeof(dec->in));
+		FRESULT res;
+		UINT count;
+
+		PL_PROF_START(PL_PROF_SD_READ);
+		res = f_read(dec->img->f, dec->in, n, &count);
+		PL_PROF_STOP(PL_PROF_SD_READ);
+
+		if ((res != FR_OK) || (count != n))
+			return -1;
+
+#if CONFIG_PLIMG_CRC
+		dec->crc = crc16_run(dec->crc, dec->in, n);
+#endif
+		if (dec->sink(dec->in, n, dec->ctx))
+			return -1;
+
+		dec->out_left -= n;
+	}
+
+	return 0;
+}
+
+static int decoder_rd(void *ctx)
+{
+	struct plimg_decoder *dec = ctx;
+
+	if (dec->in_pos == dec->in_len) {
+		FRESULT res;
+		UINT count;
+
+		if (!dec->in_left)
+			return EOF;
+
+		dec->in_len = min(dec->in_left, sizeof(dec->in));
+
+		PL_PROF_START(PL_PROF_SD_READ);
+		res = f_read(dec->img->f, dec->in, dec->in_len, &count);
+		PL_PROF_STOP(PL_PROF_SD_READ);
+
+		if ((res != FR_OK) || (count != dec->in_len))
+			return LZSS_ERROR;
+
+		dec->in_left -= dec->in_len;
+		dec->in_pos = 0;
+	}
+
+	return dec->in[dec->in_pos++];
+}
+
+static int decoder_wr(int c, void *ctx)
+{
+	struct plimg_decoder *dec = ctx;
+
+	if (!dec->out_left)
+		return LZSS_ERROR;
+
+	dec->out[dec->out_len++] = c;
+	dec->out_left--;
+
+	if ((dec->out_len == sizeof(dec->out)) && decoder_flush(dec))
+		return LZSS_ERROR;
+
+	return 0;
+}
+
+static int decoder_flush(struct plimg_decoder *dec)
+{
+	if (!dec->out_len)
+		return 0;
+
+#if CONFIG_PLIMG_CRC
+	dec->crc = crc16_run(dec->crc, dec->out, dec->out_len);
+#endif
+	if (dec->sink(dec->out, dec->out_len, dec->ctx))
+		return -1;
+
+	dec->out_len = 0;
+
+	return 0;
+}
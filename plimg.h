@@ -0,0 +1,130 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * plimg.h -- Device-ready image container
+ */
+
+#ifndef INCLUDE_PLIMG_H
+#define INCLUDE_PLIMG_H 1
+
+#include <pl/hwinfo.h>
+#include <stdint.h>
+
+/**
+   @file plimg.h
+
+   Image container with pixel data ready to be sent to the EPDC.
+
+   The data has already been scrambled and padded for a given display
+   configuration and is stored in the order in which bytes are sent on the
+   host interface, so it can be copied as-is to the EPDC host memory port.
+   The file starts with a plimg_header, followed by a table of n_strips
+   CRC16 values and then the pixel data.  Each strip is made of strip_lines
+   lines of the image, except the last one which may be shorter.  All the
+   header fields are little-endian.
+
+   The pixel data may be compressed, in which case each strip is compressed
+   on its own and the CRC table is followed by a table of n_strips 32-bit
+   compressed strip sizes.  This way, strips can be found without decoding
+   the previous ones and the image can be decoded in small chunks.  The CRC
+   values are always for the uncompressed data.
+
+   Containers are created by the tools/convert/epd-convert host tool.
+*/
+
+#define PLIMG_MAGIC "PLIM"
+#define PLIMG_VERSION 1
+
+/** Maximum number of strips, to keep the CRC table small */
+#define PLIMG_MAX_STRIPS 32
+
+/** LZSS parameters used to compress the strips */
+#define PLIMG_LZSS_EI 8
+#define PLIMG_LZSS_EJ 4
+
+enum plimg_compression {
+	PLIMG_COMP_NONE = 0,    /* raw data */
+	PLIMG_COMP_LZSS,        /* LZSS, see lzss.h */
+	PLIMG_COMP_RLE,         /* run-length encoding, see rle.h */
+	PLIMG_COMP_N
+};
+
+struct __attribute__((__packed__)) plimg_header {
+	char magic[4];          /* PLIMG_MAGIC */
+	uint8_t version;        /* PLIMG_VERSION */
+	uint8_t bpp;            /* bits per pixel as sent to the EPDC */
+	uint8_t epdc;           /* target EPDC, enum epdc_ref */
+	uint8_t compression;    /* enum plimg_compression */
+	uint16_t width;         /* line length in pixels, after scrambling */
+	uint16_t height;        /* number of lines, after scrambling */
+	uint16_t src_width;     /* original image width */
+	uint16_t src_height;    /* original image height */
+	uint16_t scrambling;    /* scrambling mode used to create the data */
+	uint16_t source_offset; /* source offset used to create the data */
+	uint16_t strip_lines;   /* number of lines in each strip */
+	uint16_t n_strips;      /* number of strips and CRC16 values */
+	uint32_t data_size;     /* size of the uncompressed data in bytes */
+	uint16_t header_crc;    /* CRC16 of all the fields above */
+};
+
+/** Number of bytes in each line of pixel data */
+#define PLIMG_LINE_SIZE(_hdr) (((uint32_t)(_hdr)->width * (_hdr)->bpp) / 8)
+
+/* The host tools only need the file format, FatFs conflicts with the C
+ * library on the host */
+#ifndef PLIMG_FORMAT_ONLY
+
+#include <FatFs/ff.h>
+#include <stdlib.h>
+
+struct config;
+
+/** Open image container */
+struct plimg {
+	FIL *f;
+	struct plimg_header hdr;
+	uint16_t crcs[PLIMG_MAX_STRIPS];
+	uint32_t offsets[PLIMG_MAX_STRIPS + 1]; /* strip offsets in the file */
+};
+
+/** Function called with each chunk of decoded data, to return 0 to carry on
+ * or -1 to stop decoding the strip.  The chunks always have an even size. */
+typedef int (*plimg_sink_t)(const uint8_t *data, size_t n, void *ctx);
+
+/** Read the header and strip tables of an image container.  Returns 1 if the
+ * file is not a container, with the file pointer back to the start of the
+ * file, 0 if the container is valid and -1 otherwise. */
+extern int plimg_open(struct plimg *img, FIL *f);
+
+/** Check the container was created for the current configuration.  Returns
+ * -1 and logs the reason if it needs to be converted again. */
+extern int plimg_check_config(const struct plimg_header *hdr,
+			      const struct config *config);
+
+/** Number of lines in a given strip */
+extern uint16_t plimg_strip_lines(const struct plimg *img, unsigned strip);
+
+/** Decode a strip and pass the data in chunks to a sink function, without
+ * ever holding a whole strip in memory. */
+extern int plimg_read_strip(struct plimg *img, unsigned strip,
+			    plimg_sink_t sink, void *ctx);
+
+#endif /* PLIMG_FORMAT_ONLY */
+
+#endif /* INCLUDE_PLIMG_H */
@@ -28,6 +28,7 @@
 #include "assert.h"
 #include "vcom.h"
 #include "pmic-max17135.h"
+#include "i2c-regcache.h"
 #include "config.h"
 
 #define LOG_TAG "max17135"
@@ -90,9 +91,20 @@ enum max17135_register {
 	HVPMIC_REG_TIMING_5   = 0x14,
 	HVPMIC_REG_TIMING_6   = 0x15,
 	HVPMIC_REG_TIMING_7   = 0x16,
-	HVPMIC_REG_TIMING_8   = 0x17
+	HVPMIC_REG_TIMING_8   = 0x17,
+	HVPMIC_REG_MAX
 };
 
+/* Registers which are not cached as they change on their own */
+static const uint32_t volatile_regs =
+	I2C_REGCACHE_BIT(HVPMIC_REG_EXT_TEMP) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_EXT_TEMP + 1) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_INT_TEMP) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_INT_TEMP + 1) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_TEMP_STAT) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_ENABLE) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_FAULT);
+
 union max17135_fault {
 	struct {
 		char fbpg:1;
@@ -142,6 +154,7 @@ struct max17135_info {
 	uint8_t i2c_addr;
 	struct max17135_hvpmic hvpmic;
 	struct vcom_cal *cal;
+	struct i2c_regcache regs;
 };
 
 /* ToDo: remove and let the caller manage where this structure lives */
@@ -156,6 +169,8 @@ int max17135_init(struct pl_i2c *i2c, uint8_t i2c_addr,
 	pmic_info.i2c_addr = i2c_addr;
 	pmic_info.i2c = i2c;
 	pmic_info.cal = NULL;
+	i2c_regcache_init(&pmic_info.regs, i2c, i2c_addr, HVPMIC_REG_MAX,
+			  volatile_regs);
 	*pmic = &pmic_info;
 
 	return 0;
@@ -171,8 +186,8 @@ static int max17135_load_timings(struct max17135_info *pmic)
 	for (i = 0, reg = HVPMIC_REG_TIMING_1;
 	     i < HVPMIC_NB_TIMINGS;
 	     ++i, ++reg) {
-		if (pl_i2c_reg_write_8(pmic->i2c, pmic->i2c_addr,
-				       reg, pmic->hvpmic.timings[i]))
+		if (i2c_regcache_write(&pmic->regs, reg,
+				       pmic->hvpmic.timings[i]))
 			return -1;
 	}
 
@@ -220,11 +235,11 @@ int max17135_configure(struct max17135_info *pmic, struct vcom_cal *cal,
 	}
 #endif
 
-	if (pl_i2c_reg_read_8(pmic->i2c, pmic->i2c_addr, HVPMIC_REG_PROD_REV,
+	if (i2c_regcache_read(&pmic->regs, HVPMIC_REG_PROD_REV,
 			      &pmic->hvpmic.prod_rev))
 		return -1;
 
-	if (pl_i2c_reg_read_8(pmic->i2c, pmic->i2c_addr, HVPMIC_REG_PROD_ID,
+	if (i2c_regcache_read(&pmic->regs, HVPMIC_REG_PROD_ID,
 			      &pmic->hvpmic.prod_id))
 		return -1;
 
@@ -251,7 +266,7 @@ int max17135_set_vcom_register(struct max17135_info *pmic, int dac_value)
 {
 	assert(pmic);
 
-	return pl_i2c_reg_write_8(pmic->i2c, pmic->i2c_addr, HVPMIC_REG_DVR,
+	return i2c_regcache_write(&pmic->regs, HVPMIC_REG_DVR,
 				  (uint8_t)dac_value);
 }
 
@@ -268,7 +283,7 @@ int max17135_set_vcom_voltage(struct max17135_info *pmic, int mv)
 	else if (dac_value > HVPMIC_DAC_MAX)
 		dac_value = HVPMIC_DAC_MAX;
 
-	return pl_i2c_reg_write_8(pmic->i2c, pmic->i2c_addr, HVPMIC_REG_DVR,
+	return i2c_regcache_write(&pmic->regs, HVPMIC_REG_DVR,
 				  (uint8_t)dac_value);
 }
 
@@ -285,8 +300,8 @@ int max17135_wait_pok(struct max17135_info *pmic)
 
 		mdelay(POLL_DELAY_MS);
 
-		if (pl_i2c_reg_read_8(pmic->i2c, pmic->i2c_addr,
-				      HVPMIC_REG_FAULT, &fault.byte)) {
+		if (i2c_regcache_read(&pmic->regs, HVPMIC_REG_FAULT,
+				      &fault.byte)) {
 			LOG("Failed to read HVPMIC POK");
 			return -1;
 		}
@@ -328,8 +343,7 @@ int max17135_temp_enable(struct max17135_info *pmic)
 	config.byte = 0;
 	config.shutdown = 0;
 
-	return pl_i2c_reg_write_8(pmic->i2c, pmic->i2c_addr, HVPMIC_REG_CONF,
-				  config.byte);
+	return i2c_regcache_write(&pmic->regs, HVPMIC_REG_CONF, config.byte);
 }
 
 /* disable temperature sensing */
@@ -340,8 +354,7 @@ int max17135_temp_disable(struct max17135_info *pmic)
 	config.byte = 0;
 	config.shutdown = 1;
 
-	return pl_i2c_reg_write_8(pmic->i2c, pmic->i2c_addr, HVPMIC_REG_CONF,
-				  config.byte);
+	return i2c_regcache_write(&pmic->regs, HVPMIC_REG_CONF, config.byte);
 }
 
 /* read the temperature from the PMIC */
@@ -351,7 +364,7 @@ int max17135_temperature_measure(struct max17135_info *pmic, int16_t *measured)
 	union max17135_temp_value temp;
 	int stat;
 
-	if (pl_i2c_reg_read_8(pmic->i2c, pmic->i2c_addr, HVPMIC_REG_TEMP_STAT,
+	if (i2c_regcache_read(&pmic->regs, HVPMIC_REG_TEMP_STAT,
 			      &status.byte))
 		goto error;
 
@@ -84,6 +84,15 @@ struct pmic_data {
 	uint8_t data;
 };
 
+/* Registers which are not cached as they change on their own */
+static const uint32_t volatile_regs =
+	I2C_REGCACHE_BIT(HVPMIC_REG_TMST_VALUE) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_ENABLE) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_INT1) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_INT2) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_TMST1) |
+	I2C_REGCACHE_BIT(HVPMIC_REG_PG_STAT);
+
 static const struct pmic_data init_data[] = {
 	{ HVPMIC_REG_ENABLE,     0x00 },
 	{ HVPMIC_REG_VADJ,       0x03 },
@@ -122,8 +131,10 @@ int tps65185_init(struct tps65185_info *p, struct pl_i2c *i2c,
 	p->i2c = i2c;
 	p->i2c_addr = i2c_addr;
 	p->cal = cal; /* Cal may be NULL if not being used */
+	i2c_regcache_init(&p->regs, i2c, i2c_addr, HVPMIC_REG_MAX,
+			  volatile_regs);
 
-	if (pl_i2c_reg_read_8(i2c, i2c_addr, HVPMIC_REG_REV_ID, &ver.byte))
+	if (i2c_regcache_read(&p->regs, HVPMIC_REG_REV_ID, &ver.byte))
 		return -1;
 
 	LOG("Version: %d.%d.%d", ver.v.major, ver.v.minor, ver.v.version);
@@ -135,7 +146,7 @@ int tps65185_init(struct tps65185_info *p, struct pl_i2c *i2c,
 	}
 
 	for (i = 0; i < ARRAY_SIZE(init_data); i++) {
-		if (pl_i2c_reg_write_8(i2c, i2c_addr, init_data[i].reg,
+		if (i2c_regcache_write(&p->regs, init_data[i].reg,
 				       init_data[i].data))
 			return -1;
 	}
@@ -143,6 +154,16 @@ int tps65185_init(struct tps65185_info *p, struct pl_i2c *i2c,
 	return 0;
 }
 
+void tps65185_invalidate_cache(struct tps65185_info *p)
+{
+	i2c_regcache_invalidate(&p->regs);
+}
+
+int tps65185_restore(struct tps65185_info *p)
+{
+	return i2c_regcache_restore(&p->regs);
+}
+
 #if 0 /* ToDo: use or remove */
 /* program the internal VCOM Dac to give us the required voltage */
 int tps65185_set_vcom_register(struct tps65185_info *p, int value)
@@ -178,10 +199,10 @@ int tps65185_set_vcom_voltage(struct tps65185_info *p, int mv)
 	v1 = dac_value & 0x00FF;
 	v2 = ((dac_value >> 8) & 0x0001);
 
-	if (pl_i2c_reg_write_8(p->i2c, p->i2c_addr, HVPMIC_REG_VCOM1, v1))
+	if (i2c_regcache_write(&p->regs, HVPMIC_REG_VCOM1, v1))
 	    return -1;
 
-	return pl_i2c_reg_write_8(p->i2c, p->i2c_addr, HVPMIC_REG_VCOM2, v2);
+	return i2c_regcache_write(&p->regs, HVPMIC_REG_VCOM2, v2);
 }
 
 #if 0 /* ToDo: use or remove */
@@ -235,18 +256,17 @@ int tps65185_temperature_measure(struct tps65185_info *p, int16_t *measured)
 	uint8_t progress;
 
 	/* Trigger conversion */
-	if (pl_i2c_reg_write_8(p->i2c, p->i2c_addr,HVPMIC_REG_TMST1, 0x80))
+	if (i2c_regcache_write(&p->regs, HVPMIC_REG_TMST1, 0x80))
 		return -1;
 
 	/* wait for it to complete */
 	do {
-		if (pl_i2c_reg_read_8(p->i2c, p->i2c_addr, HVPMIC_REG_TMST1,
-				      &progress))
+		if (i2c_regcache_read(&p->regs, HVPMIC_REG_TMST1, &progress))
 			return -1;
 	} while ((progress & 0x20));
 
 	/* read the temperature */
-	if (pl_i2c_reg_read_8(p->i2c, p->i2c_addr, HVPMIC_REG_TMST_VALUE,
+	if (i2c_regcache_read(&p->regs, HVPMIC_REG_TMST_VALUE,
 			      (uint8_t *)&temp)) {
 		temp = HVPMIC_TEMP_DEFAULT;
 		LOG("Warning: using default temperature %d", temp);
@@ -29,6 +29,7 @@
 #define INCLUDE_PMIC_TPS65185_H 1
 
 #include <stdint.h>
+#include "i2c-regcache.h"
 
 struct pl_i2c;
 struct vcom_cal;
@@ -37,6 +38,7 @@ struct tps65185_info {
 	struct pl_i2c *i2c;
 	uint8_t i2c_addr;
 	const struct vcom_cal *cal;
+	struct i2c_regcache regs;
 };
 
 extern int tps65185_init(struct tps65185_info *pmic, struct pl_i2c *i2c,
@@ -48,6 +50,12 @@ extern int tps65185_wait_pok(struct tps65185_info *pmic);
 extern int tps65185_enable(struct tps65185_info *pmic);
 extern int tps65185_disable(struct tps65185_info *pmic);
 
+/* to be called when the register values may have been reset (sleep mode) */
+extern void tps65185_invalidate_cache(struct tps65185_info *pmic);
+
+/* write the init values and VCOM again after tps65185_invalidate_cache() */
+extern int tps65185_restore(struct tps65185_info *pmic);
+
 extern int tps65185_temperature_measure(struct tps65185_info *pmic,
 					int16_t *measured);
 
@@ -0,0 +1,33 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix/intrinsics.h -- Host versions of the MSP430 compiler intrinsics
+ */
+
+#ifndef INCLUDE_POSIX_INTRINSICS_H
+#define INCLUDE_POSIX_INTRINSICS_H 1
+
+#include <stdint.h>
+
+static inline uint16_t _swap_bytes(uint16_t x)
+{
+	return (x << 8) | (x >> 8);
+}
+
+#endif /* INCLUDE_POSIX_INTRINSICS_H */
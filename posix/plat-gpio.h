@@ -0,0 +1,28 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix/plat-gpio.h -- POSIX GPIO API, no optimisation
+ */
+
+#ifndef INCLUDE_POSIX_PLAT_GPIO_H
+#define INCLUDE_POSIX_PLAT_GPIO_H 1
+
+/* Use the default pl_gpio function pointers */
+
+#endif /* INCLUDE_POSIX_PLAT_GPIO_H */
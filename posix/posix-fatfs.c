@@ -0,0 +1,169 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-fatfs.c -- FatFs file functions on top of the host file system
+ */
+
+#include <FatFs/ff.h>
+#include <stdio.h>
+#include <string.h>
+#include "posix-fatfs.h"
+
+/* Only one sector is cached in the file system window with _FS_TINY */
+#define SECTOR_SIZE 512
+#define NO_SECTOR ((unsigned long)-1)
+
+static const char *fatfs_root = ".";
+static struct posix_fatfs_stats stats;
+
+void posix_fatfs_set_root(const char *root)
+{
+	fatfs_root = root;
+}
+
+const struct posix_fatfs_stats *posix_fatfs_get_stats(void)
+{
+	return &stats;
+}
+
+void posix_fatfs_reset_stats(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+/* ----------------------------------------------------------------------------
+ * FatFs functions
+ */
+
+/* The FILE pointer is kept in the file system pointer and the sector in the
+ * FatFs window in the current cluster field, which are not used otherwise */
+
+FRESULT f_open(FIL *f, const TCHAR *path, BYTE mode)
+{
+	char full_path[256];
+	FILE *file;
+	long size;
+	int len;
+
+	if (mode != FA_READ)
+		return FR_DENIED;
+
+	/* host paths given to the benchmarks may be absolute */
+	if (path[0] == '/')
+		len = snprintf(full_path, sizeof(full_path), "%s", path);
+	else
+		len = snprintf(full_path, sizeof(full_path), "%s/%s",
+			       fatfs_root, path);
+
+	if (len >= (int)sizeof(full_path))
+		return FR_INVALID_NAME;
+
+	file = fopen(full_path, "rb");
+
+	if (file == NULL)
+		return FR_NO_FILE;
+
+	if (fseek(file, 0, SEEK_END) || ((size = ftell(file)) < 0) ||
+	    fseek(file, 0, SEEK_SET)) {
+		fclose(file);
+		return FR_DISK_ERR;
+	}
+
+	memset(f, 0, sizeof(*f));
+	f->fs = (FATFS *)file;
+	f->fsize = size;
+	f->curr_clust = NO_SECTOR;
+
+	return FR_OK;
+}
+
+/* Count the disk_read() calls and sectors as FatFs would: partial sectors go
+ * through the window, and runs of whole sectors are read directly into the
+ * buffer with a single multi-block read */
+static void count_sectors(FIL *f, size_t count)
+{
+	unsigned long pos = f->fptr;
+	const unsigned long end = pos + count;
+
+	while (pos < end) {
+		const unsigned long sect = pos / SECTOR_SIZE;
+
+		if ((pos % SECTOR_SIZE) || ((end - pos) < SECTOR_SIZE)) {
+			if (sect != f->curr_clust) {
+				stats.cmds++;
+				stats.sectors++;
+				f->curr_clust = sect;
+			}
+
+			pos = (sect + 1) * SECTOR_SIZE;
+		} else {
+			const unsigned long n = (end - pos) / SECTOR_SIZE;
+
+			stats.cmds++;
+			stats.sectors += n;
+			pos += n * SECTOR_SIZE;
+		}
+	}
+}
+
+FRESULT f_read(FIL *f, void *buff, UINT btr, UINT *br)
+{
+	FILE *file = (FILE *)f->fs;
+	size_t count;
+
+	if (btr > (f->fsize - f->fptr))
+		btr = f->fsize - f->fptr;
+
+	count = fread(buff, 1, btr, file);
+
+	if (count != btr)
+		return FR_DISK_ERR;
+
+	stats.reads++;
+	stats.bytes += count;
+	count_sectors(f, count);
+	f->fptr += count;
+	*br = count;
+
+	return FR_OK;
+}
+
+FRESULT f_lseek(FIL *f, DWORD ofs)
+{
+	FILE *file = (FILE *)f->fs;
+
+	if (ofs > f->fsize)
+		ofs = f->fsize;
+
+	if (fseek(file, ofs, SEEK_SET))
+		return FR_DISK_ERR;
+
+	stats.seeks++;
+	f->fptr = ofs;
+
+	return FR_OK;
+}
+
+FRESULT f_close(FIL *f)
+{
+	fclose((FILE *)f->fs);
+	f->fs = NULL;
+
+	return FR_OK;
+}
@@ -0,0 +1,45 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-fatfs.h -- FatFs file functions on top of the host file system
+ */
+
+#ifndef INCLUDE_POSIX_FATFS_H
+#define INCLUDE_POSIX_FATFS_H 1
+
+/** Statistics about the SD card accesses which FatFs would perform */
+struct posix_fatfs_stats {
+	unsigned long reads;       /**< number of f_read calls */
+	unsigned long seeks;       /**< number of f_lseek calls */
+	unsigned long bytes;       /**< number of bytes read */
+	unsigned long sectors;     /**< number of 512-byte sectors read */
+	unsigned long cmds;        /**< number of disk_read calls (CMD17/18) */
+};
+
+/** Set the directory used as the root of the SD card, default is ".".
+    Absolute paths given to f_open() are used as they are. */
+extern void posix_fatfs_set_root(const char *root);
+
+/** Get the statistics accumulated since the last reset */
+extern const struct posix_fatfs_stats *posix_fatfs_get_stats(void);
+
+/** Reset the statistics */
+extern void posix_fatfs_reset_stats(void);
+
+#endif /* INCLUDE_POSIX_FATFS_H */
@@ -0,0 +1,208 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-readahead.c -- File-backed SD card stand-in for the read-ahead layer
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include "posix-fatfs.h"
+#include "posix-readahead.h"
+#include "utils.h"
+
+struct disk_thread {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	int started;
+	unsigned rate;
+	unsigned cmd_us;
+	/* current request */
+	FIL *f;
+	uint8_t *buf;
+	size_t n;
+	size_t count;
+	int stat;
+	int busy;
+};
+
+static int disk_start(struct readahead_disk *d, FIL *f, uint8_t *buf,
+		      size_t n);
+static int disk_busy(struct readahead_disk *d);
+static int disk_wait(struct readahead_disk *d, size_t *count);
+static void *disk_run(void *arg);
+static void sleep_us(unsigned long us);
+
+static struct disk_thread disk_thread = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+static struct readahead_disk disk = {
+	disk_start, disk_busy, disk_wait, &disk_thread,
+};
+
+static struct posix_readahead_stats stats;
+
+struct readahead_disk *posix_readahead_disk(unsigned rate, unsigned cmd_us)
+{
+	struct disk_thread *t = &disk_thread;
+
+	t->rate = rate ? rate : 1;
+	t->cmd_us = cmd_us;
+
+	if (!t->started) {
+		if (pthread_create(&t->thread, NULL, disk_run, t))
+			return NULL;
+
+		t->started = 1;
+	}
+
+	return &disk;
+}
+
+const struct posix_readahead_stats *posix_readahead_get_stats(void)
+{
+	stats.overlap_us = (stats.busy_us > stats.blocked_us) ?
+		(stats.busy_us - stats.blocked_us) : 0;
+
+	return &stats;
+}
+
+void posix_readahead_reset_stats(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+/* ----------------------------------------------------------------------------
+ * static functions
+ */
+
+static int disk_start(struct readahead_disk *d, FIL *f, uint8_t *buf,
+		      size_t n)
+{
+	struct disk_thread *t = d->data;
+
+	pthread_mutex_lock(&t->lock);
+
+	if (t->busy) {
+		pthread_mutex_unlock(&t->lock);
+		return -1;
+	}
+
+	t->f = f;
+	t->buf = buf;
+	t->n = n;
+	t->busy = 1;
+	stats.reads++;
+	pthread_cond_broadcast(&t->cond);
+	pthread_mutex_unlock(&t->lock);
+
+	return 0;
+}
+
+static int disk_busy(struct readahead_disk *d)
+{
+	struct disk_thread *t = d->data;
+	int busy;
+
+	pthread_mutex_lock(&t->lock);
+	busy = t->busy;
+	pthread_mutex_unlock(&t->lock);
+
+	return busy;
+}
+
+static int disk_wait(struct readahead_disk *d, size_t *count)
+{
+	struct disk_thread *t = d->data;
+	const uint32_t t0 = ticks_now();
+	int stat;
+
+	pthread_mutex_lock(&t->lock);
+
+	while (t->busy)
+		pthread_cond_wait(&t->cond, &t->lock);
+
+	*count = t->count;
+	stat = t->stat;
+	pthread_mutex_unlock(&t->lock);
+
+	stats.blocked_us += ticks_now() - t0;
+
+	return stat;
+}
+
+static void *disk_run(void *arg)
+{
+	struct disk_thread *t = arg;
+	const struct posix_fatfs_stats *fs_stats = posix_fatfs_get_stats();
+
+	pthread_mutex_lock(&t->lock);
+
+	for (;;) {
+		unsigned long cmds, sectors, us, elapsed;
+		uint32_t t0;
+		UINT count;
+		int stat;
+
+		while (!t->busy)
+			pthread_cond_wait(&t->cond, &t->lock);
+
+		pthread_mutex_unlock(&t->lock);
+
+		t0 = ticks_now();
+		cmds = fs_stats->cmds;
+		sectors = fs_stats->sectors;
+		stat = (f_read(t->f, t->buf, t->n, &count) == FR_OK) ? 0 : -1;
+		cmds = fs_stats->cmds - cmds;
+		sectors = fs_stats->sectors - sectors;
+
+		/* take as long as the SD card would */
+		us = (cmds * t->cmd_us) +
+			(unsigned long)((sectors * 512ULL * 1000000ULL) /
+					(t->rate * 1024ULL));
+		elapsed = ticks_now() - t0;
+
+		if (elapsed < us)
+			sleep_us(us - elapsed);
+
+		pthread_mutex_lock(&t->lock);
+		stats.busy_us += ticks_now() - t0;
+		t->count = count;
+		t->stat = stat;
+		t->busy = 0;
+		pthread_cond_broadcast(&t->cond);
+	}
+
+	return NULL;
+}
+
+static void sleep_us(unsigned long us)
+{
+	struct timespec t;
+
+	t.tv_sec = us / 1000000UL;
+	t.tv_nsec = (us % 1000000UL) * 1000UL;
+
+	while (nanosleep(&t, &t));
+}
@@ -0,0 +1,48 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-readahead.h -- File-backed SD card stand-in for the read-ahead layer
+ */
+
+#ifndef INCLUDE_POSIX_READAHEAD_H
+#define INCLUDE_POSIX_READAHEAD_H 1
+
+#include "readahead.h"
+
+/** Timing of the reads performed by the disk thread */
+struct posix_readahead_stats {
+	unsigned long reads;       /**< number of reads started */
+	unsigned long busy_us;     /**< time spent reading */
+	unsigned long blocked_us;  /**< time spent waiting for a read */
+	unsigned long overlap_us;  /**< reading time hidden by other work */
+};
+
+/** Get a disk back-end which reads the files in a separate thread, going
+ * through posix-fatfs, and takes as long as an SD card with the given
+ * transfer rate in KB/s and overhead of each disk_read call in us. */
+extern struct readahead_disk *posix_readahead_disk(unsigned rate,
+						   unsigned cmd_us);
+
+/** Get the statistics accumulated since the last reset */
+extern const struct posix_readahead_stats *posix_readahead_get_stats(void);
+
+/** Reset the statistics */
+extern void posix_readahead_reset_stats(void);
+
+#endif /* INCLUDE_POSIX_READAHEAD_H */
@@ -0,0 +1,175 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-serial.c -- POSIX serial port for host builds
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <pl/serial.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "posix-serial.h"
+
+#define LOG_TAG "serial"
+#include "utils.h"
+
+static const struct {
+	unsigned long baud;
+	speed_t speed;
+} baud_rates[] = {
+	{ 9600, B9600 },
+	{ 19200, B19200 },
+	{ 38400, B38400 },
+	{ 57600, B57600 },
+	{ 115200, B115200 },
+	{ 230400, B230400 },
+#ifdef B460800
+	{ 460800, B460800 },
+#endif
+#ifdef B921600
+	{ 921600, B921600 },
+#endif
+};
+
+int posix_serial_open(const char *path, unsigned long baud)
+{
+	struct termios tio;
+	int fd;
+
+	fd = open(path, O_RDWR | O_NOCTTY);
+
+	if (fd < 0) {
+		LOG("Failed to open %s", path);
+		return -1;
+	}
+
+	if (tcgetattr(fd, &tio)) {
+		LOG("Failed to get terminal attributes");
+		goto err_close;
+	}
+
+	cfmakeraw(&tio);
+
+	if (baud) {
+		size_t i;
+
+		for (i = 0; i < ARRAY_SIZE(baud_rates); ++i)
+			if (baud_rates[i].baud == baud)
+				break;
+
+		if (i == ARRAY_SIZE(baud_rates)) {
+			LOG("Unsupported baud rate: %lu", baud);
+			goto err_close;
+		}
+
+		cfsetispeed(&tio, baud_rates[i].speed);
+		cfsetospeed(&tio, baud_rates[i].speed);
+	}
+
+	if (tcsetattr(fd, TCSANOW, &tio)) {
+		LOG("Failed to set terminal attributes");
+		goto err_close;
+	}
+
+	return fd;
+
+err_close:
+	close(fd);
+
+	return -1;
+}
+
+static int posix_serial_read(struct pl_serial *serial, uint8_t *data,
+			     size_t n, unsigned timeout_ms)
+{
+	struct pollfd pfd;
+	size_t count = 0;
+
+	pfd.fd = *(int *)serial->priv;
+	pfd.events = POLLIN;
+
+	while (count < n) {
+		ssize_t ret;
+
+		ret = poll(&pfd, 1, timeout_ms);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		if (ret <= 0)
+			break;
+
+		ret = read(pfd.fd, &data[count], (n - count));
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		/* end of file or error, i.e. the other end has been closed */
+		if (ret <= 0) {
+			if (!count)
+				return -1;
+			break;
+		}
+
+		count += ret;
+	}
+
+	return count;
+}
+
+static int posix_serial_write(struct pl_serial *serial, const uint8_t *data,
+			      size_t n)
+{
+	const int fd = *(int *)serial->priv;
+
+	while (n) {
+		ssize_t ret = write(fd, data, n);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		if (ret <= 0)
+			return -1;
+
+		data += ret;
+		n -= ret;
+	}
+
+	return 0;
+}
+
+int posix_serial_init(struct pl_serial *serial, int fd)
+{
+	int *pfd = malloc(sizeof(int));
+
+	if (pfd == NULL)
+		return -1;
+
+	*pfd = fd;
+	serial->read = posix_serial_read;
+	serial->write = posix_serial_write;
+	serial->get_overruns = NULL;
+	serial->priv = pfd;
+
+	return 0;
+}
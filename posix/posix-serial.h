@@ -0,0 +1,35 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-serial.h -- POSIX serial port for host builds
+ */
+
+#ifndef INCLUDE_POSIX_SERIAL_H
+#define INCLUDE_POSIX_SERIAL_H 1
+
+struct pl_serial;
+
+/** Configure a terminal in raw mode with the given baud rate (e.g. 460800),
+ * or leave the baud rate unchanged if 0 (i.e. for a pty) */
+extern int posix_serial_open(const char *path, unsigned long baud);
+
+/** Initialise a pl_serial instance to use a file descriptor */
+extern int posix_serial_init(struct pl_serial *serial, int fd);
+
+#endif /* INCLUDE_POSIX_SERIAL_H */
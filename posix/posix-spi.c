@@ -0,0 +1,206 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-spi.c -- Thread-backed fake of an EPDC interface for host builds
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include "crc16.h"
+#include "posix-spi.h"
+#include "utils.h"
+
+static int spi_read(uint8_t *buff, uint8_t size);
+static int spi_write(uint8_t *buff, uint8_t size);
+static int spi_write_async(const uint8_t *buff, uint16_t size,
+			   pl_interface_done_t done, void *ctx);
+static int spi_wait(void);
+static void send(const uint8_t *buff, size_t size);
+static void spin_ns(unsigned long long ns);
+static void *spi_run(void *arg);
+
+static pthread_t spi_thread;
+static pthread_mutex_t spi_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t spi_cond = PTHREAD_COND_INITIALIZER;
+static int spi_started;
+static unsigned spi_rate;
+static unsigned spi_call_ns;
+
+/* current asynchronous write */
+static const uint8_t *async_buff;
+static uint16_t async_size;
+static pl_interface_done_t async_done;
+static void *async_ctx;
+static int async_busy;
+
+static struct posix_spi_stats stats;
+
+int posix_spi_init(struct pl_interface *iface, unsigned rate)
+{
+	spi_rate = rate ? rate : 1;
+
+	if (!spi_started) {
+		if (pthread_create(&spi_thread, NULL, spi_run, NULL))
+			return -1;
+
+		spi_started = 1;
+	}
+
+	memset(iface, 0, sizeof(*iface));
+	iface->read = spi_read;
+	iface->write = spi_write;
+	iface->write_async = spi_write_async;
+	iface->wait = spi_wait;
+	posix_spi_reset_stats();
+
+	return 0;
+}
+
+void posix_spi_set_call_overhead(unsigned ns)
+{
+	spi_call_ns = ns;
+}
+
+const struct posix_spi_stats *posix_spi_get_stats(void)
+{
+	stats.overlap_us = (stats.busy_us > stats.blocked_us) ?
+		(stats.busy_us - stats.blocked_us) : 0;
+
+	return &stats;
+}
+
+void posix_spi_reset_stats(void)
+{
+	memset(&stats, 0, sizeof(stats));
+	stats.crc = crc16_init;
+}
+
+/* ----------------------------------------------------------------------------
+ * static functions
+ */
+
+static int spi_read(uint8_t *buff, uint8_t size)
+{
+	spi_wait();
+	spin_ns(spi_call_ns);
+	spin_ns((size * 1000000000ULL) / (spi_rate * 1024ULL));
+	memset(buff, 0, size);
+
+	return 0;
+}
+
+/* Synchronous writes keep the caller busy during the whole transfer */
+static int spi_write(uint8_t *buff, uint8_t size)
+{
+	const uint32_t t0 = ticks_now();
+
+	spi_wait();
+	spin_ns(spi_call_ns);
+	send(buff, size);
+	stats.writes++;
+	stats.blocked_us += ticks_now() - t0;
+
+	return 0;
+}
+
+static int spi_write_async(const uint8_t *buff, uint16_t size,
+			   pl_interface_done_t done, void *ctx)
+{
+	spi_wait();
+	spin_ns(spi_call_ns);
+
+	pthread_mutex_lock(&spi_lock);
+	async_buff = buff;
+	async_size = size;
+	async_done = done;
+	async_ctx = ctx;
+	async_busy = 1;
+	stats.async++;
+	pthread_cond_broadcast(&spi_cond);
+	pthread_mutex_unlock(&spi_lock);
+
+	return 0;
+}
+
+static int spi_wait(void)
+{
+	const uint32_t t0 = ticks_now();
+
+	pthread_mutex_lock(&spi_lock);
+
+	while (async_busy)
+		pthread_cond_wait(&spi_cond, &spi_lock);
+
+	pthread_mutex_unlock(&spi_lock);
+	stats.blocked_us += ticks_now() - t0;
+
+	return 0;
+}
+
+/* Take as long as the real interface would, without sleeping as most
+ * transfers are much shorter than the scheduler resolution */
+static void send(const uint8_t *buff, size_t size)
+{
+	const uint32_t t0 = ticks_now();
+
+	stats.crc = crc16_run(stats.crc, buff, size);
+	stats.bytes += size;
+	spin_ns((size * 1000000000ULL) / (spi_rate * 1024ULL));
+	stats.busy_us += ticks_now() - t0;
+}
+
+static void spin_ns(unsigned long long ns)
+{
+	struct timespec start, t;
+
+	if (!ns)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &t);
+	} while ((((t.tv_sec - start.tv_sec) * 1000000000ULL) +
+		  t.tv_nsec - start.tv_nsec) < ns);
+}
+
+static void *spi_run(void *arg)
+{
+	pthread_mutex_lock(&spi_lock);
+
+	for (;;) {
+		while (!async_busy)
+			pthread_cond_wait(&spi_cond, &spi_lock);
+
+		pthread_mutex_unlock(&spi_lock);
+		send(async_buff, async_size);
+
+		if (async_done != NULL)
+			async_done(async_ctx);
+
+		pthread_mutex_lock(&spi_lock);
+		async_busy = 0;
+		pthread_cond_broadcast(&spi_cond);
+	}
+
+	return NULL;
+}
@@ -0,0 +1,54 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-spi.h -- Thread-backed fake of an EPDC interface for host builds
+ */
+
+#ifndef INCLUDE_POSIX_SPI_H
+#define INCLUDE_POSIX_SPI_H 1
+
+#include <pl/interface.h>
+
+/** Statistics about the data sent through the fake interface */
+struct posix_spi_stats {
+	unsigned long writes;      /**< number of synchronous writes */
+	unsigned long async;       /**< number of asynchronous writes */
+	unsigned long bytes;       /**< number of bytes sent */
+	unsigned long busy_us;     /**< time spent sending data */
+	unsigned long blocked_us;  /**< time spent waiting for the interface */
+	unsigned long overlap_us;  /**< sending time hidden by other work */
+	uint16_t crc;              /**< CRC16 of all the data sent */
+};
+
+/** Initialise an interface which sends data at the given rate in KB/s,
+ * with asynchronous writes completed by a separate thread as a DMA engine
+ * would do.  The data is not sent anywhere but its CRC is computed. */
+extern int posix_spi_init(struct pl_interface *iface, unsigned rate);
+
+/** Set the time taken by the caller for each read or write call, to stand
+ * for the chip select and command framing of the real interface */
+extern void posix_spi_set_call_overhead(unsigned ns);
+
+/** Get the statistics accumulated since the last reset */
+extern const struct posix_spi_stats *posix_spi_get_stats(void);
+
+/** Reset the statistics */
+extern void posix_spi_reset_stats(void);
+
+#endif /* INCLUDE_POSIX_SPI_H */
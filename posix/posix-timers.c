@@ -0,0 +1,73 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-timers.c -- POSIX timer functions for host builds
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdint.h>
+#include <time.h>
+#include "utils.h"
+
+static struct timespec ticks_origin;
+
+static void sleep_ns(unsigned long ns)
+{
+	struct timespec t;
+
+	t.tv_sec = ns / 1000000000UL;
+	t.tv_nsec = ns % 1000000000UL;
+
+	while (nanosleep(&t, &t));
+}
+
+void udelay(uint16_t us)
+{
+	sleep_ns(us * 1000UL);
+}
+
+void mdelay(uint16_t ms)
+{
+	sleep_ns(ms * 1000000UL);
+}
+
+void msleep(uint16_t ms)
+{
+	mdelay(ms);
+}
+
+void ticks_init(void)
+{
+	clock_gettime(CLOCK_MONOTONIC, &ticks_origin);
+}
+
+uint32_t ticks_now(void)
+{
+	struct timespec t;
+	uint32_t ticks;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	/* same unit as the MSP430 counter: 1 tick per microsecond */
+	ticks = (uint32_t)(t.tv_sec - ticks_origin.tv_sec) * 1000000UL;
+	ticks += (t.tv_nsec - ticks_origin.tv_nsec) / 1000L;
+
+	return ticks;
+}
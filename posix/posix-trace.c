@@ -0,0 +1,140 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-trace.c -- EPDC command trace files for host builds
+ */
+
+#include <string.h>
+#include "posix-trace.h"
+
+/* Records are always stored as little-endian */
+#define REC_SIZE 8
+
+static void trace_write(void *ctx, const struct pl_trace_rec *rec)
+{
+	uint8_t raw[REC_SIZE];
+
+	raw[0] = rec->type;
+	raw[1] = 0;
+	raw[2] = rec->arg & 0xFF;
+	raw[3] = (rec->arg >> 8) & 0xFF;
+	raw[4] = rec->val & 0xFF;
+	raw[5] = (rec->val >> 8) & 0xFF;
+	raw[6] = (rec->val >> 16) & 0xFF;
+	raw[7] = (rec->val >> 24) & 0xFF;
+	fwrite(raw, sizeof(raw), 1, ctx);
+}
+
+int posix_trace_create(struct pl_trace_sink *sink, const char *path)
+{
+	const uint8_t header[8] = {
+		PL_TRACE_MAGIC[0], PL_TRACE_MAGIC[1],
+		PL_TRACE_MAGIC[2], PL_TRACE_MAGIC[3],
+		PL_TRACE_VERSION, 0, REC_SIZE, 0,
+	};
+	FILE *f = fopen(path, "wb");
+
+	if (f == NULL)
+		return -1;
+
+	if (fwrite(header, sizeof(header), 1, f) != 1) {
+		fclose(f);
+		return -1;
+	}
+
+	sink->write = trace_write;
+	sink->ctx = f;
+
+	return 0;
+}
+
+void posix_trace_close(struct pl_trace_sink *sink)
+{
+	fclose(sink->ctx);
+	sink->ctx = NULL;
+}
+
+int posix_trace_open(struct posix_trace_reader *r, const char *path)
+{
+	uint8_t header[8];
+
+	r->f = fopen(path, "rb");
+
+	if (r->f == NULL)
+		return -1;
+
+	if ((fread(header, sizeof(header), 1, r->f) == 1) &&
+	    !memcmp(header, PL_TRACE_MAGIC, 4)) {
+		if ((header[4] != PL_TRACE_VERSION) || (header[6] != REC_SIZE)) {
+			fclose(r->f);
+			return -1;
+		}
+
+		r->text = 0;
+	} else {
+		rewind(r->f);
+		r->text = 1;
+	}
+
+	return 0;
+}
+
+int posix_trace_read(struct posix_trace_reader *r, struct pl_trace_rec *rec)
+{
+	uint8_t raw[REC_SIZE];
+	char line[128];
+
+	if (!r->text) {
+		if (fread(raw, sizeof(raw), 1, r->f) != 1)
+			return feof(r->f) ? 0 : -1;
+
+		rec->type = raw[0];
+		rec->reserved = 0;
+		rec->arg = raw[2] | (raw[3] << 8);
+		rec->val = (uint32_t)raw[4] | ((uint32_t)raw[5] << 8) |
+			((uint32_t)raw[6] << 16) | ((uint32_t)raw[7] << 24);
+
+		return 1;
+	}
+
+	/* skip anything else in the serial output */
+	while (fgets(line, sizeof(line), r->f) != NULL) {
+		const char *it = strstr(line, "TRACE ");
+		unsigned type, arg;
+		unsigned long val;
+
+		if ((it == NULL) ||
+		    (sscanf(it, "TRACE %x %x %lx", &type, &arg, &val) != 3))
+			continue;
+
+		rec->type = type;
+		rec->reserved = 0;
+		rec->arg = arg;
+		rec->val = val;
+
+		return 1;
+	}
+
+	return ferror(r->f) ? -1 : 0;
+}
+
+void posix_trace_end(struct posix_trace_reader *r)
+{
+	fclose(r->f);
+}
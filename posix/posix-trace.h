@@ -0,0 +1,53 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * posix-trace.h -- EPDC command trace files for host builds
+ */
+
+#ifndef INCLUDE_POSIX_TRACE_H
+#define INCLUDE_POSIX_TRACE_H 1
+
+#include <pl/trace.h>
+#include <stdio.h>
+
+/** Create a trace file and set up a sink writing records to it */
+extern int posix_trace_create(struct pl_trace_sink *sink, const char *path);
+
+/** Close a trace file created with posix_trace_create */
+extern void posix_trace_close(struct pl_trace_sink *sink);
+
+/** Trace file being read */
+struct posix_trace_reader {
+	FILE *f;
+	int text;               /**< set when reading "TRACE" text lines */
+};
+
+/** Open a trace file, either binary or a serial output with the text lines
+ * printed by pl_trace_ram_dump() */
+extern int posix_trace_open(struct posix_trace_reader *r, const char *path);
+
+/** Read the next record, return 1 if a record was read, 0 at the end of the
+ * file or -1 if an error occurred */
+extern int posix_trace_read(struct posix_trace_reader *r,
+			    struct pl_trace_rec *rec);
+
+/** Close a trace file opened with posix_trace_open */
+extern void posix_trace_end(struct posix_trace_reader *r);
+
+#endif /* INCLUDE_POSIX_TRACE_H */
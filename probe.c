@@ -144,6 +144,19 @@ int probe_dispinfo(struct pl_dispinfo *dispinfo, struct pl_wflib *wflib,
 /* interim solution */
 static struct max17135_info *g_max17135;
 
+/* The TPS65185 registers are lost when the board goes to sleep or off */
+static void tps65185_power_lost_hook(void *ctx)
+{
+	tps65185_invalidate_cache(ctx);
+}
+
+static int tps65185_power_restored_hook(void *ctx)
+{
+	LOG("Restoring HV-PMIC registers");
+
+	return tps65185_restore(ctx);
+}
+
 int probe_hvpmic(struct pl_platform *plat, struct vcom_cal *vcom_cal,
 		 struct pl_epdpsu_gpio *epdpsu_gpio,
 		 struct tps65185_info *pmic_info)
@@ -194,6 +207,9 @@ int probe_hvpmic(struct pl_platform *plat, struct vcom_cal *vcom_cal,
 		if (!stat) /* ToDo: generalise set_vcom with HV-PMIC API */
 			stat = tps65185_set_vcom_voltage(
 				pmic_info, plat->dispinfo->info.vcom);
+		plat->epdc.power_lost_hook = tps65185_power_lost_hook;
+		plat->epdc.power_restored_hook = tps65185_power_restored_hook;
+		plat->epdc.power_hook_ctx = pmic_info;
 		break;
 	default:
 		assert_fail("Invalid HV-PMIC id");
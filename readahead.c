@@ -0,0 +1,247 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * readahead.c -- Double-buffered read-ahead of files from the SD card
+ */
+
+#include "readahead.h"
+#include "config.h"
+#include <pl/prof.h>
+#include <string.h>
+#include "assert.h"
+
+#define LOG_TAG "readahead"
+#include "utils.h"
+
+static int sync_start(struct readahead_disk *d, FIL *f, uint8_t *buf,
+		      size_t n);
+static int sync_busy(struct readahead_disk *d);
+static int sync_wait(struct readahead_disk *d, size_t *count);
+static void start_next(struct readahead *ra);
+static void complete(struct readahead *ra);
+
+struct readahead_disk readahead_sync_disk = {
+	sync_start, sync_busy, sync_wait, NULL,
+};
+
+/* result of the last synchronous read */
+static size_t sync_count;
+static int sync_stat;
+
+int readahead_init(struct readahead *ra, FIL *f, struct readahead_disk *disk,
+		   uint8_t *mem, size_t mem_size, unsigned n_bufs)
+{
+	unsigned i;
+
+	assert(ra != NULL);
+	assert(f != NULL);
+	assert(mem != NULL);
+
+	if ((n_bufs < 2) || (n_bufs > READAHEAD_MAX_BUFS))
+		return -1;
+
+	memset(ra, 0, sizeof(*ra));
+	ra->f = f;
+	ra->disk = (disk != NULL) ? disk : &readahead_sync_disk;
+	ra->buf_size = (mem_size / n_bufs) & ~(READAHEAD_SECTOR_SIZE - 1);
+
+	if (!ra->buf_size) {
+		LOG("Not enough memory for %u buffers", n_bufs);
+		return -1;
+	}
+
+	ra->n_bufs = n_bufs;
+	ra->to_read = f->fsize - f->fptr;
+
+	for (i = 0; i < n_bufs; ++i)
+		ra->bufs[i] = mem + (i * ra->buf_size);
+
+	start_next(ra);
+
+	return ra->error ? -1 : 0;
+}
+
+int readahead_next(struct readahead *ra, const uint8_t **data)
+{
+	assert(ra != NULL);
+	assert(data != NULL);
+
+	/* release the current buffer so it can be filled again */
+	if (ra->current) {
+		ra->head = (ra->head + 1) % ra->n_bufs;
+		ra->current = 0;
+	}
+
+	readahead_poll(ra);
+
+	if (!ra->filled) {
+		if (!ra->pending)
+			return ra->error ? -1 : 0;
+
+		complete(ra);
+		start_next(ra);
+	}
+
+	if (ra->error)
+		return -1;
+
+	ra->filled--;
+	ra->current = 1;
+	ra->pos = 0;
+	*data = ra->bufs[ra->head];
+
+	return ra->counts[ra->head];
+}
+
+const uint8_t *readahead_get(struct readahead *ra, size_t n, uint8_t *tmp,
+			     size_t *count)
+{
+	size_t copied = 0;
+
+	assert(ra != NULL);
+	assert(tmp != NULL);
+	assert(count != NULL);
+
+	for (;;) {
+		const uint8_t *data;
+		size_t avail;
+
+		if (!ra->current || (ra->pos == ra->counts[ra->head])) {
+			if (readahead_next(ra, &data) <= 0) {
+				*count = copied;
+				return NULL;
+			}
+		}
+
+		data = ra->bufs[ra->head] + ra->pos;
+		avail = ra->counts[ra->head] - ra->pos;
+
+		/* no copy needed when the data is all in the same buffer */
+		if (!copied && (avail >= n)) {
+			ra->pos += n;
+			*count = n;
+			return data;
+		}
+
+		if (avail > (n - copied))
+			avail = n - copied;
+
+		memcpy(tmp + copied, data, avail);
+		copied += avail;
+		ra->pos += avail;
+
+		if (copied == n) {
+			*count = n;
+			return tmp;
+		}
+	}
+}
+
+void readahead_poll(struct readahead *ra)
+{
+	assert(ra != NULL);
+
+	if (ra->pending && !ra->disk->busy(ra->disk))
+		complete(ra);
+
+	start_next(ra);
+}
+
+int readahead_end(struct readahead *ra)
+{
+	assert(ra != NULL);
+
+	if (ra->pending)
+		complete(ra);
+
+	return ra->error ? -1 : 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * static functions
+ */
+
+static int sync_start(struct readahead_disk *d, FIL *f, uint8_t *buf,
+		      size_t n)
+{
+	UINT count;
+
+	PL_PROF_START(PL_PROF_SD_READ);
+	sync_stat = (f_read(f, buf, n, &count) == FR_OK) ? 0 : -1;
+	PL_PROF_STOP(PL_PROF_SD_READ);
+	sync_count = count;
+
+	return sync_stat;
+}
+
+static int sync_busy(struct readahead_disk *d)
+{
+	return 0;
+}
+
+static int sync_wait(struct readahead_disk *d, size_t *count)
+{
+	*count = sync_count;
+
+	return sync_stat;
+}
+
+/* Start filling the next free buffer, only one read can be in progress */
+static void start_next(struct readahead *ra)
+{
+	const unsigned used = ra->current + ra->filled;
+	unsigned i;
+	size_t n;
+
+	if (ra->error || ra->pending || !ra->to_read || (used == ra->n_bufs))
+		return;
+
+	i = (ra->head + used) % ra->n_bufs;
+
+	/* stop on a sector boundary so the next reads are aligned */
+	n = ra->buf_size - (ra->f->fptr % READAHEAD_SECTOR_SIZE);
+
+	if (n > ra->to_read)
+		n = ra->to_read;
+
+	if (ra->disk->start(ra->disk, ra->f, ra->bufs[i], n)) {
+		ra->error = 1;
+		return;
+	}
+
+	ra->counts[i] = n;
+	ra->to_read -= n;
+	ra->pending = 1;
+}
+
+static void complete(struct readahead *ra)
+{
+	const unsigned i = (ra->head + ra->current + ra->filled) % ra->n_bufs;
+	size_t count;
+
+	ra->pending = 0;
+
+	if (ra->disk->wait(ra->disk, &count) || (count != ra->counts[i])) {
+		LOG("Read error");
+		ra->error = 1;
+		return;
+	}
+
+	ra->filled++;
+}
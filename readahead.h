@@ -0,0 +1,116 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * readahead.h -- Double-buffered read-ahead of files from the SD card
+ */
+
+#ifndef INCLUDE_READAHEAD_H
+#define INCLUDE_READAHEAD_H 1
+
+#include <FatFs/ff.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+   @file readahead.h
+
+   Read a file sequentially through two or more buffers, so the next buffer
+   can be filled while the data from the previous one is being sent to the
+   EPDC.
+
+   Each buffer is a whole number of sectors.  The first read stops on a
+   sector boundary, so all the following ones go straight from the SD card
+   to the buffer with a single multi-block read (CMD18) instead of a mix of
+   single-block reads through the FatFs window.
+
+   The reads are performed by a disk back-end which may complete them
+   asynchronously.  The default one calls f_read() directly, so on the
+   MSP430 the SD card reads still don't overlap with the EPDC transfers and
+   the only gain is the aligned multi-block reads.  The host build provides
+   a back-end with a thread to measure the overlap (see
+   posix/posix-readahead.h).  A DMA back-end can be added in the same way
+   on platforms where the SD card interface supports it.
+*/
+
+/** Size of an SD card sector */
+#define READAHEAD_SECTOR_SIZE 512
+
+/** Maximum number of buffers */
+#define READAHEAD_MAX_BUFS 4
+
+/** Disk back-end */
+struct readahead_disk {
+	/** start reading n bytes from the file into buf */
+	int (*start)(struct readahead_disk *d, FIL *f, uint8_t *buf,
+		     size_t n);
+	/** optional, return 1 while the last read is still in progress */
+	int (*busy)(struct readahead_disk *d);
+	/** wait for the last read to complete and get the number of bytes */
+	int (*wait)(struct readahead_disk *d, size_t *count);
+	void *data;
+};
+
+/** Default back-end which reads synchronously with f_read() */
+extern struct readahead_disk readahead_sync_disk;
+
+struct readahead {
+	FIL *f;
+	struct readahead_disk *disk;
+	uint8_t *bufs[READAHEAD_MAX_BUFS];
+	size_t counts[READAHEAD_MAX_BUFS];
+	size_t buf_size;         /* size of each buffer, in bytes */
+	uint32_t to_read;        /* bytes of the file not requested yet */
+	uint8_t n_bufs;
+	uint8_t head;            /* oldest buffer not released yet */
+	uint8_t filled;          /* number of buffers ready to be used */
+	uint8_t pending;         /* 1 if a read is in progress */
+	uint8_t current;         /* 1 if the head buffer is in use */
+	size_t pos;              /* position in the head buffer */
+	int error;
+};
+
+/** Initialise a read-ahead context with a memory area split into n_bufs
+ * buffers, and start reading from the current position in the file.  The
+ * memory area needs to be at least n_bufs sectors long.  The disk back-end
+ * can be NULL to use readahead_sync_disk. */
+extern int readahead_init(struct readahead *ra, FIL *f,
+			  struct readahead_disk *disk, uint8_t *mem,
+			  size_t mem_size, unsigned n_bufs);
+
+/** Get the next buffer of data, after releasing the previous one.  Returns
+ * the number of bytes in the buffer, 0 at the end of the file or -1 if an
+ * error occurred. */
+extern int readahead_next(struct readahead *ra, const uint8_t **data);
+
+/** Get n contiguous bytes, directly in a buffer when possible or otherwise
+ * copied to tmp which needs to be at least n bytes long.  Returns a pointer
+ * to the data, or NULL if fewer than n bytes are left or on error with the
+ * number of bytes actually available in *count. */
+extern const uint8_t *readahead_get(struct readahead *ra, size_t n,
+				    uint8_t *tmp, size_t *count);
+
+/** Start the next read if the disk is idle and a buffer is free, to be
+ * called while processing data to keep the disk busy. */
+extern void readahead_poll(struct readahead *ra);
+
+/** Wait for any read still in progress, to be called before closing the
+ * file or reusing the memory area */
+extern int readahead_end(struct readahead *ra);
+
+#endif /* INCLUDE_READAHEAD_H */
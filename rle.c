@@ -0,0 +1,159 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * rle.c -- Run-length encoding
+ */
+
+#include "rle.h"
+#include <stdint.h>
+
+struct rle_enc {
+	struct lzss_io *io;
+	uint8_t literal[RLE_MAX_LITERAL];
+	unsigned n_literal;
+};
+
+static int flush_literal(struct rle_enc *enc);
+static int add_literal(struct rle_enc *enc, uint8_t c, unsigned n);
+static int put_run(struct rle_enc *enc, uint8_t c, unsigned n);
+
+int rle_encode(struct lzss_io *io)
+{
+	struct rle_enc enc;
+	unsigned run = 0;
+	int prev = 0;
+
+	enc.io = io;
+	enc.n_literal = 0;
+
+	for (;;) {
+		const int c = io->rd(io->i);
+
+		if (c == LZSS_ERROR)
+			return -1;
+
+		if ((c != EOF) && run && (c == prev) && (run < RLE_MAX_RUN)) {
+			++run;
+			continue;
+		}
+
+		if (run >= RLE_MIN_RUN) {
+			if (put_run(&enc, prev, run))
+				return -1;
+		} else if (run) {
+			if (add_literal(&enc, prev, run))
+				return -1;
+		}
+
+		if (c == EOF)
+			break;
+
+		prev = c;
+		run = 1;
+	}
+
+	return flush_literal(&enc);
+}
+
+int rle_decode(struct lzss_io *io)
+{
+	for (;;) {
+		int c = io->rd(io->i);
+		unsigned n;
+
+		if (c == EOF)
+			break;
+
+		if (c == LZSS_ERROR)
+			return -1;
+
+		if (c < 0x80) {
+			for (n = c + 1; n; --n) {
+				c = io->rd(io->i);
+
+				if ((c == EOF) || (c == LZSS_ERROR))
+					return -1;
+
+				if (io->wr(c, io->o) == LZSS_ERROR)
+					return -1;
+			}
+		} else {
+			n = c - 0x80 + RLE_MIN_RUN;
+			c = io->rd(io->i);
+
+			if ((c == EOF) || (c == LZSS_ERROR))
+				return -1;
+
+			while (n--)
+				if (io->wr(c, io->o) == LZSS_ERROR)
+					return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * static functions
+ */
+
+static int flush_literal(struct rle_enc *enc)
+{
+	unsigned i;
+
+	if (!enc->n_literal)
+		return 0;
+
+	if (enc->io->wr(enc->n_literal - 1, enc->io->o) == LZSS_ERROR)
+		return -1;
+
+	for (i = 0; i < enc->n_literal; ++i)
+		if (enc->io->wr(enc->literal[i], enc->io->o) == LZSS_ERROR)
+			return -1;
+
+	enc->n_literal = 0;
+
+	return 0;
+}
+
+static int add_literal(struct rle_enc *enc, uint8_t c, unsigned n)
+{
+	while (n--) {
+		if ((enc->n_literal == RLE_MAX_LITERAL) && flush_literal(enc))
+			return -1;
+
+		enc->literal[enc->n_literal++] = c;
+	}
+
+	return 0;
+}
+
+static int put_run(struct rle_enc *enc, uint8_t c, unsigned n)
+{
+	if (flush_literal(enc))
+		return -1;
+
+	if (enc->io->wr(n - RLE_MIN_RUN + 0x80, enc->io->o) == LZSS_ERROR)
+		return -1;
+
+	if (enc->io->wr(c, enc->io->o) == LZSS_ERROR)
+		return -1;
+
+	return 0;
+}
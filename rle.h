@@ -0,0 +1,63 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * rle.h -- Run-length encoding
+ */
+
+#ifndef INCLUDE_RLE_H
+#define INCLUDE_RLE_H 1
+
+#include "lzss.h"
+
+/**
+   @file rle.h
+
+   Byte-oriented run-length encoding for images with large flat areas.
+
+   The encoded data is a sequence of packets, each starting with a control
+   byte c.  If c is lower than 0x80, it is followed by c + 1 literal bytes.
+   Otherwise, it is followed by a single byte which is repeated
+   c - 0x80 + RLE_MIN_RUN times.
+
+   The same I/O interface as the LZSS functions is used so both can be used
+   interchangeably by the callers.  Errors are reported with LZSS_ERROR.
+*/
+
+/** Shortest run encoded as a repeated byte */
+#define RLE_MIN_RUN 3
+
+/** Longest run encoded in a single packet */
+#define RLE_MAX_RUN (0x7F + RLE_MIN_RUN)
+
+/** Maximum number of literal bytes in a single packet */
+#define RLE_MAX_LITERAL 0x80
+
+/** Encode some data
+    @param[in] io pointer to an I/O API instance
+    @return -1 if error (i.e. I/O error), 0 otherwise
+ */
+extern int rle_encode(struct lzss_io *io);
+
+/** Decode some data
+    @param[in] io pointer to an I/O API instance
+    @return -1 if error (i.e. I/O error or truncated data), 0 otherwise
+ */
+extern int rle_decode(struct lzss_io *io);
+
+#endif /* INCLUDE_RLE_H */
@@ -0,0 +1,166 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * scramble.c -- Display data scrambling
+ */
+
+#include "scramble.h"
+
+#define ALIGN8(_value) ((((_value) + 7) / 8) * 8)
+
+static uint16_t calcPixelIndex(uint16_t gl, uint16_t sl, uint16_t slCount);
+
+uint16_t scramble_array(uint8_t* source, uint8_t* target, uint16_t *glCount, uint16_t *slCount, uint16_t scramblingMode){
+
+	uint16_t sl,gl;
+	uint16_t targetIdx;
+	uint16_t sourceIdx;
+	uint16_t _glCount = *glCount;
+	uint16_t _slCount = *slCount;
+	uint16_t __glCount = _glCount;
+	uint16_t __slCount = _slCount;
+
+	if (scramblingMode == 0){
+		// no need to scramble image data, just copy
+		return 0;
+	}
+	else {
+		// need to scramble image data based on scrambling mode
+		for(gl=0; gl< _glCount; gl++)
+		{
+			for(sl=0; sl< _slCount; sl++)
+			{
+				__glCount = _glCount;
+				__slCount = _slCount;
+
+				targetIdx = calcScrambledIndex(scramblingMode, gl, sl , &__glCount, &__slCount);
+				sourceIdx = calcPixelIndex(gl, sl, _slCount);
+				target[targetIdx] = source[sourceIdx];
+				source[sourceIdx] = 0xFF;
+				//LOG("sourceIdx: %i, targetIdx: %i", sourceIdx, targetIdx);
+			}
+		}
+		*glCount = __glCount;
+		*slCount = __slCount;
+		return 1;
+	}
+}
+
+uint16_t calcScrambledIndex(uint16_t scramblingMode, uint16_t gl, uint16_t sl, uint16_t *glCount, uint16_t *slCount){
+	// set starting values
+	uint16_t newGlIdx = gl;
+	uint16_t newSlIdx = sl;
+	uint16_t _glCount = *glCount;
+	uint16_t _slCount = *slCount;
+
+	// source line scrambling for half nbr of gate lines and double nbr of source lines
+	// scrambling between the scrambling resolution
+	if (scramblingMode & SCRAMBLING_SOURCE_SCRAMBLE_MASK)
+	{
+		_glCount = _glCount/2;
+		_slCount = _slCount*2;
+
+		if(scramblingMode & SCRAMBLING_SCRAMBLE_FIRST_ODD_LINE_MASK)
+		{
+			newSlIdx = (newGlIdx%2) ? newSlIdx*2 : (newSlIdx*2+1);
+			newGlIdx = newGlIdx/2;
+		}
+		else
+		{
+			newSlIdx = (newGlIdx%2) ? (newSlIdx*2+1) : newSlIdx*2;
+			newGlIdx = newGlIdx/2;
+		}
+	}
+	// gate line scrambling for half nbr of source lines and double nbr of gate lines
+	else if (scramblingMode & SCRAMBLING_GATE_SCRAMBLE_MASK){
+
+		_glCount = _glCount*2;
+		_slCount = _slCount/2;
+
+		if(scramblingMode & SCRAMBLING_SCRAMBLE_FIRST_ODD_LINE_MASK){
+			// scrambling between image resolution and scrambling resolution
+			// move every even source line to the next gate line
+			// by bisect the source line index
+			newGlIdx = (newGlIdx*2) + (newSlIdx+1)%2;
+			newSlIdx = (newSlIdx/2);
+		}
+		else{
+			// scrambling between image resolution and scrambling resolution
+			// move every odd source line to the next gate line
+			// by bisect the source line index
+			newGlIdx = (newGlIdx*2) + newSlIdx%2;
+			newSlIdx = (newSlIdx/2);
+		}
+	}
+
+	// check for difference in source interlaced setting
+	if (scramblingMode & SCRAMBLING_SOURCE_INTERLACED_MASK){
+		if(scramblingMode & SCRAMBLING_SOURCE_INTERLACED_FIRST_ODD_LINE_MASK){
+			newSlIdx = ((newSlIdx+1) % 2) ? ((newSlIdx/2)+_slCount/2) : (newSlIdx/2);
+		}
+		else{
+			newSlIdx = ((newSlIdx) % 2) ? ((newSlIdx/2)+_slCount/2) : (newSlIdx/2);
+		}
+	}
+
+	// mirrors the first image half
+	if (scramblingMode & SCRAMBLING_SOURCE_MIRROR_LH_MASK){
+		if(newSlIdx < _slCount/2){
+			newSlIdx = (_slCount/2 - 1) - newSlIdx;
+		}
+	}
+
+	// mirrors the second image half
+	if (scramblingMode & SCRAMBLING_SOURCE_MIRROR_RH_MASK){
+		if(newSlIdx >= _slCount/2){
+			newSlIdx = (_slCount-1) - (newSlIdx - (_slCount/2)) ;
+		}
+	}
+
+	// check for difference in source direction setting
+	if (scramblingMode & SCRAMBLING_SOURCE_DIRECTION_MASK){
+		newSlIdx = _slCount-newSlIdx-1;
+	}
+
+	// check for difference in source direction setting
+	if (scramblingMode & SCRAMBLING_SOURCE_START_MASK){
+		newSlIdx = (newSlIdx+_slCount/2)%_slCount;
+	}
+
+	// check for difference in gate direction setting
+	if (scramblingMode & SCRAMBLING_GATE_DIRECTION_MASK){
+		newGlIdx = _glCount-newGlIdx-1;
+	}
+
+	*glCount = _glCount;
+	*slCount = _slCount;
+
+	return calcPixelIndex(newGlIdx, newSlIdx, _slCount);
+}
+
+static uint16_t calcPixelIndex(uint16_t gl, uint16_t sl, uint16_t slCount)
+{
+	return gl*slCount+sl;
+}
+
+uint16_t scramble_source_pad(uint16_t source_offset)
+{
+	return ALIGN8(source_offset / 2) -
+		(ALIGN8(source_offset) - source_offset);
+}
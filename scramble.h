@@ -0,0 +1,88 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * scramble.h -- Display data scrambling
+ */
+
+#ifndef INCLUDE_SCRAMBLE_H
+#define INCLUDE_SCRAMBLE_H 1
+
+#include <stdint.h>
+
+/* This file has no platform dependencies so it can also be used by the host
+ * tools which prepare the image files (see tools/convert). */
+
+/**
+ * defines a structure representing a array scrambling configuration
+ *
+ * source_interlaced: defines whether the data will be interlaced or not
+ *                    0 -> no interlacing:  S0, S1, S2, S3, S4, ...
+ *                    1 -> interlacing:     S0, Sn, S1, Sn+1, S2, Sn+2, ...  (with n = slCount/2)
+ *
+ * source_direction: direction of source data
+ * 					  0 -> upwards: 		S0, S1, S2, S3, ...
+ * 					  1 -> downwards: 		Sn, Sn-1, Sn-2, Sn-3, ...        (with n = slCount)
+ *
+ * source_start: starting position for source outputs, either left (default) or right
+ * 					  0 -> left:			S0 is output first
+ * 					  1 -> right:			Sn is output first 				 (with n = slCount/2)
+ *
+ * gate_direction: direction of gate data
+ * 					  0 -> upwards: 		G0, G1, G2, G3, ...
+ * 					  1 -> downwards: 		Gn, Gn-1, Gn-2, Gn-3, ...		 (with n = glCount)
+ *
+ */
+
+#define SCRAMBLING_SOURCE_START_BIT				0
+#define SCRAMBLING_SOURCE_INTERLACED_BIT		1
+#define SCRAMBLING_SOURCE_DIRECTION_BIT			2
+#define SCRAMBLING_GATE_DIRECTION_BIT			3
+#define SCRAMBLING_SOURCE_SCRAMBLE_BIT			4	// source line is connected to every 2nd pixel
+#define SCRAMBLING_GATE_SCRAMBLE_BIT			5	// gate line is connected to every 2nd pixel
+#define SCRAMBLING_SCRAMBLE_FIRST_ODD_LINE_BIT	6	// if is set the odd lines will be first
+#define SCRAMBLING_SOURCE_MIRROR_RH_BIT 		7	// mirrors the first image half
+#define SCRAMBLING_SOURCE_INTERLACED_FIRST_ODD_LINE_BIT 8
+#define SCRAMBLING_SOURCE_MIRROR_LH_BIT			9	// mirrors the second image half
+
+#define SCRAMBLING_SOURCE_START_MASK			(1 << SCRAMBLING_SOURCE_START_BIT)
+#define SCRAMBLING_SOURCE_INTERLACED_MASK 		(1 << SCRAMBLING_SOURCE_INTERLACED_BIT)
+#define SCRAMBLING_SOURCE_DIRECTION_MASK		(1 << SCRAMBLING_SOURCE_DIRECTION_BIT)
+#define SCRAMBLING_GATE_DIRECTION_MASK			(1 << SCRAMBLING_GATE_DIRECTION_BIT)
+#define SCRAMBLING_SOURCE_SCRAMBLE_MASK			(1 << SCRAMBLING_SOURCE_SCRAMBLE_BIT)
+#define SCRAMBLING_GATE_SCRAMBLE_MASK			(1 << SCRAMBLING_GATE_SCRAMBLE_BIT)
+#define SCRAMBLING_SCRAMBLE_FIRST_ODD_LINE_MASK	(1 << SCRAMBLING_SCRAMBLE_FIRST_ODD_LINE_BIT)
+#define SCRAMBLING_SOURCE_MIRROR_RH_MASK 		(1 << SCRAMBLING_SOURCE_MIRROR_RH_BIT)
+#define SCRAMBLING_SOURCE_INTERLACED_FIRST_ODD_LINE_MASK (1 << SCRAMBLING_SOURCE_INTERLACED_FIRST_ODD_LINE_BIT)
+#define SCRAMBLING_SOURCE_MIRROR_LH_MASK 		(1 << SCRAMBLING_SOURCE_MIRROR_LH_BIT)
+
+
+/** copies data from source to target array while applying a scrambling algorithm
+ * S0, Sn, S1, Sn+1, S2, Sn+2; with n = slCount/2;
+ * no scrambling in gate direction
+ * Expects data in source array as sourceline fast addressed and starting with gate=0 and source=0.
+ */
+uint16_t scramble_array(uint8_t* source, uint8_t* target, uint16_t *glCount, uint16_t *slCount, uint16_t scramblingMode);
+
+uint16_t calcScrambledIndex(uint16_t scramblingMode, uint16_t gl, uint16_t sl, uint16_t *glCount, uint16_t *slCount);
+
+/** Number of padding pixels to insert on the left of each scrambled line to
+ * honour the source_offset setting of a display */
+uint16_t scramble_source_pad(uint16_t source_offset);
+
+#endif /* INCLUDE_SCRAMBLE_H */
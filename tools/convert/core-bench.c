@@ -0,0 +1,971 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * core-bench.c -- Microbenchmarks for the portable core modules
+ */
+
+#define _GNU_SOURCE
+
+#include <app/parser.h>
+#include <pl/endian.h>
+#include <pl/types.h>
+#include <crc16.h>
+#include <lzss.h>
+#include <pattern.h>
+#include <font.h>
+#include <pnm-utils.h>
+#include <scramble.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "assert.h"
+#include "posix-fatfs.h"
+#include "utils.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+/* Same as S1D13541 waveform libraries, which are also LZSS compressed */
+#define WF_SIZE (48 * 1024)
+#define IMG_WIDTH 1280
+#define IMG_HEIGHT 960
+#define SCRIPT_LINES 2000
+#define SWAP_WORDS 1024
+#define MAX_REPS 1000
+#define MAX_BASELINE 64
+
+static const char PGM_NAME[] = "bench.pgm";
+static const char SCRIPT_NAME[] = "bench.txt";
+static const char SEP[] = ", ";
+
+struct mem_buffer {
+	const uint8_t *in;
+	size_t in_len;
+	size_t in_pos;
+	uint8_t *out;
+	size_t out_len;
+	size_t out_size;
+};
+
+/* Inputs shared by all the benchmarks */
+struct inputs {
+	uint8_t *wf;
+	size_t wf_len;
+	uint8_t *wf_lzss;
+	size_t wf_lzss_len;
+	uint8_t *img;
+	unsigned width;
+	unsigned height;
+	char *script;
+	size_t script_len;
+	char dir[32];
+};
+
+struct bench {
+	const char *name;
+	size_t (*run)(struct inputs *in);     /* one op, returns its bytes */
+};
+
+struct result {
+	char name[24];
+	unsigned long ops;
+	double ns_op;
+	double min_ns_op;
+	double mb_s;
+	double cycles_byte;
+};
+
+struct options {
+	unsigned warmup;
+	unsigned reps;
+	unsigned min_ms;
+	unsigned mhz;
+	unsigned threshold;
+	const char *baseline;
+	const char *filter;
+};
+
+/* Prevent the compiler from discarding the benchmark results */
+static volatile unsigned sink;
+
+/* Defined in main.c on the target, used by utils.c */
+void abort_now(const char *abort_msg, enum abort_error error_code)
+{
+	fprintf(stderr, "abort: %s (%d)\n", abort_msg, error_code);
+	exit(2);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	return ((uint64_t)t.tv_sec * 1000000000ULL) + t.tv_nsec;
+}
+
+static uint64_t now_cycles(void)
+{
+#if HAVE_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/* Deterministic pseudo-random numbers so runs can be compared */
+static uint32_t lcg_state = 0x1234567;
+
+static unsigned lcg(unsigned n)
+{
+	lcg_state = (lcg_state * 1103515245UL) + 12345UL;
+
+	return (lcg_state >> 16) % n;
+}
+
+/* ----------------------------------------------------------------------------
+ * Inputs
+ */
+
+static int mem_rd(void *ctx)
+{
+	struct mem_buffer *buf = ctx;
+
+	if (buf->in_pos == buf->in_len)
+		return EOF;
+
+	return buf->in[buf->in_pos++];
+}
+
+static int mem_wr(int c, void *ctx)
+{
+	struct mem_buffer *buf = ctx;
+
+	if (buf->out_len == buf->out_size) {
+		size_t size = buf->out_size ? (buf->out_size * 2) : 4096;
+		uint8_t *out = realloc(buf->out, size);
+
+		if (out == NULL)
+			return LZSS_ERROR;
+
+		buf->out = out;
+		buf->out_size = size;
+	}
+
+	buf->out[buf->out_len++] = c;
+
+	return c;
+}
+
+static int lzss_mem(const uint8_t *data, size_t n, struct mem_buffer *buf,
+		    int encode)
+{
+	struct lzss_io io;
+	struct lzss lzss;
+	int ret;
+
+	buf->in = data;
+	buf->in_len = n;
+	buf->in_pos = 0;
+	buf->out_len = 0;
+	io.rd = mem_rd;
+	io.wr = mem_wr;
+	io.i = buf;
+	io.o = buf;
+
+	if (lzss_init(&lzss, LZSS_STD_EI, LZSS_STD_EJ) ||
+	    lzss_alloc_buffer(&lzss))
+		return -1;
+
+	ret = encode ? lzss_encode(&lzss, &io) : lzss_decode(&lzss, &io);
+	lzss_free_buffer(&lzss);
+
+	return ret;
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+	uint8_t *data;
+	FILE *f;
+	long n;
+
+	f = fopen(path, "rb");
+
+	if (f == NULL)
+		return NULL;
+
+	fseek(f, 0, SEEK_END);
+	n = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	data = malloc(n + 1);
+
+	if ((data != NULL) && (fread(data, 1, n, f) != (size_t)n)) {
+		free(data);
+		data = NULL;
+	}
+
+	fclose(f);
+
+	if (data != NULL) {
+		data[n] = '\0';
+		*len = n;
+	}
+
+	return data;
+}
+
+/* Waveform libraries are made of long runs of the same phase values with
+ * timing and voltage tables in between */
+static void make_waveform(struct inputs *in)
+{
+	size_t i = 0;
+
+	in->wf_len = WF_SIZE;
+	in->wf = malloc(in->wf_len);
+
+	while (i < in->wf_len) {
+		const size_t run = 1 + lcg(lcg(8) ? 64 : 4);
+		const uint8_t phase = lcg(4) * 0x55;
+		size_t j;
+
+		for (j = 0; (j < run) && (i < in->wf_len); ++j)
+			in->wf[i++] = lcg(16) ? phase : lcg(256);
+	}
+}
+
+/* Grey gradient with dithering noise and a few flat user interface boxes */
+static void make_image(struct inputs *in)
+{
+	unsigned x, y, i;
+
+	in->width = IMG_WIDTH;
+	in->height = IMG_HEIGHT;
+	in->img = malloc(in->width * in->height);
+
+	for (y = 0; y < in->height; ++y)
+		for (x = 0; x < in->width; ++x)
+			in->img[(y * in->width) + x] =
+				((x * 16 / in->width) * 0x11) ^ (lcg(4) << 2);
+
+	for (i = 0; i < 16; ++i) {
+		const unsigned w = 40 + lcg(200), h = 20 + lcg(100);
+		const unsigned left = lcg(in->width - w);
+		const unsigned top = lcg(in->height - h);
+		const uint8_t grey = lcg(16) * 0x11;
+
+		for (y = top; y < (top + h); ++y)
+			memset(&in->img[(y * in->width) + left], grey, w);
+	}
+}
+
+static int load_pgm(struct inputs *in, const char *path)
+{
+	unsigned width, height, max_grey;
+	size_t len;
+	uint8_t *data;
+	int pos;
+
+	data = read_file(path, &len);
+
+	if (data == NULL)
+		return -1;
+
+	if ((sscanf((const char *)data, "P5 %u %u %u%n", &width, &height,
+		    &max_grey, &pos) != 3) || (max_grey > 255) ||
+	    ((size_t)pos + 1 + ((size_t)width * height) > len)) {
+		fprintf(stderr, "Unsupported PGM file: %s\n", path);
+		free(data);
+		return -1;
+	}
+
+	in->width = width;
+	in->height = height;
+	in->img = malloc(width * height);
+	memcpy(in->img, &data[pos + 1], width * height);
+	free(data);
+
+	return 0;
+}
+
+/* Same commands as in the sequencer slides files */
+static void make_script(struct inputs *in)
+{
+	const size_t size = SCRIPT_LINES * 64;
+	size_t len = 0;
+	unsigned i;
+
+	in->script = malloc(size);
+
+	for (i = 0; i < SCRIPT_LINES; ++i) {
+		char *l = &in->script[len];
+		const size_t n = size - len;
+
+		switch (lcg(5)) {
+		case 0:
+			len += snprintf(l, n, "image, img/%03u.pgm, %u, %u, "
+					"%u, %u, %u, %u\n", lcg(100), lcg(400),
+					lcg(300), lcg(400), lcg(300),
+					1 + lcg(800), 1 + lcg(600));
+			break;
+		case 1:
+			len += snprintf(l, n, "fill, %u, %u, %u, %u, %u\n",
+					lcg(400), lcg(300), 1 + lcg(800),
+					1 + lcg(600), lcg(16));
+			break;
+		case 2:
+			len += snprintf(l, n, "update, %u, %u, %u, %u, %u, "
+					"%u, %u\n", lcg(6), lcg(2), lcg(400),
+					lcg(300), 1 + lcg(800), 1 + lcg(600),
+					lcg(1000));
+			break;
+		case 3:
+			len += snprintf(l, n, "power, %s\n",
+					lcg(2) ? "on" : "off");
+			break;
+		default:
+			len += snprintf(l, n, "sleep, %u\n", lcg(5000));
+			break;
+		}
+	}
+
+	in->script_len = len;
+}
+
+static int write_file(const char *dir, const char *name, const char *hdr,
+		      const void *data, size_t n)
+{
+	char path[64];
+	FILE *f;
+	int ret;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	f = fopen(path, "wb");
+
+	if (f == NULL)
+		return -1;
+
+	ret = ((hdr != NULL) && (fputs(hdr, f) < 0)) ||
+		(fwrite(data, 1, n, f) != n);
+
+	return (fclose(f) || ret) ? -1 : 0;
+}
+
+static void remove_files(const struct inputs *in)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "%s/%s", in->dir, PGM_NAME);
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/%s", in->dir, SCRIPT_NAME);
+	unlink(path);
+	rmdir(in->dir);
+}
+
+static int prepare_files(struct inputs *in)
+{
+	struct mem_buffer buf;
+	char hdr[32];
+
+	memset(&buf, 0, sizeof(buf));
+
+	if (lzss_mem(in->wf, in->wf_len, &buf, 1))
+		return -1;
+
+	in->wf_lzss = buf.out;
+	in->wf_lzss_len = buf.out_len;
+
+	strcpy(in->dir, "/tmp/core-bench-XXXXXX");
+
+	if (mkdtemp(in->dir) == NULL)
+		return -1;
+
+	posix_fatfs_set_root(in->dir);
+	snprintf(hdr, sizeof(hdr), "P5\n%u %u\n255\n", in->width, in->height);
+
+	if (write_file(in->dir, PGM_NAME, hdr, in->img,
+		       in->width * in->height) ||
+	    write_file(in->dir, SCRIPT_NAME, NULL, in->script,
+		       in->script_len)) {
+		remove_files(in);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Benchmarks
+ */
+
+static size_t bench_crc16(struct inputs *in)
+{
+	sink += crc16_run(crc16_init, in->wf, in->wf_len);
+
+	return in->wf_len;
+}
+
+static size_t bench_lzss_decode(struct inputs *in)
+{
+	static struct mem_buffer buf;
+
+	if (lzss_mem(in->wf_lzss, in->wf_lzss_len, &buf, 0) ||
+	    (buf.out_len != in->wf_len))
+		abort_now("LZSS decoding failed", ABORT_UNDEFINED);
+
+	return in->wf_len;
+}
+
+static size_t bench_lzss_encode(struct inputs *in)
+{
+	static struct mem_buffer buf;
+
+	if (lzss_mem(in->wf, in->wf_len, &buf, 1))
+		abort_now("LZSS encoding failed", ABORT_UNDEFINED);
+
+	return in->wf_len;
+}
+
+/* Same line by line pattern as transfer_file_scrambled() */
+static size_t scramble_image(struct inputs *in, uint16_t mode)
+{
+	static uint8_t *src, *dst;
+	const unsigned step = (mode & SCRAMBLING_SOURCE_SCRAMBLE_MASK) ? 2 : 1;
+	unsigned y;
+
+	if (src == NULL) {
+		src = malloc(in->width * 2);
+		dst = malloc(in->width * 4);
+	}
+
+	for (y = 0; (y + step) <= in->height; y += step) {
+		uint16_t gl = step;
+		uint16_t sl = in->width;
+
+		/* scramble_array() overwrites its source buffer */
+		memcpy(src, &in->img[y * in->width], step * in->width);
+		scramble_array(src, dst, &gl, &sl, mode);
+		sink += dst[0];
+	}
+
+	return (size_t)in->width * in->height;
+}
+
+static size_t bench_scramble_s049(struct inputs *in)
+{
+	return scramble_image(in, 96);
+}
+
+static size_t bench_scramble_s115(struct inputs *in)
+{
+	return scramble_image(in, 36);
+}
+
+static size_t bench_scrambled_index(struct inputs *in)
+{
+	uint16_t sl;
+
+	for (sl = 0; sl < in->width; ++sl) {
+		uint16_t g = 1, s = in->width;
+
+		sink += calcScrambledIndex(96, 0, sl, &g, &s);
+	}
+
+	return in->width;
+}
+
+static size_t bench_swap16_array(struct inputs *in)
+{
+	static int16_t *ptrs[SWAP_WORDS];
+	unsigned i;
+
+	if (ptrs[0] == NULL)
+		for (i = 0; i < SWAP_WORDS; ++i)
+			ptrs[i] = (int16_t *)&in->img[i * 2];
+
+	swap16_array(ptrs, SWAP_WORDS);
+
+	return SWAP_WORDS * 2;
+}
+
+static size_t bench_pnm_header(struct inputs *in)
+{
+	struct pnm_header hdr;
+	FIL f;
+
+	if ((f_open(&f, PGM_NAME, FA_READ) != FR_OK) ||
+	    pnm_read_header(&f, &hdr) || (hdr.width != (int)in->width))
+		abort_now("Failed to read PGM header", ABORT_UNDEFINED);
+
+	sink += hdr.height;
+	f_close(&f);
+
+	return f.fptr;
+}
+
+/* Same as the sequencer pattern command, all the types in turn */
+static size_t bench_pattern(struct inputs *in)
+{
+	static uint8_t buffer[2 * IMG_WIDTH];
+	static unsigned type;
+	struct pattern pat;
+	uint16_t y;
+
+	pat.type = type++ % PATTERN_N;
+	pat.width = IMG_WIDTH;
+	pat.height = IMG_HEIGHT;
+	pat.size = 0;
+	pat.fg = 0x00;
+	pat.bg = 0xFF;
+	pat.bpp = 8;
+
+	if (pattern_init(&pat, buffer, sizeof(buffer)))
+		abort_now("Failed to initialise pattern", ABORT_UNDEFINED);
+
+	for (y = 0; y < pat.height; ++y)
+		sink += pattern_line(&pat, y)[y % pat.width];
+
+	return (size_t)pat.width * pat.height;
+}
+
+/* Same as the sequencer text command with the built-in font, one status line
+ * scaled up across the image width and packed to 4bpp */
+static size_t bench_text(struct inputs *in)
+{
+	static uint8_t line[IMG_WIDTH];
+	struct font_text t;
+	uint16_t x, y;
+
+	t.font = &font_5x9;
+	t.text = "Status: 12:34  Price: 1234.56 EUR  Stock: 789 items left";
+	t.width = IMG_WIDTH;
+	t.scale = 4;
+	t.fg = 0x00;
+	t.bg = 0xFF;
+
+	if (font_text_init(&t, NULL, 0))
+		abort_now("Failed to initialise text", ABORT_UNDEFINED);
+
+	for (y = 0; y < (font_5x9.height * t.scale); ++y) {
+		font_text_line(&t, y, line);
+
+		/* packed to 4bpp as sent to the EPDC */
+		for (x = 0; x < (IMG_WIDTH / 2); ++x)
+			line[x] = (line[2 * x] >> 4) | (line[(2 * x) + 1] & 0xF0);
+
+		sink += line[y];
+	}
+
+	return (size_t)t.width * font_5x9.height * t.scale;
+}
+
+/* Same parsing as the sequencer commands */
+static void parse_line(const char *line)
+{
+	char cmd[16];
+	char file[32];
+	struct pl_area area;
+	int a, b;
+	int len;
+
+	len = parser_read_str(line, SEP, cmd, sizeof(cmd));
+
+	if (len <= 0)
+		return;
+
+	line += len;
+
+	if (!strcmp(cmd, "image")) {
+		int *coords[] = { &a, &b, &area.left, &area.top, &area.width,
+				  &area.height, NULL };
+
+		len = parser_read_str(line, SEP, file, sizeof(file));
+
+		if (len > 0)
+			parser_read_int_list(line + len, SEP, coords);
+	} else if (!strcmp(cmd, "fill")) {
+		len = parser_read_area(line, SEP, &area);
+
+		if (len > 0)
+			parser_read_int(line + len, SEP, &a);
+	} else if (!strcmp(cmd, "update")) {
+		len = parser_read_int(line, SEP, &a);
+		line += len;
+		len = parser_read_int(line, SEP, &b);
+		line += len;
+		len = parser_read_area(line, SEP, &area);
+
+		if (len > 0)
+			parser_read_int(line + len, SEP, &a);
+	} else if (!strcmp(cmd, "power")) {
+		parser_read_str(line, SEP, file, sizeof(file));
+	} else {
+		parser_read_int(line, SEP, &a);
+	}
+
+	sink += area.width + a;
+}
+
+static size_t bench_parser(struct inputs *in)
+{
+	char line[96];
+	const char *it = in->script;
+
+	while (*it) {
+		const char *end = strchr(it, '\n');
+		const size_t n = end - it;
+
+		memcpy(line, it, n);
+		line[n] = '\0';
+		parse_line(line);
+		it = end + 1;
+	}
+
+	return in->script_len;
+}
+
+static size_t bench_parser_file(struct inputs *in)
+{
+	char line[96];
+	FIL f;
+	int stat;
+
+	if (f_open(&f, SCRIPT_NAME, FA_READ) != FR_OK)
+		abort_now("Failed to open script", ABORT_UNDEFINED);
+
+	while ((stat = parser_read_file_line(&f, line, sizeof(line))) > 0)
+		sink += line[0];
+
+	f_close(&f);
+
+	if (stat < 0)
+		abort_now("Failed to read script", ABORT_UNDEFINED);
+
+	return in->script_len;
+}
+
+static const struct bench benches[] = {
+	{ "crc16", bench_crc16 },
+	{ "lzss-decode", bench_lzss_decode },
+	{ "lzss-encode", bench_lzss_encode },
+	{ "scramble-s049", bench_scramble_s049 },
+	{ "scramble-s115", bench_scramble_s115 },
+	{ "scrambled-index", bench_scrambled_index },
+	{ "swap16-array", bench_swap16_array },
+	{ "pnm-header", bench_pnm_header },
+	{ "pattern", bench_pattern },
+	{ "text", bench_text },
+	{ "parser", bench_parser },
+	{ "parser-file", bench_parser_file },
+};
+
+/* ----------------------------------------------------------------------------
+ * Harness
+ */
+
+static int cmp_double(const void *a, const void *b)
+{
+	const double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Run the warm-up iterations, then find how many ops make one repetition at
+ * least min_ms long and keep the median of all the repetitions */
+static void run_bench(const struct bench *b, struct inputs *in,
+		      const struct options *opt, struct result *res)
+{
+	static double rep_ns[MAX_REPS];
+	static double rep_cycles[MAX_REPS];
+	unsigned long ops = 1;
+	size_t bytes = 0;
+	unsigned i;
+
+	for (i = 0; i < opt->warmup; ++i)
+		bytes = b->run(in);
+
+	for (;;) {
+		const uint64_t t0 = now_ns();
+		unsigned long j;
+
+		for (j = 0; j < ops; ++j)
+			bytes = b->run(in);
+
+		if ((now_ns() - t0) >= (opt->min_ms * 1000000ULL))
+			break;
+
+		ops *= 2;
+	}
+
+	for (i = 0; i < opt->reps; ++i) {
+		const uint64_t t0 = now_ns();
+		const uint64_t c0 = now_cycles();
+		unsigned long j;
+
+		for (j = 0; j < ops; ++j)
+			b->run(in);
+
+		rep_cycles[i] = (double)(now_cycles() - c0) / ops;
+		rep_ns[i] = (double)(now_ns() - t0) / ops;
+	}
+
+	qsort(rep_ns, opt->reps, sizeof(double), cmp_double);
+	qsort(rep_cycles, opt->reps, sizeof(double), cmp_double);
+
+	snprintf(res->name, sizeof(res->name), "%s", b->name);
+	res->ops = ops * opt->reps;
+	res->ns_op = rep_ns[opt->reps / 2];
+	res->min_ns_op = rep_ns[0];
+	res->mb_s = (bytes * 1000.0) / res->ns_op;
+
+	if (opt->mhz)
+		res->cycles_byte = (res->ns_op * opt->mhz) / (bytes * 1000.0);
+	else
+		res->cycles_byte = rep_cycles[opt->reps / 2] / bytes;
+
+	printf("%s,%lu,%lu,%.1f,%.1f,%.2f,%.3f\n", res->name,
+	       (unsigned long)bytes, res->ops, res->ns_op, res->min_ns_op,
+	       res->mb_s, res->cycles_byte);
+	fflush(stdout);
+}
+
+static int read_baseline(const char *path, struct result *base, unsigned max)
+{
+	char line[128];
+	unsigned n = 0;
+	FILE *f;
+
+	f = fopen(path, "r");
+
+	if (f == NULL) {
+		fprintf(stderr, "Failed to open baseline: %s\n", path);
+		return -1;
+	}
+
+	while ((n < max) && (fgets(line, sizeof(line), f) != NULL)) {
+		struct result *r = &base[n];
+		unsigned long bytes;
+
+		if (sscanf(line, "%23[^,],%lu,%lu,%lf,%lf,%lf,%lf", r->name,
+			   &bytes, &r->ops, &r->ns_op, &r->min_ns_op,
+			   &r->mb_s, &r->cycles_byte) == 7)
+			++n;
+	}
+
+	fclose(f);
+
+	return n;
+}
+
+/* Report each benchmark which is slower than the baseline by more than the
+ * threshold in percent, and return the number of regressions.  The fastest
+ * repetitions are compared as they are the least affected by other tasks
+ * running on the host. */
+static int check_baseline(const struct result *res, unsigned n,
+			  const struct options *opt)
+{
+	struct result base[MAX_BASELINE];
+	int n_base;
+	int regressions = 0;
+	unsigned i;
+
+	n_base = read_baseline(opt->baseline, base, MAX_BASELINE);
+
+	if (n_base < 0)
+		return -1;
+
+	fprintf(stderr, "%-16s %12s %12s %8s\n", "bench", "base(ns/op)",
+		"min(ns/op)", "change");
+
+	for (i = 0; i < n; ++i) {
+		const struct result *b = NULL;
+		double change;
+		int j;
+
+		for (j = 0; j < n_base; ++j)
+			if (!strcmp(base[j].name, res[i].name))
+				b = &base[j];
+
+		if (b == NULL) {
+			fprintf(stderr, "%-16s %12s %12.1f\n", res[i].name,
+				"-", res[i].min_ns_op);
+			continue;
+		}
+
+		change = ((res[i].min_ns_op - b->min_ns_op) * 100.0) /
+			b->min_ns_op;
+		fprintf(stderr, "%-16s %12.1f %12.1f %+7.1f%%%s\n",
+			res[i].name, b->min_ns_op, res[i].min_ns_op, change,
+			(change > opt->threshold) ? " REGRESSION" : "");
+
+		if (change > opt->threshold)
+			++regressions;
+	}
+
+	return regressions;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+"Usage: %s [OPTIONS]\n"
+"\n"
+"Run the microbenchmarks of the portable modules (crc16, lzss, scramble,\n"
+"utils, pnm-utils, pattern, font and the sequencer parser) and print the\n"
+"results in CSV with the median time per op, MB/s and cycles per byte.\n"
+"\n"
+"  -w FILE   waveform file for crc16 and lzss (default: synthetic %u KB)\n"
+"  -i FILE   8-bit PGM image for scramble (default: synthetic %ux%u)\n"
+"  -s FILE   sequencer script for the parser (default: %u lines)\n"
+"  -k NAME   only run the benchmarks with NAME in their name\n"
+"  -W N      warm-up ops before measuring (default: 3)\n"
+"  -n N      number of repetitions, the median is reported (default: 7)\n"
+"  -m MS     minimum duration of each repetition (default: 20)\n"
+"  -F MHZ    CPU clock for cycles per byte (default: TSC cycles)\n"
+"  -b FILE   compare with a baseline CSV file made by an earlier run\n"
+"  -t PCT    regression threshold in percent with -b (default: 10)\n",
+		name, WF_SIZE / 1024, IMG_WIDTH, IMG_HEIGHT, SCRIPT_LINES);
+}
+
+int main(int argc, char **argv)
+{
+	struct result res[ARRAY_SIZE(benches)];
+	struct options opt;
+	struct inputs in;
+	const char *wf_path = NULL;
+	const char *img_path = NULL;
+	const char *script_path = NULL;
+	unsigned n = 0;
+	unsigned i;
+	int ret = 0;
+	int c;
+
+	memset(&in, 0, sizeof(in));
+	memset(&opt, 0, sizeof(opt));
+	opt.warmup = 3;
+	opt.reps = 7;
+	opt.min_ms = 20;
+	opt.threshold = 10;
+
+	while ((c = getopt(argc, argv, "w:i:s:k:W:n:m:F:b:t:")) != -1) {
+		switch (c) {
+		case 'w':
+			wf_path = optarg;
+			break;
+		case 'i':
+			img_path = optarg;
+			break;
+		case 's':
+			script_path = optarg;
+			break;
+		case 'k':
+			opt.filter = optarg;
+			break;
+		case 'W':
+			opt.warmup = strtoul(optarg, NULL, 10);
+			break;
+		case 'n':
+			opt.reps = strtoul(optarg, NULL, 10);
+			break;
+		case 'm':
+			opt.min_ms = strtoul(optarg, NULL, 10);
+			break;
+		case 'F':
+			opt.mhz = strtoul(optarg, NULL, 10);
+			break;
+		case 'b':
+			opt.baseline = optarg;
+			break;
+		case 't':
+			opt.threshold = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if ((optind != argc) || !opt.reps || (opt.reps > MAX_REPS)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (wf_path != NULL) {
+		in.wf = read_file(wf_path, &in.wf_len);
+
+		if ((in.wf == NULL) || !in.wf_len) {
+			fprintf(stderr, "Failed to read %s\n", wf_path);
+			return 1;
+		}
+	} else {
+		make_waveform(&in);
+	}
+
+	if (img_path != NULL) {
+		if (load_pgm(&in, img_path))
+			return 1;
+	} else {
+		make_image(&in);
+	}
+
+	if (script_path != NULL) {
+		in.script = (char *)read_file(script_path, &in.script_len);
+
+		if ((in.script == NULL) || !in.script_len ||
+		    (in.script[in.script_len - 1] != '\n')) {
+			fprintf(stderr, "Failed to read %s\n", script_path);
+			return 1;
+		}
+	} else {
+		make_script(&in);
+	}
+
+	if (prepare_files(&in)) {
+		fprintf(stderr, "Failed to prepare the input files\n");
+		return 1;
+	}
+
+	printf("bench,bytes,ops,ns_op,min_ns_op,mb_s,cycles_byte\n");
+
+	for (i = 0; i < ARRAY_SIZE(benches); ++i)
+		if ((opt.filter == NULL) ||
+		    (strstr(benches[i].name, opt.filter) != NULL))
+			run_bench(&benches[i], &in, &opt, &res[n++]);
+
+	remove_files(&in);
+
+	if (opt.baseline != NULL) {
+		const int regressions = check_baseline(res, n, &opt);
+
+		if (regressions)
+			ret = 1;
+
+		if (regressions > 0)
+			fprintf(stderr, "%d regression(s) above %u%%\n",
+				regressions, opt.threshold);
+	}
+
+	return ret;
+}
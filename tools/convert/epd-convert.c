@@ -0,0 +1,1067 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * epd-convert.c -- Convert images to device-ready files for a given display
+ */
+
+#define _DEFAULT_SOURCE
+#define PLIMG_FORMAT_ONLY
+
+#include <scramble.h>
+#include <plimg.h>
+#include <crc16.h>
+#include <lzss.h>
+#include <rle.h>
+#include <dirent.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_THREADS 64
+
+enum dither {
+	DITHER_NONE = 0,
+	DITHER_ORDERED,
+	DITHER_FS,
+};
+
+enum format {
+	FORMAT_PGM = 0,
+	FORMAT_4BPP,
+	FORMAT_1BPP,
+	FORMAT_PLIMG,
+};
+
+struct options {
+	const char *out_dir;
+	uint16_t scrambling;
+	uint16_t source_offset;
+	uint8_t epdc;
+	enum plimg_compression compression;
+	unsigned xres;
+	enum dither dither;
+	enum format format;
+	int verbose;
+};
+
+struct image {
+	unsigned width;
+	unsigned height;
+	unsigned src_width;
+	unsigned src_height;
+	uint8_t *data;
+};
+
+struct job_list {
+	char **paths;
+	unsigned n;
+	unsigned next;
+	unsigned errors;
+	pthread_mutex_t lock;
+	const struct options *opt;
+};
+
+struct panel {
+	const char *name;
+	uint16_t scrambling;
+	uint8_t epdc;
+};
+
+/* Same scrambling modes and boards as set by config.c for each display type,
+ * with the EPDC used on each board as in main.c */
+static const struct panel panels[] = {
+	{ "S079", 32, EPDC_S1D13524 },
+	{ "S115", 36, EPDC_S1D13524 },
+	{ "D107", 0, EPDC_S1D13524 },
+	{ "S047", 0, EPDC_S1D13524 },
+	{ "D054", 418, EPDC_S1D13541 },
+	{ "S049", 96, EPDC_S1D13541 },
+	{ "S040", 0, EPDC_S1D13541 },
+	{ NULL, 0, EPDC_NONE },
+};
+
+#define N_FORMATS 4
+static const char *format_ext[N_FORMATS] = { "pgm", "4bpp", "1bpp", "plimg" };
+static const unsigned format_levels[N_FORMATS] = { 16, 16, 2, 16 };
+
+struct mem_buffer {
+	const uint8_t *in;
+	size_t in_len;
+	size_t in_pos;
+	uint8_t *out;
+	size_t out_size;
+	size_t out_len;
+};
+
+/* 4x4 Bayer matrix */
+static const uint8_t bayer4[4][4] = {
+	{  0,  8,  2, 10 },
+	{ 12,  4, 14,  6 },
+	{  3, 11,  1,  9 },
+	{ 15,  7, 13,  5 },
+};
+
+/* ----------------------------------------------------------------------------
+ * PNM input
+ */
+
+static int pnm_read_int(FILE *f, unsigned *value)
+{
+	int c;
+
+	do {
+		c = fgetc(f);
+
+		if (c == '#') {
+			while ((c != '\n') && (c != EOF))
+				c = fgetc(f);
+		}
+	} while ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'));
+
+	if ((c < '0') || (c > '9'))
+		return -1;
+
+	*value = 0;
+
+	while ((c >= '0') && (c <= '9')) {
+		*value = (*value * 10) + (c - '0');
+		c = fgetc(f);
+	}
+
+	/* one white space character before the binary data */
+	return (c == EOF) ? -1 : 0;
+}
+
+/* Convert RGB to luma with integer BT.601 weights, kept as a simple loop over
+ * plain arrays so the compiler can vectorise it */
+static void rgb_to_grey(uint8_t *grey, const uint8_t *rgb, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; ++i) {
+		const unsigned r = rgb[(i * 3)];
+		const unsigned g = rgb[(i * 3) + 1];
+		const unsigned b = rgb[(i * 3) + 2];
+
+		grey[i] = ((77 * r) + (150 * g) + (29 * b) + 128) >> 8;
+	}
+}
+
+static void scale_grey(uint8_t *grey, const uint8_t *raw, size_t n,
+		       unsigned maxval)
+{
+	size_t i;
+
+	if (maxval < 256) {
+		for (i = 0; i < n; ++i)
+			grey[i] = ((raw[i] * 255) + (maxval / 2)) / maxval;
+	} else {
+		for (i = 0; i < n; ++i) {
+			const unsigned v = (raw[i * 2] << 8) | raw[(i * 2) + 1];
+
+			grey[i] = ((v * 255) + (maxval / 2)) / maxval;
+		}
+	}
+}
+
+static int pnm_load(const char *path, struct image *img)
+{
+	unsigned maxval;
+	unsigned channels;
+	unsigned bytes;
+	size_t n;
+	uint8_t *raw = NULL;
+	FILE *f;
+	int ret = -1;
+	char magic[2];
+
+	f = fopen(path, "rb");
+
+	if (f == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	if (fread(magic, 1, 2, f) != 2 || magic[0] != 'P' ||
+	    (magic[1] != '5' && magic[1] != '6')) {
+		fprintf(stderr, "%s: not a binary PGM or PPM file\n", path);
+		goto exit_close;
+	}
+
+	channels = (magic[1] == '6') ? 3 : 1;
+
+	if (pnm_read_int(f, &img->width) || pnm_read_int(f, &img->height) ||
+	    pnm_read_int(f, &maxval) || !maxval || (maxval > 65535) ||
+	    !img->width || !img->height) {
+		fprintf(stderr, "%s: invalid PNM header\n", path);
+		goto exit_close;
+	}
+
+	img->src_width = img->width;
+	img->src_height = img->height;
+	n = (size_t)img->width * img->height;
+	bytes = (maxval < 256) ? 1 : 2;
+	raw = malloc(n * channels * bytes);
+	img->data = malloc(n);
+
+	if ((raw == NULL) || (img->data == NULL)) {
+		fprintf(stderr, "%s: not enough memory\n", path);
+		goto exit_free;
+	}
+
+	if (fread(raw, channels * bytes, n, f) != n) {
+		fprintf(stderr, "%s: truncated file\n", path);
+		goto exit_free;
+	}
+
+	if (channels == 3) {
+		if (bytes == 2) {
+			size_t i;
+
+			/* keep the 8 most significant bits of each sample */
+			for (i = 0; i < (n * 3); ++i)
+				raw[i] = raw[i * 2];
+		}
+
+		rgb_to_grey(img->data, raw, n);
+
+		if (maxval != 255)
+			scale_grey(img->data, img->data, n,
+				   (bytes == 2) ? (maxval >> 8) : maxval);
+	} else if (maxval == 255) {
+		memcpy(img->data, raw, n);
+	} else {
+		scale_grey(img->data, raw, n, maxval);
+	}
+
+	ret = 0;
+
+exit_free:
+	free(raw);
+
+	if (ret) {
+		free(img->data);
+		img->data = NULL;
+	}
+exit_close:
+	fclose(f);
+
+	return ret;
+}
+
+/* ----------------------------------------------------------------------------
+ * Quantisation and dithering
+ */
+
+static inline uint8_t quantise(int value, unsigned max, int threshold)
+{
+	int level;
+
+	if (value < 0)
+		value = 0;
+	else if (value > 255)
+		value = 255;
+
+	level = ((value * (int)max) + threshold) / 255;
+
+	return (level > (int)max) ? max : level;
+}
+
+/* Replace each pixel with its level number, from 0 (black) to levels - 1 */
+static int dither_image(struct image *img, unsigned levels, enum dither dither)
+{
+	const unsigned max = levels - 1;
+	unsigned x, y;
+
+	if (dither == DITHER_NONE) {
+		uint8_t *it = img->data;
+		size_t n = (size_t)img->width * img->height;
+
+		while (n--) {
+			*it = quantise(*it, max, 127);
+			++it;
+		}
+	} else if (dither == DITHER_ORDERED) {
+		for (y = 0; y < img->height; ++y) {
+			uint8_t *line = &img->data[y * img->width];
+
+			for (x = 0; x < img->width; ++x) {
+				const int t = ((bayer4[y & 3][x & 3] * 2 + 1)
+					       * 255) / 32;
+
+				line[x] = quantise(line[x], max, t);
+			}
+		}
+	} else {
+		int *err = calloc(2 * (img->width + 2), sizeof(int));
+		int *cur = err + 1;
+		int *next = err + img->width + 3;
+		int i;
+
+		if (err == NULL)
+			return -1;
+
+		/* Floyd-Steinberg with errors scaled by 16 */
+		for (y = 0; y < img->height; ++y) {
+			uint8_t *line = &img->data[y * img->width];
+			int *tmp;
+
+			for (i = 0; i < (int)img->width; ++i) {
+				const int v = line[i] + (cur[i] / 16);
+				const uint8_t q = quantise(v, max, 127);
+				const int e = v - ((q * 255) / max);
+
+				line[i] = q;
+				cur[i + 1] += e * 7;
+				next[i - 1] += e * 3;
+				next[i] += e * 5;
+				next[i + 1] += e;
+			}
+
+			tmp = cur;
+			cur = next;
+			next = tmp;
+			memset(next - 1, 0, (img->width + 2) * sizeof(int));
+		}
+
+		free(err);
+	}
+
+	return 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Scrambling and padding
+ */
+
+/* Scramble the image with the same code and in the same line by line fashion
+ * as transfer_file_scrambled() in epson-s1d135xx.c, then pad each resulting
+ * line to the controller line length with white pixels */
+static int scramble_image(struct image *img, const struct options *opt,
+			  uint8_t white)
+{
+	/* source scrambling merges pairs of lines */
+	const unsigned step =
+		(opt->scrambling & SCRAMBLING_SOURCE_SCRAMBLE_MASK) ? 2 : 1;
+	uint16_t gl = step;
+	uint16_t sl = img->width;
+	uint16_t xpad;
+	unsigned out_w, out_h;
+	unsigned y;
+	uint8_t *src, *tmp, *out;
+
+	if (img->height % step) {
+		fprintf(stderr, "odd number of lines with source scrambling\n");
+		return -1;
+	}
+
+	if ((step * img->width) > 0xFFFF) {
+		fprintf(stderr, "image too wide\n");
+		return -1;
+	}
+
+	if (opt->scrambling) {
+		uint16_t g = step, s = img->width;
+
+		/* just to get the dimensions of the scrambled lines */
+		calcScrambledIndex(opt->scrambling, 0, 0, &g, &s);
+		gl = g;
+		sl = s;
+		xpad = scramble_source_pad(opt->source_offset);
+	} else {
+		xpad = opt->source_offset;
+	}
+
+	out_w = opt->xres ? opt->xres : (sl + xpad);
+	out_h = (img->height / step) * gl;
+
+	if ((sl + xpad) > out_w) {
+		fprintf(stderr, "scrambled lines too long: %u > %u\n",
+			sl + xpad, out_w);
+		return -1;
+	}
+
+	if (!opt->scrambling && (out_w == img->width))
+		return 0;
+
+	src = malloc(step * img->width);
+	tmp = malloc(step * img->width);
+	out = malloc((size_t)out_w * out_h);
+
+	if ((src == NULL) || (tmp == NULL) || (out == NULL)) {
+		free(src);
+		free(tmp);
+		free(out);
+		return -1;
+	}
+
+	memset(out, white, (size_t)out_w * out_h);
+
+	for (y = 0; y < img->height; y += step) {
+		const uint8_t *in = &img->data[y * img->width];
+		uint8_t *dst = &out[(y / step) * gl * out_w];
+		uint16_t g = step, s = img->width;
+		unsigned i;
+
+		if (!opt->scrambling) {
+			memcpy(&dst[xpad], in, img->width);
+			continue;
+		}
+
+		/* scramble_array() overwrites its source buffer */
+		memcpy(src, in, step * img->width);
+		scramble_array(src, tmp, &g, &s, opt->scrambling);
+
+		for (i = 0; i < g; ++i)
+			memcpy(&dst[(i * out_w) + xpad], &tmp[i * s], s);
+	}
+
+	free(src);
+	free(tmp);
+	free(img->data);
+	img->data = out;
+	img->width = out_w;
+	img->height = out_h;
+
+	return 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Output
+ */
+
+/* Write one packed line, with the first pixel in the least significant bits
+ * of each byte and each line starting on a byte boundary */
+static size_t pack_line(uint8_t *out, const uint8_t *levels, unsigned width,
+			unsigned bpp)
+{
+	const unsigned ppb = 8 / bpp;
+	size_t n = 0;
+	unsigned x;
+
+	for (x = 0; x < width; x += ppb) {
+		uint8_t byte = 0;
+		unsigned i;
+
+		for (i = 0; (i < ppb) && ((x + i) < width); ++i)
+			byte |= levels[x + i] << (i * bpp);
+
+		/* pad with white */
+		for (; i < ppb; ++i)
+			byte |= ((1 << bpp) - 1) << (i * bpp);
+
+		out[n++] = byte;
+	}
+
+	return n;
+}
+
+static int mem_rd(void *ctx)
+{
+	struct mem_buffer *buf = ctx;
+
+	if (buf->in_pos == buf->in_len)
+		return EOF;
+
+	return buf->in[buf->in_pos++];
+}
+
+static int mem_wr(int c, void *ctx)
+{
+	struct mem_buffer *buf = ctx;
+
+	if (buf->out_len == buf->out_size) {
+		size_t size = buf->out_size ? (buf->out_size * 2) : 4096;
+		uint8_t *out = realloc(buf->out, size);
+
+		if (out == NULL)
+			return LZSS_ERROR;
+
+		buf->out = out;
+		buf->out_size = size;
+	}
+
+	buf->out[buf->out_len++] = c;
+
+	return c;
+}
+
+/* Compress one strip into buf->out, which the caller needs to free */
+static int compress_strip(struct mem_buffer *buf, const uint8_t *data,
+			  size_t n, enum plimg_compression compression)
+{
+	struct lzss_io io;
+
+	memset(buf, 0, sizeof(*buf));
+	buf->in = data;
+	buf->in_len = n;
+	io.rd = mem_rd;
+	io.wr = mem_wr;
+	io.i = buf;
+	io.o = buf;
+
+	if (compression == PLIMG_COMP_LZSS) {
+		struct lzss lzss;
+		int ret;
+
+		if (lzss_init(&lzss, PLIMG_LZSS_EI, PLIMG_LZSS_EJ) ||
+		    lzss_alloc_buffer(&lzss))
+			return -1;
+
+		ret = lzss_encode(&lzss, &io);
+		lzss_free_buffer(&lzss);
+
+		return ret;
+	}
+
+	return rle_encode(&io);
+}
+
+/* Write an image container with 8bpp data in the byte order of the EPDC host
+ * interface, i.e. each pair of bytes is swapped as done by htobe16() in
+ * send_param(), and optionally compress each strip */
+static int write_plimg(FILE *f, const struct image *img,
+		       const struct options *opt)
+{
+	struct plimg_header hdr;
+	struct mem_buffer strips[PLIMG_MAX_STRIPS];
+	uint16_t crcs[PLIMG_MAX_STRIPS];
+	uint32_t sizes[PLIMG_MAX_STRIPS];
+	uint8_t *data;
+	const size_t n = (size_t)img->width * img->height;
+	unsigned strip;
+	size_t i;
+	int ret = 0;
+
+	if ((img->width % 2) || (img->width > 0xFFFF) ||
+	    (img->height > 0xFFFF)) {
+		fprintf(stderr, "invalid container size: %ux%u\n",
+			img->width, img->height);
+		return -1;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, PLIMG_MAGIC, sizeof(hdr.magic));
+	hdr.version = PLIMG_VERSION;
+	hdr.bpp = 8;
+	hdr.epdc = opt->epdc;
+	hdr.compression = opt->compression;
+	hdr.width = img->width;
+	hdr.height = img->height;
+	hdr.src_width = img->src_width;
+	hdr.src_height = img->src_height;
+	hdr.scrambling = opt->scrambling;
+	hdr.source_offset = opt->source_offset;
+	hdr.strip_lines =
+		(img->height + PLIMG_MAX_STRIPS - 1) / PLIMG_MAX_STRIPS;
+	hdr.n_strips =
+		(img->height + hdr.strip_lines - 1) / hdr.strip_lines;
+	hdr.data_size = n;
+
+	data = malloc(n);
+
+	if (data == NULL)
+		return -1;
+
+	for (i = 0; i < n; i += 2) {
+		data[i] = img->data[i + 1] * 17;
+		data[i + 1] = img->data[i] * 17;
+	}
+
+	memset(strips, 0, sizeof(strips));
+
+	for (strip = 0; !ret && (strip < hdr.n_strips); ++strip) {
+		const size_t line = (size_t)strip * hdr.strip_lines;
+		const size_t lines = ((line + hdr.strip_lines) > img->height) ?
+			(img->height - line) : hdr.strip_lines;
+		const uint8_t *strip_data = &data[line * img->width];
+		const size_t size = lines * img->width;
+
+		crcs[strip] = crc16_run(crc16_init, strip_data, size);
+
+		if (opt->compression == PLIMG_COMP_NONE) {
+			strips[strip].out = (uint8_t *)strip_data;
+			strips[strip].out_len = size;
+		} else {
+			ret = compress_strip(&strips[strip], strip_data, size,
+					     opt->compression);
+		}
+
+		sizes[strip] = strips[strip].out_len;
+	}
+
+	hdr.header_crc = crc16_run(crc16_init, (const uint8_t *)&hdr,
+				   offsetof(struct plimg_header, header_crc));
+
+	if (!ret && ((fwrite(&hdr, sizeof(hdr), 1, f) != 1) ||
+		     (fwrite(crcs, sizeof(uint16_t), hdr.n_strips, f)
+		      != hdr.n_strips)))
+		ret = -1;
+
+	if (!ret && (opt->compression != PLIMG_COMP_NONE) &&
+	    (fwrite(sizes, sizeof(uint32_t), hdr.n_strips, f)
+	     != hdr.n_strips))
+		ret = -1;
+
+	for (strip = 0; !ret && (strip < hdr.n_strips); ++strip)
+		if (fwrite(strips[strip].out, 1, sizes[strip], f)
+		    != sizes[strip])
+			ret = -1;
+
+	if (opt->compression != PLIMG_COMP_NONE)
+		for (strip = 0; strip < hdr.n_strips; ++strip)
+			free(strips[strip].out);
+
+	free(data);
+
+	return ret;
+}
+
+static int write_image(const char *path, const struct image *img,
+		       const struct options *opt)
+{
+	const enum format format = opt->format;
+	const size_t n = (size_t)img->width * img->height;
+	FILE *f;
+	int ret = 0;
+
+	f = fopen(path, "wb");
+
+	if (f == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	if (format == FORMAT_PLIMG) {
+		ret = write_plimg(f, img, opt);
+	} else if (format == FORMAT_PGM) {
+		uint8_t *grey = malloc(n);
+		size_t i;
+
+		if (grey == NULL) {
+			ret = -1;
+		} else {
+			/* 4-bit levels in both nibbles, as expected in 8bpp */
+			for (i = 0; i < n; ++i)
+				grey[i] = img->data[i] * 17;
+
+			fprintf(f, "P5\n%u %u\n255\n", img->width, img->height);
+
+			if (fwrite(grey, 1, n, f) != n)
+				ret = -1;
+
+			free(grey);
+		}
+	} else {
+		const unsigned bpp = (format == FORMAT_4BPP) ? 4 : 1;
+		uint8_t *line = malloc((img->width + 7) / 8 * bpp);
+		unsigned y;
+
+		if (line == NULL)
+			ret = -1;
+
+		for (y = 0; !ret && (y < img->height); ++y) {
+			const size_t len = pack_line(
+				line, &img->data[y * img->width], img->width,
+				bpp);
+
+			if (fwrite(line, 1, len, f) != len)
+				ret = -1;
+		}
+
+		free(line);
+	}
+
+	if (fclose(f))
+		ret = -1;
+
+	if (ret)
+		fprintf(stderr, "%s: failed to write image\n", path);
+
+	return ret;
+}
+
+static int make_out_path(char *out, size_t n, const char *in,
+			 const struct options *opt)
+{
+	const char *base = strrchr(in, '/');
+	const char *dot;
+	int len;
+
+	base = (base == NULL) ? in : (base + 1);
+	dot = strrchr(base, '.');
+	len = (dot == NULL) ? (int)strlen(base) : (int)(dot - base);
+
+	if (snprintf(out, n, "%s/%.*s.%s", opt->out_dir, len, base,
+		     format_ext[opt->format]) >= (int)n)
+		return -1;
+
+	return 0;
+}
+
+static int same_file(const char *a, const char *b)
+{
+	struct stat sa, sb;
+
+	if (stat(a, &sa) || stat(b, &sb))
+		return 0;
+
+	return (sa.st_dev == sb.st_dev) && (sa.st_ino == sb.st_ino);
+}
+
+static int convert_file(const char *path, const struct options *opt)
+{
+	struct image img;
+	char out_path[1024];
+	int ret = -1;
+
+	if (make_out_path(out_path, sizeof(out_path), path, opt)) {
+		fprintf(stderr, "%s: output path too long\n", path);
+		return -1;
+	}
+
+	if (same_file(path, out_path)) {
+		fprintf(stderr, "%s: would overwrite the input file\n", path);
+		return -1;
+	}
+
+	if (pnm_load(path, &img))
+		return -1;
+
+	if (dither_image(&img, format_levels[opt->format], opt->dither))
+		goto exit_free;
+
+	if (scramble_image(&img, opt, format_levels[opt->format] - 1))
+		goto exit_free;
+
+	ret = write_image(out_path, &img, opt);
+
+	if (!ret && opt->verbose)
+		printf("%s: %ux%u -> %s: %ux%u\n", path, img.src_width,
+		       img.src_height, out_path, img.width, img.height);
+
+exit_free:
+	free(img.data);
+
+	return ret;
+}
+
+/* ----------------------------------------------------------------------------
+ * Job list and worker threads
+ */
+
+static int is_image_name(const char *name)
+{
+	const char *dot = strrchr(name, '.');
+
+	if (dot == NULL)
+		return 0;
+
+	return !strcasecmp(dot, ".pgm") || !strcasecmp(dot, ".ppm") ||
+		!strcasecmp(dot, ".pnm");
+}
+
+static int add_job(struct job_list *jobs, const char *path)
+{
+	char **paths = realloc(jobs->paths, (jobs->n + 1) * sizeof(char *));
+
+	if (paths == NULL)
+		return -1;
+
+	jobs->paths = paths;
+	jobs->paths[jobs->n] = strdup(path);
+
+	if (jobs->paths[jobs->n] == NULL)
+		return -1;
+
+	jobs->n++;
+
+	return 0;
+}
+
+static int add_path(struct job_list *jobs, const char *path)
+{
+	struct stat st;
+	struct dirent *entry;
+	DIR *dir;
+	char full[1024];
+	int ret = 0;
+
+	if (stat(path, &st)) {
+		perror(path);
+		return -1;
+	}
+
+	if (!S_ISDIR(st.st_mode))
+		return add_job(jobs, path);
+
+	dir = opendir(path);
+
+	if (dir == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	while (!ret && ((entry = readdir(dir)) != NULL)) {
+		if (!is_image_name(entry->d_name))
+			continue;
+
+		if (snprintf(full, sizeof(full), "%s/%s", path, entry->d_name)
+		    >= (int)sizeof(full))
+			continue;
+
+		ret = add_job(jobs, full);
+	}
+
+	closedir(dir);
+
+	return ret;
+}
+
+static void *worker(void *arg)
+{
+	struct job_list *jobs = arg;
+
+	for (;;) {
+		unsigned i;
+
+		pthread_mutex_lock(&jobs->lock);
+		i = jobs->next++;
+		pthread_mutex_unlock(&jobs->lock);
+
+		if (i >= jobs->n)
+			break;
+
+		if (convert_file(jobs->paths[i], jobs->opt)) {
+			pthread_mutex_lock(&jobs->lock);
+			jobs->errors++;
+			pthread_mutex_unlock(&jobs->lock);
+		}
+	}
+
+	return NULL;
+}
+
+static int run_jobs(struct job_list *jobs, unsigned n_threads)
+{
+	pthread_t threads[MAX_THREADS];
+	unsigned i;
+
+	if (n_threads > jobs->n)
+		n_threads = jobs->n;
+
+	for (i = 0; i < n_threads; ++i) {
+		if (pthread_create(&threads[i], NULL, worker, jobs)) {
+			fprintf(stderr, "failed to create thread\n");
+			break;
+		}
+	}
+
+	/* carry on with fewer threads if some could not be created */
+	if (!i)
+		worker(jobs);
+
+	while (i--)
+		pthread_join(threads[i], NULL);
+
+	return jobs->errors ? -1 : 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * main
+ */
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+"Usage: %s [OPTIONS] INPUT...\n"
+"\n"
+"Convert binary PGM or PPM images to files ready to be loaded on a display.\n"
+"Each INPUT is either an image file or a directory with images to convert.\n"
+"\n"
+"Options:\n"
+"  -o DIR     output directory (default: current directory)\n"
+"  -p PANEL   use the scrambling mode of a display type (e.g. S079, S049)\n"
+"  -s MODE    scrambling mode as in config.txt (default: 0)\n"
+"  -O OFFSET  source offset in pixels as in config.txt (default: 0)\n"
+"  -x XRES    controller line length in pixels (default: image width)\n"
+"  -d DITHER  none, ordered or fs for Floyd-Steinberg (default: none)\n"
+"  -f FORMAT  pgm, 4bpp, 1bpp or plimg (default: pgm)\n"
+"  -c COMP    plimg compression: none, lzss or rle (default: none)\n"
+"  -j JOBS    number of threads (default: number of CPUs)\n"
+"  -v         print each converted file\n", name);
+}
+
+static int find_panel(const char *name, struct options *opt)
+{
+	const struct panel *it;
+
+	for (it = panels; it->name != NULL; ++it) {
+		if (!strncmp(name, it->name, 4)) {
+			opt->scrambling = it->scrambling;
+			opt->epdc = it->epdc;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+static int parse_enum(const char *arg, const char * const *names,
+		      unsigned n)
+{
+	unsigned i;
+
+	for (i = 0; i < n; ++i)
+		if (!strcmp(arg, names[i]))
+			return i;
+
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	static const char * const dither_names[] = { "none", "ordered", "fs" };
+	static const char * const comp_names[PLIMG_COMP_N] = {
+		"none", "lzss", "rle" };
+	struct options opt;
+	struct job_list jobs;
+	struct timespec t0, t1;
+	long n_cpus;
+	unsigned n_threads;
+	unsigned long ms;
+	int opt_char;
+	int ret;
+	int i;
+
+	memset(&opt, 0, sizeof(opt));
+	memset(&jobs, 0, sizeof(jobs));
+	opt.out_dir = ".";
+	n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	n_threads = (n_cpus > 0) ? n_cpus : 1;
+
+	while ((opt_char = getopt(argc, argv, "o:p:s:O:x:d:f:c:j:v")) != -1) {
+		switch (opt_char) {
+		case 'o':
+			opt.out_dir = optarg;
+			break;
+		case 'p':
+			if (find_panel(optarg, &opt)) {
+				fprintf(stderr, "Unknown panel: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 's':
+			opt.scrambling = strtoul(optarg, NULL, 0);
+			break;
+		case 'O':
+			opt.source_offset = strtoul(optarg, NULL, 0);
+			break;
+		case 'x':
+			opt.xres = strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			ret = parse_enum(optarg, dither_names, 3);
+			if (ret < 0) {
+				fprintf(stderr, "Invalid dither: %s\n", optarg);
+				return 1;
+			}
+			opt.dither = ret;
+			break;
+		case 'c':
+			ret = parse_enum(optarg, comp_names, PLIMG_COMP_N);
+			if (ret < 0) {
+				fprintf(stderr, "Invalid compression: %s\n",
+					optarg);
+				return 1;
+			}
+			opt.compression = ret;
+			break;
+		case 'f':
+			ret = parse_enum(optarg, format_ext, N_FORMATS);
+			if (ret < 0) {
+				fprintf(stderr, "Invalid format: %s\n", optarg);
+				return 1;
+			}
+			opt.format = ret;
+			break;
+		case 'j':
+			n_threads = strtoul(optarg, NULL, 10);
+			break;
+		case 'v':
+			opt.verbose = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind >= argc) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (!n_threads)
+		n_threads = 1;
+	else if (n_threads > MAX_THREADS)
+		n_threads = MAX_THREADS;
+
+	if (mkdir(opt.out_dir, 0755) && (access(opt.out_dir, W_OK))) {
+		perror(opt.out_dir);
+		return 1;
+	}
+
+	pthread_mutex_init(&jobs.lock, NULL);
+	jobs.opt = &opt;
+
+	for (i = optind; i < argc; ++i)
+		if (add_path(&jobs, argv[i]))
+			return 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	ret = run_jobs(&jobs, n_threads);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	ms = ((t1.tv_sec - t0.tv_sec) * 1000) +
+		((t1.tv_nsec - t0.tv_nsec) / 1000000);
+
+	printf("%u image(s) converted in %lu ms with %u thread(s)",
+	       jobs.n - jobs.errors, ms,
+	       (n_threads < jobs.n) ? n_threads : jobs.n);
+
+	if (jobs.errors)
+		printf(", %u error(s)", jobs.errors);
+
+	printf("\n");
+
+	for (i = 0; i < (int)jobs.n; ++i)
+		free(jobs.paths[i]);
+
+	free(jobs.paths);
+	pthread_mutex_destroy(&jobs.lock);
+
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,449 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * font-convert.c -- Convert BDF fonts into font files for the firmware
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <font.h>
+#include <crc16.h>
+#include <libgen.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "posix-fatfs.h"
+
+/* Characters of the BDF font, 1 byte per pixel */
+struct glyph {
+	int advance;
+	int width;
+	int height;
+	int xoff;
+	int yoff;
+	uint8_t *bits;
+};
+
+struct bdf {
+	int ascent;
+	int descent;
+	struct glyph glyphs[256];
+};
+
+static int hex_digit(char c)
+{
+	if ((c >= '0') && (c <= '9'))
+		return c - '0';
+
+	if ((c >= 'a') && (c <= 'f'))
+		return c - 'a' + 10;
+
+	if ((c >= 'A') && (c <= 'F'))
+		return c - 'A' + 10;
+
+	return -1;
+}
+
+static int read_bdf(const char *path, struct bdf *bdf)
+{
+	char line[256];
+	struct glyph *g = NULL;
+	struct glyph dummy;
+	int fbb[4] = { 0, 0, 0, 0 };
+	int row = -1;
+	int ret = 0;
+	FILE *f;
+
+	memset(bdf, 0, sizeof(*bdf));
+	memset(&dummy, 0, sizeof(dummy));
+	bdf->ascent = bdf->descent = -1;
+	f = fopen(path, "r");
+
+	if (f == NULL) {
+		fprintf(stderr, "Failed to open %s\n", path);
+		return -1;
+	}
+
+	while (!ret && (fgets(line, sizeof(line), f) != NULL)) {
+		int code;
+
+		if (row >= 0) {
+			int x;
+
+			if (!strncmp(line, "ENDCHAR", 7)) {
+				row = -1;
+				continue;
+			}
+
+			if (row >= g->height)
+				continue;
+
+			for (x = 0; x < g->width; ++x) {
+				const int d = hex_digit(line[x / 4]);
+
+				if (d < 0) {
+					ret = -1;
+					break;
+				}
+
+				g->bits[(row * g->width) + x] =
+					(d >> (3 - (x % 4))) & 1;
+			}
+
+			++row;
+		} else if (sscanf(line, "FONTBOUNDINGBOX %d %d %d %d", &fbb[0],
+				  &fbb[1], &fbb[2], &fbb[3]) == 4) {
+			continue;
+		} else if (sscanf(line, "FONT_ASCENT %d", &bdf->ascent) == 1) {
+			continue;
+		} else if (sscanf(line, "FONT_DESCENT %d", &bdf->descent)
+			   == 1) {
+			continue;
+		} else if (sscanf(line, "ENCODING %d", &code) == 1) {
+			/* only keep the 8-bit character codes */
+			g = ((code >= 0) && (code < 256)) ?
+				&bdf->glyphs[code] : &dummy;
+			free(g->bits);
+			memset(g, 0, sizeof(*g));
+		} else if (g == NULL) {
+			continue;
+		} else if (sscanf(line, "DWIDTH %d", &g->advance) == 1) {
+			continue;
+		} else if (sscanf(line, "BBX %d %d %d %d", &g->width,
+				  &g->height, &g->xoff, &g->yoff) == 4) {
+			if ((g->width < 0) || (g->height < 0) ||
+			    (g->width > 256) || (g->height > 256))
+				ret = -1;
+		} else if (!strncmp(line, "BITMAP", 6)) {
+			g->bits = calloc(1, (g->width * g->height) + 1);
+
+			if (g->bits == NULL)
+				ret = -1;
+
+			row = 0;
+		}
+	}
+
+	fclose(f);
+
+	free(dummy.bits);
+
+	if (bdf->ascent < 0)
+		bdf->ascent = fbb[1] + fbb[3];
+
+	if (bdf->descent < 0)
+		bdf->descent = -fbb[3];
+
+	if (ret || ((bdf->ascent + bdf->descent) <= 0)) {
+		fprintf(stderr, "Invalid BDF font: %s\n", path);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Pixel of a glyph in its character cell */
+static int cell_pixel(const struct bdf *bdf, const struct glyph *g, int x,
+		      int y)
+{
+	const int gx = x - g->xoff;
+	const int gy = y - (bdf->ascent - (g->yoff + g->height));
+
+	if ((g->bits == NULL) || (gx < 0) || (gx >= g->width) || (gy < 0) ||
+	    (gy >= g->height))
+		return 0;
+
+	return g->bits[(gy * g->width) + gx];
+}
+
+/* Reduce the glyphs by scale with 4-bit anti-aliased pixels, or keep them
+ * as they are with 1-bit pixels if scale is 1 */
+static int write_font(const struct bdf *bdf, int first, int last, int scale,
+		      const char *path)
+{
+	const int cell_height = bdf->ascent + bdf->descent;
+	const int area = scale * scale;
+	struct font_header hdr;
+	uint16_t offsets[257];
+	uint32_t row_size;
+	uint8_t *row;
+	int ret = 0;
+	int c, y;
+	FILE *f;
+
+	memcpy(hdr.magic, FONT_MAGIC, sizeof(hdr.magic));
+	hdr.version = FONT_VERSION;
+	hdr.bpp = (scale > 1) ? 4 : 1;
+	hdr.height = (cell_height + scale - 1) / scale;
+	hdr.baseline = (bdf->ascent + scale - 1) / scale;
+	hdr.first = first;
+	hdr.count = last - first + 1;
+
+	for (offsets[0] = 0, c = first; c <= last; ++c) {
+		const struct glyph *g = &bdf->glyphs[c];
+		const int w = (g->advance + scale - 1) / scale;
+
+		if ((offsets[c - first] + w) > 0xFFFF) {
+			fprintf(stderr, "Font too large\n");
+			return -1;
+		}
+
+		offsets[c - first + 1] = offsets[c - first] + w;
+	}
+
+	hdr.strike_width = offsets[hdr.count];
+	hdr.header_crc = crc16_run(crc16_init, (const uint8_t *)&hdr,
+				   offsetof(struct font_header, header_crc));
+	row_size = FONT_ROW_SIZE(hdr.strike_width, hdr.bpp);
+	row = malloc(row_size + 1);
+	f = fopen(path, "wb");
+
+	if ((row == NULL) || (f == NULL)) {
+		fprintf(stderr, "Failed to create %s\n", path);
+		free(row);
+
+		if (f != NULL)
+			fclose(f);
+
+		return -1;
+	}
+
+	if ((fwrite(&hdr, sizeof(hdr), 1, f) != 1) ||
+	    (fwrite(offsets, sizeof(uint16_t), (hdr.count + 1), f)
+	     != (hdr.count + 1)))
+		ret = -1;
+
+	for (y = 0; !ret && (y < hdr.height); ++y) {
+		memset(row, 0, row_size);
+
+		for (c = first; c <= last; ++c) {
+			const struct glyph *g = &bdf->glyphs[c];
+			const int x0 = offsets[c - first];
+			const int w = offsets[c - first + 1] - x0;
+			int x;
+
+			for (x = 0; x < w; ++x) {
+				const int px = x0 + x;
+				int sum = 0;
+				int i, j;
+
+				for (j = 0; j < scale; ++j)
+					for (i = 0; i < scale; ++i)
+						sum += cell_pixel(
+							bdf, g,
+							((x * scale) + i),
+							((y * scale) + j));
+
+				if (hdr.bpp == 1) {
+					if (sum)
+						row[px / 8] |= 0x80 >> (px % 8);
+				} else {
+					const int v = ((sum * 15) +
+						       (area / 2)) / area;
+
+					row[px / 2] |= (px % 2) ? v : (v << 4);
+				}
+			}
+		}
+
+		if (fwrite(row, 1, row_size, f) != row_size)
+			ret = -1;
+	}
+
+	if (fclose(f))
+		ret = -1;
+
+	free(row);
+
+	if (ret)
+		fprintf(stderr, "Failed to write %s\n", path);
+	else
+		printf("%s: %d characters, %dx%d pixels, %d bpp, %lu bytes\n",
+		       path, hdr.count, hdr.strike_width, hdr.height,
+		       hdr.bpp, (unsigned long)(sizeof(hdr) +
+			       ((hdr.count + 1) * sizeof(uint16_t)) +
+			       (row_size * hdr.height)));
+
+	return ret;
+}
+
+/* Render some text with the firmware code and show it as ASCII art */
+static int preview(const char *path, const char *text)
+{
+	static const char shades[] = " .:-=+*#%@";
+	struct font_text t;
+	struct font font;
+	char all[257];
+	char *dir, *name;
+	uint8_t *buffer = NULL;
+	uint8_t *line;
+	FIL f;
+	uint16_t y;
+	int ret = 0;
+
+	if (!strcmp(path, "5x9")) {
+		font = font_5x9;
+	} else {
+		dir = strdup(path);
+		name = strdup(path);
+		posix_fatfs_set_root(dirname(dir));
+
+		if (f_open(&f, basename(name), FA_READ) != FR_OK) {
+			fprintf(stderr, "Failed to open %s\n", path);
+			return -1;
+		}
+
+		if (font_open(&font, &f)) {
+			fprintf(stderr, "Invalid font file: %s\n", path);
+			f_close(&f);
+			return -1;
+		}
+
+		buffer = malloc(font.row_size);
+	}
+
+	if (text == NULL) {
+		int i;
+
+		for (i = 0; i < font.count; ++i)
+			all[i] = font.first + i;
+
+		all[i] = '\0';
+		text = all;
+	}
+
+	t.font = &font;
+	t.text = text;
+	t.width = font_text_width(&font, text);
+	t.scale = 1;
+	t.fg = 0x00;
+	t.bg = 0xFF;
+	line = malloc(t.width + 1);
+
+	if ((line == NULL) ||
+	    font_text_init(&t, buffer, buffer ? font.row_size : 0)) {
+		fprintf(stderr, "Failed to initialise the text\n");
+		ret = -1;
+	}
+
+	for (y = 0; !ret && (y < font.height); ++y) {
+		uint16_t x;
+
+		if (font_text_line(&t, y, line)) {
+			fprintf(stderr, "Failed to read the font\n");
+			ret = -1;
+			break;
+		}
+
+		for (x = 0; x < t.width; ++x)
+			putchar(shades[((15 - (line[x] >> 4)) * 9) / 15]);
+
+		putchar((y == (font.baseline - 1)) ? '<' : '|');
+		putchar('\n');
+	}
+
+	free(line);
+
+	if (font.f != NULL) {
+		font_close(&font);
+		f_close(&f);
+		free(buffer);
+	}
+
+	return ret;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+"Usage: %s [-s SCALE] [-r FIRST-LAST] -o OUTPUT FONT.bdf\n"
+"       %s -p FONT [-t TEXT]\n"
+"\n"
+"Convert a BDF font into a font file for the firmware (see font.h).  The\n"
+"characters FIRST to LAST are kept (default: 32-126).  With -s, the glyphs\n"
+"are reduced by SCALE with 4-bit anti-aliased pixels, so a large BDF font\n"
+"can be used to make a smoother one.\n"
+"\n"
+"Use -p to show some text rendered with a font file or the built-in 5x9\n"
+"font, as the firmware would render it (default: all the characters).\n",
+		name, name);
+}
+
+int main(int argc, char **argv)
+{
+	const char *output = NULL;
+	const char *font = NULL;
+	const char *text = NULL;
+	struct bdf *bdf;
+	int first = 32, last = 126;
+	int scale = 1;
+	int ret;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "o:s:r:p:t:")) != -1) {
+		switch (opt) {
+		case 'o':
+			output = optarg;
+			break;
+		case 's':
+			scale = atoi(optarg);
+			break;
+		case 'r':
+			if (sscanf(optarg, "%d-%d", &first, &last) != 2) {
+				fprintf(stderr, "Invalid range: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'p':
+			font = optarg;
+			break;
+		case 't':
+			text = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (font != NULL)
+		return preview(font, text) ? 1 : 0;
+
+	if ((output == NULL) || (optind != (argc - 1)) || (scale < 1) ||
+	    (scale > 16) || (first < 0) || (last > 255) || (first > last) ||
+	    ((last - first) > 254)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	bdf = malloc(sizeof(*bdf));
+
+	if (bdf == NULL)
+		return 1;
+
+	ret = read_bdf(argv[optind], bdf);
+
+	if (!ret)
+		ret = write_font(bdf, first, last, scale, output);
+
+	return ret ? 1 : 0;
+}
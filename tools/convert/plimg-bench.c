@@ -0,0 +1,314 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * plimg-bench.c -- Compare the cost of loading PGM files and image containers
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <plimg.h>
+#include <pnm-utils.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "posix-fatfs.h"
+
+/* Same as in epson-s1d135xx.c */
+#define DATA_BUFFER_LENGTH 2048
+
+struct crop {
+	int left;
+	int top;
+	int width;
+	int height;
+};
+
+struct sink_stats {
+	uint32_t bytes;
+	uint32_t line_size;
+	uint32_t pos;
+	uint32_t first;
+	uint32_t last;
+	uint16_t skip;
+	uint16_t lines;
+	uint16_t word;
+};
+
+static uint32_t now_us(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	return (t.tv_sec * 1000000UL) + (t.tv_nsec / 1000);
+}
+
+/* Stand-in for transfer_data(), with the byte swapping done in send_param() */
+static void transfer_data(struct sink_stats *st, const uint8_t *data,
+			  size_t n)
+{
+	const uint16_t *data16 = (const uint16_t *)data;
+
+	for (n /= 2; n; --n) {
+		const uint16_t w = *data16++;
+
+		st->word ^= (w >> 8) | (w << 8);
+		st->bytes += 2;
+	}
+}
+
+/* Same reading pattern as transfer_image() in epson-s1d135xx.c */
+static int load_pgm(FIL *f, const struct crop *crop, struct sink_stats *st)
+{
+	uint8_t data[DATA_BUFFER_LENGTH];
+	struct pnm_header hdr;
+	struct crop area;
+	int line;
+
+	if (pnm_read_header(f, &hdr))
+		return -1;
+
+	if (crop->width) {
+		area = *crop;
+	} else {
+		area.left = area.top = 0;
+		area.width = hdr.width;
+		area.height = hdr.height;
+	}
+
+	if ((area.left + area.width) > hdr.width ||
+	    (area.top + area.height) > hdr.height)
+		return -1;
+
+	if (f_lseek(f, f->fptr + ((long)area.top * hdr.width)) != FR_OK)
+		return -1;
+
+	for (line = area.height; line; --line) {
+		size_t remaining = area.width;
+
+		if (f_lseek(f, f->fptr + area.left) != FR_OK)
+			return -1;
+
+		while (remaining) {
+			const size_t btr = (remaining < sizeof(data)) ?
+				remaining : sizeof(data);
+			UINT count;
+
+			if (f_read(f, data, btr, &count) != FR_OK ||
+			    count != btr)
+				return -1;
+
+			transfer_data(st, data, btr);
+			remaining -= btr;
+		}
+
+		if (f_lseek(f, f->fptr + (hdr.width - (area.left + area.width)))
+		    != FR_OK)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int plimg_sink(const uint8_t *data, size_t n, void *ctx)
+{
+	struct sink_stats *st = ctx;
+
+	while (n) {
+		size_t chunk = st->line_size - st->pos;
+
+		if (chunk > n)
+			chunk = n;
+
+		if (!st->skip) {
+			const uint32_t start =
+				(st->pos > st->first) ? st->pos : st->first;
+			const uint32_t end = ((st->pos + chunk) < st->last) ?
+				(st->pos + chunk) : st->last;
+
+			if (start < end)
+				transfer_data(st, data + (start - st->pos),
+					      end - start);
+		}
+
+		st->pos += chunk;
+		data += chunk;
+		n -= chunk;
+
+		if (st->pos == st->line_size) {
+			st->pos = 0;
+
+			if (st->skip)
+				st->skip--;
+			else if (!--st->lines)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Same strip selection as load_plimg() in epson-s1d135xx.c */
+static int load_plimg(struct plimg *img, const struct crop *crop,
+		      struct sink_stats *st)
+{
+	const struct plimg_header *hdr = &img->hdr;
+	const int top = crop->width ? crop->top : 0;
+	unsigned strip;
+
+	st->line_size = PLIMG_LINE_SIZE(hdr);
+	st->pos = 0;
+	st->first = crop->width ? ((crop->left * hdr->bpp) / 8) : 0;
+	st->last = crop->width ?
+		(st->first + ((crop->width * hdr->bpp) / 8)) : st->line_size;
+	st->skip = top % hdr->strip_lines;
+	st->lines = crop->width ? crop->height : hdr->height;
+
+	if ((top + st->lines) > hdr->height)
+		return -1;
+
+	for (strip = top / hdr->strip_lines; st->lines; ++strip)
+		if (plimg_read_strip(img, strip, plimg_sink, st) && st->lines)
+			return -1;
+
+	return 0;
+}
+
+static int bench_file(const char *path, const struct crop *crop,
+		      unsigned rate, unsigned runs)
+{
+	static const char *comp_names[PLIMG_COMP_N] = {
+		"plimg", "plimg-lzss", "plimg-rle" };
+	const struct posix_fatfs_stats *fs_stats = posix_fatfs_get_stats();
+	struct sink_stats st;
+	const char *format = "pgm";
+	uint32_t total_us = 0;
+	unsigned long size = 0;
+	unsigned run;
+	int ret = 0;
+
+	posix_fatfs_reset_stats();
+
+	for (run = 0; !ret && (run < runs); ++run) {
+		struct plimg img;
+		uint32_t t0;
+		FIL f;
+		int stat;
+
+		memset(&st, 0, sizeof(st));
+
+		if (f_open(&f, path, FA_READ) != FR_OK) {
+			fprintf(stderr, "Failed to open %s\n", path);
+			return -1;
+		}
+
+		size = f.fsize;
+		t0 = now_us();
+		stat = plimg_open(&img, &f);
+
+		if (stat < 0) {
+			ret = -1;
+		} else if (stat) {
+			ret = load_pgm(&f, crop, &st);
+		} else {
+			format = comp_names[img.hdr.compression];
+			ret = load_plimg(&img, crop, &st);
+		}
+
+		total_us += now_us() - t0;
+		f_close(&f);
+	}
+
+	if (ret) {
+		fprintf(stderr, "Failed to load %s\n", path);
+		return -1;
+	}
+
+	printf("%-24s %-10s %9lu %9lu %9lu %8lu %8lu %9lu %8lu\n", path,
+	       format, size, (unsigned long)st.bytes,
+	       fs_stats->bytes / runs, fs_stats->sectors / runs,
+	       fs_stats->reads / runs,
+	       (fs_stats->sectors / runs) * 512UL * 1000UL / (rate * 1024UL),
+	       (unsigned long)(total_us / runs));
+
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+"Usage: %s [-r KBPS] [-n RUNS] [-a WxH+X+Y] FILE...\n"
+"\n"
+"Load PGM files and image containers as the firmware would and report the\n"
+"amount of data read from the SD card.  The SD card time is estimated with\n"
+"the given transfer rate (default: 400 KB/s).  The CPU time is measured on\n"
+"the host so it is only meaningful to compare formats with each other.\n"
+"Use -a to load only an area of the images.\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	struct crop crop;
+	unsigned rate = 400;
+	unsigned runs = 1;
+	int opt;
+	int ret = 0;
+
+	memset(&crop, 0, sizeof(crop));
+
+	while ((opt = getopt(argc, argv, "r:n:a:")) != -1) {
+		switch (opt) {
+		case 'r':
+			rate = strtoul(optarg, NULL, 10);
+			break;
+		case 'n':
+			runs = strtoul(optarg, NULL, 10);
+			break;
+		case 'a':
+			if ((sscanf(optarg, "%dx%d+%d+%d", &crop.width,
+				    &crop.height, &crop.left, &crop.top) != 4)
+			    || (crop.width <= 0) || (crop.height <= 0)) {
+				fprintf(stderr, "Invalid area: %s\n", optarg);
+				return 1;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if ((optind >= argc) || !rate || !runs) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	printf("%-24s %-10s %9s %9s %9s %8s %8s %9s %8s\n", "file", "format",
+	       "size", "pixels", "sd-bytes", "sectors", "reads", "sd-ms",
+	       "cpu-us");
+
+	for (; optind < argc; ++optind)
+		if (bench_file(argv[optind], &crop, rate, runs))
+			ret = 1;
+
+	return ret;
+}
@@ -0,0 +1,241 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * readahead-bench.c -- Measure the overlap between SD card reads and EPDC
+ *                      transfers with the read-ahead layer
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pnm-utils.h>
+#include <readahead.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "posix-fatfs.h"
+#include "posix-readahead.h"
+#include "utils.h"
+
+/* Same as in epson-s1d135xx.c */
+#define DATA_BUFFER_LENGTH 2048
+
+struct options {
+	unsigned sd_rate;
+	unsigned cmd_us;
+	unsigned xfer_rate;
+	unsigned n_bufs;
+	unsigned sectors;
+};
+
+/* Stand-in for transfer_data(), taking as long as the EPDC interface */
+static void transfer_data(const struct options *opt, const uint8_t *data,
+			  size_t n)
+{
+	const unsigned long us = (unsigned long)
+		((n * 1000000ULL) / (opt->xfer_rate * 1024ULL));
+	struct timespec t;
+
+	t.tv_sec = us / 1000000UL;
+	t.tv_nsec = (us % 1000000UL) * 1000UL;
+
+	while (nanosleep(&t, &t));
+}
+
+/* Open the file and skip the PNM header if any, as the image loader does */
+static int open_file(FIL *f, const char *path)
+{
+	struct pnm_header hdr;
+
+	if (f_open(f, path, FA_READ) != FR_OK) {
+		fprintf(stderr, "Failed to open %s\n", path);
+		return -1;
+	}
+
+	if (pnm_read_header(f, &hdr) && (f_lseek(f, 0) != FR_OK))
+		return -1;
+
+	return 0;
+}
+
+/* Same pattern as transfer_file() before the read-ahead layer: read 2 KB and
+ * then send it, so the disk and the EPDC are never busy at the same time */
+static int load_direct(const struct options *opt, struct readahead_disk *d,
+		       FIL *f)
+{
+	uint8_t data[DATA_BUFFER_LENGTH];
+
+	for (;;) {
+		size_t count;
+
+		if (d->start(d, f, data, sizeof(data)) || d->wait(d, &count))
+			return -1;
+
+		if (!count)
+			break;
+
+		transfer_data(opt, data, count);
+	}
+
+	return 0;
+}
+
+static int load_readahead(const struct options *opt,
+			  struct readahead_disk *d, FIL *f)
+{
+	const size_t mem_size =
+		opt->n_bufs * opt->sectors * READAHEAD_SECTOR_SIZE;
+	uint8_t *mem = malloc(mem_size);
+	struct readahead ra;
+	const uint8_t *data;
+	int count;
+
+	if (mem == NULL)
+		return -1;
+
+	if (readahead_init(&ra, f, d, mem, mem_size, opt->n_bufs)) {
+		free(mem);
+		return -1;
+	}
+
+	while ((count = readahead_next(&ra, &data)) > 0)
+		transfer_data(opt, data, count);
+
+	if (readahead_end(&ra))
+		count = -1;
+
+	free(mem);
+
+	return count;
+}
+
+static int bench_file(const struct options *opt, const char *path)
+{
+	static const char *mode_names[2] = { "direct", "readahead" };
+	const struct posix_fatfs_stats *fs_stats = posix_fatfs_get_stats();
+	const struct posix_readahead_stats *ra_stats;
+	struct readahead_disk *d;
+	unsigned mode;
+
+	d = posix_readahead_disk(opt->sd_rate, opt->cmd_us);
+
+	if (d == NULL)
+		return -1;
+
+	for (mode = 0; mode < 2; ++mode) {
+		uint32_t t0;
+		FIL f;
+		int stat;
+
+		if (open_file(&f, path))
+			return -1;
+
+		posix_fatfs_reset_stats();
+		posix_readahead_reset_stats();
+		t0 = ticks_now();
+		stat = mode ? load_readahead(opt, d, &f) :
+			load_direct(opt, d, &f);
+		t0 = ticks_now() - t0;
+		f_close(&f);
+
+		if (stat) {
+			fprintf(stderr, "Failed to load %s\n", path);
+			return -1;
+		}
+
+		ra_stats = posix_readahead_get_stats();
+
+		printf("%-24s %-10s %9lu %6lu %8lu %8lu %8lu %8lu %8lu\n",
+		       path, mode_names[mode], fs_stats->bytes,
+		       fs_stats->cmds, fs_stats->sectors,
+		       (unsigned long)(t0 / 1000),
+		       ra_stats->busy_us / 1000, ra_stats->blocked_us / 1000,
+		       ra_stats->overlap_us / 1000);
+	}
+
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+"Usage: %s [-r KBPS] [-c US] [-x KBPS] [-n BUFS] [-s SECTORS] FILE...\n"
+"\n"
+"Load files as the EPDC driver would, first reading and sending the data\n"
+"in turns and then with the read-ahead layer.  The SD card is simulated by\n"
+"a thread with the given transfer rate (-r, default: 400 KB/s) and time\n"
+"for each disk_read call (-c, default: 500 us).  The EPDC transfers take as\n"
+"long as the given rate (-x, default: 500 KB/s).  The read-ahead layer uses\n"
+"-n buffers of -s sectors (default: 2 buffers of 2 sectors).\n"
+"\n"
+"The cmds column is the number of disk_read calls which FatFs would make.\n"
+"The overlap column is the time spent reading from the SD card while the\n"
+"data was being sent to the EPDC.\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	struct options opt = { 400, 500, 500, 2, 2 };
+	int opt_char;
+	int ret = 0;
+
+	while ((opt_char = getopt(argc, argv, "r:c:x:n:s:")) != -1) {
+		switch (opt_char) {
+		case 'r':
+			opt.sd_rate = strtoul(optarg, NULL, 10);
+			break;
+		case 'c':
+			opt.cmd_us = strtoul(optarg, NULL, 10);
+			break;
+		case 'x':
+			opt.xfer_rate = strtoul(optarg, NULL, 10);
+			break;
+		case 'n':
+			opt.n_bufs = strtoul(optarg, NULL, 10);
+			break;
+		case 's':
+			opt.sectors = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if ((optind >= argc) || !opt.sd_rate || !opt.xfer_rate ||
+	    (opt.n_bufs < 2) || (opt.n_bufs > READAHEAD_MAX_BUFS) ||
+	    !opt.sectors) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	ticks_init();
+
+	printf("%-24s %-10s %9s %6s %8s %8s %8s %8s %8s\n", "file", "mode",
+	       "bytes", "cmds", "sectors", "wall-ms", "sd-ms", "wait-ms",
+	       "overlap");
+
+	for (; optind < argc; ++optind)
+		if (bench_file(&opt, argv[optind]))
+			ret = 1;
+
+	return ret;
+}
@@ -0,0 +1,314 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * trace-replay.c -- Replay EPDC command traces through a fake interface
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pl/endian.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "posix-spi.h"
+#include "posix-trace.h"
+#include "utils.h"
+
+/* Same as in epson-s1d135xx.c */
+#define XFER_ASYNC_LENGTH 128
+#define HOST_MEM_PORT 0x0154
+
+enum mode {
+	MODE_WORD = 0,          /* 2-byte writes, as transfer_data() over SPI */
+	MODE_BURST,             /* 254-byte writes, as transfer_raw() */
+	MODE_ASYNC,             /* asynchronous writes, as with SPI DMA */
+	MODE_N
+};
+
+enum phase {
+	PHASE_INIT = 0,
+	PHASE_POWER,
+	PHASE_WFLIB,
+	PHASE_IMAGE,
+	PHASE_UPDATE,
+	PHASE_REG,
+	PHASE_OTHER,
+	PHASE_N
+};
+
+struct phase_stat {
+	unsigned long cmds;
+	unsigned long bytes;
+	unsigned long waits;
+	uint32_t rec_us;        /* time recorded on the target */
+	uint32_t replay_us;     /* time taken to replay */
+};
+
+static const char *mode_names[MODE_N] = { "word", "burst", "async" };
+static const char *phase_names[PHASE_N] = {
+	"init", "power", "wflib", "image", "update", "reg", "other" };
+
+static uint8_t data_buf[2][XFER_ASYNC_LENGTH];
+static unsigned data_idx;
+
+static enum phase cmd_phase(uint16_t cmd)
+{
+	switch (cmd) {
+	case 0x00: case 0x01: case 0x06: case 0x0B: case 0x0E:
+		return PHASE_INIT;
+	case 0x02: case 0x04: case 0x05:
+		return PHASE_POWER;
+	case 0x1C: case 0x1D: case 0x1E:
+		return PHASE_WFLIB;
+	case 0x20: case 0x22: case 0x23:
+		return PHASE_IMAGE;
+	case 0x28: case 0x29: case 0x32: case 0x33: case 0x34: case 0x35:
+	case 0x36: case 0x37:
+		return PHASE_UPDATE;
+	case 0x10: case 0x11:
+		return PHASE_REG;
+	default:
+		return PHASE_OTHER;
+	}
+}
+
+static void send_word(struct pl_interface *iface, uint16_t w)
+{
+	w = htobe16(w);
+	iface->write((uint8_t *)&w, sizeof(w));
+}
+
+static void send_data(struct pl_interface *iface, enum mode mode, uint32_t n)
+{
+	while (n) {
+		uint32_t chunk;
+
+		switch (mode) {
+		case MODE_WORD:
+			chunk = 2;
+			iface->write(data_buf[0], chunk);
+			break;
+		case MODE_BURST:
+			chunk = min(n, 254);
+			iface->write(data_buf[0], chunk);
+			break;
+		case MODE_ASYNC:
+		default:
+			chunk = min(n, XFER_ASYNC_LENGTH);
+			iface->write_async(data_buf[data_idx], chunk, NULL, NULL);
+			data_idx ^= 1;
+			break;
+		}
+
+		n -= min(n, chunk);
+	}
+}
+
+static void spin_us(uint32_t us)
+{
+	const uint32_t t0 = ticks_now();
+
+	while ((ticks_now() - t0) < us);
+}
+
+static int replay(const char *path, enum mode mode, unsigned rate,
+		  unsigned call_ns, int waits)
+{
+	struct phase_stat stats[PHASE_N];
+	struct posix_trace_reader r;
+	struct pl_trace_rec rec;
+	struct pl_interface iface;
+	enum phase phase = PHASE_OTHER;
+	uint16_t last_cmd = 0xFFFF;
+	uint32_t last_stamp = 0;
+	uint32_t t0, last_t;
+	unsigned long n_recs = 0;
+	int have_stamp = 0;
+	int stat;
+	unsigned i;
+
+	if (posix_trace_open(&r, path)) {
+		fprintf(stderr, "Failed to open trace %s\n", path);
+		return -1;
+	}
+
+	if (posix_spi_init(&iface, rate)) {
+		posix_trace_end(&r);
+		return -1;
+	}
+
+	posix_spi_set_call_overhead(call_ns);
+	memset(stats, 0, sizeof(stats));
+	t0 = last_t = ticks_now();
+
+	while ((stat = posix_trace_read(&r, &rec)) == 1) {
+		struct phase_stat *s;
+		uint32_t t;
+		uint8_t buf[4];
+
+		n_recs++;
+
+		switch (rec.type) {
+		case PL_TRACE_CMD:
+			iface.wait();
+			t = ticks_now();
+			s = &stats[phase];
+			s->replay_us += t - last_t;
+			last_t = t;
+
+			if (have_stamp)
+				s->rec_us += rec.val - last_stamp;
+
+			last_stamp = rec.val;
+			have_stamp = 1;
+			last_cmd = rec.arg;
+			phase = cmd_phase(rec.arg);
+			stats[phase].cmds++;
+			send_word(&iface, rec.arg);
+			break;
+		case PL_TRACE_PARAM:
+			/* writing to the host memory port loads the wflib */
+			if ((last_cmd == 0x11) && (rec.arg == HOST_MEM_PORT))
+				phase = PHASE_WFLIB;
+
+			last_cmd = 0xFFFF;
+			send_word(&iface, rec.arg);
+			break;
+		case PL_TRACE_READ:
+			iface.read(buf, sizeof(buf));
+			break;
+		case PL_TRACE_DATA:
+			stats[phase].bytes += rec.val;
+			send_data(&iface, mode, rec.val);
+			break;
+		case PL_TRACE_WAIT:
+			iface.wait();
+			stats[phase].waits++;
+
+			if (waits)
+				spin_us(rec.val);
+			break;
+		default:
+			fprintf(stderr, "Invalid record type: %u\n", rec.type);
+			stat = -1;
+			break;
+		}
+
+		if (stat < 0)
+			break;
+	}
+
+	iface.wait();
+	stats[phase].replay_us += ticks_now() - last_t;
+	posix_trace_end(&r);
+
+	if (stat < 0) {
+		fprintf(stderr, "Failed to read trace %s\n", path);
+		return -1;
+	}
+
+	printf("%s: %lu records, %s mode, %u KB/s, %u ns per call\n", path,
+	       n_recs, mode_names[mode], rate, call_ns);
+	printf("%-8s %8s %10s %6s %10s %10s\n", "phase", "cmds", "bytes",
+	       "waits", "rec-us", "replay-us");
+
+	for (i = 0; i < PHASE_N; ++i) {
+		const struct phase_stat *s = &stats[i];
+
+		if (!s->cmds && !s->bytes)
+			continue;
+
+		printf("%-8s %8lu %10lu %6lu %10lu %10lu\n", phase_names[i],
+		       s->cmds, s->bytes, s->waits, (unsigned long)s->rec_us,
+		       (unsigned long)s->replay_us);
+	}
+
+	printf("%-8s %8s %10s %6s %10s %10lu\n", "total", "", "", "", "",
+	       (unsigned long)(ticks_now() - t0));
+
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+"Usage: %s [-m word|burst|async] [-x KBPS] [-c NS] [-W] TRACE...\n"
+"\n"
+"Replay EPDC command traces recorded with pl/trace.h, either binary files\n"
+"or serial output with the TRACE lines from the sequencer \"trace dump\"\n"
+"command.  Commands, parameters and data are sent to a fake interface at\n"
+"the given rate (-x, default: 1000 KB/s) with -c ns of overhead per call\n"
+"(default: 0), and the waits for the EPDC take as long as they did on the\n"
+"target unless -W is used.  Data is sent with 2-byte writes (word, the\n"
+"default), 254-byte writes (burst) or asynchronous writes (async).  The\n"
+"time recorded on the target and the replay time are reported per phase.\n",
+		name);
+}
+
+int main(int argc, char **argv)
+{
+	enum mode mode = MODE_WORD;
+	unsigned rate = 1000;
+	unsigned call_ns = 0;
+	int waits = 1;
+	int opt;
+	int ret = 0;
+
+	while ((opt = getopt(argc, argv, "m:x:c:W")) != -1) {
+		switch (opt) {
+		case 'm':
+			for (mode = 0; mode < MODE_N; ++mode)
+				if (!strcmp(optarg, mode_names[mode]))
+					break;
+
+			if (mode == MODE_N) {
+				fprintf(stderr, "Invalid mode: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'x':
+			rate = strtoul(optarg, NULL, 10);
+			break;
+		case 'c':
+			call_ns = strtoul(optarg, NULL, 10);
+			break;
+		case 'W':
+			waits = 0;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if ((optind >= argc) || !rate) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	ticks_init();
+
+	for (; optind < argc; ++optind)
+		if (replay(argv[optind], mode, rate, call_ns, waits))
+			ret = 1;
+
+	return ret;
+}
@@ -0,0 +1,248 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * xfer-bench.c -- Measure the overlap between EPDC transfers and the work
+ *                 needed to prepare the data with an asynchronous interface
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pl/endian.h>
+#include <pnm-utils.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "posix-fatfs.h"
+#include "posix-spi.h"
+#include "posix-trace.h"
+#include "utils.h"
+
+/* Same as in epson-s1d135xx.c */
+#define XFER_ASYNC_LENGTH 128
+#define CMD_LD_IMG_AREA 0x22
+#define CMD_LD_IMG_END 0x23
+#define LD_IMG_8BPP (1 << 4)
+
+static uint16_t xfer_bufs[2][XFER_ASYNC_LENGTH / 2];
+static unsigned xfer_buf;
+
+/* Same as transfer_data() in epson-s1d135xx.c without write_async */
+static void transfer_sync(struct pl_interface *iface, const uint8_t *data,
+			  size_t n)
+{
+	const uint16_t *data16 = (const uint16_t *)data;
+
+	for (n /= 2; n; --n) {
+		uint16_t param = htobe16(*data16++);
+
+		iface->write((uint8_t *)&param, sizeof(param));
+	}
+}
+
+/* Same as transfer_async() in epson-s1d135xx.c */
+static void transfer_async(struct pl_interface *iface, const uint8_t *data,
+			   size_t n)
+{
+	while (n) {
+		const size_t chunk = min(n, XFER_ASYNC_LENGTH) & ~1;
+		const uint16_t *data16 = (const uint16_t *)data;
+		uint16_t *buf = xfer_bufs[xfer_buf];
+		size_t i;
+
+		if (!chunk)
+			break;
+
+		for (i = 0; i < (chunk / 2); ++i)
+			buf[i] = htobe16(data16[i]);
+
+		iface->write_async((const uint8_t *)buf, chunk, NULL, NULL);
+		xfer_buf ^= 1;
+		data += chunk;
+		n -= chunk;
+	}
+}
+
+/* Stand-in for reading and scrambling each line */
+static void prepare_line(unsigned work_us)
+{
+	const uint32_t t0 = ticks_now();
+
+	while ((ticks_now() - t0) < work_us);
+}
+
+static int bench_file(const char *path, unsigned rate, unsigned work_us,
+		      const struct pl_trace_sink *trace)
+{
+	static const char *mode_names[2] = { "sync", "async" };
+	struct pnm_header hdr;
+	struct pl_interface iface;
+	uint8_t *line;
+	unsigned mode;
+	uint16_t crc = 0;
+
+	for (mode = 0; mode < 2; ++mode) {
+		const struct posix_spi_stats *stats;
+		uint32_t t0;
+		FIL f;
+		int y;
+
+		if (f_open(&f, path, FA_READ) != FR_OK) {
+			fprintf(stderr, "Failed to open %s\n", path);
+			return -1;
+		}
+
+		if (pnm_read_header(&f, &hdr)) {
+			fprintf(stderr, "Invalid PNM file: %s\n", path);
+			f_close(&f);
+			return -1;
+		}
+
+		line = malloc(hdr.width + 1);
+
+		if ((line == NULL) || posix_spi_init(&iface, rate)) {
+			free(line);
+			f_close(&f);
+			return -1;
+		}
+
+		t0 = ticks_now();
+
+		/* record what the firmware would send in the first pass */
+		if (!mode && (trace != NULL)) {
+			const uint16_t args[] = {
+				LD_IMG_8BPP, 0, 0, hdr.width, hdr.height };
+			unsigned i;
+
+			pl_trace_start(trace);
+			pl_trace(PL_TRACE_CMD, CMD_LD_IMG_AREA, 0);
+
+			for (i = 0; i < ARRAY_SIZE(args); ++i)
+				pl_trace(PL_TRACE_PARAM, args[i], 0);
+		}
+
+		for (y = 0; y < hdr.height; ++y) {
+			UINT count;
+
+			if ((f_read(&f, line, hdr.width, &count) != FR_OK) ||
+			    (count != hdr.width))
+				break;
+
+			prepare_line(work_us);
+			pl_trace(PL_TRACE_DATA, 0, count);
+
+			if (mode)
+				transfer_async(&iface, line, count);
+			else
+				transfer_sync(&iface, line, count);
+		}
+
+		iface.wait();
+		pl_trace(PL_TRACE_CMD, CMD_LD_IMG_END, 0);
+		pl_trace_stop();
+		t0 = ticks_now() - t0;
+		free(line);
+		f_close(&f);
+
+		if (y != hdr.height) {
+			fprintf(stderr, "Failed to read %s\n", path);
+			return -1;
+		}
+
+		stats = posix_spi_get_stats();
+
+		printf("%-24s %-6s %9lu %8lu %8lu %8lu %8lu %04X%s\n", path,
+		       mode_names[mode], stats->bytes,
+		       (unsigned long)(t0 / 1000), stats->busy_us / 1000,
+		       stats->blocked_us / 1000, stats->overlap_us / 1000,
+		       stats->crc,
+		       (mode && (stats->crc != crc)) ? " MISMATCH" : "");
+		crc = stats->crc;
+	}
+
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+"Usage: %s [-x KBPS] [-w US] [-T TRACE] FILE...\n"
+"\n"
+"Send PGM files line by line to a fake EPDC interface, first with\n"
+"synchronous writes and then with asynchronous ones as with the MSP430 DMA\n"
+"engine.  The interface sends data at the given rate (-x, default: 1000\n"
+"KB/s) and each line takes -w us to prepare (default: 200) to stand for\n"
+"the time spent reading and scrambling it.  The overlap column is the time\n"
+"spent sending data while the next line was being prepared.  The CRC of\n"
+"the data sent must be the same in both modes.  Use -T to record the\n"
+"synchronous pass as an EPDC command trace for trace-replay.\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned rate = 1000;
+	unsigned work_us = 200;
+	const char *trace_path = NULL;
+	struct pl_trace_sink trace;
+	int opt;
+	int ret = 0;
+
+	while ((opt = getopt(argc, argv, "x:w:T:")) != -1) {
+		switch (opt) {
+		case 'x':
+			rate = strtoul(optarg, NULL, 10);
+			break;
+		case 'w':
+			work_us = strtoul(optarg, NULL, 10);
+			break;
+		case 'T':
+			trace_path = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if ((optind >= argc) || !rate) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	ticks_init();
+
+	if ((trace_path != NULL) && posix_trace_create(&trace, trace_path)) {
+		fprintf(stderr, "Failed to create %s\n", trace_path);
+		return 1;
+	}
+
+	printf("%-24s %-6s %9s %8s %8s %8s %8s %s\n", "file", "mode", "bytes",
+	       "wall-ms", "xfer-ms", "wait-ms", "overlap", "crc");
+
+	for (; optind < argc; ++optind)
+		if (bench_file(argv[optind], rate, work_us,
+			       trace_path ? &trace : NULL))
+			ret = 1;
+
+	if (trace_path != NULL)
+		posix_trace_close(&trace);
+
+	return ret;
+}
@@ -0,0 +1,103 @@
+# Decode the deferred log records sent by the firmware over the serial port
+
+# Copyright (C) 2014 Plastic Logic Limited
+#
+# This program is free software: you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+# or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+from __future__ import print_function
+
+import sys
+import os
+import re
+import argparse
+
+DLOG_SYNC = 0x1E
+
+MSG_RE = re.compile(
+    r'^DLOG_MSG\((\w+),\s*"([^"]*)",\s*(\d+),\s*"((?:[^"\\]|\\.)*)"\)')
+
+def load_messages(path):
+    "Parse dlog-msgs.h and return a list of (tag, nargs, fmt) tuples"
+    msgs = []
+    with open(path) as f:
+        for line in f:
+            m = MSG_RE.match(line.strip())
+            if m:
+                msg_id, tag, nargs, fmt = m.groups()
+                msgs.append((tag, int(nargs), fmt.encode().decode('unicode_escape')))
+    return msgs
+
+def format_record(msgs, msg_id, args):
+    "Format one record like the firmware would in text mode"
+    if msg_id >= len(msgs):
+        return "{:<16s} unknown message id {} {}".format("dlog", msg_id, args)
+    tag, nargs, fmt = msgs[msg_id]
+    # arguments are 16-bit, convert them back to signed for %d and %i
+    values = []
+    for spec, value in zip(re.findall(r'%[-0-9.]*([a-zA-Z])', fmt), args):
+        if spec in 'di' and value >= 0x8000:
+            value -= 0x10000
+        values.append(value)
+    return "{:<16s} {}".format(tag, fmt % tuple(values))
+
+def decode(msgs, stream, out):
+    "Copy text through and expand the binary records found in the stream"
+    while True:
+        c = stream.read(1)
+        if not c:
+            break
+        if ord(c) != DLOG_SYNC:
+            out.write(c.decode('latin-1'))
+            continue
+        msg_id = stream.read(1)
+        if not msg_id:
+            break
+        msg_id = ord(msg_id)
+        nargs = msgs[msg_id][1] if msg_id < len(msgs) else 0
+        data = bytearray(stream.read(nargs * 2))
+        if len(data) < (nargs * 2):
+            break
+        args = [data[i] | (data[i + 1] << 8) for i in range(0, len(data), 2)]
+        out.write("{}\n".format(format_record(msgs, msg_id, args)))
+        out.flush()
+
+def main(argv):
+    default_msgs = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                os.pardir, 'dlog-msgs.h')
+    parser = argparse.ArgumentParser(
+        description="Decode deferred log records from the serial port")
+    parser.add_argument('input', nargs='?',
+                        help="serial device or captured log file, "
+                        "default is stdin")
+    parser.add_argument('--messages', default=default_msgs,
+                        help="path to dlog-msgs.h")
+    args = parser.parse_args(argv[1:])
+
+    msgs = load_messages(args.messages)
+
+    if args.input:
+        stream = open(args.input, 'rb', 0)
+    else:
+        stream = getattr(sys.stdin, 'buffer', sys.stdin)
+
+    try:
+        decode(msgs, stream, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+
+    return True
+
+if __name__ == '__main__':
+    ret = main(sys.argv)
+    sys.exit(0 if ret is True else 1)
@@ -0,0 +1,287 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * stream-board.c -- Host stand-in for a board running the stream app
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include <app/app.h>
+#include <pl/platform.h>
+#include <pl/serial.h>
+#include <pl/types.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "posix-serial.h"
+
+#define LOG_TAG "board"
+#include "utils.h"
+
+/* Runs app_stream() on the master side of a pseudo-terminal, with a fake EPDC
+ * which renders into a frame buffer saved as a PGM file after each update. */
+
+int app_stop = 0;
+
+static const char *output_path = "board.pgm";
+static uint8_t *fb;
+static struct pl_area load_area;
+static uint32_t load_pos;
+static int loading;
+
+/* corrupt about one in N bytes received while loading an image, to test
+ * the retransmission of DATA frames */
+static unsigned corrupt_period;
+static int (*serial_read)(struct pl_serial *serial, uint8_t *data, size_t n,
+			  unsigned timeout_ms);
+
+static const struct pl_wfid fake_wf_table[] = {
+	{ 1, 1 },
+	{ 2, 2 },
+	{ 3, 3 },
+	{ 4, 4 },
+	{ 0, 0 },
+	{ -1, -1 }
+};
+
+static void stop(int sig)
+{
+	app_stop = 1;
+}
+
+static int corrupt_read(struct pl_serial *serial, uint8_t *data, size_t n,
+			unsigned timeout_ms)
+{
+	const int ret = serial_read(serial, data, n, timeout_ms);
+	int i;
+
+	for (i = 0; loading && (i < ret); ++i)
+		if (!(rand() % corrupt_period))
+			data[i] ^= 0x10;
+
+	return ret;
+}
+
+static void full_area(struct pl_epdc *p, const struct pl_area *area,
+		      struct pl_area *out)
+{
+	if (area != NULL) {
+		*out = *area;
+	} else {
+		out->left = out->top = 0;
+		out->width = p->xres;
+		out->height = p->yres;
+	}
+}
+
+static int check_area(struct pl_epdc *p, const struct pl_area *a)
+{
+	if ((a->left + a->width) > (int)p->xres ||
+	    (a->top + a->height) > (int)p->yres) {
+		LOG("Area out of bounds: (%d, %d) %dx%d", a->left, a->top,
+		    a->width, a->height);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int fake_fill(struct pl_epdc *p, const struct pl_area *area,
+		     uint8_t g)
+{
+	struct pl_area a;
+	int y;
+
+	full_area(p, area, &a);
+
+	if (check_area(p, &a))
+		return -1;
+
+	for (y = a.top; y < (a.top + a.height); ++y)
+		memset(&fb[(y * p->xres) + a.left], g, a.width);
+
+	return 0;
+}
+
+static int fake_load_area_begin(struct pl_epdc *p, const struct pl_area *area)
+{
+	full_area(p, area, &load_area);
+	load_pos = 0;
+	loading = 1;
+
+	return check_area(p, &load_area);
+}
+
+static int fake_load_area_data(struct pl_epdc *p, const uint8_t *data,
+			       size_t n)
+{
+	const uint32_t size = (uint32_t)load_area.width * load_area.height;
+
+	while (n-- && (load_pos < size)) {
+		const int x = load_area.left + (load_pos % load_area.width);
+		const int y = load_area.top + (load_pos / load_area.width);
+
+		fb[(y * p->xres) + x] = *data++;
+		load_pos++;
+	}
+
+	return 0;
+}
+
+static int fake_load_area_end(struct pl_epdc *p)
+{
+	LOG("Loaded %lu pixels", (unsigned long)load_pos);
+	loading = 0;
+
+	return 0;
+}
+
+static int fake_update(struct pl_epdc *p, int wfid, enum pl_update_mode mode,
+		       const struct pl_area *area)
+{
+	FILE *f;
+
+	LOG("Update wfid=%d mode=%d, saving %s", wfid, mode, output_path);
+
+	f = fopen(output_path, "wb");
+
+	if (f == NULL) {
+		LOG("Failed to open %s", output_path);
+		return -1;
+	}
+
+	fprintf(f, "P5\n%u %u\n255\n", p->xres, p->yres);
+	fwrite(fb, p->xres, p->yres, f);
+	fclose(f);
+
+	return 0;
+}
+
+static int fake_nop(struct pl_epdc *p)
+{
+	return 0;
+}
+
+static int fake_psu(struct pl_epdpsu *psu)
+{
+	psu->state = !psu->state;
+	LOG("EPD PSU %s", psu->state ? "on" : "off");
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct pl_platform plat;
+	struct pl_serial serial;
+	struct termios tio;
+	unsigned xres = 1280;
+	unsigned yres = 960;
+	int master;
+	int slave;
+	int opt;
+	int stat;
+
+	while ((opt = getopt(argc, argv, "e:o:s:")) != -1) {
+		switch (opt) {
+		case 'e':
+			corrupt_period = strtoul(optarg, NULL, 10);
+			break;
+		case 'o':
+			output_path = optarg;
+			break;
+		case 's':
+			if (sscanf(optarg, "%ux%u", &xres, &yres) != 2) {
+				fprintf(stderr, "Invalid size: %s\n", optarg);
+				return 1;
+			}
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-e N] [-o output.pgm] "
+				"[-s WIDTHxHEIGHT]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if ((master < 0) || grantpt(master) || unlockpt(master)) {
+		LOG("Failed to create pseudo-terminal");
+		return 1;
+	}
+
+	/* keep the slave open so the master does not hang up between hosts */
+	slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+
+	if ((slave < 0) || tcgetattr(slave, &tio)) {
+		LOG("Failed to open %s", ptsname(master));
+		return 1;
+	}
+
+	cfmakeraw(&tio);
+	tcsetattr(slave, TCSANOW, &tio);
+
+	fb = malloc(xres * yres);
+
+	if (fb == NULL)
+		return 1;
+
+	memset(fb, 0xFF, (xres * yres));
+	memset(&plat, 0, sizeof(plat));
+	posix_serial_init(&serial, master);
+
+	if (corrupt_period) {
+		serial_read = serial.read;
+		serial.read = corrupt_read;
+		srand(corrupt_period);
+	}
+
+	plat.serial = &serial;
+	plat.epdc.fill = fake_fill;
+	plat.epdc.load_area_begin = fake_load_area_begin;
+	plat.epdc.load_area_data = fake_load_area_data;
+	plat.epdc.load_area_end = fake_load_area_end;
+	plat.epdc.update = fake_update;
+	plat.epdc.update_temp = fake_nop;
+	plat.epdc.wait_update_end = fake_nop;
+	plat.epdc.wf_table = fake_wf_table;
+	plat.epdc.xres = xres;
+	plat.epdc.yres = yres;
+	plat.psu.on = fake_psu;
+	plat.psu.off = fake_psu;
+
+	signal(SIGINT, stop);
+	signal(SIGTERM, stop);
+	ticks_init();
+
+	LOG("%ux%u display on %s", xres, yres, ptsname(master));
+	fflush(stdout);
+
+	stat = app_stream(&plat);
+
+	close(slave);
+	close(master);
+	free(fb);
+
+	return stat ? 1 : 0;
+}
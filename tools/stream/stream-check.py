@@ -0,0 +1,104 @@
+# Round-trip test of the stream protocol with stream-board and stream-send
+
+# Copyright (C) 2014 Plastic Logic Limited
+#
+# This program is free software: you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+# or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+from __future__ import print_function
+
+import sys
+import os
+import re
+import random
+import subprocess
+import tempfile
+
+WIDTH = 256
+HEIGHT = 64
+
+def make_image(seed):
+    """Pixels with many repeated sequences of 0xFE and 0xFF so the LZSS data
+    has back-references to them, which get sign-extended on the way out of
+    the dictionary buffer"""
+    rnd = random.Random(seed)
+    data = bytearray()
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            if ((x // 8) + y) % 3 == 0:
+                data.append(0xFE)
+            else:
+                data.append(rnd.choice([0x00, 0x80, 0xFE, 0xFF]))
+    return bytes(data)
+
+def write_pgm(path, data):
+    with open(path, 'wb') as f:
+        f.write('P5\n{} {}\n255\n'.format(WIDTH, HEIGHT).encode())
+        f.write(data)
+
+def read_pixels(path):
+    with open(path, 'rb') as f:
+        return f.read()[-(WIDTH * HEIGHT):]
+
+def start_board(tool_dir, out_path, board_opts):
+    board = subprocess.Popen(
+        [os.path.join(tool_dir, 'stream-board'), '-s',
+         '{}x{}'.format(WIDTH, HEIGHT), '-o', out_path] + board_opts,
+        stdout=subprocess.PIPE, universal_newlines=True)
+    m = re.search(r' on (\S+)$', board.stdout.readline())
+    if m is None:
+        board.kill()
+        raise Exception("Failed to start stream-board")
+    return board, m.group(1)
+
+def send(tool_dir, tty, *args):
+    cmd = [os.path.join(tool_dir, 'stream-send'), tty] + list(args)
+    return subprocess.call(cmd, stdout=subprocess.DEVNULL, timeout=30) == 0
+
+def run_check(tool_dir, tmp, name, opts, data, board_opts=[]):
+    in_path = os.path.join(tmp, 'in.pgm')
+    out_path = os.path.join(tmp, 'out.pgm')
+    write_pgm(in_path, data)
+    if os.path.exists(out_path):
+        os.unlink(out_path)
+    board, tty = start_board(tool_dir, out_path, board_opts)
+    try:
+        ok = (send(tool_dir, tty, *(['load'] + opts + [in_path])) and
+              send(tool_dir, tty, 'update', '2') and
+              read_pixels(out_path) == data)
+    finally:
+        board.terminate()
+        board.wait()
+    print("{}: {}".format(name, "OK" if ok else "FAILED"))
+    return ok
+
+def main(argv):
+    tool_dir = os.path.dirname(os.path.abspath(argv[0]))
+    tmp = tempfile.mkdtemp()
+    ok = True
+    for seed in range(4):
+        data = make_image(seed)
+        ok &= run_check(tool_dir, tmp, 'lzss-{}'.format(seed), [], data)
+        ok &= run_check(tool_dir, tmp, 'raw-{}'.format(seed), ['--raw'], data)
+    # some corrupted bytes, the DATA frames need to be sent again
+    data = make_image(0)
+    ok &= run_check(tool_dir, tmp, 'lzss-errors', [], data, ['-e', '1000'])
+    ok &= run_check(tool_dir, tmp, 'raw-errors', ['--raw'], data,
+                    ['-e', '1000'])
+    for f in os.listdir(tmp):
+        os.unlink(os.path.join(tmp, f))
+    os.rmdir(tmp)
+    return 0 if ok else 1
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,650 @@
+/*
+  Plastic Logic EPD project on MSP430
+
+  Copyright (C) 2014 Plastic Logic Limited
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * stream-send.c -- Send images and commands to a board running app_stream
+ */
+
+#include <app/stream.h>
+#include <pl/serial.h>
+#include <crc16.h>
+#include <lzss.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "posix-serial.h"
+
+#define REPLY_TIMEOUT_MS 5000
+
+/* Time to wait for a DATA reply before sending the frames again, shorter
+ * than the time the board waits for the next DATA frame */
+#define DATA_REPLY_TIMEOUT_MS 1000
+
+/* Number of times the DATA frames are sent again without any progress */
+#define DATA_RETRIES 8
+
+struct sender {
+	struct pl_serial serial;
+	unsigned window;
+	int verbose;
+	uint8_t seq;
+	unsigned junk;
+};
+
+struct reply {
+	uint8_t type;
+	uint8_t seq;
+	uint8_t status;
+	uint16_t len;
+	uint8_t data[STREAM_MAX_PAYLOAD];
+};
+
+struct buffer {
+	uint8_t *data;
+	size_t size;
+	size_t len;
+	size_t pos;
+};
+
+static const char *status_names[] = {
+	"OK", "CRC error", "unknown command", "invalid argument",
+	"sequence error", "EPDC error", "LZSS error",
+};
+
+static const char *stat_names[STREAM_STAT_N] = {
+	"frames", "bytes", "crc-errors", "junk", "loads", "pixels",
+	"updates", "load-us", "rx-overruns",
+};
+
+static void put_le16(uint8_t *data, uint16_t value)
+{
+	data[0] = value & 0xFF;
+	data[1] = (value >> 8) & 0xFF;
+}
+
+static uint16_t get_le16(const uint8_t *data)
+{
+	return data[0] | ((uint16_t)data[1] << 8);
+}
+
+static uint32_t get_le32(const uint8_t *data)
+{
+	return get_le16(data) | ((uint32_t)get_le16(&data[2]) << 16);
+}
+
+static void put_area(uint8_t *data, unsigned left, unsigned top,
+		     unsigned width, unsigned height)
+{
+	put_le16(&data[0], left);
+	put_le16(&data[2], top);
+	put_le16(&data[4], width);
+	put_le16(&data[6], height);
+}
+
+static const char *status_str(unsigned status)
+{
+	if (status >= (sizeof(status_names) / sizeof(status_names[0])))
+		return "unknown";
+
+	return status_names[status];
+}
+
+static double now_sec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+/* -- frames -- */
+
+static int send_frame(struct sender *snd, uint8_t type, const uint8_t *data,
+		      size_t len)
+{
+	uint8_t frame[STREAM_MAX_FRAME];
+	uint16_t crc;
+
+	if (len > STREAM_MAX_PAYLOAD)
+		return -1;
+
+	frame[0] = STREAM_SOF;
+	frame[1] = type;
+	frame[2] = snd->seq++;
+	put_le16(&frame[3], len);
+
+	if (len)
+		memcpy(&frame[STREAM_HEADER_SIZE], data, len);
+
+	crc = crc16_run(crc16_init, &frame[1], (STREAM_HEADER_SIZE - 1 + len));
+	put_le16(&frame[STREAM_HEADER_SIZE + len], crc);
+
+	return snd->serial.write(&snd->serial, frame,
+				 (STREAM_HEADER_SIZE + len + STREAM_CRC_SIZE));
+}
+
+/* Read the next reply frame, anything else is considered as log text and
+ * printed if verbose.  Return 0 on success, -1 on timeout.  */
+static int read_reply(struct sender *snd, struct reply *r,
+		      unsigned timeout_ms)
+{
+	struct pl_serial *serial = &snd->serial;
+	uint8_t hdr[STREAM_HEADER_SIZE];
+	uint8_t payload[STREAM_MAX_PAYLOAD + STREAM_CRC_SIZE];
+	uint16_t crc;
+	uint16_t len;
+
+	for (;;) {
+		if (serial->read(serial, hdr, 1, timeout_ms) != 1)
+			return -1;
+
+		if (hdr[0] != STREAM_SOF) {
+			snd->junk++;
+
+			if (snd->verbose)
+				fputc(hdr[0], stderr);
+
+			continue;
+		}
+
+		if (serial->read(serial, &hdr[1], (STREAM_HEADER_SIZE - 1),
+				 timeout_ms) != (STREAM_HEADER_SIZE - 1))
+			return -1;
+
+		len = get_le16(&hdr[3]);
+
+		if (!len || (len > STREAM_MAX_PAYLOAD) ||
+		    !(hdr[1] & STREAM_REPLY))
+			continue;
+
+		if (serial->read(serial, payload, (len + STREAM_CRC_SIZE),
+				 timeout_ms) != (len + STREAM_CRC_SIZE))
+			return -1;
+
+		crc = crc16_run(crc16_init, &hdr[1], (STREAM_HEADER_SIZE - 1));
+		crc = crc16_run(crc, payload, len);
+
+		if (crc != get_le16(&payload[len])) {
+			fprintf(stderr, "Invalid CRC in reply\n");
+			continue;
+		}
+
+		break;
+	}
+
+	r->type = hdr[1] & ~STREAM_REPLY;
+	r->seq = hdr[2];
+	r->status = payload[0];
+	r->len = len - 1;
+	memcpy(r->data, &payload[1], r->len);
+
+	return 0;
+}
+
+/* Wait for the reply to a given frame, return its status or -1 */
+static int wait_reply(struct sender *snd, uint8_t type, uint8_t seq,
+		      struct reply *r)
+{
+	if (read_reply(snd, r, REPLY_TIMEOUT_MS)) {
+		fprintf(stderr, "No reply to command 0x%02X seq %u\n",
+			type, seq);
+		return -1;
+	}
+
+	if ((r->type != type) || (r->seq != seq)) {
+		fprintf(stderr, "Unexpected reply 0x%02X seq %u, "
+			"expected 0x%02X seq %u\n", r->type, r->seq, type,
+			seq);
+		return -1;
+	}
+
+	if (r->status != STREAM_OK)
+		fprintf(stderr, "Command 0x%02X seq %u failed: %s\n", type,
+			seq, status_str(r->status));
+
+	return r->status;
+}
+
+static int run_cmd(struct sender *snd, uint8_t type, const uint8_t *data,
+		   size_t len, struct reply *r)
+{
+	const uint8_t seq = snd->seq;
+
+	if (send_frame(snd, type, data, len))
+		return -1;
+
+	return wait_reply(snd, type, seq, r);
+}
+
+/* -- image loading -- */
+
+static int buffer_rd(struct buffer *b)
+{
+	if (b->pos == b->len)
+		return EOF;
+
+	return b->data[b->pos++];
+}
+
+static int buffer_wr(int c, struct buffer *b)
+{
+	if (b->len == b->size) {
+		size_t size = b->size ? (b->size * 2) : 4096;
+		uint8_t *data = realloc(b->data, size);
+
+		if (data == NULL)
+			return LZSS_ERROR;
+
+		b->data = data;
+		b->size = size;
+	}
+
+	b->data[b->len++] = c;
+
+	return c;
+}
+
+static int compress(const struct buffer *in, struct buffer *out)
+{
+	struct lzss lzss;
+	struct lzss_io io;
+	struct buffer src = *in;
+	int stat;
+
+	src.pos = 0;
+	memset(out, 0, sizeof(*out));
+
+	if (lzss_init(&lzss, STREAM_LZSS_EI, STREAM_LZSS_EJ) ||
+	    lzss_alloc_buffer(&lzss))
+		return -1;
+
+	io.rd = (lzss_rd_t)buffer_rd;
+	io.i = &src;
+	io.wr = (lzss_wr_t)buffer_wr;
+	io.o = out;
+	stat = lzss_encode(&lzss, &io);
+	lzss_free_buffer(&lzss);
+
+	return stat;
+}
+
+static int read_pgm(const char *path, struct buffer *img, unsigned *width,
+		    unsigned *height)
+{
+	FILE *f;
+	unsigned maxval;
+	int stat = -1;
+
+	f = fopen(path, "rb");
+
+	if (f == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	memset(img, 0, sizeof(*img));
+
+	if ((fscanf(f, "P5 %u %u %u", width, height, &maxval) != 3) ||
+	    (maxval != 255) || (fgetc(f) == EOF)) {
+		fprintf(stderr, "%s: only 8-bit binary PGM is supported\n",
+			path);
+		goto exit_close;
+	}
+
+	img->len = img->size = (size_t)*width * *height;
+	img->data = malloc(img->size);
+
+	if (img->data == NULL)
+		goto exit_close;
+
+	if (fread(img->data, 1, img->len, f) != img->len) {
+		fprintf(stderr, "%s: truncated image\n", path);
+		goto exit_close;
+	}
+
+	stat = 0;
+
+exit_close:
+	fclose(f);
+
+	return stat;
+}
+
+/* Send the DATA frames with up to snd->window frames waiting for a reply.
+ * Frame n starts at n * STREAM_MAX_PAYLOAD in the data and has the sequence
+ * number seq0 + n, so on a CRC error or a missing reply all the frames
+ * which have not been acknowledged are sent again with the same sequence
+ * numbers.  Replies are cumulative as the board consumes frames in order. */
+static int send_data(struct sender *snd, const struct buffer *data)
+{
+	const uint8_t seq0 = snd->seq;
+	const unsigned n = (data->len + STREAM_MAX_PAYLOAD - 1) /
+		STREAM_MAX_PAYLOAD;
+	unsigned head = 0;
+	unsigned tail = 0;
+	unsigned retries = 0;
+	struct reply r;
+
+	while (tail < n) {
+		unsigned acked;
+
+		while ((head < n) && ((head - tail) < snd->window)) {
+			const size_t pos = (size_t)head * STREAM_MAX_PAYLOAD;
+			const size_t len = ((data->len - pos) > STREAM_MAX_PAYLOAD)
+				? STREAM_MAX_PAYLOAD : (data->len - pos);
+
+			snd->seq = seq0 + head++;
+
+			if (send_frame(snd, STREAM_CMD_DATA, &data->data[pos],
+				       len))
+				return -1;
+		}
+
+		if (read_reply(snd, &r, DATA_REPLY_TIMEOUT_MS)) {
+			fprintf(stderr, "No reply to DATA seq %u\n",
+				(uint8_t)(seq0 + tail));
+			r.status = STREAM_ERR_CRC;
+			r.seq = seq0 + tail;
+		} else if (r.type != STREAM_CMD_DATA) {
+			continue;
+		}
+
+		/* number of frames acknowledged by this reply, if any */
+		acked = (uint8_t)(r.seq - (uint8_t)(seq0 + tail)) + 1;
+
+		if (acked > (head - tail))
+			continue;
+
+		if (r.status == STREAM_OK) {
+			tail += acked;
+			retries = 0;
+		} else if (r.status == STREAM_ERR_CRC) {
+			if (++retries > DATA_RETRIES) {
+				fprintf(stderr, "Too many DATA errors\n");
+				return -1;
+			}
+
+			/* the board expects r.seq, send it and the next ones */
+			tail += acked - 1;
+			head = tail;
+		} else {
+			fprintf(stderr, "DATA seq %u failed: %s\n", r.seq,
+				status_str(r.status));
+			return -1;
+		}
+	}
+
+	snd->seq = seq0 + n;
+
+	return 0;
+}
+
+static int cmd_load(struct sender *snd, int argc, char **argv)
+{
+	struct buffer img;
+	struct buffer lz;
+	const struct buffer *data;
+	struct reply r;
+	uint8_t payload[13];
+	unsigned width, height;
+	unsigned left = 0, top = 0;
+	int raw = 0;
+	double t;
+	int stat = -1;
+
+	if (argc && !strcmp(argv[0], "--raw")) {
+		raw = 1;
+		argc--;
+		argv++;
+	}
+
+	if ((argc != 1) && (argc != 3)) {
+		fprintf(stderr, "Usage: load [--raw] FILE.pgm [LEFT TOP]\n");
+		return -1;
+	}
+
+	if (argc == 3) {
+		left = atoi(argv[1]);
+		top = atoi(argv[2]);
+	}
+
+	if (read_pgm(argv[0], &img, &width, &height))
+		return -1;
+
+	memset(&lz, 0, sizeof(lz));
+
+	if (raw) {
+		data = &img;
+	} else {
+		if (compress(&img, &lz)) {
+			fprintf(stderr, "Failed to compress image\n");
+			goto exit_free;
+		}
+
+		data = &lz;
+	}
+
+	printf("Loading %ux%u at (%u, %u), %zu bytes%s\n", width, height,
+	       left, top, data->len, raw ? "" : " (LZSS)");
+
+	payload[0] = raw ? 0 : STREAM_LOAD_LZSS;
+	put_area(&payload[1], left, top, width, height);
+	payload[9] = data->len & 0xFF;
+	payload[10] = (data->len >> 8) & 0xFF;
+	payload[11] = (data->len >> 16) & 0xFF;
+	payload[12] = (data->len >> 24) & 0xFF;
+
+	t = now_sec();
+
+	if (run_cmd(snd, STREAM_CMD_LOAD_AREA, payload, sizeof(payload), &r))
+		goto exit_free;
+
+	if (send_data(snd, data))
+		goto exit_free;
+
+	t = now_sec() - t;
+	printf("Loaded in %.3f s, %.1f kB/s on the link, %.1f kpixels/s\n",
+	       t, (data->len / t / 1000), (img.len / t / 1000));
+	stat = 0;
+
+exit_free:
+	free(img.data);
+	free(lz.data);
+
+	return stat;
+}
+
+/* -- other commands -- */
+
+static int read_area_args(int argc, char **argv, uint8_t *data)
+{
+	if (!argc) {
+		put_area(data, 0, 0, 0, 0);
+		return 0;
+	}
+
+	if (argc != 4)
+		return -1;
+
+	put_area(data, atoi(argv[0]), atoi(argv[1]), atoi(argv[2]),
+		 atoi(argv[3]));
+
+	return 0;
+}
+
+static int cmd_query(struct sender *snd, int argc, char **argv)
+{
+	struct reply r;
+	unsigned i;
+
+	if (run_cmd(snd, STREAM_CMD_QUERY_STATS, NULL, 0, &r))
+		return -1;
+
+	for (i = 0; (i < STREAM_STAT_N) && (((i + 1) * 4) <= r.len); ++i)
+		printf("%-12s %lu\n", stat_names[i],
+		       (unsigned long)get_le32(&r.data[i * 4]));
+
+	return 0;
+}
+
+static int cmd_power(struct sender *snd, int argc, char **argv)
+{
+	struct reply r;
+	uint8_t on;
+
+	if ((argc != 1) || (strcmp(argv[0], "on") && strcmp(argv[0], "off"))) {
+		fprintf(stderr, "Usage: power on|off\n");
+		return -1;
+	}
+
+	on = !strcmp(argv[0], "on");
+
+	return run_cmd(snd, STREAM_CMD_POWER, &on, 1, &r) ? -1 : 0;
+}
+
+static int cmd_fill(struct sender *snd, int argc, char **argv)
+{
+	struct reply r;
+	uint8_t payload[9];
+
+	if (!argc || read_area_args((argc - 1), &argv[1], &payload[1])) {
+		fprintf(stderr, "Usage: fill GREY [LEFT TOP WIDTH HEIGHT]\n");
+		return -1;
+	}
+
+	payload[0] = strtoul(argv[0], NULL, 0);
+
+	return run_cmd(snd, STREAM_CMD_FILL, payload, sizeof(payload), &r) ?
+		-1 : 0;
+}
+
+static int cmd_update(struct sender *snd, int argc, char **argv)
+{
+	struct reply r;
+	uint8_t payload[10];
+
+	if (!argc || (argc == 1 ? read_area_args(0, NULL, &payload[2]) :
+		      read_area_args((argc - 2), &argv[2], &payload[2]))) {
+		fprintf(stderr, "Usage: update WAVEFORM [MODE "
+			"[LEFT TOP WIDTH HEIGHT]]\n");
+		return -1;
+	}
+
+	payload[0] = atoi(argv[0]);
+	payload[1] = (argc > 1) ? atoi(argv[1]) : 0;
+
+	return run_cmd(snd, STREAM_CMD_UPDATE, payload, sizeof(payload), &r) ?
+		-1 : 0;
+}
+
+static const struct {
+	const char *name;
+	int (*run)(struct sender *snd, int argc, char **argv);
+} commands[] = {
+	{ "query", cmd_query },
+	{ "power", cmd_power },
+	{ "fill", cmd_fill },
+	{ "update", cmd_update },
+	{ "load", cmd_load },
+	{ NULL, NULL }
+};
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+"Usage: %s [-b BAUD] [-w WINDOW] [-v] DEVICE COMMAND [ARGS...]\n"
+"\n"
+"Commands:\n"
+"  query                                 print the board statistics\n"
+"  power on|off                          turn the EPD power on or off\n"
+"  fill GREY [LEFT TOP WIDTH HEIGHT]     fill an area with a grey level\n"
+"  update WAVEFORM [MODE [L T W H]]      update the display\n"
+"  load [--raw] FILE.pgm [LEFT TOP]      load an 8-bit PGM image\n",
+		name);
+}
+
+int main(int argc, char **argv)
+{
+	struct sender snd;
+	unsigned long baud = 0;
+	int fd;
+	int opt;
+	int i;
+
+	memset(&snd, 0, sizeof(snd));
+	snd.window = STREAM_WINDOW;
+
+	while ((opt = getopt(argc, argv, "+b:w:v")) != -1) {
+		switch (opt) {
+		case 'b':
+			baud = strtoul(optarg, NULL, 10);
+			break;
+		case 'w':
+			snd.window = atoi(optarg);
+			break;
+		case 'v':
+			snd.verbose = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if ((argc - optind) < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (!snd.window || (snd.window > STREAM_WINDOW)) {
+		fprintf(stderr, "Window must be between 1 and %u\n",
+			STREAM_WINDOW);
+		return 1;
+	}
+
+	fd = posix_serial_open(argv[optind], baud);
+
+	if (fd < 0)
+		return 1;
+
+	posix_serial_init(&snd.serial, fd);
+	snd.seq = (uint8_t)time(NULL);
+
+	for (i = 0; commands[i].name != NULL; ++i)
+		if (!strcmp(commands[i].name, argv[optind + 1]))
+			break;
+
+	if (commands[i].name == NULL) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (commands[i].run(&snd, (argc - optind - 2), &argv[optind + 2]))
+		return 1;
+
+	if (snd.verbose && snd.junk)
+		fprintf(stderr, "\n%u bytes of log text received\n", snd.junk);
+
+	close(fd);
+
+	return 0;
+}
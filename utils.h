@@ -21,6 +21,7 @@
 #define INCLUDE_UTIL_H 1
 
 #include "FatFs/ff.h"
+#include "scramble.h"
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -67,6 +68,17 @@ extern void udelay(uint16_t us);
 extern void mdelay(uint16_t ms);
 extern void msleep(uint16_t ms);
 
+/* -- Free-running tick counter -- */
+
+/** Rate of the free-running tick counter, 1 tick per microsecond */
+#define TICKS_PER_SEC 1000000L
+
+/** Start the free-running tick counter, needs to be called early on */
+extern void ticks_init(void);
+
+/** Current value of the tick counter, wraps around after about 71 minutes */
+extern uint32_t ticks_now(void);
+
 /** Check for the presence of a file in FatFs */
 extern int is_file_present(const char *path);
 
@@ -88,59 +100,4 @@ extern int open_image(const char *dir, const char *file, FIL *f,
 /** Print the contents of a buffer with offsets on stdout */
 extern void dump_hex(const void *data, uint16_t len);
 
-
-/**
- * defines a structure representing a array scrambling configuration
- *
- * source_interlaced: defines whether the data will be interlaced or not
- *                    0 -> no interlacing:  S0, S1, S2, S3, S4, ...
- *                    1 -> interlacing:     S0, Sn, S1, Sn+1, S2, Sn+2, ...  (with n = slCount/2)
- *
- * source_direction: direction of source data
- * 					  0 -> upwards: 		S0, S1, S2, S3, ...
- * 					  1 -> downwards: 		Sn, Sn-1, Sn-2, Sn-3, ...        (with n = slCount)
- *
- * source_start: starting position for source outputs, either left (default) or right
- * 					  0 -> left:			S0 is output first
- * 					  1 -> right:			Sn is output first 				 (with n = slCount/2)
- *
- * gate_direction: direction of gate data
- * 					  0 -> upwards: 		G0, G1, G2, G3, ...
- * 					  1 -> downwards: 		Gn, Gn-1, Gn-2, Gn-3, ...		 (with n = glCount)
- *
- */
-
-#define SCRAMBLING_SOURCE_START_BIT				0
-#define SCRAMBLING_SOURCE_INTERLACED_BIT		1
-#define SCRAMBLING_SOURCE_DIRECTION_BIT			2
-#define SCRAMBLING_GATE_DIRECTION_BIT			3
-#define SCRAMBLING_SOURCE_SCRAMBLE_BIT			4	// source line is connected to every 2nd pixel
-#define SCRAMBLING_GATE_SCRAMBLE_BIT			5	// gate line is connected to every 2nd pixel
-#define SCRAMBLING_SCRAMBLE_FIRST_ODD_LINE_BIT	6	// if is set the odd lines will be first
-#define SCRAMBLING_SOURCE_MIRROR_RH_BIT 		7	// mirrors the first image half
-#define SCRAMBLING_SOURCE_INTERLACED_FIRST_ODD_LINE_BIT 8
-#define SCRAMBLING_SOURCE_MIRROR_LH_BIT			9	// mirrors the second image half
-
-#define SCRAMBLING_SOURCE_START_MASK			(1 << SCRAMBLING_SOURCE_START_BIT)
-#define SCRAMBLING_SOURCE_INTERLACED_MASK 		(1 << SCRAMBLING_SOURCE_INTERLACED_BIT)
-#define SCRAMBLING_SOURCE_DIRECTION_MASK		(1 << SCRAMBLING_SOURCE_DIRECTION_BIT)
-#define SCRAMBLING_GATE_DIRECTION_MASK			(1 << SCRAMBLING_GATE_DIRECTION_BIT)
-#define SCRAMBLING_SOURCE_SCRAMBLE_MASK			(1 << SCRAMBLING_SOURCE_SCRAMBLE_BIT)
-#define SCRAMBLING_GATE_SCRAMBLE_MASK			(1 << SCRAMBLING_GATE_SCRAMBLE_BIT)
-#define SCRAMBLING_SCRAMBLE_FIRST_ODD_LINE_MASK	(1 << SCRAMBLING_SCRAMBLE_FIRST_ODD_LINE_BIT)
-#define SCRAMBLING_SOURCE_MIRROR_RH_MASK 		(1 << SCRAMBLING_SOURCE_MIRROR_RH_BIT)
-#define SCRAMBLING_SOURCE_INTERLACED_FIRST_ODD_LINE_MASK (1 << SCRAMBLING_SOURCE_INTERLACED_FIRST_ODD_LINE_BIT)
-#define SCRAMBLING_SOURCE_MIRROR_LH_MASK 		(1 << SCRAMBLING_SOURCE_MIRROR_LH_BIT)
-
-
-/** copies data from source to target array while applying a scrambling algorithm
- * S0, Sn, S1, Sn+1, S2, Sn+2; with n = slCount/2;
- * no scrambling in gate direction
- * Expects data in source array as sourceline fast addressed and starting with gate=0 and source=0.
- */
-uint16_t scramble_array(uint8_t* source, uint8_t* target, uint16_t *glCount, uint16_t *slCount, uint16_t scramblingMode);
-
-uint16_t calcScrambledIndex(uint16_t scramblingMode, uint16_t gl, uint16_t sl, uint16_t *glCount, uint16_t *slCount);
-
-
 #endif /* INCLUDE_UTIL_H */